@@ -6,7 +6,7 @@
  * SAHM = Sensor Acquisition to Host Memory
  * 
  * Compile:
- *   g++ -std=c++17 sahm_reader.cpp ../src/sahm.cpp \
+ *   g++ -std=c++17 sahm_reader.cpp ../src/sahm.cpp ../src/wait_strategy.cpp \
  *       -I../include -lrt -lpthread -o sahm_reader
  * 
  * Run (start this BEFORE writer!):
@@ -0,0 +1,234 @@
+/**
+ * @file async_writer.hpp
+ * @brief Async Writer - offload large copies from the producer thread
+ *
+ * A 50MB write() keeps the driver thread busy for milliseconds. Here the
+ * caller hands over its buffer and gets a completion token back at once:
+ * - Copy threads (optionally pinned) do the copy and the publish
+ * - The buffer comes back through a completion queue once published
+ * - Each channel is served by one copy thread, in submit order
+ * - Per-channel depth bounds buffers in flight (submit fails when full)
+ *
+ * Usage:
+ *   SIM::AsyncWriter async(SIM::AsyncWriterConfig::pinned({3}));
+ *   int cam = async.addChannel(camera_writer);
+ *   async.start();
+ *   uint64_t token = async.submit(cam, dma_buf, size);
+ *   SIM::AsyncCompletion done;
+ *   while (async.poll(done)) requeue(done.buffer);
+ */
+
+#ifndef ASYNC_WRITER_HPP
+#define ASYNC_WRITER_HPP
+
+#include "wait_strategy.hpp"
+#include "work_queue.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace SIM {
+
+/**
+ * @struct AsyncWriterConfig
+ * @brief Copy thread configuration
+ */
+struct AsyncWriterConfig {
+    size_t num_threads;             // Copy threads (channels are spread round-robin)
+    std::vector<int> cpus;          // Optional pinning, cpus[i] for thread i
+    size_t queue_depth;             // Buffers in flight per channel (incl. unpolled)
+    WaitStrategy wait_strategy;     // Copy thread wait when idle
+    
+    /**
+     * @brief One unpinned copy thread, 8 buffers per channel
+     */
+    static AsyncWriterConfig defaults() {
+        AsyncWriterConfig cfg;
+        cfg.num_threads = 1;
+        cfg.queue_depth = 8;
+        cfg.wait_strategy = WaitStrategy::adaptive();
+        return cfg;
+    }
+    
+    /**
+     * @brief One copy thread per given CPU
+     */
+    static AsyncWriterConfig pinned(const std::vector<int>& cpus, size_t queue_depth = 8) {
+        AsyncWriterConfig cfg;
+        cfg.num_threads = cpus.empty() ? 1 : cpus.size();
+        cfg.cpus = cpus;
+        cfg.queue_depth = queue_depth;
+        cfg.wait_strategy = WaitStrategy::adaptive();
+        return cfg;
+    }
+};
+
+/**
+ * @struct AsyncCompletion
+ * @brief A submitted buffer handed back to the caller
+ */
+struct AsyncCompletion {
+    uint64_t token;         // Returned by submit()
+    int channel;
+    const void* buffer;     // Caller's buffer, free to reuse
+    size_t size;
+    bool success;           // false: write() failed or writer stopped first
+    int64_t queued_ns;      // submit() -> publish
+};
+
+/**
+ * @struct AsyncWriterStats
+ * @brief Runtime counters
+ */
+struct AsyncWriterStats {
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t rejected;      // submit() with the channel queue full
+    uint64_t bytes;
+    int64_t max_queued_ns;
+};
+
+/**
+ * @class AsyncWriter
+ * @brief Publishes caller buffers on copy threads
+ *
+ * Channels must be added before start(). Completions have to be polled:
+ * a buffer counts against its channel's depth until poll() returns it.
+ */
+class AsyncWriter {
+public:
+    using PublishFn = std::function<bool(const void* data, size_t size)>;
+    
+    explicit AsyncWriter(const AsyncWriterConfig& config = AsyncWriterConfig::defaults());
+    ~AsyncWriter();
+    
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+    
+    /**
+     * @brief Add any transport writer (must outlive the AsyncWriter)
+     *
+     * SAHM reports success when at least one reader was written.
+     *
+     * @return Channel id, or -1 if running
+     */
+    template <typename Writer>
+    int addChannel(Writer& writer) {
+        return addChannel([&writer](const void* data, size_t size) {
+            return writer.write(data, size) > 0;
+        });
+    }
+    
+    /**
+     * @brief Add a raw publish function
+     */
+    int addChannel(PublishFn publish);
+    
+    /**
+     * @brief Start copy threads
+     */
+    bool start();
+    
+    /**
+     * @brief Join copy threads; queued buffers complete with success = false
+     *
+     * Waits for submit() calls already past their check; later ones fail.
+     */
+    void stop();
+    
+    /**
+     * @brief Queue a buffer for publishing (returns immediately)
+     *
+     * The buffer must stay valid and unchanged until its completion is polled.
+     *
+     * @return Completion token (> 0), or 0 if not running or the channel is full
+     */
+    uint64_t submit(int channel, const void* data, size_t size);
+    
+    /**
+     * @brief Take the next completion (non-blocking)
+     */
+    bool poll(AsyncCompletion& out);
+    
+    /**
+     * @brief Take the next completion, waiting up to timeout_ms
+     */
+    bool waitCompletion(AsyncCompletion& out, uint32_t timeout_ms);
+    
+    /**
+     * @brief Wait until every submitted buffer has been published
+     * @return false on timeout
+     */
+    bool flush(uint32_t timeout_ms);
+    
+    /**
+     * @brief Completions waiting to be polled
+     */
+    bool hasNewData() const { return completions_ && completions_->size() > 0; }
+    
+    /**
+     * @brief Bumped on every completion (WaitSet / Executor integration)
+     */
+    NotifyWord* getNotifyWord() { return &completion_word_; }
+    
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+    size_t getChannelCount() const { return channels_.size(); }
+    AsyncWriterStats getStats() const;
+
+private:
+    struct Request {
+        uint64_t token;
+        const void* data;
+        size_t size;
+        int64_t submit_ns;
+    };
+    
+    struct Channel {
+        explicit Channel(size_t depth) : queue(depth), outstanding(0) {}
+        PublishFn publish;
+        BoundedQueue<Request> queue;
+        std::atomic<size_t> outstanding;    // Submitted, not yet polled
+        size_t thread;
+    };
+    
+    struct CopyThread {
+        std::thread thread;
+        NotifyWord work;
+        std::vector<int> channels;
+        int cpu;
+    };
+    
+    uint64_t enqueue(Channel& ch, const void* data, size_t size);
+    void copyLoop(size_t index);
+    bool hasWork(const CopyThread& self) const;
+    void complete(int channel, const Request& request, bool success, int64_t now);
+    
+    AsyncWriterConfig config_;
+    std::atomic<bool> running_;
+    std::atomic<bool> stop_;
+    std::atomic<uint32_t> submitters_;      // submit() calls in progress (see stop())
+    
+    std::vector<std::unique_ptr<Channel>> channels_;
+    std::vector<std::unique_ptr<CopyThread>> threads_;
+    std::unique_ptr<BoundedQueue<AsyncCompletion>> completions_;
+    NotifyWord completion_word_;
+    
+    std::atomic<uint64_t> next_token_;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> in_flight_;
+    
+    std::atomic<uint64_t> stat_submitted_;
+    std::atomic<uint64_t> stat_completed_;
+    std::atomic<uint64_t> stat_failed_;
+    std::atomic<uint64_t> stat_rejected_;
+    std::atomic<uint64_t> stat_bytes_;
+    std::atomic<int64_t> stat_max_queued_ns_;
+};
+
+} // namespace SIM
+
+#endif // ASYNC_WRITER_HPP
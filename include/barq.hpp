@@ -1,15 +1,23 @@
 /**
  * @file barq.hpp
  * @brief BARQ (Burst Access Reader Queue) - Ultra-Fast "Shoot and Forget" Transport
- * 
+ *
  * Optimized double-buffer architecture with:
- * - Huge pages support (2MB, auto-fallback)
+ * - Huge pages support (2MB hugetlb or THP, auto-fallback; see huge_pages.hpp)
  * - Cache-line aligned structures (64B)
  * - Non-temporal stores for large writes
  * - Software prefetching
  * - MAP_POPULATE + mlock
  * - Minimal synchronization overhead
- * 
+ * - Futex wake-up for blocked readers (see wait_strategy.hpp)
+ * - Optional per-frame user metadata block beside the frame header
+ * - Segments from the broker daemon when it runs (see broker.hpp)
+ * - Optional anonymous memfd segments served over a Unix socket (see memfd.hpp)
+ * - Optional idle policy: back buffer memory released while quiet (see idle.hpp)
+ * - Online resize: the writer lays out new buffers, readers remap lazily
+ * - Readers attach to their NUMA node's replica when one exists (see replica.hpp)
+ * - Optional paced copies of large frames and channel priorities (see pacing.hpp)
+ *
  * "Shoot and Forget" - Writer never waits, reader always gets latest.
  */
 
@@ -21,20 +29,29 @@
 #include <atomic>
 #include <string>
 
+#include "broker.hpp"
+#include "gather.hpp"
+#include "huge_pages.hpp"
+#include "idle.hpp"
+#include "memfd.hpp"
+#include "pacing.hpp"
+#include "wait_strategy.hpp"
+
 namespace BARQ {
 
 // Constants
 constexpr uint32_t MAGIC = 0x53484D32;  // "SHM2"
-constexpr uint32_t VERSION = 0x00020000;
+constexpr uint32_t VERSION = 0x00020300;
 constexpr size_t CACHE_LINE = 64;
 constexpr size_t HUGE_PAGE = 2 * 1024 * 1024;
 
 /**
  * @struct Header
  * @brief Cache-line aligned header for maximum performance
- * 
+ *
  * Each critical field has its own cache line to prevent false sharing.
- * Total: 5 cache lines = 320 bytes
+ * Total: 6 cache lines = 384 bytes, followed by two user metadata
+ * blocks (one per buffer, meta_size rounded up to 64B) and the buffers.
  */
 struct alignas(CACHE_LINE) Header {
     // === Cache Line 0: Static metadata (64 bytes) ===
@@ -42,9 +59,10 @@ struct alignas(CACHE_LINE) Header {
     uint32_t version;
     size_t capacity;
     size_t buffer_offset;      // Offset to buffer A
-    uint32_t flags;            // 0x1 = huge pages active
-    uint32_t reserved;
-    char pad0[CACHE_LINE - 32];
+    uint32_t flags;            // SEGMENT_FLAG_HUGETLB (0x1) / SEGMENT_FLAG_THP (0x2)
+    uint32_t meta_size;        // Per-frame user metadata bytes (0 = none)
+    std::atomic<uint32_t> layout_gen;  // Odd while resize() rewrites capacity/buffer_offset
+    char pad0[CACHE_LINE - 36];
     
     // === Cache Line 1: Front index (64 bytes) ===
     // This is the HOT field - written by writer on every publish
@@ -67,11 +85,16 @@ struct alignas(CACHE_LINE) Header {
     alignas(CACHE_LINE) std::atomic<int64_t> heartbeat_ns;
     std::atomic<uint64_t> total_writes;
     std::atomic<uint64_t> total_bytes;
-    char pad4[CACHE_LINE - 24];
+    std::atomic<int32_t> writer_pid;    // 0 = no writer attached (see gc.hpp)
+    char pad4[CACHE_LINE - 28];
+    
+    // === Cache Line 5: Reader wake-up (64 bytes) ===
+    // Bumped on every publish; FUTEX_WAKE only if waiters > 0
+    alignas(CACHE_LINE) SIM::NotifyWord notify;
 };
 
 // Verify alignment
-static_assert(sizeof(Header) == 5 * CACHE_LINE, "Header must be 5 cache lines");
+static_assert(sizeof(Header) == 6 * CACHE_LINE, "Header must be 6 cache lines");
 
 /**
  * @class Writer
@@ -84,8 +107,10 @@ public:
      * @param name Shared memory name (e.g., "/sensor")
      * @param max_size Maximum data size per write
      * @param use_huge_pages Try to use 2MB huge pages
+     * @param meta_size Per-frame user metadata bytes (0 = none)
      */
-    Writer(const std::string& name, size_t max_size, bool use_huge_pages = true);
+    Writer(const std::string& name, size_t max_size, bool use_huge_pages = true,
+           size_t meta_size = 0);
     ~Writer();
     
     Writer(const Writer&) = delete;
@@ -93,22 +118,59 @@ public:
     
     /**
      * @brief Initialize shared memory
+     *
+     * Gets the segment from the broker daemon when it runs. Otherwise
+     * creates an anonymous segment if requested, or attaches to a
+     * pre-provisioned segment with the same layout (see provision.hpp)
+     * instead of recreating it; such a segment is left in place by
+     * destroy().
+     *
      * @return true on success
      */
     bool init();
     
+    /**
+     * @brief Use an anonymous memfd segment instead of a /dev/shm name (see memfd.hpp)
+     *
+     * Call before init(). Defaults to true with SIM_SEGMENTS=memfd.
+     */
+    void setAnonymous(bool anonymous) { anonymous_ = anonymous; }
+    
+    /**
+     * @brief Ask the broker daemon for the segment when it runs (default)
+     *
+     * Call before init(). Provisioning turns it off: the segment must be
+     * a named one that outlives the writer.
+     */
+    void setUseBroker(bool use_broker) { use_broker_ = use_broker; }
+    
+    /**
+     * @brief init() created an anonymous segment served by this process
+     */
+    bool isAnonymous() const { return serving_; }
+    
     /**
      * @brief Write data (shoot and forget)
-     * 
+     *
      * Uses non-temporal stores for data > 4KB.
      * Never blocks, always succeeds if initialized.
-     * 
+     *
      * @param data Pointer to data
      * @param size Size in bytes
      * @return true on success
      */
     bool write(const void* data, size_t size);
     
+    /**
+     * @brief Write a multi-part message (header + payload planes...)
+     *
+     * Segments are gathered straight into the back buffer; non-temporal
+     * stores span segment boundaries when the total is > 4KB.
+     *
+     * @return false if the total exceeds max_size
+     */
+    bool writev(const struct iovec* iov, int iovcnt);
+    
     /**
      * @brief Get write buffer for zero-copy writing
      * Call commit() after filling.
@@ -119,9 +181,64 @@ public:
     /**
      * @brief Commit zero-copy write
      * @param size Actual size written
+     * @param timestamp_ns Frame timestamp (0 = now; relays pass the source frame's)
      * @return true on success
      */
-    bool commit(size_t size);
+    bool commit(size_t size, int64_t timestamp_ns = 0);
+    
+    /**
+     * @brief User metadata block of the back buffer
+     *
+     * Fill it before write()/writev()/commit(): it is published
+     * atomically with the frame, without touching the payload.
+     *
+     * @return Pointer to meta_size bytes, nullptr if meta_size == 0
+     */
+    void* getWriteMetadata();
+    
+    size_t getMetadataSize() const { return meta_size_; }
+    
+    /**
+     * @brief Release the back buffer after a quiet period (see idle.hpp)
+     */
+    void setIdlePolicy(const SIM::IdlePolicy& policy) { idle_policy_ = policy; }
+    
+    /**
+     * @brief Release the back buffer if the channel has been quiet long enough
+     *
+     * Call from the writer's thread (loop timeout, timer), never while a
+     * getWriteBuffer() frame is being filled.
+     *
+     * @return true if memory was released
+     */
+    bool releaseIfIdle();
+    
+    /**
+     * @brief Re-populate a released back buffer and run the warm-up hook
+     *
+     * write() and getWriteBuffer() do this on demand; call it ahead of a
+     * publish to keep that cost off the publish path.
+     */
+    bool prepare();
+    
+    bool isIdleReleased() const { return back_released_; }
+    SIM::IdleStats getIdleStats() const;
+    
+    /**
+     * @brief Copy large write() frames in paced chunks (see pacing.hpp)
+     */
+    void setPacing(const SIM::PacingPolicy& policy) { pacer_.setPolicy(policy); }
+    const SIM::PacingStats& getPacingStats() const { return pacer_.getStats(); }
+    
+    /**
+     * @brief Channel priority (Normal by default)
+     *
+     * Critical writers signal pending work on every publish and are never
+     * paced. Bulk writers without a pacing policy get
+     * PacingPolicy::latencyBudget(CRITICAL_HOLD_NS / 2).
+     */
+    void setPriority(SIM::ChannelPriority priority);
+    SIM::ChannelPriority getPriority() const { return priority_; }
     
     /**
      * @brief Check if ready
@@ -133,17 +250,74 @@ public:
      */
     uint64_t getFrameCount() const { return frame_count_; }
     
+    const std::string& getName() const { return name_; }
+    size_t getMaxSize() const { return max_size_; }
+    
+    /**
+     * @brief init() attached to a pre-provisioned segment
+     */
+    bool isProvisioned() const { return provisioned_; }
+    
+    /**
+     * @brief init() got the segment from the broker daemon
+     */
+    bool isBrokered() const { return broker_.isConnected(); }
+    
+    bool isHugePagesActive() const { return huge_pages_active_; }
+    
+    /**
+     * @brief Pages backing the segment now (hugetlb, THP or regular, from smaps)
+     */
+    SIM::PageReport getPageReport() const { return SIM::inspectMapping(ptr_, shm_size_); }
+    
+    /**
+     * @brief Change the maximum frame size without recreating the channel
+     *
+     * Lays out a new pair of buffers (growing the segment if needed) and
+     * carries the latest frame over, then publishes a new layout
+     * generation; readers remap on their next poll. Buffers of the old
+     * layout are released two publishes later, so frames already handed
+     * out stay valid for the usual double-buffer window. Pointers from
+     * getWriteBuffer()/getWriteMetadata() must be fetched again.
+     *
+     * A latest frame larger than new_max_size is not carried over (readers
+     * remapping before the next publish see it empty).
+     *
+     * @return false if the segment could not grow (old layout kept)
+     */
+    bool resize(size_t new_max_size);
+    
+    /**
+     * @brief Number of resizes published on this segment
+     */
+    uint32_t getLayoutGeneration() const {
+        return header_ ? header_->layout_gen.load(std::memory_order_relaxed) / 2 : 0;
+    }
+    
     /**
      * @brief Clean up
      */
     void destroy();
+    
+    /**
+     * @brief Unmap but leave the segment for the next writer (provisioning)
+     */
+    void detach();
 
 private:
     std::string name_;
     size_t max_size_;
+    size_t meta_size_;
     bool use_huge_pages_;
     bool initialized_;
-    bool huge_pages_active_;
+    bool huge_pages_active_;    // hugetlb or THP, as found after mapping
+    SIM::PageReport pages_;
+    bool provisioned_;
+    bool keep_segment_;
+    bool anonymous_;
+    bool use_broker_;
+    bool serving_;              // Anonymous segment published (withdrawn by destroy())
+    SIM::BrokerClient broker_;
     
     int fd_;
     void* ptr_;
@@ -151,8 +325,26 @@ private:
     
     Header* header_;
     uint8_t* buffer_[2];
+    uint8_t* meta_[2];
     uint64_t frame_count_;
     
+    SIM::IdlePolicy idle_policy_;
+    SIM::IdleStats idle_stats_;
+    bool back_released_;
+    
+    SIM::ChannelPriority priority_;
+    SIM::BandwidthPacer pacer_;
+    
+    size_t retired_offset_;     // Buffers of the previous layout, freed at retire_at_
+    size_t retired_len_;
+    uint64_t retire_at_;
+    
+    size_t backOffset() const;
+    size_t pageSize() const;
+    void retireLayout();
+    void releaseSegment();
+    // Metadata, flip and wake-ups for a filled back buffer (timestamp 0 = now)
+    void publishBack(uint32_t back, size_t size, int64_t timestamp_ns);
     void writeNonTemporal(void* dst, const void* src, size_t size);
     int64_t nowNs();
 };
@@ -166,7 +358,7 @@ public:
     /**
      * @brief Constructor
      * @param name Shared memory name
-     * @param max_size Maximum expected data size
+     * @param max_size Maximum expected data size (the layout comes from the writer)
      */
     Reader(const std::string& name, size_t max_size);
     ~Reader();
@@ -176,22 +368,108 @@ public:
     
     /**
      * @brief Connect to writer's shared memory
+     *
+     * Attaches to the replica of the node the calling thread runs on if
+     * the channel is replicated (pin the thread first), to the channel
+     * itself otherwise.
+     *
      * @return true on success
      */
     bool init();
     
+    /**
+     * @brief Attach to the channel itself even if a local replica exists
+     *
+     * Call before init() (relays reading the primary do this).
+     */
+    void setLocalReplica(bool enabled) { local_replica_ = enabled; }
+    
+    /**
+     * @brief Segment actually attached (the channel name or a replica's)
+     */
+    const std::string& getAttachedName() const { return attached_; }
+    
     /**
      * @brief Get pointer to latest data (true zero-copy)
-     * 
+     *
      * Returns pointer directly into shared memory.
-     * Valid until next call to getLatest().
-     * 
+     * Valid until next call to getLatest(). Remaps first if the writer
+     * resized the channel (the previous mapping is kept until the next
+     * remap).
+     *
      * @param size Output: size of data
      * @param timestamp_ns Output: timestamp when written
      * @return Pointer to data, nullptr if no new data
      */
     const void* getLatest(size_t& size, int64_t& timestamp_ns);
     
+    /**
+     * @brief Get latest data, waiting up to timeout_ms for a new frame
+     *
+     * Waits according to the configured WaitStrategy (default: adaptive
+     * spin -> yield -> futex park).
+     *
+     * @return Pointer to data, nullptr on timeout
+     */
+    const void* getLatestWithTimeout(size_t& size, int64_t& timestamp_ns,
+                                     uint32_t timeout_ms);
+    
+    /**
+     * @brief Front buffer if it holds frame seq (does not consume)
+     *
+     * Used for consistent multi-channel snapshots (publish groups).
+     *
+     * @return Pointer to data, nullptr if the front holds another frame
+     *         or the layout changed since the last refreshLayout()
+     */
+    const void* peek(uint64_t seq, size_t& size, int64_t& timestamp_ns) const;
+    
+    /**
+     * @brief Remap if the writer resized the channel
+     *
+     * getLatest() does this on its own; peek() users call it first.
+     *
+     * @return false if the new layout could not be mapped
+     */
+    bool refreshLayout();
+    
+    /**
+     * @brief Maximum frame size of the current layout
+     */
+    size_t getCapacity() const { return capacity_; }
+    
+    /**
+     * @brief User metadata of the frame last returned by getLatest()
+     *
+     * Valid as long as that frame's payload pointer.
+     *
+     * @return Pointer to getMetadataSize() bytes, nullptr if none
+     */
+    const void* getMetadata() const;
+    
+    size_t getMetadataSize() const { return header_ ? header_->meta_size : 0; }
+    
+    /**
+     * @brief Wait until a new frame is published (does not consume it)
+     * @return true if new data is available
+     */
+    bool waitForData(uint32_t timeout_ms);
+    
+    /**
+     * @brief Check for a frame newer than the last one returned
+     */
+    bool hasNewData() const;
+    
+    /**
+     * @brief Select how the reader waits for new data
+     */
+    void setWaitStrategy(const SIM::WaitStrategy& strategy) { wait_strategy_ = strategy; }
+    
+    /**
+     * @brief Writable notify word for WaitSet/executors (nullptr if read-only)
+     */
+    SIM::NotifyWord* getNotifyWord() const { return notify_.get(); }
+    
     /**
      * @brief Check if writer is alive
      * @param timeout_ms Timeout in milliseconds
@@ -216,19 +494,32 @@ public:
 
 private:
     std::string name_;
+    std::string attached_;
     size_t max_size_;
     bool initialized_;
+    bool local_replica_;
     
     int fd_;
     void* ptr_;
     size_t shm_size_;
+    SIM::BrokerClient broker_;  // Holds reader membership while connected
+    void* retired_ptr_;         // Mapping before the last remap (frames in flight)
+    size_t retired_size_;
     
     Header* header_;
     const uint8_t* buffer_[2];
+    const uint8_t* meta_[2];
+    size_t capacity_;
+    uint32_t layout_gen_;
     
     uint64_t last_seq_;
+    uint32_t last_idx_;         // Buffer of the frame last returned
     uint64_t dropped_;
     
+    SIM::NotifyView notify_;
+    SIM::WaitStrategy wait_strategy_;
+    
+    bool mapLayout();
     int64_t nowNs() const;
 };
 
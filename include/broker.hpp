@@ -0,0 +1,240 @@
+/**
+ * @file broker.hpp
+ * @brief Channel Broker - optional local daemon owning segment lifecycle
+ *
+ * Without a broker every writer creates and unlinks its own segment and
+ * nobody cleans up after a crash. With sim_broker running:
+ * - The broker creates segments (memfd) and hands out fds (SCM_RIGHTS)
+ * - Pre-faulted pools of common sizes make writer startup a map only
+ * - Membership is tied to the client connection: a crashed process is
+ *   dropped at once, a restarted writer gets the same segment back
+ * - Unused segments are reclaimed after a linger time
+ * - Health (writer, readers, pools) is queryable
+ *
+ * BARQ and CASIR writers and readers use the broker when it runs and fall
+ * back to direct shm_open() otherwise. SIM_BROKER selects another socket
+ * name, SIM_BROKER=off disables the broker for a process.
+ *
+ * Usage:
+ *   // Daemon (see tools/sim_broker.cpp)
+ *   SIM::BrokerServer broker(SIM::BrokerConfig::withPools({{8 << 20, 4}}));
+ *   broker.start();
+ *
+ *   // Monitoring
+ *   SIM::BrokerClient client;
+ *   SIM::BrokerHealth health;
+ *   std::vector<SIM::ChannelHealth> channels;
+ *   if (client.connect() && client.status(health, channels)) ...
+ */
+
+#ifndef BROKER_HPP
+#define BROKER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SIM {
+
+constexpr const char* BROKER_DEFAULT_SOCKET = "sim_broker";   // Abstract namespace
+constexpr size_t BROKER_NAME_LEN = 64;
+
+/**
+ * @brief Broker socket name for this process (SIM_BROKER), empty if disabled
+ */
+std::string brokerSocketName();
+
+/**
+ * @enum BrokerRole
+ * @brief What a client does with a channel
+ */
+enum class BrokerRole : uint32_t {
+    Writer = 1,     // Creates the segment (size required), one per channel
+    Reader = 2      // Attaches to an existing segment
+};
+
+/**
+ * @struct BrokerPool
+ * @brief Pre-faulted segments kept ready for one size class
+ */
+struct BrokerPool {
+    size_t size;        // Segment bytes (requests up to this size use the class)
+    size_t count;       // Segments kept ready
+};
+
+/**
+ * @struct BrokerConfig
+ * @brief Daemon configuration
+ */
+struct BrokerConfig {
+    std::string socket_name;        // Abstract Unix socket name
+    std::vector<BrokerPool> pools;
+    uint32_t linger_ms;             // Keep unused channels (writer restarts)
+    
+    static BrokerConfig defaults() {
+        BrokerConfig cfg;
+        cfg.socket_name = BROKER_DEFAULT_SOCKET;
+        cfg.linger_ms = 10000;
+        return cfg;
+    }
+    
+    static BrokerConfig withPools(const std::vector<BrokerPool>& pools) {
+        BrokerConfig cfg = defaults();
+        cfg.pools = pools;
+        return cfg;
+    }
+};
+
+/**
+ * @struct ChannelHealth
+ * @brief One channel as seen by the broker
+ */
+struct ChannelHealth {
+    std::string name;
+    size_t size;
+    int32_t writer_pid;         // 0 = no writer attached
+    uint32_t readers;           // Attached reader connections
+    uint32_t generation;        // Times the segment was (re)created
+    int64_t age_ns;             // Since creation
+    int64_t idle_ns;            // Since the last member left (0 = in use)
+};
+
+/**
+ * @struct BrokerHealth
+ * @brief Daemon-wide counters
+ */
+struct BrokerHealth {
+    uint32_t channels;
+    uint32_t clients;
+    uint32_t pooled;            // Segments ready in pools
+    uint64_t pool_hits;
+    uint64_t pool_misses;
+    uint64_t reclaimed;         // Channels dropped after linger
+};
+
+/**
+ * @class BrokerClient
+ * @brief Connection to the broker (one per writer/reader)
+ *
+ * Membership lasts as long as the connection: close() or process exit
+ * releases every channel acquired through it.
+ */
+class BrokerClient {
+public:
+    BrokerClient();
+    ~BrokerClient();
+    
+    BrokerClient(const BrokerClient&) = delete;
+    BrokerClient& operator=(const BrokerClient&) = delete;
+    
+    BrokerClient(BrokerClient&& other) noexcept;
+    BrokerClient& operator=(BrokerClient&& other) noexcept;
+    
+    /**
+     * @brief Connect to the daemon
+     * @return false if no broker is running (or it is disabled)
+     */
+    bool connect(const std::string& socket_name = brokerSocketName());
+    
+    /**
+     * @brief Get a channel segment fd (connects first if needed)
+     *
+     * Stays connected when the broker refuses (unknown channel, second
+     * writer...), so isConnected() tells refusal from absence.
+     *
+     * @param size Segment bytes (Writer); ignored for readers
+     * @param created Set when the broker made a new segment (optional)
+     * @return fd owned by the caller, or -1
+     */
+    int acquire(const std::string& channel, size_t size, BrokerRole role,
+                bool* created = nullptr);
+    
+    /**
+     * @brief Drop this connection's membership of a channel
+     */
+    bool release(const std::string& channel);
+    
+    /**
+     * @brief Query daemon and channel health
+     */
+    bool status(BrokerHealth& health, std::vector<ChannelHealth>& channels);
+    
+    bool isConnected() const { return fd_ >= 0; }
+    void close();
+
+private:
+    int fd_;
+};
+
+/**
+ * @class BrokerServer
+ * @brief The daemon side, served from one background thread
+ */
+class BrokerServer {
+public:
+    explicit BrokerServer(const BrokerConfig& config = BrokerConfig::defaults());
+    ~BrokerServer();
+    
+    BrokerServer(const BrokerServer&) = delete;
+    BrokerServer& operator=(const BrokerServer&) = delete;
+    
+    /**
+     * @brief Bind the socket, fill pools and start serving
+     * @return false if another broker owns the socket name
+     */
+    bool start();
+    
+    /**
+     * @brief Stop serving and close every segment (mappings stay valid)
+     */
+    void stop();
+    
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+private:
+    struct Channel {
+        int fd;
+        size_t size;
+        int writer;                 // Client id, -1 = none
+        std::vector<int> readers;   // Client ids
+        uint32_t generation;
+        int64_t created_ns;
+        int64_t idle_since_ns;
+    };
+    
+    struct Client {
+        int fd;
+        int32_t pid;
+    };
+    
+    void serve();
+    void handle(int client);
+    void disconnect(int client);
+    void leave(Channel& channel, int client);
+    void reclaim(int64_t now);
+    void refill();
+    int takeSegment(size_t size);
+    
+    BrokerConfig config_;
+    std::atomic<bool> running_;
+    std::atomic<bool> stop_;
+    std::thread thread_;
+    int listen_fd_;
+    
+    std::map<std::string, Channel> channels_;
+    std::map<int, Client> clients_;
+    std::vector<std::vector<int>> pools_;   // Ready fds per config pool
+    int next_client_;
+    
+    uint64_t pool_hits_;
+    uint64_t pool_misses_;
+    uint64_t reclaimed_;
+};
+
+} // namespace SIM
+
+#endif // BROKER_HPP
@@ -9,6 +9,7 @@
  * - NUMA topology
  * 
  * All detection is portable and gracefully handles missing features.
+ * Results come from the process-wide topology snapshot (see topology.hpp).
  */
 
 #ifndef CACHE_UTILS_HPP
@@ -54,10 +55,14 @@ struct CacheInfo {
  */
 struct HugePagesInfo {
     bool available;         // Huge pages supported
-    bool usable;            // Enough free huge pages
+    bool usable;            // Free huge pages not reserved by other mappings
     size_t total;           // Total huge pages
-    size_t free;            // Free huge pages
+    size_t free;            // Free huge pages (reserved ones included)
+    size_t reserved;        // Free pages promised to existing mappings
     size_t page_size;       // Huge page size (usually 2MB)
+    bool thp_shmem;         // Shared memory may use transparent huge pages
+    
+    size_t unreserved() const { return free > reserved ? free - reserved : 0; }
 };
 
 /**
@@ -101,7 +106,8 @@ public:
     
     /**
      * @brief Check if huge pages are beneficial for size
-     * Huge pages are beneficial for allocations > 2MB
+     * Huge pages are beneficial for allocations > 1MB, if hugetlb pages
+     * (unreserved) or shmem THP can back them
      */
     static bool shouldUseHugePages(size_t size);
     
@@ -145,12 +151,11 @@ public:
      * @brief Get current CPU core
      */
     static int getCurrentCpu();
-
-private:
-    static size_t readCacheSize(const std::string& path);
-    static size_t parseSize(const std::string& str);
 };
 
+// Best CPU for a single latency-critical thread (see placement.hpp)
+int quietestCpu();
+
 /**
  * @struct SiCConfig
  * @brief Configuration for SIM Turbo
@@ -170,7 +175,7 @@ struct SiCConfig {
         auto cache = CacheUtils::detectCacheInfo();
         auto hp = CacheUtils::detectHugePages();
         
-        cfg.use_huge_pages = hp.usable;
+        cfg.use_huge_pages = hp.usable || hp.thp_shmem;
         cfg.enable_prefetch = true;
         cfg.numa_aware = true;
         cfg.cpu_affinity = -1;
@@ -200,7 +205,7 @@ struct SiCConfig {
         cfg.use_huge_pages = true;
         cfg.enable_prefetch = true;
         cfg.numa_aware = true;
-        cfg.cpu_affinity = 0;  // Pin to core 0
+        cfg.cpu_affinity = quietestCpu();  // CPU 0 and IRQ-heavy CPUs last
         cfg.prefetch_distance = 0;  // Auto
         return cfg;
     }
@@ -213,6 +218,8 @@ struct SiCConfig {
 struct SiCStats {
     // Configuration used
     bool huge_pages_active;
+    uint32_t page_flags;        // SEGMENT_FLAG_* of the mapping (see huge_pages.hpp)
+    size_t huge_page_bytes;     // Bytes mapped by huge pages at init
     bool prefetch_active;
     int numa_node;
     int pinned_cpu;
@@ -1,21 +1,35 @@
 /**
  * @file casir.hpp
  * @brief CASIR (Cache Access Streaming Into Reader) - Cache-Optimized Ultra-Low Latency Transport
- * 
+ *
  * Enhanced version of SIM with:
- * - Huge pages support (2MB pages, auto-fallback)
+ * - Huge pages support (2MB hugetlb or THP, auto-fallback; see huge_pages.hpp)
  * - Cache line aligned structures
  * - Software prefetching
  * - NUMA awareness
  * - CPU affinity support
- * 
+ * - Futex wake-up for blocked readers
+ * - Optional per-frame user metadata block beside the frame header
+ * - Segments from the broker daemon when it runs (see broker.hpp)
+ * - Optional anonymous memfd segments served over a Unix socket (see memfd.hpp)
+ * - Optional idle policy: back buffer memory released while quiet (see idle.hpp)
+ * - Online resize: the writer lays out new buffers, readers remap lazily
+ * - Channel priorities: critical channels make paced bulk copies step aside (see pacing.hpp)
+ *
  * All features auto-detect and fallback gracefully.
  */
 
 #ifndef CASIR_HPP
 #define CASIR_HPP
 
+#include "broker.hpp"
 #include "cache_utils.hpp"
+#include "gather.hpp"
+#include "huge_pages.hpp"
+#include "idle.hpp"
+#include "memfd.hpp"
+#include "pacing.hpp"
+#include "wait_strategy.hpp"
 #include <string>
 #include <atomic>
 #include <cstdint>
@@ -29,6 +43,7 @@ using Config = SIM::SiCConfig;
 using Stats = SIM::SiCStats;
 using CacheInfo = SIM::CacheInfo;
 using CacheUtils = SIM::CacheUtils;
+using WaitStrategy = SIM::WaitStrategy;
 constexpr size_t CACHE_LINE_SIZE = SIM::CACHE_LINE_SIZE;
 constexpr size_t HUGE_PAGE_SIZE = SIM::HUGE_PAGE_SIZE;
 
@@ -36,22 +51,27 @@ constexpr size_t HUGE_PAGE_SIZE = SIM::HUGE_PAGE_SIZE;
 constexpr uint32_t CASIR_MAGIC = 0x43415352;  // "CASR"
 
 // Version
-constexpr uint32_t CASIR_VERSION = 0x00010000;
+constexpr uint32_t CASIR_VERSION = 0x00010300;
 
 /**
  * @struct Header
  * @brief Cache-line aligned header for CASIR (Cache Access Streaming Into Reader)
- * 
+ *
  * Each atomic field has its own cache line to prevent false sharing.
+ * Followed by two user metadata blocks (one per buffer, meta_size
+ * rounded up to a cache line) and the buffers.
  */
 struct alignas(CACHE_LINE_SIZE) Header {
     // === Cache Line 0: Static metadata ===
     uint32_t magic;
     uint32_t version;
     size_t capacity;
-    size_t huge_page_size;
-    uint32_t flags;
-    char padding0[CACHE_LINE_SIZE - sizeof(uint32_t)*3 - sizeof(size_t)*2];
+    size_t huge_page_size;  // Page size of the huge part of the segment (0 = none)
+    uint32_t flags;         // SEGMENT_FLAG_HUGETLB (0x1) / SEGMENT_FLAG_THP (0x2)
+    uint32_t meta_size;     // Per-frame user metadata bytes (0 = none)
+    size_t buffer_offset;   // Offset to buffer 0
+    std::atomic<uint32_t> layout_gen;   // Odd while resize() rewrites capacity/buffer_offset
+    char padding0[CACHE_LINE_SIZE - sizeof(uint32_t)*5 - sizeof(size_t)*3];
     
     // === Cache Line 1: Front index (hot, written by writer) ===
     alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> front_idx;
@@ -61,31 +81,35 @@ struct alignas(CACHE_LINE_SIZE) Header {
     alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> frame0;
     std::atomic<int64_t> timestamp0_ns;
     std::atomic<uint32_t> checksum0;
-    char padding2[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>) - 
+    char padding2[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>) -
                   sizeof(std::atomic<int64_t>) - sizeof(std::atomic<uint32_t>)];
     
     // === Cache Line 3: Buffer 1 metadata ===
     alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> frame1;
     std::atomic<int64_t> timestamp1_ns;
     std::atomic<uint32_t> checksum1;
-    char padding3[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>) - 
+    char padding3[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>) -
                   sizeof(std::atomic<int64_t>) - sizeof(std::atomic<uint32_t>)];
     
     // === Cache Line 4: Writer state ===
     alignas(CACHE_LINE_SIZE) std::atomic<size_t> published_length;
     std::atomic<int64_t> writer_heartbeat_ns;
     std::atomic<bool> checksum_enabled;
-    char padding4[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - 
+    char padding4[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) -
                   sizeof(std::atomic<int64_t>) - sizeof(std::atomic<bool>)];
     
-    // === Cache Line 5: Stats ===
+    // === Cache Line 5: Stats and owner ===
     alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> total_writes;
     std::atomic<uint64_t> total_bytes;
-    char padding5[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)*2];
+    std::atomic<int32_t> writer_pid;    // 0 = no writer attached (see gc.hpp)
+    char padding5[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)*2 - sizeof(std::atomic<int32_t>)];
+    
+    // === Cache Line 6: Reader wake-up ===
+    alignas(CACHE_LINE_SIZE) SIM::NotifyWord notify;
 };
 
 // Verify cache line alignment
-static_assert(sizeof(Header) % CACHE_LINE_SIZE == 0, 
+static_assert(sizeof(Header) % CACHE_LINE_SIZE == 0,
               "Header must be cache-line aligned");
 
 /**
@@ -96,9 +120,11 @@ class Writer {
 public:
     /**
      * @brief Constructor with auto-detected configuration
+     * @param meta_size Per-frame user metadata bytes (0 = none)
      */
     Writer(const std::string& shm_name, size_t max_size,
-                const Config& config = Config::autoDetect());
+                const Config& config = Config::autoDetect(),
+                size_t meta_size = 0);
     
     ~Writer();
     
@@ -112,14 +138,41 @@ public:
     
     /**
      * @brief Initialize shared memory with optimal settings
+     *
+     * Gets the segment from the broker daemon when it runs. Otherwise
+     * creates an anonymous segment if requested, or attaches to a
+     * pre-provisioned segment with the same layout (see provision.hpp);
+     * such a segment is left in place by destroy().
      */
     bool init();
     
+    /**
+     * @brief Use an anonymous memfd segment instead of a /dev/shm name (see memfd.hpp)
+     * Call before init(); defaults to true with SIM_SEGMENTS=memfd
+     */
+    void setAnonymous(bool anonymous) { anonymous_ = anonymous; }
+    
+    /**
+     * @brief Ask the broker daemon for the segment when it runs (default)
+     * Call before init(); provisioning turns it off to get a named segment
+     */
+    void setUseBroker(bool use_broker) { use_broker_ = use_broker; }
+    
+    /**
+     * @brief init() created an anonymous segment served by this process
+     */
+    bool isAnonymous() const { return serving_; }
+    
     /**
      * @brief Write data with prefetching optimization
      */
     bool write(const void* data, size_t size);
     
+    /**
+     * @brief Write a multi-part message gathered straight into the back buffer
+     */
+    bool writev(const struct iovec* iov, int iovcnt);
+    
     /**
      * @brief Zero-copy write - caller fills buffer directly
      * @param fill_func Function that fills the buffer
@@ -138,31 +191,142 @@ public:
      */
     bool commitWrite(size_t size);
     
+    /**
+     * @brief User metadata block of the back buffer
+     * Fill before write()/commitWrite(); published atomically with the frame
+     */
+    void* getWriteMetadata();
+    
+    size_t getMetadataSize() const { return meta_size_; }
+    
+    /**
+     * @brief Release the back buffer after a quiet period (see idle.hpp)
+     */
+    void setIdlePolicy(const SIM::IdlePolicy& policy) { idle_policy_ = policy; }
+    
+    /**
+     * @brief Release the back buffer if the channel has been quiet long enough
+     * Call from the writer's thread, never while a getWriteBuffer() frame is filled
+     */
+    bool releaseIfIdle();
+    
+    /**
+     * @brief Re-populate a released back buffer and run the warm-up hook
+     * Done on demand by the write paths; call ahead of a publish to avoid that cost
+     */
+    bool prepare();
+    
+    bool isIdleReleased() const { return back_released_; }
+    SIM::IdleStats getIdleStats() const;
+    
+    /**
+     * @brief Copy large write() frames in paced chunks (see pacing.hpp)
+     */
+    void setPacing(const SIM::PacingPolicy& policy) { pacer_.setPolicy(policy); }
+    const SIM::PacingStats& getPacingStats() const { return pacer_.getStats(); }
+    
+    /**
+     * @brief Channel priority (Normal by default)
+     *
+     * Critical writers (small control channels) signal pending work on
+     * every publish, so paced bulk copies pause while readers pick it up.
+     * Bulk writers without a pacing policy get
+     * PacingPolicy::latencyBudget(CRITICAL_HOLD_NS / 2).
+     */
+    void setPriority(SIM::ChannelPriority priority);
+    SIM::ChannelPriority getPriority() const { return priority_; }
+    
     bool isReady() const { return is_initialized_; }
     const std::string& getName() const { return shm_name_; }
+    size_t getMaxSize() const { return max_size_; }
     uint64_t getFrameCount() const { return frame_count_; }
     Stats getStats() const;
     
+    /**
+     * @brief Pages backing the segment now (hugetlb, THP or regular, from smaps)
+     */
+    SIM::PageReport getPageReport() const { return SIM::inspectMapping(shm_ptr_, shm_size_); }
+    
+    /**
+     * @brief init() attached to a pre-provisioned segment
+     */
+    bool isProvisioned() const { return provisioned_; }
+    
+    /**
+     * @brief init() got the segment from the broker daemon
+     */
+    bool isBrokered() const { return broker_.isConnected(); }
+    
+    /**
+     * @brief Change the maximum frame size without recreating the channel
+     *
+     * New buffers are laid out (growing the segment if needed) with the
+     * latest frame carried over, and readers remap on their next read.
+     * The old buffers are released two publishes later. Pointers from
+     * getWriteBuffer()/getWriteMetadata() must be fetched again.
+     *
+     * @return false if the segment could not grow (old layout kept)
+     */
+    bool resize(size_t new_max_size);
+    
+    /**
+     * @brief Number of resizes published on this segment
+     */
+    uint32_t getLayoutGeneration() const {
+        return header_ ? header_->layout_gen.load(std::memory_order_relaxed) / 2 : 0;
+    }
+    
     void destroy();
+    
+    /**
+     * @brief Unmap but leave the segment for the next writer (provisioning)
+     */
+    void detach();
 
 private:
     std::string shm_name_;
     size_t max_size_;
+    size_t meta_size_;
     Config config_;
     bool is_initialized_;
+    bool provisioned_;
+    bool keep_segment_;
+    bool anonymous_;
+    bool use_broker_;
+    bool serving_;              // Anonymous segment published (withdrawn by destroy())
+    SIM::BrokerClient broker_;
     
     int shm_fd_;
     void* shm_ptr_;
     size_t shm_size_;
-    bool using_huge_pages_;
+    bool using_huge_pages_;     // hugetlb or THP, as found after mapping
+    SIM::PageReport pages_;
     
     Header* header_;
     uint8_t* buffer_[2];
+    uint8_t* meta_[2];
     uint64_t frame_count_;
     
     CacheInfo cache_info_;
     
-    bool allocateMemory();
+    SIM::IdlePolicy idle_policy_;
+    SIM::IdleStats idle_stats_;
+    bool back_released_;
+    
+    SIM::ChannelPriority priority_;
+    SIM::BandwidthPacer pacer_;
+    
+    size_t retired_offset_;     // Buffers of the previous layout, freed at retire_at_
+    size_t retired_len_;
+    uint64_t retire_at_;
+    
+    bool allocateMemory(bool thp);
+    size_t backOffset() const;
+    size_t pageSize() const;
+    void retireLayout();
+    void releaseSegment();
+    // Metadata, flip and wake-ups for a filled back buffer
+    void publishBack(uint32_t back, size_t size);
     void prefetchBuffer(int idx);
     uint32_t calculateChecksum(const void* data, size_t size) const;
     int64_t getCurrentTimestampNs() const;
@@ -197,9 +361,17 @@ public:
     
     /**
      * @brief Read with prefetching optimization
+     *
+     * Copies at most the max_size given at construction: frames of a
+     * channel resized beyond it are left for readZeroCopy().
      */
     bool read(void* data, size_t& size);
     
+    /**
+     * @brief Read frame and its user metadata (getMetadataSize() bytes)
+     */
+    bool read(void* data, size_t& size, void* metadata);
+    
     /**
      * @brief Zero-copy read - returns pointer to buffer
      * MUST call releaseZeroCopy() after processing
@@ -211,11 +383,68 @@ public:
      */
     void releaseZeroCopy();
     
+    /**
+     * @brief Front buffer if it holds the given frame (does not consume)
+     *
+     * Used for consistent multi-channel snapshots (publish groups). The
+     * header keeps one published length, so a commit racing with peek()
+     * can report the next frame's size: validate with an outer sequence.
+     */
+    const void* peek(uint64_t frame, size_t& size, int64_t& timestamp_ns) const;
+    
+    /**
+     * @brief Remap if the writer resized the channel
+     *
+     * read()/readZeroCopy() do this on their own; peek() returns nullptr
+     * until it has been called. The previous mapping is kept until the
+     * next remap, so frames already returned stay readable.
+     */
+    bool refreshLayout();
+    
+    /**
+     * @brief Maximum frame size of the current layout
+     */
+    size_t getCapacity() const { return capacity_; }
+    
+    /**
+     * @brief User metadata of the frame last returned by readZeroCopy()/read()
+     *
+     * Zero-copy: valid as long as that frame's buffer.
+     *
+     * @return nullptr if the channel has no metadata
+     */
+    const void* getMetadata() const;
+    
+    size_t getMetadataSize() const { return header_ ? header_->meta_size : 0; }
+    
     /**
      * @brief Read with timeout
+     *
+     * Waits according to the configured WaitStrategy
+     * (default: adaptive spin -> yield -> futex park).
      */
     bool readWithTimeout(void* data, size_t& size, uint32_t timeout_ms);
     
+    /**
+     * @brief Wait until a new frame is published (does not consume it)
+     */
+    bool waitForData(uint32_t timeout_ms);
+    
+    /**
+     * @brief Check for a frame newer than the last one read
+     */
+    bool hasNewData() const;
+    
+    /**
+     * @brief Select how the reader waits for new data
+     */
+    void setWaitStrategy(const WaitStrategy& strategy) { wait_strategy_ = strategy; }
+    
+    /**
+     * @brief Writable notify word for WaitSet/executors (nullptr if read-only)
+     */
+    SIM::NotifyWord* getNotifyWord() const { return notify_.get(); }
+    
     bool isReady() const { return is_initialized_; }
     bool isWriterAlive(uint32_t timeout_ms = 1000) const;
     
@@ -235,19 +464,30 @@ private:
     int shm_fd_;
     void* shm_ptr_;
     size_t shm_size_;
+    SIM::BrokerClient broker_;  // Holds reader membership while connected
     bool using_huge_pages_;
+    void* retired_ptr_;         // Mapping before the last remap (frames in flight)
+    size_t retired_size_;
     
     Header* header_;
     const uint8_t* buffer_[2];
+    const uint8_t* meta_[2];
+    size_t capacity_;
+    uint32_t layout_gen_;
     
     uint64_t last_frame_;
+    uint32_t last_idx_;         // Buffer of the frame last returned
     int64_t last_timestamp_ns_;
     uint64_t dropped_frames_;
     bool last_checksum_valid_;
     bool zero_copy_active_;
     
     CacheInfo cache_info_;
+    SIM::NotifyView notify_;
+    WaitStrategy wait_strategy_;
     
+    bool mapLayout();
+    bool checkLayout(uint32_t& front);
     void prefetchBuffer(int idx);
     uint32_t calculateChecksum(const void* data, size_t size) const;
     int64_t getCurrentTimestampNs() const;
@@ -0,0 +1,399 @@
+/**
+ * @file coro.hpp
+ * @brief C++20 coroutine reads for BARQ, CASIR and SAHM readers
+ *
+ * Write sensor logic as straight-line code instead of polling state machines:
+ * - co_await SIM::next(reader) suspends until the writer publishes
+ * - One Scheduler thread waits on all suspended readers (WaitSet, futex_waitv)
+ *   and resumes coroutines inline or on a small worker pool
+ * - Frames are zero-copy pointers into shared memory, valid until the next
+ *   read on the same reader (they survive any number of suspensions)
+ * - Coroutine frames come from FramePool, not the heap
+ *
+ * Usage (compile with -std=c++20):
+ *   SIM::Task fuse(BARQ::Reader& cam, SAHM::DirectReader& lidar) {
+ *       while (true) {
+ *           SIM::Frame img = co_await SIM::next(cam);
+ *           SIM::Frame pts = co_await SIM::next(lidar, 50);
+ *           if (img && pts) process(img.data(), pts.data());
+ *       }
+ *   }
+ *   SIM::Scheduler sched;
+ *   sched.spawn(fuse(cam, lidar));
+ *   sched.run();
+ *
+ * FramePool and Frame are available in C++17 builds; everything else needs
+ * compiler coroutine support.
+ */
+
+#ifndef CORO_HPP
+#define CORO_HPP
+
+#include "barq.hpp"
+#include "casir.hpp"
+#include "sahm.hpp"
+#include "wait_set.hpp"
+#include "work_queue.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#define SIM_HAS_COROUTINES 1
+#endif
+
+namespace SIM {
+
+/**
+ * @class FramePool
+ * @brief Size-class pool for coroutine frames
+ *
+ * Power-of-two classes from 64B to 16KB, carved from 64-block chunks and
+ * recycled through per-class free lists. Larger frames use operator new.
+ * Memory is kept for reuse until process exit.
+ */
+class FramePool {
+public:
+    static constexpr size_t MIN_BLOCK = 64;
+    static constexpr size_t NUM_CLASSES = 9;        // 64B .. 16KB
+    static constexpr size_t BLOCKS_PER_CHUNK = 64;
+    
+    /**
+     * @brief Process-wide pool used by Task
+     */
+    static FramePool& instance();
+    
+    void* allocate(size_t size);
+    void deallocate(void* ptr, size_t size) noexcept;
+    
+    uint64_t getAllocations() const { return allocations_.load(std::memory_order_relaxed); }
+    uint64_t getHeapAllocations() const { return heap_allocations_.load(std::memory_order_relaxed); }
+
+private:
+    FramePool();
+    ~FramePool();
+    
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    
+    struct alignas(CACHE_LINE_SIZE) SizeClass {
+        std::atomic_flag lock;
+        FreeBlock* free_list;
+    };
+    
+    static int classIndex(size_t size);
+    
+    SizeClass classes_[NUM_CLASSES];
+    std::mutex chunks_mutex_;
+    std::vector<void*> chunks_;
+    std::atomic<uint64_t> allocations_;
+    std::atomic<uint64_t> heap_allocations_;
+};
+
+/**
+ * @class Frame
+ * @brief Zero-copy view of one published message (move-only)
+ *
+ * Points straight into shared memory. For CASIR the zero-copy lock is
+ * released when the Frame is destroyed or reset.
+ */
+class Frame {
+public:
+    Frame() : data_(nullptr), size_(0), timestamp_ns_(0), release_(nullptr), owner_(nullptr) {}
+    
+    Frame(const void* data, size_t size, int64_t timestamp_ns,
+          void (*release)(void*) = nullptr, void* owner = nullptr)
+        : data_(data), size_(size), timestamp_ns_(timestamp_ns)
+        , release_(data ? release : nullptr), owner_(owner) {}
+    
+    ~Frame() { reset(); }
+    
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+    
+    Frame(Frame&& other) noexcept
+        : data_(other.data_), size_(other.size_), timestamp_ns_(other.timestamp_ns_)
+        , release_(other.release_), owner_(other.owner_)
+    {
+        other.data_ = nullptr;
+        other.release_ = nullptr;
+    }
+    
+    Frame& operator=(Frame&& other) noexcept {
+        if (this != &other) {
+            reset();
+            data_ = other.data_;
+            size_ = other.size_;
+            timestamp_ns_ = other.timestamp_ns_;
+            release_ = other.release_;
+            owner_ = other.owner_;
+            other.data_ = nullptr;
+            other.release_ = nullptr;
+        }
+        return *this;
+    }
+    
+    void reset() {
+        if (release_) release_(owner_);
+        data_ = nullptr;
+        size_ = 0;
+        release_ = nullptr;
+    }
+    
+    const void* data() const { return data_; }
+    size_t size() const { return size_; }
+    int64_t timestampNs() const { return timestamp_ns_; }
+    explicit operator bool() const { return data_ != nullptr; }
+
+private:
+    const void* data_;
+    size_t size_;
+    int64_t timestamp_ns_;
+    void (*release_)(void*);
+    void* owner_;
+};
+
+/**
+ * @brief Consume the latest message of a reader as a Frame
+ *
+ * Empty when nothing was published since the last fetch, so an awaiter
+ * that timed out never hands back a frame it already returned.
+ */
+inline Frame fetchFrame(BARQ::Reader& reader) {
+    size_t size = 0;
+    int64_t timestamp_ns = 0;
+    const void* data = reader.getLatest(size, timestamp_ns);
+    return Frame(data, size, timestamp_ns);
+}
+
+inline Frame fetchFrame(CASIR::Reader& reader) {
+    size_t size = 0;
+    const void* data = reader.readZeroCopy(size);
+    return Frame(data, size, reader.getLastTimestampNs(),
+                 [](void* owner) { static_cast<CASIR::Reader*>(owner)->releaseZeroCopy(); },
+                 &reader);
+}
+
+inline Frame fetchFrame(SAHM::DirectReader& reader) {
+    // getLatest() returns the newest slot even when it was already seen
+    if (!reader.hasNewData()) return Frame();
+    size_t size = 0;
+    const void* data = reader.getLatest(size);
+    return Frame(data, size, data ? reader.getLatestTimestampNs() : 0);
+}
+
+#ifdef SIM_HAS_COROUTINES
+
+class Scheduler;
+
+/**
+ * @class Task
+ * @brief Detached coroutine started by Scheduler::spawn()
+ *
+ * Starts suspended; the frame is freed when the coroutine returns.
+ */
+class Task {
+public:
+    struct promise_type {
+        Scheduler* scheduler = nullptr;
+        
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+            void await_resume() noexcept {}
+        };
+        
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+        
+        static void* operator new(size_t size) {
+            return FramePool::instance().allocate(size);
+        }
+        static void operator delete(void* ptr, size_t size) noexcept {
+            FramePool::instance().deallocate(ptr, size);
+        }
+    };
+    
+    using Handle = std::coroutine_handle<promise_type>;
+    
+    Task(Task&& other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = other.handle_;
+            other.handle_ = nullptr;
+        }
+        return *this;
+    }
+    ~Task() { if (handle_) handle_.destroy(); }
+    
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+private:
+    friend class Scheduler;
+    explicit Task(Handle handle) : handle_(handle) {}
+    
+    Handle release() {
+        Handle handle = handle_;
+        handle_ = nullptr;
+        return handle;
+    }
+    
+    Handle handle_;
+};
+
+/**
+ * @struct Waiter
+ * @brief Suspended read, stored in the awaiting coroutine's frame
+ */
+struct Waiter {
+    NotifyWord* word;               // nullptr = poll ready()
+    bool (*ready)(void*);
+    void* ctx;
+    std::coroutine_handle<> handle;
+    int64_t deadline_ns;            // steady_clock, INT64_MAX = none
+    int channel;                    // WaitSet id (scheduler internal)
+};
+
+/**
+ * @class Scheduler
+ * @brief Resumes coroutines when their readers publish
+ *
+ * run() owns the WaitSet. With num_threads == 0 coroutines are resumed on
+ * the run() thread, otherwise on a pool of num_threads workers.
+ * A reader must not be awaited by two coroutines at the same time.
+ */
+class Scheduler {
+public:
+    explicit Scheduler(size_t num_threads = 0);
+    ~Scheduler();
+    
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+    
+    /**
+     * @brief Queue a coroutine; it starts on the next run() iteration
+     */
+    void spawn(Task&& task);
+    
+    /**
+     * @brief Run until every spawned coroutine returned or stop() is called
+     */
+    void run();
+    
+    /**
+     * @brief Make run() return (suspended coroutines are destroyed with the Scheduler)
+     */
+    void stop();
+    
+    size_t getActiveCount() const { return live_.load(std::memory_order_acquire); }
+    
+    /**
+     * @brief Spin/yield budget of the run() thread before parking
+     */
+    void setWaitStrategy(const WaitStrategy& strategy) { wait_set_.setWaitStrategy(strategy); }
+    
+    // Awaiter interface
+    void suspend(Waiter* waiter);
+    void taskDone();
+
+private:
+    void dispatch(std::coroutine_handle<> handle);
+    void watch(Waiter* waiter);
+    void unwatch(Waiter* waiter);
+    void workerLoop();
+    
+    size_t num_threads_;
+    std::atomic<bool> stop_;
+    std::atomic<size_t> live_;
+    
+    // Incoming work from spawn()/suspend(), any thread
+    std::mutex mutex_;
+    std::vector<std::coroutine_handle<>> spawned_;
+    std::vector<Waiter*> incoming_;
+    NotifyWord control_;
+    
+    // Owned by the run() thread
+    WaitSet wait_set_;
+    int control_id_;
+    std::vector<Waiter*> by_channel_;
+    std::vector<Waiter*> polled_;       // No notify word or WaitSet full
+    
+    // Worker pool
+    std::vector<std::thread> workers_;
+    BoundedQueue<void*> run_queue_;
+    NotifyWord work_;
+};
+
+/**
+ * @class NextFrame
+ * @brief Awaitable returned by SIM::next()
+ */
+template <typename Reader>
+class NextFrame {
+public:
+    NextFrame(Reader& reader, uint32_t timeout_ms)
+        : reader_(reader), timeout_ms_(timeout_ms) {}
+    
+    bool await_ready() { return reader_.hasNewData(); }
+    
+    void await_suspend(std::coroutine_handle<Task::promise_type> handle) {
+        waiter_.word = reader_.getNotifyWord();
+        waiter_.ready = &NextFrame::ready;
+        waiter_.ctx = &reader_;
+        waiter_.handle = handle;
+        waiter_.deadline_ns = INT64_MAX;
+        waiter_.channel = -1;
+        if (timeout_ms_ != WAIT_FOREVER) {
+            waiter_.deadline_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count() +
+                static_cast<int64_t>(timeout_ms_) * 1000000;
+        }
+        // Last access to this frame: the scheduler may resume it right away
+        handle.promise().scheduler->suspend(&waiter_);
+    }
+    
+    /**
+     * @return Latest frame, or an empty Frame on timeout
+     */
+    Frame await_resume() { return fetchFrame(reader_); }
+    
+    static constexpr uint32_t WAIT_FOREVER = UINT32_MAX;
+
+private:
+    static bool ready(void* ctx) { return static_cast<Reader*>(ctx)->hasNewData(); }
+    
+    Reader& reader_;
+    uint32_t timeout_ms_;
+    Waiter waiter_;
+};
+
+/**
+ * @brief Suspend until reader has a new message, then consume it
+ * @param timeout_ms Give up after this long (empty Frame), default forever
+ */
+template <typename Reader>
+NextFrame<Reader> next(Reader& reader, uint32_t timeout_ms = NextFrame<Reader>::WAIT_FOREVER) {
+    return NextFrame<Reader>(reader, timeout_ms);
+}
+
+#endif // SIM_HAS_COROUTINES
+
+} // namespace SIM
+
+#endif // CORO_HPP
@@ -0,0 +1,210 @@
+/**
+ * @file derived.hpp
+ * @brief Lazy derived channels (downscale, grayscale, crop...)
+ *
+ * A derived channel is a pure function of one or more source channels,
+ * evaluated on demand:
+ * - Nothing is computed until a DerivedReader asks for data newer than
+ *   the cached result
+ * - The result is memoized per source sequence, so any number of readers
+ *   share one computation per source frame
+ * - Results live in a small ring of buffers (zero-copy for readers)
+ *
+ * DerivedReader has the usual reader surface (getLatest, hasNewData,
+ * waitForData, getNotifyWord), so it works with WaitSet, Executor,
+ * Pipeline sources and co_await SIM::next().
+ *
+ * Usage:
+ *   SIM::DerivedChannel gray("gray", W * H,
+ *       [](const std::vector<SIM::DerivedInput>& in, void* out, size_t cap) {
+ *           return toGray(in[0].data, in[0].size, out, cap);   // bytes written
+ *       });
+ *   gray.addSource(camera_reader);
+ *   SIM::DerivedReader r1(gray), r2(gray);     // one conversion per frame
+ *   size_t sz; int64_t ts;
+ *   const void* img = r1.getLatest(sz, ts);
+ */
+
+#ifndef DERIVED_HPP
+#define DERIVED_HPP
+
+#include "coro.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace SIM {
+
+/**
+ * @struct DerivedInput
+ * @brief Latest frame of one source, as seen by the derive function
+ */
+struct DerivedInput {
+    const void* data;
+    size_t size;
+    int64_t timestamp_ns;
+    uint64_t sequence;      // Frames consumed from this source so far
+};
+
+/**
+ * @brief Derive function: fill out (capacity bytes) from inputs
+ * @return Bytes written, 0 to publish nothing for this source sequence
+ */
+using DeriveFn = std::function<size_t(const std::vector<DerivedInput>& inputs,
+                                      void* out, size_t capacity)>;
+
+/**
+ * @struct DerivedStats
+ * @brief Computation counters
+ */
+struct DerivedStats {
+    uint64_t requests;      // getLatest() calls that needed a fresh check
+    uint64_t computations;  // Derive function invocations
+    uint64_t shared;        // Requests served from the memoized result
+};
+
+/**
+ * @class DerivedChannel
+ * @brief Memoized, demand-driven function of source channels
+ */
+class DerivedChannel {
+public:
+    static constexpr size_t DEFAULT_DEPTH = 3;
+    
+    /**
+     * @param max_size Result buffer size
+     * @param depth Result buffers; a returned pointer stays valid for
+     *              depth - 1 further computations
+     */
+    DerivedChannel(const std::string& name, size_t max_size, DeriveFn fn,
+                   size_t depth = DEFAULT_DEPTH);
+    ~DerivedChannel();
+    
+    DerivedChannel(const DerivedChannel&) = delete;
+    DerivedChannel& operator=(const DerivedChannel&) = delete;
+    
+    /**
+     * @brief Add a source reader (BARQ, CASIR, SAHM or another DerivedReader)
+     *
+     * The channel consumes from the reader; do not read it elsewhere.
+     * Sources must be added before the first read.
+     */
+    template <typename Reader>
+    bool addSource(Reader& reader) {
+        return addSource(reader.getNotifyWord(),
+                         [&reader] { return reader.hasNewData(); },
+                         [&reader] { return fetchFrame(reader); });
+    }
+    
+    bool addSource(NotifyWord* word, std::function<bool()> has_data,
+                   std::function<Frame()> fetch);
+    
+    const std::string& getName() const { return name_; }
+    size_t getMaxSize() const { return max_size_; }
+    size_t getSourceCount() const { return sources_.size(); }
+    DerivedStats getStats() const;
+
+private:
+    friend class DerivedReader;
+    
+    struct Source {
+        NotifyWord* word;
+        std::function<bool()> has_data;
+        std::function<Frame()> fetch;
+        Frame current;
+        uint64_t sequence;
+    };
+    
+    struct Result {
+        uint8_t* data;
+        size_t size;
+        int64_t timestamp_ns;
+    };
+    
+    /**
+     * @brief Recompute if any source moved on
+     * @param out Current result (valid if the returned version is > 0)
+     * @param computed Set if this call ran the derive function
+     * @return Current version (0 = nothing derived yet)
+     */
+    uint64_t refresh(Result& out, bool& computed);
+    bool sourcesChanged() const;
+    
+    std::string name_;
+    size_t max_size_;
+    DeriveFn fn_;
+    size_t depth_;
+    
+    mutable std::mutex mutex_;
+    std::vector<Source> sources_;
+    std::vector<DerivedInput> inputs_;
+    std::unique_ptr<uint8_t[]> storage_;
+    std::vector<Result> results_;
+    std::atomic<uint64_t> version_;     // Results published (0 = none)
+    
+    std::atomic<uint64_t> stat_requests_;
+    std::atomic<uint64_t> stat_computations_;
+    std::atomic<uint64_t> stat_shared_;
+};
+
+/**
+ * @class DerivedReader
+ * @brief Per-consumer cursor on a DerivedChannel (one thread at a time)
+ */
+class DerivedReader {
+public:
+    explicit DerivedReader(DerivedChannel& channel)
+        : channel_(channel), last_version_(0), last_timestamp_ns_(0)
+        , wait_strategy_(WaitStrategy::adaptive()) {}
+    
+    /**
+     * @brief Latest derived result, computing it if stale
+     * @return Pointer to result, nullptr if nothing newer than last call
+     */
+    const void* getLatest(size_t& size, int64_t& timestamp_ns);
+    
+    /**
+     * @brief New result available, or a source published since the last compute
+     */
+    bool hasNewData() const;
+    
+    /**
+     * @brief Wait until hasNewData() (sources' wait strategy: adaptive)
+     */
+    bool waitForData(uint32_t timeout_ms);
+    
+    void setWaitStrategy(const WaitStrategy& strategy) { wait_strategy_ = strategy; }
+    
+    /**
+     * @brief Notify word of the first source (for WaitSet/executors)
+     *
+     * Blocking waits follow the first source; publishes on the others
+     * are picked up on the next check.
+     */
+    NotifyWord* getNotifyWord() const;
+    
+    uint64_t getLastVersion() const { return last_version_; }
+    int64_t getLastTimestampNs() const { return last_timestamp_ns_; }
+
+private:
+    DerivedChannel& channel_;
+    uint64_t last_version_;
+    int64_t last_timestamp_ns_;
+    WaitStrategy wait_strategy_;
+};
+
+inline Frame fetchFrame(DerivedReader& reader) {
+    size_t size = 0;
+    int64_t timestamp_ns = 0;
+    const void* data = reader.getLatest(size, timestamp_ns);
+    return Frame(data, size, timestamp_ns);
+}
+
+} // namespace SIM
+
+#endif // DERIVED_HPP
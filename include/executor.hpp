@@ -0,0 +1,281 @@
+/**
+ * @file executor.hpp
+ * @brief Subscription Executor - callbacks on a fixed worker pool
+ *
+ * Replaces one polling thread per channel:
+ * - Dispatcher threads wait on up to 126 channels each (WaitSet, futex_waitv)
+ * - Ready subscriptions are queued once, however many frames arrived
+ *   (coalescing), and never run concurrently with themselves
+ * - Workers pop from Chase-Lev deques by priority and steal when idle
+ * - Parked workers are woken once per dispatch batch, not per frame
+ *
+ * Usage:
+ *   SIM::Executor exec(SIM::ExecutorConfig::defaults());
+ *   exec.subscribe(camera_reader, [&] {
+ *       size_t sz; int64_t ts;
+ *       if (auto* p = camera_reader.getLatest(sz, ts)) process(p, sz);
+ *   });
+ *   exec.start();
+ */
+
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include "wait_set.hpp"
+#include "work_queue.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SIM {
+
+/**
+ * @enum Priority
+ * @brief Callback priority (higher runs first)
+ */
+enum class Priority : uint32_t {
+    Low = 0,
+    Normal = 1,
+    High = 2
+};
+
+constexpr size_t PRIORITY_LEVELS = 3;
+
+/**
+ * @struct SubscriptionOptions
+ * @brief Per-callback scheduling hints
+ */
+struct SubscriptionOptions {
+    Priority priority;      // Queue level
+    int cpu_hint;           // Prefer the worker pinned to this CPU (-1 = any)
+    
+    static SubscriptionOptions defaults() {
+        SubscriptionOptions opts;
+        opts.priority = Priority::Normal;
+        opts.cpu_hint = -1;
+        return opts;
+    }
+    
+    static SubscriptionOptions withPriority(Priority priority, int cpu_hint = -1) {
+        SubscriptionOptions opts;
+        opts.priority = priority;
+        opts.cpu_hint = cpu_hint;
+        return opts;
+    }
+};
+
+/**
+ * @struct ExecutorConfig
+ * @brief Worker pool configuration
+ */
+struct ExecutorConfig {
+    size_t num_workers;             // Worker threads (0 = auto)
+    std::vector<int> worker_cpus;   // Optional pinning, worker_cpus[i] for worker i
+    int dispatcher_cpu;             // Pin dispatcher threads (-1 = none)
+    WaitStrategy wait_strategy;     // Dispatcher wait before parking
+    
+    /**
+     * @brief One worker per 4 online cores (min 1), no pinning
+     */
+    static ExecutorConfig defaults() {
+        ExecutorConfig cfg;
+        auto cache = CacheUtils::detectCacheInfo();
+        cfg.num_workers = cache.num_cores > 4 ? static_cast<size_t>(cache.num_cores / 4) : 1;
+        cfg.dispatcher_cpu = -1;
+        cfg.wait_strategy = WaitStrategy::adaptive();
+        return cfg;
+    }
+    
+    /**
+     * @brief Fixed worker count pinned to the given CPUs
+     */
+    static ExecutorConfig pinned(const std::vector<int>& cpus, int dispatcher_cpu = -1) {
+        ExecutorConfig cfg;
+        cfg.num_workers = cpus.empty() ? 1 : cpus.size();
+        cfg.worker_cpus = cpus;
+        cfg.dispatcher_cpu = dispatcher_cpu;
+        cfg.wait_strategy = WaitStrategy::adaptive();
+        return cfg;
+    }
+};
+
+/**
+ * @struct ExecutorStats
+ * @brief Runtime counters
+ */
+struct ExecutorStats {
+    uint64_t dispatched;    // Subscriptions queued
+    uint64_t executed;      // Callbacks run
+    uint64_t coalesced;     // Notifications merged into a queued/running callback
+    uint64_t stolen;        // Tasks taken from another worker
+    uint64_t wakeups;       // FUTEX_WAKE calls issued to workers
+};
+
+/**
+ * @class Executor
+ * @brief Owns channel subscriptions and runs their callbacks on a worker pool
+ */
+class Executor {
+public:
+    static constexpr size_t MAX_SUBSCRIPTIONS = 4096;   // Live at once; slots are recycled
+    static constexpr size_t CHANNELS_PER_DISPATCHER = WaitSet::MAX_CHANNELS - 1;
+    
+    explicit Executor(const ExecutorConfig& config = ExecutorConfig::defaults());
+    ~Executor();
+    
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+    
+    /**
+     * @brief Subscribe a callback to any transport reader
+     *
+     * The callback runs on a worker when the channel publishes; it should
+     * consume the data itself (getLatest()/readZeroCopy()...). A callback
+     * never runs concurrently with itself, so the reader needs no locking.
+     *
+     * @return Subscription id, or -1 if full
+     */
+    template <typename Reader>
+    int subscribe(Reader& reader, std::function<void()> callback,
+                  const SubscriptionOptions& options = SubscriptionOptions::defaults()) {
+        return subscribe(reader.getNotifyWord(), [&reader] { return reader.hasNewData(); },
+                         std::move(callback), options);
+    }
+    
+    /**
+     * @brief Subscribe with a raw notify word and/or readiness predicate
+     *
+     * Slots of removed subscriptions are reused once the dispatcher has
+     * dropped them; the id carries a generation, so a stale id is
+     * rejected rather than reaching the new subscription.
+     */
+    int subscribe(NotifyWord* word, std::function<bool()> has_data,
+                  std::function<void()> callback,
+                  const SubscriptionOptions& options = SubscriptionOptions::defaults());
+    
+    /**
+     * @brief Remove a subscription
+     *
+     * Returns once the callback is no longer queued or running. From
+     * inside the subscription's own callback it returns at once: the
+     * callback finishes and is not run again.
+     */
+    bool unsubscribe(int id);
+    
+    /**
+     * @brief Queue a subscription's callback as if its channel had published
+     *
+     * Safe from any thread, including callbacks. Coalesces like a publish.
+     */
+    bool trigger(int id);
+    
+    /**
+     * @brief Start dispatcher and worker threads
+     */
+    bool start();
+    
+    /**
+     * @brief Stop and join all threads (pending callbacks are dropped)
+     */
+    void stop();
+    
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+    size_t getWorkerCount() const { return config_.num_workers; }
+    ExecutorStats getStats() const;
+
+private:
+    // Subscription id = generation << SLOT_BITS | slot
+    static constexpr int SLOT_BITS = 12;
+    static constexpr uint32_t GENERATION_MASK = (1u << (31 - SLOT_BITS)) - 1;
+    static_assert(MAX_SUBSCRIPTIONS <= (size_t(1) << SLOT_BITS), "Slot index must fit the id");
+    
+    enum TaskState : uint32_t {
+        IDLE = 0,
+        QUEUED = 1,
+        RUNNING = 2,
+        RUNNING_DIRTY = 3   // Published again while running: re-run once
+    };
+    
+    struct Subscription {
+        NotifyWord* word;
+        std::function<bool()> has_data;
+        std::function<void()> callback;
+        SubscriptionOptions options;
+        std::atomic<uint32_t> state;
+        std::atomic<bool> cancelled;
+        int shard;
+        int channel_id;     // Id inside the shard WaitSet
+        uint32_t generation;        // Bumped on reuse, part of the id
+        uint32_t remove_ticket;     // Shard command that drops it
+    };
+    
+    struct Command {
+        Subscription* sub;
+        bool add;
+    };
+    
+    struct Shard {
+        std::thread thread;
+        WaitSet wait_set;
+        NotifyWord control;
+        int control_id;
+        std::mutex mutex;
+        std::vector<Command> commands;
+        std::vector<Subscription*> by_channel;
+        std::atomic<uint32_t> applied;  // Commands applied so far
+        uint32_t submitted;             // Guarded by mutex
+        size_t count;
+    };
+    
+    struct Worker {
+        explicit Worker(size_t capacity);
+        std::thread thread;
+        int cpu;
+        std::unique_ptr<WorkStealingDeque<Subscription>> deques[PRIORITY_LEVELS];
+        BoundedQueue<Subscription*> inbox;
+    };
+    
+    void dispatchLoop(Shard* shard);
+    void applyCommands(Shard* shard);
+    bool notify(Subscription* sub);
+    size_t route(Subscription* sub);
+    void workerLoop(size_t index);
+    Subscription* nextTask(size_t index);
+    void run(size_t index, Subscription* sub);
+    void startShard(Shard* shard);
+    uint32_t submit(Shard* shard, const Command& cmd);
+    Subscription* lookup(int id);
+    void reclaim();
+    
+    ExecutorConfig config_;
+    std::atomic<bool> running_;
+    std::atomic<bool> stop_;
+    
+    std::mutex subs_mutex_;
+    std::vector<std::unique_ptr<Subscription>> subs_;
+    std::vector<size_t> retired_;       // Cancelled, removal maybe not applied yet
+    std::vector<size_t> free_;          // Reusable slots
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_worker_;
+    
+    // Worker parking (coalesced wake-ups)
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> work_seq_;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> idle_workers_;
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> pending_;
+    
+    std::atomic<uint64_t> stat_dispatched_;
+    std::atomic<uint64_t> stat_executed_;
+    std::atomic<uint64_t> stat_coalesced_;
+    std::atomic<uint64_t> stat_stolen_;
+    std::atomic<uint64_t> stat_wakeups_;
+};
+
+} // namespace SIM
+
+#endif // EXECUTOR_HPP
@@ -0,0 +1,38 @@
+/**
+ * @file gather.hpp
+ * @brief Scatter-gather copy used by the writers' writev() APIs
+ *
+ * Copies an iovec array (header struct + payload planes...) straight into
+ * a back buffer or ring slot, without a staging buffer:
+ * - Small leading segments are coalesced into one store sequence
+ * - The non-temporal path streams 16-byte chunks across segment
+ *   boundaries (a carry register joins the tails) with one sfence at the end
+ */
+
+#ifndef GATHER_HPP
+#define GATHER_HPP
+
+#include <sys/uio.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace SIM {
+
+// Leading segments up to this size in total are coalesced
+constexpr size_t GATHER_COALESCE_BYTES = 256;
+
+/**
+ * @brief Total byte count of an iovec array
+ * @return SIZE_MAX if iovcnt < 0 or the sum overflows
+ */
+size_t iovecSize(const struct iovec* iov, int iovcnt);
+
+/**
+ * @brief Copy all segments back to back into dst
+ * @param non_temporal Use streaming stores (bypass cache) where available
+ */
+void gatherCopy(void* dst, const struct iovec* iov, int iovcnt, bool non_temporal);
+
+} // namespace SIM
+
+#endif // GATHER_HPP
@@ -0,0 +1,133 @@
+/**
+ * @file gc.hpp
+ * @brief Segment GC - find and reclaim shared memory left behind by crashes
+ *
+ * A crashed process leaves its segments in /dev/shm: BARQ/CASIR/SIM
+ * channels, SAHM control channels, per-reader SAHM rings
+ * (/<channel>_reader_<pid>), Mux segments and phase boards
+ * (<channel>@phase). The GC recognizes them by their magic and decides
+ * liveness, in order:
+ * - Owner pid recorded in the header (reader pid for rings) still
+ *   exists, or heartbeat younger than the grace time -> live
+ * - No owner recorded (provisioned or cleanly detached) -> parked
+ * - Otherwise dead, unless the owner lock is held: writers (and SAHM
+ *   readers, Mux owners, phase participants) keep a shared flock() on
+ *   their segment while attached, which also covers owners in other pid
+ *   namespaces
+ *
+ * Reclaiming takes the lock exclusively (a writer attaching meanwhile
+ * recreates the segment instead of using it), re-checks the header, and
+ * moves the name away before unlinking so a recreated segment never gets
+ * removed. Dead SAHM readers are also dropped from their control channel.
+ *
+ * Usage:
+ *   std::vector<SIM::SegmentInfo> report;
+ *   size_t reclaimed = SIM::collectGarbage(SIM::GcConfig::defaults(), &report);
+ */
+
+#ifndef GC_HPP
+#define GC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SIM {
+
+/**
+ * @enum SegmentKind
+ * @brief Library segment types recognized by magic
+ */
+enum class SegmentKind : uint32_t {
+    Unknown = 0,
+    SIM,
+    BARQ,
+    CASIR,
+    SahmControl,
+    SahmRing,
+    Mux,
+    Phase
+};
+
+const char* segmentKindName(SegmentKind kind);
+
+/**
+ * @enum SegmentState
+ * @brief Liveness verdict
+ */
+enum class SegmentState : uint32_t {
+    Live = 0,       // Locked, owner running or recent heartbeat
+    Parked,         // No owner recorded: provisioned or cleanly detached
+    Dead            // Owner gone and heartbeat stale
+};
+
+const char* segmentStateName(SegmentState state);
+
+/**
+ * @struct SegmentInfo
+ * @brief One library segment found in the shm directory
+ */
+struct SegmentInfo {
+    std::string name;       // POSIX name ("/channel")
+    SegmentKind kind;
+    SegmentState state;
+    size_t bytes;
+    int32_t owner_pid;      // Writer (reader for SAHM rings), 0 = none recorded
+    bool locked;            // Looked reclaimable but a live owner holds the lock
+    int64_t idle_ns;        // Since the last heartbeat (-1 = no heartbeat)
+    bool reclaimed;
+};
+
+/**
+ * @struct GcConfig
+ * @brief Collection policy
+ */
+struct GcConfig {
+    std::string shm_dir;    // Where POSIX shm names live
+    uint32_t grace_ms;      // Heartbeats younger than this count as alive
+    bool collect_parked;    // Also reclaim parked segments idle for grace_ms
+    
+    static GcConfig defaults() {
+        GcConfig cfg;
+        cfg.shm_dir = "/dev/shm";
+        cfg.grace_ms = 5000;
+        cfg.collect_parked = false;
+        return cfg;
+    }
+    
+    static GcConfig withParked(uint32_t grace_ms) {
+        GcConfig cfg = defaults();
+        cfg.grace_ms = grace_ms;
+        cfg.collect_parked = true;
+        return cfg;
+    }
+};
+
+/**
+ * @brief pid exists (possibly owned by another user)
+ */
+bool processAlive(int32_t pid);
+
+/**
+ * @brief Find and classify every library segment (nothing is removed)
+ * @return Number of segments found
+ */
+size_t scanSegments(std::vector<SegmentInfo>& out, const GcConfig& config = GcConfig::defaults());
+
+/**
+ * @brief Whether collectGarbage() would reclaim this segment
+ */
+bool isReclaimable(const SegmentInfo& info, const GcConfig& config = GcConfig::defaults());
+
+/**
+ * @brief Reclaim dead (and optionally parked) segments
+ * @param report Every segment found, with reclaimed set (optional)
+ * @return Number of segments removed
+ */
+size_t collectGarbage(const GcConfig& config = GcConfig::defaults(),
+                      std::vector<SegmentInfo>* report = nullptr);
+
+} // namespace SIM
+
+#endif // GC_HPP
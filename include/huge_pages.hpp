@@ -0,0 +1,136 @@
+/**
+ * @file huge_pages.hpp
+ * @brief Huge page strategy - where a segment gets its huge pages from
+ *
+ * MAP_HUGETLB only applies to anonymous and hugetlbfs mappings: asked for
+ * on a /dev/shm fd it always failed and writers silently fell back. Huge
+ * pages now come with the segment, tried in this order:
+ * - hugetlb: a file on a hugetlbfs mount (named channels) or an
+ *   MFD_HUGETLB memfd (anonymous and brokered channels), when the pool
+ *   has enough free pages that other mappings have not reserved
+ * - shmem THP: the tmpfs segment is mapped 2MB-aligned and advised with
+ *   MADV_HUGEPAGE before the first fault; whether the kernel complies is
+ *   up to shmem_enabled (memfds) or the huge= option of /dev/shm
+ * - regular pages
+ *
+ * What backs a mapping is then read from /proc/self/smaps, and that is
+ * what writers record in the header flags and report in their stats.
+ *
+ * SIM_HUGEPAGES=auto|hugetlb|thp|off restricts the choice for a process.
+ * SIM_HUGETLBFS=<dir> overrides the hugetlbfs mount used for named segments.
+ *
+ * Usage:
+ *   SIM::PageReport pages = writer.getPageReport();
+ *   printf("%s, %zu bytes huge\n", SIM::backingName(pages.backing), pages.huge_bytes);
+ */
+
+#ifndef HUGE_PAGES_HPP
+#define HUGE_PAGES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace SIM {
+
+// Header flags bits (BARQ/CASIR Header::flags)
+constexpr uint32_t SEGMENT_FLAG_HUGETLB = 0x1;
+constexpr uint32_t SEGMENT_FLAG_THP = 0x2;
+
+/**
+ * @brief Pages backing a mapping, as the kernel reports them
+ */
+enum class PageBacking : uint32_t {
+    Regular = 0,
+    Hugetlb = 1,        // hugetlbfs file or MFD_HUGETLB memfd
+    THP = 2             // Transparent huge pages of a tmpfs segment (possibly partly)
+};
+
+/**
+ * @brief Result of inspectMapping()
+ */
+struct PageReport {
+    PageBacking backing;
+    size_t page_size;       // Huge page size, or the base page size if none
+    size_t huge_bytes;      // Bytes currently mapped by huge pages
+
+    uint32_t flags() const {
+        switch (backing) {
+            case PageBacking::Hugetlb: return SEGMENT_FLAG_HUGETLB;
+            case PageBacking::THP:     return SEGMENT_FLAG_THP;
+            default:                   return 0;
+        }
+    }
+};
+
+/**
+ * @brief Backings to try for a new segment
+ */
+struct HugePagePlan {
+    bool hugetlb;           // hugetlbfs file / MFD_HUGETLB memfd (pool can back it)
+    bool thp;               // MADV_HUGEPAGE on a tmpfs segment
+};
+
+/**
+ * @brief Choose the backings for a segment of size bytes
+ * @param wanted Caller asked for huge pages (use_huge_pages)
+ */
+HugePagePlan planHugePages(size_t size, bool wanted);
+
+/**
+ * @brief hugetlbfs directory for named segments ("" if none is usable)
+ */
+std::string hugetlbfsMount();
+
+/**
+ * @brief Open a named segment: /dev/shm first, then the hugetlbfs mount
+ * @return fd (close-on-exec), or -1 with errno set by the last attempt
+ */
+int openNamedSegment(const std::string& name, int flags);
+
+/**
+ * @brief Create a named segment of size bytes, replacing any existing one
+ * @param hugetlb Try the hugetlbfs mount first (falls back to /dev/shm)
+ * @return fd, or -1
+ */
+int createNamedSegment(const std::string& name, size_t size, bool hugetlb);
+
+/**
+ * @brief Remove a named segment wherever it lives
+ * @return 0 if something was removed
+ */
+int unlinkNamedSegment(const std::string& name);
+
+/**
+ * @brief fd still has a name (the GC unlinks segments under LOCK_EX)
+ *
+ * Checked after taking the shared owner lock: an fd opened just before
+ * the GC removed the name would otherwise lock an orphaned inode that
+ * readers can no longer open.
+ */
+bool segmentLinked(int fd);
+
+/**
+ * @brief mmap(MAP_SHARED) a segment fd, prepared for THP if huge is set
+ *
+ * tmpfs segments are mapped at a 2MB boundary and advised with
+ * MADV_HUGEPAGE before populate faults them in. hugetlb segments are
+ * mapped as they are.
+ *
+ * @return Mapping, or MAP_FAILED
+ */
+void* mapSegment(int fd, size_t size, int prot, bool populate, bool huge);
+
+/**
+ * @brief What backs [addr, addr + size) right now (/proc/self/smaps)
+ */
+PageReport inspectMapping(const void* addr, size_t size);
+
+/**
+ * @brief "regular", "hugetlb" or "thp"
+ */
+const char* backingName(PageBacking backing);
+
+} // namespace SIM
+
+#endif // HUGE_PAGES_HPP
@@ -0,0 +1,86 @@
+/**
+ * @file idle.hpp
+ * @brief Idle Policy - give back buffer memory while a channel is quiet
+ *
+ * A 50MB channel published every few minutes keeps both buffers resident
+ * and mlocked. With an idle policy the writer releases its back buffer
+ * (unlock + punch hole) once the channel has been quiet long enough, and
+ * re-populates it before the next publish. The front buffer stays, so
+ * readers still see the latest frame.
+ *
+ * Release runs on the writer's thread (releaseIfIdle() from its loop or
+ * a timer), so the publish path only pays one predictable branch.
+ *
+ * Usage:
+ *   SIM::IdlePolicy policy = SIM::IdlePolicy::after(30000);
+ *   policy.warmup = [](void* buf, size_t size) { prepareTemplate(buf, size); };
+ *   writer.setIdlePolicy(policy);
+ *   ...
+ *   writer.releaseIfIdle();        // periodically
+ *   writer.prepare();              // optional: re-inflate ahead of a publish
+ */
+
+#ifndef IDLE_HPP
+#define IDLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace SIM {
+
+/**
+ * @struct IdlePolicy
+ * @brief When to release, and what to run after re-inflating
+ */
+struct IdlePolicy {
+    uint32_t quiet_ms;                                  // 0 = never release
+    std::function<void(void* buffer, size_t size)> warmup;  // After re-populating (optional)
+    
+    static IdlePolicy disabled() {
+        IdlePolicy policy;
+        policy.quiet_ms = 0;
+        return policy;
+    }
+    
+    static IdlePolicy after(uint32_t quiet_ms) {
+        IdlePolicy policy;
+        policy.quiet_ms = quiet_ms;
+        return policy;
+    }
+};
+
+/**
+ * @struct IdleStats
+ * @brief Memory given back and the cost of getting it again
+ */
+struct IdleStats {
+    uint64_t releases;
+    uint64_t reinflations;
+    size_t released_bytes;          // Back buffer bytes released right now
+    size_t resident_bytes;          // Segment bytes resident in this mapping
+    size_t segment_bytes;
+    int64_t last_reinflate_ns;      // Populate + lock + warm-up of the last re-inflation
+};
+
+/**
+ * @brief Unlock and free the whole pages of [offset, offset + len) of a mapped segment
+ * @param fd Segment fd (hole punched through it; MADV_REMOVE if unsupported)
+ * @param page Page size of the mapping
+ * @return Bytes released (0 if the range holds no whole page)
+ */
+size_t releasePages(int fd, void* base, size_t offset, size_t len, size_t page);
+
+/**
+ * @brief Fault the whole pages of a released range back in (and mlock them)
+ */
+void populatePages(void* base, size_t offset, size_t len, size_t page, bool lock);
+
+/**
+ * @brief Bytes of [addr, addr + len) resident in memory
+ */
+size_t residentBytes(const void* addr, size_t len);
+
+} // namespace SIM
+
+#endif // IDLE_HPP
@@ -0,0 +1,172 @@
+/**
+ * @file memfd.hpp
+ * @brief Anonymous segments - memfd channels handed over Unix sockets
+ *
+ * shm_open() names are global (channels of containers sharing /dev/shm
+ * collide), outlive crashed writers, and cannot use huge pages: tmpfs
+ * rejects MAP_HUGETLB. An anonymous BARQ/CASIR writer instead:
+ * - Creates its segment with memfd_create(), with MFD_HUGETLB when the
+ *   segment is a multiple of 2MB and the huge page pool can back it
+ * - Seals it against shrinking: a mapping can never be cut short, so
+ *   readers skip the size check (growing stays allowed for resize())
+ * - Serves the fd on the abstract socket "sim_seg<channel>", which is
+ *   per network namespace; readers receive it with SCM_RIGHTS
+ *
+ * Nothing is left behind: the segment goes away with the last mapping.
+ * Readers try the broker, then an anonymous writer, then shm_open().
+ * SIM_SEGMENTS=memfd makes every writer of the process anonymous.
+ *
+ * Usage:
+ *   BARQ::Writer writer("/camera", 8 << 20);
+ *   writer.setAnonymous(true);
+ *   writer.init();
+ *
+ *   BARQ::Reader reader("/camera", 8 << 20);     // unchanged
+ */
+
+#ifndef MEMFD_HPP
+#define MEMFD_HPP
+
+#include "gc.hpp"
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace SIM {
+
+class BrokerClient;
+
+/**
+ * @brief Create a sealable memfd of size bytes
+ * @param try_huge Use MFD_HUGETLB if size is a multiple of 2MB and the pool can back it
+ * @return fd (close-on-exec), or -1
+ */
+int createMemfd(const char* tag, size_t size, bool try_huge);
+
+/**
+ * @brief Seal a memfd against shrinking (F_SEAL_SHRINK)
+ */
+bool sealSegment(int fd);
+
+/**
+ * @brief Segment can never shrink below its current size
+ */
+bool isShrinkSealed(int fd);
+
+/**
+ * @brief Segment lives on hugetlbfs (MFD_HUGETLB memfd or hugetlbfs file)
+ */
+bool isHugetlbFd(int fd);
+
+/**
+ * @brief Send one message on a Unix socket, with an fd attached if fd >= 0
+ */
+bool sendFd(int sock, const void* data, size_t size, int fd);
+
+/**
+ * @brief Receive one message and the fd attached to it (-1 if none)
+ */
+bool recvFd(int sock, void* data, size_t size, int& fd);
+
+/**
+ * @brief Writers default to anonymous segments (SIM_SEGMENTS=memfd)
+ */
+bool anonymousSegmentsDefault();
+
+/**
+ * @brief Serve a channel's segment to readers of this host
+ *
+ * One background thread per process serves every published channel.
+ *
+ * @return false if another process already serves the channel
+ */
+bool publishSegment(const std::string& channel, int fd);
+
+/**
+ * @brief Stop serving a channel (readers keep their mappings)
+ */
+void withdrawSegment(const std::string& channel);
+
+/**
+ * @brief Segment fd of an anonymous channel
+ * @return fd owned by the caller, or -1 if no writer serves the channel
+ */
+int fetchSegment(const std::string& channel);
+
+/**
+ * @brief Abstract Unix socket address for name (sun_path[0] = 0)
+ * @return Address length to pass to bind()/connect()
+ */
+socklen_t abstractAddress(const std::string& name, sockaddr_un& addr);
+
+/**
+ * @struct WriterSegment
+ * @brief Where a BARQ/CASIR writer's segment came from
+ */
+struct WriterSegment {
+    int fd;                 // -1 on failure
+    bool serving;           // Anonymous memfd served by this process
+    bool provisioned;       // Existing segment of the same layout, reused
+    bool keep;              // Left in place when the writer goes away (brokered, served, provisioned)
+};
+
+/**
+ * @brief Segment for a channel writer, in order of preference
+ *
+ * - From the broker daemon when one runs (a refusal is final)
+ * - Anonymous: a sealed memfd served on the channel's socket (a second
+ *   writer of the channel fails to claim the name)
+ * - An existing named segment with the same layout and no live writer
+ *   (pre-provisioned), otherwise a new one: on hugetlbfs if the pool can
+ *   back it, else /dev/shm
+ *
+ * Named segments are returned holding a shared flock(): the GC only
+ * reclaims what it can lock exclusively, and a segment it unlinked
+ * before the lock was taken is recreated.
+ *
+ * @param same_layout Whether an existing segment fd can be reused as is
+ * @param broker Connection used for the daemon (nullptr = no broker)
+ */
+WriterSegment acquireWriterSegment(const std::string& name, size_t size, const char* memfd_tag,
+                                   bool hugetlb, bool anonymous, BrokerClient* broker,
+                                   const std::function<bool(int)>& same_layout);
+
+/**
+ * @brief Close a writer's segment: unlink it unless kept, stop serving it
+ * and leave the broker
+ */
+void releaseWriterSegment(const std::string& name, WriterSegment& segment, BrokerClient& broker);
+
+/**
+ * @brief Existing segment of size bytes with this transport layout and
+ * no live writer: a live writer's segment is never shared with a second one
+ *
+ * Header is a transport header with magic, version, capacity, meta_size
+ * and writer_pid fields.
+ */
+template <typename Header>
+bool sameLayout(int fd, size_t size, uint32_t magic, uint32_t version,
+                size_t capacity, size_t meta_size) {
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) != size) return false;
+    
+    alignas(alignof(Header)) uint8_t raw[sizeof(Header)];
+    if (pread(fd, raw, sizeof(raw), 0) != static_cast<ssize_t>(sizeof(raw))) return false;
+    const Header* header = reinterpret_cast<const Header*>(raw);
+    if (header->magic != magic || header->version != version ||
+        header->capacity != capacity || header->meta_size != meta_size) {
+        return false;
+    }
+    int32_t pid = header->writer_pid.load(std::memory_order_relaxed);
+    return pid == 0 || !processAlive(pid);
+}
+
+} // namespace SIM
+
+#endif // MEMFD_HPP
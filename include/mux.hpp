@@ -0,0 +1,256 @@
+/**
+ * @file mux.hpp
+ * @brief Multiplexed Segment - many small topics in one shared memory object
+ *
+ * One shm_open/mmap per process instead of one per topic:
+ * - Compact 128-byte topic headers (double buffer state like SIM/BARQ)
+ * - Dense per-topic change words that readers diff with SIMD (SSE2/AVX2)
+ *   into a private change bitmap, so any number of readers can share them
+ * - In-segment name index (open addressing), topics addressable by name
+ * - One futex notify word for the whole segment
+ *
+ * Usage:
+ *   // Owner (creates the segment)
+ *   SIM::MuxSegment seg("/robot_topics");
+ *   seg.create(512, 4 * 1024 * 1024);
+ *   int odom = seg.addTopic("odom", sizeof(Odometry));
+ *   seg.write(odom, &o, sizeof(o));
+ *
+ *   // Reader (one mapping, any number of topics)
+ *   SIM::MuxSegment seg("/robot_topics");
+ *   seg.open();
+ *   SIM::MuxReader reader(seg);
+ *   int odom = reader.subscribe("odom");
+ *   std::vector<int> changed;
+ *   while (reader.wait(changed, 100)) { for (int id : changed) ... }
+ */
+
+#ifndef MUX_HPP
+#define MUX_HPP
+
+#include "wait_strategy.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SIM {
+
+constexpr uint32_t MUX_MAGIC = 0x4D555830;     // "MUX0"
+constexpr uint32_t MUX_VERSION = 0x00010000;
+constexpr size_t MUX_TOPIC_NAME_LEN = 48;
+
+/**
+ * @struct MuxHeader
+ * @brief Segment header, followed by change words, name index, topic table and data
+ */
+struct alignas(CACHE_LINE_SIZE) MuxHeader {
+    // === Cache Line 0: Layout (static) ===
+    uint32_t magic;
+    uint32_t version;
+    uint32_t max_topics;
+    uint32_t index_size;            // Power of two, >= 2 * max_topics
+    uint64_t change_offset;         // uint32_t[max_topics]
+    uint64_t index_offset;          // uint32_t[index_size], topic id + 1 (0 = empty)
+    uint64_t topic_offset;          // MuxTopic[max_topics]
+    uint64_t data_offset;
+    uint64_t data_size;
+    char pad0[CACHE_LINE_SIZE - 56];
+    
+    // === Cache Line 1: Allocation (topic creation only) ===
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> lock;
+    std::atomic<uint32_t> num_topics;
+    std::atomic<uint64_t> data_used;
+    std::atomic<int64_t> heartbeat_ns;
+    std::atomic<int32_t> owner_pid;     // Creator, 0 = gone cleanly (see gc.hpp)
+    
+    // === Cache Line 2: Reader wake-up (any topic published) ===
+    alignas(CACHE_LINE_SIZE) NotifyWord notify;
+};
+
+/**
+ * @struct MuxTopic
+ * @brief Compact per-topic header (2 cache lines)
+ */
+struct alignas(CACHE_LINE_SIZE) MuxTopic {
+    // === Cache Line 0: Static ===
+    char name[MUX_TOPIC_NAME_LEN];
+    uint32_t max_size;
+    uint32_t hash;
+    uint64_t buffer_offset;         // Two buffers of alignUp(max_size, 64), from data_offset
+    
+    // === Cache Line 1: Double buffer state ===
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> front_idx;
+    std::atomic<uint32_t> len[2];
+    std::atomic<uint64_t> seq[2];
+    std::atomic<int64_t> ts[2];
+};
+
+static_assert(sizeof(MuxTopic) == 2 * CACHE_LINE_SIZE, "MuxTopic must be 2 cache lines");
+
+/**
+ * @class MuxSegment
+ * @brief One mapping of a multiplexed segment (owner, writer or reader side)
+ *
+ * Each topic must be written by one thread at a time; different topics can
+ * be written concurrently, from any process that opened the segment writable.
+ */
+class MuxSegment {
+public:
+    explicit MuxSegment(const std::string& name);
+    ~MuxSegment();
+    
+    MuxSegment(const MuxSegment&) = delete;
+    MuxSegment& operator=(const MuxSegment&) = delete;
+    
+    /**
+     * @brief Create the segment (replaces an existing one)
+     * @param max_topics Topic table size
+     * @param data_bytes Payload pool shared by all topics
+     */
+    bool create(uint32_t max_topics, size_t data_bytes);
+    
+    /**
+     * @brief Attach to an existing segment
+     * @param writable Map read-write to add/write topics from this process
+     */
+    bool open(bool writable = false);
+    
+    /**
+     * @brief Add a topic, or return the existing one with that name
+     * @return Topic id, or -1 if full, read-only or max_size does not fit
+     */
+    int addTopic(const std::string& topic, size_t max_size);
+    
+    /**
+     * @brief Look a topic up in the in-segment index
+     * @return Topic id, or -1 if unknown
+     */
+    int findTopic(const std::string& topic) const;
+    
+    /**
+     * @brief Copy and publish one frame of a topic
+     */
+    bool write(int id, const void* data, size_t size);
+    
+    /**
+     * @brief Back buffer of a topic for zero-copy writing; call commit() after
+     */
+    void* getWriteBuffer(int id);
+    bool commit(int id, size_t size);
+    
+    /**
+     * @brief Latest frame of a topic (zero-copy, does not track consumption)
+     * @return nullptr if nothing published yet
+     */
+    const void* peek(int id, size_t& size, int64_t& timestamp_ns, uint64_t& seq) const;
+    
+    bool isReady() const { return header_ != nullptr; }
+    bool isWritable() const { return writable_; }
+    uint32_t getTopicCount() const;
+    uint32_t getMaxTopics() const { return header_ ? header_->max_topics : 0; }
+    const char* getTopicName(int id) const;
+    size_t getTopicSize(int id) const;
+    const std::string& getName() const { return name_; }
+    
+    /**
+     * @brief Dense change words, one per topic (bumped after each publish)
+     */
+    const std::atomic<uint32_t>* getChangeWords() const { return change_; }
+    
+    /**
+     * @brief Segment notify word (nullptr if mapped read-only without RW fd)
+     */
+    NotifyWord* getNotifyWord() const;
+    
+    /**
+     * @brief Unmap; the owner also unlinks the segment
+     */
+    void destroy();
+
+private:
+    MuxTopic* topic(int id) const;
+    int lookup(const char* topic, uint32_t hash) const;
+    void lock();
+    void unlock();
+    bool map(size_t size, bool writable);
+    
+    std::string name_;
+    bool owner_;
+    bool writable_;
+    int fd_;
+    void* ptr_;
+    size_t shm_size_;
+    
+    MuxHeader* header_;
+    std::atomic<uint32_t>* change_;
+    std::atomic<uint32_t>* index_;
+    MuxTopic* topics_;
+    uint8_t* data_;
+    
+    NotifyView notify_;
+};
+
+/**
+ * @class MuxReader
+ * @brief Subscribes to topics of a MuxSegment and reports which changed
+ *
+ * Single thread. Several readers can share one MuxSegment mapping.
+ */
+class MuxReader {
+public:
+    explicit MuxReader(MuxSegment& segment);
+    
+    /**
+     * @brief Subscribe by id or name
+     * @return Topic id, or -1 if unknown
+     */
+    int subscribe(int id);
+    int subscribe(const std::string& topic);
+    bool unsubscribe(int id);
+    
+    /**
+     * @brief Subscribed topics published since the last poll()/wait()
+     * @return Number of changed topics
+     */
+    size_t poll(std::vector<int>& changed);
+    
+    /**
+     * @brief Block until a subscribed topic publishes
+     * @return Number of changed topics (0 on timeout)
+     */
+    size_t wait(std::vector<int>& changed, uint32_t timeout_ms);
+    
+    /**
+     * @brief Latest frame of a topic (zero-copy)
+     * @return nullptr if nothing published yet
+     */
+    const void* getLatest(int id, size_t& size, int64_t& timestamp_ns);
+    
+    /**
+     * @brief Copy the latest frame of a topic
+     */
+    bool read(int id, void* data, size_t& size);
+    
+    /**
+     * @brief Any subscribed topic changed since the last poll()
+     */
+    bool hasNewData() const;
+    
+    NotifyWord* getNotifyWord() const { return segment_.getNotifyWord(); }
+    void setWaitStrategy(const WaitStrategy& strategy) { wait_strategy_ = strategy; }
+
+private:
+    void sync();
+    
+    MuxSegment& segment_;
+    std::vector<uint64_t> subscribed_;  // Bitmap by topic id
+    std::vector<uint32_t> seen_;        // Change words acknowledged
+    std::vector<uint32_t> current_;     // Scratch for the vectorized scan
+    WaitStrategy wait_strategy_;
+};
+
+} // namespace SIM
+
+#endif // MUX_HPP
@@ -0,0 +1,30 @@
+/**
+ * @file name_hash.hpp
+ * @brief Topic name hash shared by the registry and Mux segments
+ *
+ * Stored in shared memory next to the name: every process must hash
+ * the same way, so there is exactly one definition.
+ */
+
+#ifndef NAME_HASH_HPP
+#define NAME_HASH_HPP
+
+#include <cstdint>
+
+namespace SIM {
+
+/**
+ * @brief FNV-1a of a NUL-terminated name, never 0
+ */
+inline uint32_t hashName(const char* name) {
+    uint32_t h = 2166136261u;
+    for (const char* p = name; *p; ++p) {
+        h ^= static_cast<uint8_t>(*p);
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+} // namespace SIM
+
+#endif // NAME_HASH_HPP
@@ -0,0 +1,177 @@
+/**
+ * @file pacing.hpp
+ * @brief Bandwidth pacing - keep large copies from starving small channels
+ *
+ * A 50MB BARQ write saturates the memory controller and evicts the LLC
+ * for milliseconds; a 1KB control channel published meanwhile sees its
+ * latency spike. With a pacing policy the writer copies large frames in
+ * chunks and, between chunks:
+ * - Waits for tokens of a per-writer token bucket (rate + burst)
+ * - Re-sizes chunks to a latency budget (longest uninterrupted copy)
+ * - Pauses while a critical channel signals pending work, bounded by
+ *   max_defer_ns per chunk so bulk copies are never starved
+ *
+ * Channels have a priority. Critical writers signal on every publish
+ * through the shm segment "/sim_pacing", so bulk copies in other
+ * processes step aside while critical readers pick the frame up; readers
+ * can also hold a CriticalWork scope while they process it.
+ * SIM_PACING_BOARD=off keeps the signals within the process.
+ *
+ * Usage:
+ *   bulk.setPriority(SIM::ChannelPriority::Bulk);
+ *   bulk.setPacing(SIM::PacingPolicy::latencyBudget(50000));    // 50us
+ *   control.setPriority(SIM::ChannelPriority::Critical);
+ *
+ *   // Critical reader, optional
+ *   { SIM::CriticalWork busy; handle(reader.read(...)); }
+ */
+
+#ifndef PACING_HPP
+#define PACING_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SIM {
+
+// Window after a critical publish during which bulk copies pause
+constexpr int64_t CRITICAL_HOLD_NS = 20000;
+
+/**
+ * @enum ChannelPriority
+ * @brief Who steps aside for whom
+ */
+enum class ChannelPriority : uint32_t {
+    Bulk = 0,       // Paced copies yield to critical channels
+    Normal,         // Default: neither yields nor signals
+    Critical        // Signals pending work on every publish
+};
+
+const char* priorityName(ChannelPriority priority);
+
+/**
+ * @struct PacingPolicy
+ * @brief How a writer copies large frames
+ */
+struct PacingPolicy {
+    size_t chunk_bytes;             // Copy unit between checks (0 = no pacing)
+    double rate_bytes_per_s;        // Token bucket rate (0 = unlimited)
+    size_t burst_bytes;             // Token bucket depth
+    int64_t latency_budget_ns;      // Longest chunk copy; chunks re-sized to it (0 = fixed)
+    bool yield_to_critical;         // Pause while critical channels signal
+    int64_t max_defer_ns;           // Longest pause per chunk for critical work
+
+    static PacingPolicy disabled() {
+        PacingPolicy policy;
+        policy.chunk_bytes = 0;
+        policy.rate_bytes_per_s = 0.0;
+        policy.burst_bytes = 0;
+        policy.latency_budget_ns = 0;
+        policy.yield_to_critical = false;
+        policy.max_defer_ns = 0;
+        return policy;
+    }
+
+    /**
+     * @brief At most bytes_per_s on average, bursts up to burst_bytes
+     */
+    static PacingPolicy rate(double bytes_per_s, size_t burst_bytes = 4 * 1024 * 1024) {
+        PacingPolicy policy = disabled();
+        policy.chunk_bytes = 256 * 1024;
+        policy.rate_bytes_per_s = bytes_per_s;
+        policy.burst_bytes = burst_bytes;
+        policy.yield_to_critical = true;
+        policy.max_defer_ns = 2000000;
+        return policy;
+    }
+
+    /**
+     * @brief Critical work waits at most about budget_ns for a chunk to finish
+     */
+    static PacingPolicy latencyBudget(int64_t budget_ns) {
+        PacingPolicy policy = disabled();
+        policy.chunk_bytes = 64 * 1024;
+        policy.latency_budget_ns = budget_ns;
+        policy.yield_to_critical = true;
+        policy.max_defer_ns = 2000000;
+        return policy;
+    }
+};
+
+/**
+ * @struct PacingStats
+ * @brief What pacing cost the writer
+ */
+struct PacingStats {
+    uint64_t paced_writes;
+    uint64_t chunks;
+    uint64_t deferrals;             // Chunks that waited for critical work
+    int64_t throttled_ns;           // Waiting for tokens
+    int64_t deferred_ns;            // Waiting for critical work
+};
+
+/**
+ * @class BandwidthPacer
+ * @brief Chunked copy with token bucket, latency budget and critical yield
+ */
+class BandwidthPacer {
+public:
+    BandwidthPacer();
+    explicit BandwidthPacer(const PacingPolicy& policy);
+
+    void setPolicy(const PacingPolicy& policy);
+    const PacingPolicy& getPolicy() const { return policy_; }
+
+    /**
+     * @brief Copy size is large enough to be paced
+     */
+    bool applies(size_t size) const { return policy_.chunk_bytes > 0 && size > policy_.chunk_bytes; }
+
+    /**
+     * @brief Copy src to dst chunk by chunk
+     * @param non_temporal Streaming stores (see gather.hpp)
+     */
+    void copy(void* dst, const void* src, size_t size, bool non_temporal);
+
+    const PacingStats& getStats() const { return stats_; }
+
+private:
+    PacingPolicy policy_;
+    PacingStats stats_;
+    size_t chunk_;                  // Current chunk size (adapted to the budget)
+    double tokens_;
+    int64_t refill_ns_;
+
+    void takeTokens(size_t bytes);
+    void deferToCritical();
+};
+
+/**
+ * @brief Critical work is pending: bulk copies pause for hold_ns
+ */
+void signalCritical(int64_t hold_ns = CRITICAL_HOLD_NS);
+
+/**
+ * @brief A critical signal or CriticalWork scope is active
+ */
+bool criticalPending();
+
+/**
+ * @class CriticalWork
+ * @brief Scope during which bulk copies pause (bounded by their max_defer_ns)
+ *
+ * Scopes are counted per process on the board; the count of a process
+ * that died inside a scope is dropped by the next criticalPending().
+ */
+class CriticalWork {
+public:
+    CriticalWork();
+    ~CriticalWork();
+
+    CriticalWork(const CriticalWork&) = delete;
+    CriticalWork& operator=(const CriticalWork&) = delete;
+};
+
+} // namespace SIM
+
+#endif // PACING_HPP
@@ -0,0 +1,252 @@
+/**
+ * @file phase.hpp
+ * @brief Phase alignment - publish just before consumers read
+ *
+ * A 30Hz consumer polling at its own phase finds frames that waited up
+ * to 33ms in the buffer. Here consumers announce when they consume, and
+ * the writer (or a timer driving it) publishes just ahead of them:
+ * - ConsumerPhase: the reader reports each frame it takes; its schedule
+ *   (period and a recent consume time) is learned from those calls and
+ *   published, with the frame age achieved, in the side segment
+ *   "<channel>@phase"
+ * - PhaseAligner: the writer picks the publish phase that minimizes the
+ *   mean frame age over all live consumers, and sleeps until the next
+ *   publish time (or hands it to a timer / Executor::trigger())
+ * - Consumers that cannot move the writer align themselves instead:
+ *   ConsumerPhase::nextAlignedConsume() from the frame timestamps seen
+ *
+ * A schedule is exchanged as anchor + k * period, the anchor being a
+ * recent event in the frame timestamp clock (high_resolution_clock, as
+ * written by the transports). Phases are only ever taken relative to
+ * such an anchor, never as an epoch modulo: a learned period off by a
+ * nanosecond would move an epoch phase by seconds.
+ *
+ * Usage:
+ *   // Writer, 30Hz
+ *   SIM::PhaseAligner aligner("/camera", 33333333);
+ *   aligner.attach();
+ *   while (running) { aligner.sleepUntilNext(); writer.write(frame, size); }
+ *
+ *   // Reader
+ *   SIM::ConsumerPhase phase("/camera");
+ *   phase.attach();
+ *   if (const void* data = reader.getLatest(size, ts)) { phase.consumed(ts); ... }
+ *   printf("age %.1f ms\n", phase.getAgeStats().window_mean_ns / 1e6);
+ */
+
+#ifndef PHASE_HPP
+#define PHASE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SIM {
+
+constexpr uint32_t PHASE_MAGIC = 0x50485331;    // "PHS1"
+constexpr int PHASE_MAX_CONSUMERS = 32;
+
+/**
+ * @struct PhaseSlot
+ * @brief One consumer's announcement (written by it, read by the writer)
+ */
+struct alignas(64) PhaseSlot {
+    std::atomic<int32_t> pid;           // 0 = free
+    std::atomic<uint32_t> weight;       // Relative importance (1 by default)
+    std::atomic<int64_t> period_ns;     // 0 = not learned yet
+    std::atomic<int64_t> anchor_ns;     // Recent consume time (schedule anchor)
+    std::atomic<int64_t> updated_ns;    // Last consumed() call
+    std::atomic<int64_t> mean_age_ns;   // Achieved age, last window
+    std::atomic<int64_t> max_age_ns;
+    char pad[64 - 48];
+};
+
+static_assert(sizeof(PhaseSlot) == 64, "PhaseSlot must be one cache line");
+
+/**
+ * @struct PhaseHeader
+ * @brief Side segment "<channel>@phase"
+ */
+struct PhaseHeader {
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<int64_t> publish_period_ns;     // Written by PhaseAligner (0 = none)
+    std::atomic<int64_t> publish_anchor_ns;     // Last planned publish time
+    char pad[64 - 24];
+    PhaseSlot slots[PHASE_MAX_CONSUMERS];
+};
+
+/**
+ * @struct AgeStats
+ * @brief Frame age (consume time - frame timestamp) achieved by a consumer
+ */
+struct AgeStats {
+    uint64_t frames;
+    int64_t last_ns;
+    double mean_ns;             // Since attach()
+    double window_mean_ns;      // Last completed window
+    int64_t window_max_ns;
+    uint64_t windows;           // Completed windows
+};
+
+/**
+ * @struct ConsumerInfo
+ * @brief Live consumer as seen by the writer
+ */
+struct ConsumerInfo {
+    int32_t pid;
+    uint32_t weight;
+    int64_t period_ns;
+    int64_t anchor_ns;          // Consumes at anchor_ns + k * period_ns
+    int64_t mean_age_ns;
+    int64_t max_age_ns;
+};
+
+/**
+ * @class ConsumerPhase
+ * @brief Reader side: learn and announce the consumption schedule
+ */
+class ConsumerPhase {
+public:
+    /**
+     * @param channel Channel name (e.g. "/camera")
+     * @param period_ns Consumption period (0 = learn from consumed() calls)
+     * @param window_ns Age statistics window
+     */
+    explicit ConsumerPhase(const std::string& channel, int64_t period_ns = 0,
+                           int64_t window_ns = 1000000000);
+    ~ConsumerPhase();
+
+    ConsumerPhase(const ConsumerPhase&) = delete;
+    ConsumerPhase& operator=(const ConsumerPhase&) = delete;
+
+    /**
+     * @brief Claim a slot in the side segment (created if needed)
+     * @return false if all slots are taken by live processes
+     */
+    bool attach(uint32_t weight = 1);
+    void detach();
+    bool isAttached() const { return slot_ != nullptr; }
+
+    /**
+     * @brief The consumer took a frame now
+     * @param frame_timestamp_ns Timestamp returned with the frame
+     */
+    void consumed(int64_t frame_timestamp_ns);
+
+    int64_t getPeriod() const { return period_ns_; }
+
+    /**
+     * @brief Smoothed recent consume time: consumes at anchor + k * period
+     */
+    int64_t getAnchor() const { return anchor_ns_; }
+    AgeStats getAgeStats() const { return stats_; }
+
+    /**
+     * @brief Next time to consume if the consumer adapts to the writer
+     *
+     * The writer's phase is learned from the frame timestamps seen (or
+     * taken from the PhaseAligner when one runs).
+     *
+     * @param lead_ns Margin after the publish (copy, wake-up)
+     * @return Time in the frame timestamp clock, 0 if not known yet
+     */
+    int64_t nextAlignedConsume(int64_t lead_ns = 200000) const;
+
+private:
+    std::string channel_;
+    int64_t window_ns_;
+    bool fixed_period_;
+    PhaseHeader* header_;
+    int board_fd_;                  // Shared lock held while attached
+    PhaseSlot* slot_;
+
+    int64_t period_ns_;
+    int64_t anchor_ns_;             // Consume schedule, re-anchored every frame
+    int64_t last_consume_ns_;
+    int64_t last_frame_ns_;
+    int64_t frame_period_ns_;       // Writer schedule, from the frame timestamps
+    int64_t frame_anchor_ns_;
+    int period_misses_;             // Inconsistent intervals in a row
+    int frame_misses_;
+    int period_samples_;            // Intervals in the learned period (up to a window)
+    int frame_samples_;
+
+    AgeStats stats_;
+    int64_t window_start_ns_;
+    double window_sum_ns_;
+    uint64_t window_count_;
+    int64_t window_max_ns_;
+};
+
+/**
+ * @class PhaseAligner
+ * @brief Writer side: publish phase that minimizes the consumers' frame age
+ */
+class PhaseAligner {
+public:
+    /**
+     * @param channel Channel name
+     * @param period_ns Publish period
+     * @param lead_ns Publish this long before consumers read (copy, wake-up)
+     */
+    PhaseAligner(const std::string& channel, int64_t period_ns, int64_t lead_ns = 200000);
+    ~PhaseAligner();
+
+    PhaseAligner(const PhaseAligner&) = delete;
+    PhaseAligner& operator=(const PhaseAligner&) = delete;
+
+    bool attach();
+
+    /**
+     * @brief Consumers that announced within the last few periods
+     */
+    std::vector<ConsumerInfo> consumers() const;
+
+    /**
+     * @brief Publish schedule anchor for the current consumers
+     *
+     * Weighted mean age over one hyperperiod of every consumer (bounded)
+     * is evaluated for each candidate (each upcoming consume time minus
+     * the lead); the lowest wins. Keeps the current schedule without
+     * consumers.
+     *
+     * @return Publish time; publishes follow at + k * getPeriod()
+     */
+    int64_t bestAnchor();
+
+    /**
+     * @brief Expected mean frame age when publishing at anchor_ns + k * period
+     *
+     * A frame published less than lead_ns before a consume counts as missed.
+     */
+    double expectedAge(int64_t anchor_ns) const;
+
+    /**
+     * @brief First aligned publish time after now (frame timestamp clock)
+     */
+    int64_t nextPublishTime();
+
+    /**
+     * @brief Sleep until nextPublishTime()
+     */
+    void sleepUntilNext();
+
+    int64_t getPeriod() const { return period_ns_; }
+
+private:
+    std::string channel_;
+    int64_t period_ns_;
+    int64_t lead_ns_;
+    int64_t anchor_ns_;             // Publish schedule (0 = not planned yet)
+    int64_t planned_ns_;            // Last bestAnchor() evaluation
+    int64_t last_publish_ns_;
+    PhaseHeader* header_;
+    int board_fd_;                  // Shared lock held while attached
+};
+
+} // namespace SIM
+
+#endif // PHASE_HPP
@@ -0,0 +1,291 @@
+/**
+ * @file pipeline.hpp
+ * @brief Zero-copy dataflow pipeline (camera -> rectify -> detect -> track)
+ *
+ * Stages are nodes that read one or more inputs and write into a loaned
+ * output buffer; nothing is copied between in-process stages:
+ * - Source stages read a transport reader (BARQ, CASIR, SAHM) in place
+ * - Each stage owns a fixed pool of output slots (queue_depth). Committed
+ *   slots are handed to consumers by pointer and recycled when all
+ *   consumers are done, so the pool is the bounded queue
+ * - Backpressure: when all slots are in flight, a Block stage is not run
+ *   until a consumer releases one (its input stays queued, sources resume
+ *   with the newest frame); a Drop stage runs and loan() returns nullptr
+ * - Stages run on the Executor worker pool and never run concurrently
+ *   with themselves
+ * - exportOutput() mirrors a stage to a BARQ channel for stages running
+ *   in another process (which add it back with addSource())
+ *
+ * Input 0 triggers a stage; further inputs are sampled (latest message).
+ * A sampled input holds its newest message until a newer one arrives, so
+ * the producer gets one slot per sampled consumer on top of queue_depth.
+ *
+ * Usage:
+ *   SIM::Pipeline pipe;
+ *   int rect = pipe.addSource("rectify", camera_reader, IMG_SIZE,
+ *       [](SIM::StageContext& ctx) {
+ *           size_t sz;
+ *           const void* raw = ctx.input(0, sz);
+ *           if (void* out = ctx.loan()) { rectify(raw, out); ctx.commit(IMG_SIZE); }
+ *       });
+ *   int det = pipe.addStage("detect", {rect}, DET_SIZE, detect_fn);
+ *   pipe.addStage("track", {det}, 0, track_fn);
+ *   pipe.start();
+ */
+
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include "coro.hpp"
+#include "executor.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SIM {
+
+/**
+ * @enum Backpressure
+ * @brief What loan() does when every output slot is in flight
+ */
+enum class Backpressure : uint32_t {
+    Block = 0,      // Hold the stage until a consumer releases a slot
+    Drop = 1        // Run anyway, loan() returns nullptr
+};
+
+/**
+ * @struct StageOptions
+ * @brief Per-stage queueing and scheduling
+ */
+struct StageOptions {
+    size_t queue_depth;                 // Output slots in flight
+    Backpressure backpressure;
+    SubscriptionOptions scheduling;     // Executor priority / CPU hint
+    
+    static StageOptions defaults() {
+        StageOptions opts;
+        opts.queue_depth = 4;
+        opts.backpressure = Backpressure::Block;
+        opts.scheduling = SubscriptionOptions::defaults();
+        return opts;
+    }
+    
+    /**
+     * @brief Never stall upstream: drop frames when consumers lag
+     */
+    static StageOptions dropping(size_t queue_depth = 4) {
+        StageOptions opts = defaults();
+        opts.queue_depth = queue_depth;
+        opts.backpressure = Backpressure::Drop;
+        return opts;
+    }
+};
+
+/**
+ * @struct StageStats
+ * @brief Per-stage latency accounting (steady clock)
+ */
+struct StageStats {
+    uint64_t runs;              // Stage function invocations
+    uint64_t dropped;           // Loans refused (Drop policy)
+    uint64_t blocked;           // Runs deferred for lack of a free slot
+    uint64_t total_ns;          // Time inside the stage function
+    uint64_t max_ns;
+    uint64_t total_wait_ns;     // Time the trigger input spent queued
+    uint64_t total_latency_ns;  // Source start -> end of this stage
+    uint64_t max_latency_ns;
+    
+    double avgNs() const { return runs ? static_cast<double>(total_ns) / runs : 0.0; }
+    double avgWaitNs() const { return runs ? static_cast<double>(total_wait_ns) / runs : 0.0; }
+    double avgLatencyNs() const { return runs ? static_cast<double>(total_latency_ns) / runs : 0.0; }
+};
+
+class Pipeline;
+
+/**
+ * @class StageContext
+ * @brief Inputs and output loan of one stage invocation
+ */
+class StageContext {
+public:
+    size_t inputCount() const { return inputs_.size(); }
+    
+    /**
+     * @brief Zero-copy input (valid until the stage function returns)
+     * @return nullptr if a sampled input has no message yet
+     */
+    const void* input(size_t index, size_t& size) const;
+    
+    /**
+     * @brief Steady-clock time the originating source frame was picked up
+     */
+    int64_t originNs() const { return origin_ns_; }
+    
+    /**
+     * @brief Borrow this stage's output buffer (outputCapacity() bytes)
+     * @return nullptr if the stage has no output, or on Drop backpressure
+     */
+    void* loan();
+    
+    /**
+     * @brief Publish the loaned buffer to consumers (and the export channel)
+     */
+    bool commit(size_t size);
+    
+    size_t outputCapacity() const;
+
+private:
+    friend class Pipeline;
+    
+    struct Input {
+        const void* data;
+        size_t size;
+    };
+    
+    StageContext(Pipeline* pipeline, void* node)
+        : pipeline_(pipeline), node_(node), origin_ns_(0)
+        , loaned_(nullptr), direct_(nullptr), committed_(false) {}
+    
+    Pipeline* pipeline_;
+    void* node_;
+    std::vector<Input> inputs_;
+    int64_t origin_ns_;
+    void* loaned_;          // Message* from the slot pool
+    void* direct_;          // Export buffer when loaning straight from BARQ
+    bool committed_;
+};
+
+using StageFn = std::function<void(StageContext&)>;
+
+/**
+ * @class Pipeline
+ * @brief Graph of stages scheduled on an Executor
+ */
+class Pipeline {
+public:
+    explicit Pipeline(const ExecutorConfig& config = ExecutorConfig::defaults());
+    ~Pipeline();
+    
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+    
+    /**
+     * @brief Stage triggered by a transport reader, input 0 read in place
+     * @param output_size Output slot size in bytes (0 = sink)
+     * @return Stage id, or -1 on error
+     */
+    template <typename Reader>
+    int addSource(const std::string& name, Reader& reader, size_t output_size, StageFn fn,
+                  const StageOptions& options = StageOptions::defaults()) {
+        return addNode(name, std::vector<int>(), output_size, std::move(fn), options,
+                       reader.getNotifyWord(),
+                       [&reader] { return reader.hasNewData(); },
+                       [&reader] { return fetchFrame(reader); });
+    }
+    
+    /**
+     * @brief Stage fed by earlier stages (input 0 triggers, others sampled)
+     * @return Stage id, or -1 on error
+     */
+    int addStage(const std::string& name, const std::vector<int>& inputs, size_t output_size,
+                 StageFn fn, const StageOptions& options = StageOptions::defaults());
+    
+    /**
+     * @brief Mirror a stage's output to a BARQ channel for other processes
+     *
+     * If the stage has no in-process consumers, loan() hands out the BARQ
+     * back buffer directly (zero-copy), otherwise commits are copied once.
+     */
+    bool exportOutput(int stage, const std::string& shm_name);
+    
+    bool start();
+    void stop();
+    bool isRunning() const { return executor_.isRunning(); }
+    
+    int findStage(const std::string& name) const;
+    size_t size() const { return nodes_.size(); }
+    StageStats getStats(int stage) const;
+    ExecutorStats getExecutorStats() const { return executor_.getStats(); }
+
+private:
+    friend class StageContext;
+    
+    struct Node;
+    
+    struct Message {
+        uint8_t* data;
+        size_t size;
+        int64_t origin_ns;
+        int64_t enqueue_ns;
+        std::atomic<uint32_t> refs;
+        Node* owner;
+    };
+    
+    struct Edge {
+        Node* consumer;
+        size_t input;
+    };
+    
+    struct Node {
+        std::string name;
+        std::vector<int> inputs;
+        size_t output_size;
+        StageFn fn;
+        StageOptions options;
+        
+        // Source stages
+        NotifyWord* source_word;
+        std::function<bool()> source_ready;
+        std::function<Frame()> fetch;
+        
+        // Output slot pool (allocated by start(), once edges are known)
+        size_t slots;                   // queue_depth + one held sample per sampled consumer
+        std::unique_ptr<uint8_t[]> slab;
+        std::unique_ptr<Message[]> messages;
+        std::unique_ptr<BoundedQueue<Message*>> free_slots;
+        std::vector<Edge> edges;
+        std::unique_ptr<BARQ::Writer> exporter;
+        
+        // Input side: one queue per input, latest message for sampled inputs
+        std::vector<std::unique_ptr<BoundedQueue<Message*>>> queues;
+        std::vector<Message*> latest;
+        NotifyWord notify;
+        
+        int subscription;               // Executor subscription id
+        std::atomic<bool> deferred;     // Skipped a run for lack of slots
+        
+        std::atomic<uint64_t> runs;
+        std::atomic<uint64_t> dropped;
+        std::atomic<uint64_t> blocked;
+        std::atomic<uint64_t> total_ns;
+        std::atomic<uint64_t> max_ns;
+        std::atomic<uint64_t> total_wait_ns;
+        std::atomic<uint64_t> total_latency_ns;
+        std::atomic<uint64_t> max_latency_ns;
+    };
+    
+    int addNode(const std::string& name, const std::vector<int>& inputs, size_t output_size,
+                StageFn fn, const StageOptions& options, NotifyWord* source_word,
+                std::function<bool()> source_ready, std::function<Frame()> fetch);
+    void allocate(Node* node);
+    bool hasInput(const Node* node) const;
+    bool slotAvailable(Node* node);
+    void runStage(Node* node);
+    void execute(Node* node, StageContext& ctx, int64_t enqueue_ns);
+    void* loan(Node* node, StageContext& ctx);
+    bool commit(Node* node, StageContext& ctx, size_t size);
+    void release(Message* msg);
+    
+    Executor executor_;
+    std::vector<std::unique_ptr<Node>> nodes_;
+    std::vector<int> subscriptions_;
+    std::atomic<bool> stopping_;
+};
+
+} // namespace SIM
+
+#endif // PIPELINE_HPP
@@ -0,0 +1,182 @@
+/**
+ * @file placement.hpp
+ * @brief Placement planner - which CPU each writer/reader thread runs on
+ *
+ * A single static cpu_affinity (SiCConfig::maxPerformance() pinned to
+ * core 0, the core that usually takes interrupts) ignores who talks to
+ * whom. The planner takes the channel graph (threads and the channels
+ * they write and read) and the host topology (see topology.hpp), and:
+ * - Keeps threads linked by hot channels in the same L3 group, heaviest
+ *   links first; groups that do not fit spill to the same NUMA node
+ * - Uses one hardware thread per core while cores remain (no SMT sharing)
+ * - Leaves CPU 0 and CPUs taking most device interrupts for last
+ * - Is deterministic (names and CPU ids break ties), and with a state
+ *   file keeps earlier placements across restarts while still valid
+ *
+ * Each channel path gets an expected one-way cache line latency from its
+ * topology class; measure() replaces guesses with ping-pong timings.
+ *
+ * Usage:
+ *   SIM::PlacementPlanner planner;
+ *   planner.addChannel("/camera", "capture", {"detect", "record"}, 10.0);
+ *   planner.addChannel("/objects", "detect", {"track"});
+ *   SIM::PlacementPlan plan = planner.plan();
+ *
+ *   // In the capture thread
+ *   plan.apply("capture");
+ */
+
+#ifndef PLACEMENT_HPP
+#define PLACEMENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SIM {
+
+/**
+ * @enum PathClass
+ * @brief Topology distance between a writer and a reader CPU
+ */
+enum class PathClass : uint32_t {
+    SameCore = 0,       // Same CPU or SMT siblings
+    SameL3,
+    SameNode,
+    CrossNode
+};
+
+const char* pathClassName(PathClass path);
+
+/**
+ * @struct PlacementOptions
+ * @brief Planner constraints
+ */
+struct PlacementOptions {
+    std::vector<int> allowed;   // Eligible CPUs (empty = this process's affinity mask)
+    bool avoid_smt;             // One thread per core while cores remain
+    bool avoid_irq_cpus;        // CPUs taking most device interrupts go last
+    bool avoid_cpu0;            // CPU 0 goes last (timers, housekeeping)
+    std::string state_file;     // Placements kept across restarts ("" = none)
+
+    static PlacementOptions defaults() {
+        PlacementOptions opts;
+        opts.avoid_smt = true;
+        opts.avoid_irq_cpus = true;
+        opts.avoid_cpu0 = true;
+        return opts;
+    }
+};
+
+/**
+ * @struct ThreadPlacement
+ * @brief CPU chosen for one thread
+ */
+struct ThreadPlacement {
+    std::string thread;
+    int cpu;
+    int node;
+    int l3_group;           // Lowest CPU of the L3 group (-1 = none)
+    bool shared;            // CPU or core shared with another planned thread
+    bool kept;              // Taken over from the state file
+};
+
+/**
+ * @struct ChannelPath
+ * @brief One writer -> reader hop of a channel
+ */
+struct ChannelPath {
+    std::string channel;
+    std::string writer;
+    std::string reader;
+    double weight;
+    PathClass path;
+    double expected_ns;     // Typical one-way cache line transfer for the class
+    double measured_ns;     // From measure() (-1 = not measured)
+};
+
+/**
+ * @class PlacementPlan
+ * @brief Result of PlacementPlanner::plan()
+ */
+class PlacementPlan {
+public:
+    std::vector<ThreadPlacement> threads;
+    std::vector<ChannelPath> paths;
+
+    /**
+     * @brief CPU of a thread (-1 if not planned)
+     */
+    int cpuOf(const std::string& thread) const;
+
+    /**
+     * @brief CPUs of several threads, e.g. for ExecutorConfig::pinned()
+     */
+    std::vector<int> cpusOf(const std::vector<std::string>& names) const;
+
+    /**
+     * @brief Pin the calling thread to the CPU planned for it
+     */
+    bool apply(const std::string& thread) const;
+
+    /**
+     * @brief Time a cache line ping-pong between the CPUs of every path
+     * @param round_trips Per CPU pair
+     */
+    void measure(size_t round_trips = 20000);
+
+    /**
+     * @brief Write the placements to a state file (see PlacementOptions)
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief Table of placements and paths (expected vs measured)
+     */
+    std::string describe() const;
+};
+
+/**
+ * @class PlacementPlanner
+ * @brief Builds a PlacementPlan from the channel graph
+ */
+class PlacementPlanner {
+public:
+    explicit PlacementPlanner(const PlacementOptions& options = PlacementOptions::defaults());
+
+    /**
+     * @brief Thread that needs a CPU (threads named in addChannel() are added too)
+     */
+    void addThread(const std::string& name);
+
+    /**
+     * @brief Channel written by writer and read by readers
+     * @param weight Relative traffic (frames/s, bytes/s...) - heavier links stay closer
+     */
+    void addChannel(const std::string& channel, const std::string& writer,
+                    const std::vector<std::string>& readers, double weight = 1.0);
+
+    PlacementPlan plan() const;
+
+private:
+    struct Channel {
+        std::string name;
+        std::string writer;
+        std::vector<std::string> readers;
+        double weight;
+    };
+
+    PlacementOptions options_;
+    std::vector<std::string> threads_;
+    std::vector<Channel> channels_;
+};
+
+/**
+ * @brief Best CPU for a single latency-critical thread (-1 if none is eligible)
+ */
+int quietestCpu();
+
+} // namespace SIM
+
+#endif // PLACEMENT_HPP
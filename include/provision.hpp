@@ -0,0 +1,121 @@
+/**
+ * @file provision.hpp
+ * @brief Channel Provisioning - create and pre-fault segments ahead of startup
+ *
+ * Creating, populating and mlocking 40 multi-MB segments when the stack
+ * starts takes seconds and contends on the mm lock. Instead a manifest
+ * lists the channels and a provisioning step creates them all once, in
+ * parallel, before the stack starts:
+ * - Exact transport layout (BARQ, CASIR, SIM), header valid for readers
+ * - Pages faulted in on the requested NUMA node
+ * - Writers init() by attaching to the provisioned segment, readers can
+ *   attach before the writer runs
+ * - Per-channel timing report
+ *
+ * Provisioned segments are named /dev/shm (or hugetlbfs) segments, also
+ * under SIM_SEGMENTS=memfd. With the broker daemon running, BARQ and
+ * CASIR writers get their segments from it instead, so those channels
+ * are not provisioned but reported as such: size the broker's pools
+ * (BrokerConfig::pools) for them.
+ *
+ * Manifest (one channel per line, '#' starts a comment):
+ *   # name          transport  size   options
+ *   /camera_front   barq       6M     huge=on numa=0 meta=64
+ *   /imu            casir      4K
+ *   /status         sim        1K     numa=1
+ *
+ * Usage:
+ *   std::vector<SIM::ChannelSpec> specs;
+ *   std::string error;
+ *   if (!SIM::loadManifest("/etc/robot/channels.conf", specs, &error)) ...
+ *   std::vector<SIM::ProvisionReport> reports;
+ *   SIM::provisionChannels(specs, reports);
+ */
+
+#ifndef PROVISION_HPP
+#define PROVISION_HPP
+
+#include "registry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SIM {
+
+/**
+ * @struct ChannelSpec
+ * @brief One manifest entry
+ */
+struct ChannelSpec {
+    std::string name;
+    TransportType transport;    // BARQ, CASIR or SIM
+    size_t max_size;            // Max bytes per frame
+    size_t meta_size;           // Per-frame user metadata bytes
+    bool huge_pages;            // Huge page preference (BARQ, CASIR)
+    int numa_node;              // Fault pages on this node (-1 = local)
+    
+    static ChannelSpec make(const std::string& name, TransportType transport, size_t max_size,
+                            size_t meta_size = 0, bool huge_pages = true, int numa_node = -1) {
+        ChannelSpec spec;
+        spec.name = name;
+        spec.transport = transport;
+        spec.max_size = max_size;
+        spec.meta_size = meta_size;
+        spec.huge_pages = huge_pages;
+        spec.numa_node = numa_node;
+        return spec;
+    }
+};
+
+/**
+ * @struct ProvisionReport
+ * @brief Outcome and startup cost of one channel
+ */
+struct ProvisionReport {
+    std::string name;
+    bool success;
+    bool reused;                // Already provisioned with the same layout
+    bool numa_bound;            // Pages faulted under the requested node policy
+    size_t bytes;               // Segment size
+    int64_t setup_ns;           // Create, size, header and fault in every page
+    std::string error;
+};
+
+/**
+ * @brief Parse manifest text
+ * @param error Set to "line N: ..." on failure (optional)
+ */
+bool parseManifest(const std::string& text, std::vector<ChannelSpec>& out,
+                   std::string* error = nullptr);
+
+/**
+ * @brief Read and parse a manifest file
+ */
+bool loadManifest(const std::string& path, std::vector<ChannelSpec>& out,
+                  std::string* error = nullptr);
+
+/**
+ * @brief Create and pre-fault every channel, in parallel
+ *
+ * Segments already provisioned with the same layout are kept (and
+ * faulted in again if needed). When a registry is given, each channel
+ * is advertised in it. BARQ and CASIR channels fail with "broker
+ * running, use its pools" while the broker daemon runs.
+ *
+ * @param threads Worker threads (0 = one per channel, up to the core count)
+ * @return Number of channels provisioned successfully
+ */
+size_t provisionChannels(const std::vector<ChannelSpec>& specs,
+                         std::vector<ProvisionReport>& reports,
+                         size_t threads = 0, Registry* registry = nullptr);
+
+/**
+ * @brief Remove provisioned segments (and their registry entries)
+ * @return Number of segments removed
+ */
+size_t unprovisionChannels(const std::vector<ChannelSpec>& specs, Registry* registry = nullptr);
+
+} // namespace SIM
+
+#endif // PROVISION_HPP
@@ -0,0 +1,268 @@
+/**
+ * @file publish_group.hpp
+ * @brief Atomic multi-channel publish groups (objects + free space + lanes)
+ *
+ * A PublishGroup stages writes into several BARQ/CASIR channels and makes
+ * them visible together with one group-sequence bump:
+ * - Writer fills each channel's back buffer, then publish() commits them
+ *   inside a seqlock window of a small group segment that records the
+ *   frame number of every member
+ * - GroupReader reads that record and peeks each channel's front buffer
+ *   for exactly those frames: a lock-free, zero-copy snapshot where every
+ *   member comes from the same group sequence
+ *
+ * Member channels stay ordinary channels: plain readers keep working.
+ * They must only be written through the group.
+ *
+ * Usage:
+ *   BARQ::Writer objects("/objects", OBJ_SIZE), lanes("/lanes", LANE_SIZE);
+ *   objects.init(); lanes.init();
+ *   SIM::PublishGroup group("/perception");
+ *   int obj = group.addChannel(objects);
+ *   int lan = group.addChannel(lanes);
+ *   group.init();
+ *   fillObjects(group.getWriteBuffer(obj)); group.stage(obj, n1);
+ *   group.write(lan, lane_data, n2);
+ *   group.publish();
+ *
+ *   SIM::GroupReader reader("/perception");   // opens member channels itself
+ *   reader.init();
+ *   SIM::GroupSnapshot snap;
+ *   if (reader.readWithTimeout(snap, 100)) use(snap.members[0], snap.members[1]);
+ */
+
+#ifndef PUBLISH_GROUP_HPP
+#define PUBLISH_GROUP_HPP
+
+#include "barq.hpp"
+#include "casir.hpp"
+#include "wait_strategy.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SIM {
+
+constexpr uint32_t GROUP_MAGIC = 0x47525550;    // "GRUP"
+constexpr uint32_t GROUP_VERSION = 0x00010000;
+constexpr size_t MAX_GROUP_CHANNELS = 16;
+constexpr size_t GROUP_NAME_LEN = 64;
+
+/**
+ * @enum GroupTransport
+ */
+enum class GroupTransport : uint32_t {
+    BARQ = 0,
+    CASIR = 1
+};
+
+/**
+ * @struct GroupMemberInfo
+ * @brief Member channel description (written once at init)
+ */
+struct GroupMemberInfo {
+    char name[GROUP_NAME_LEN];
+    uint32_t transport;
+    uint32_t reserved;
+    uint64_t max_size;
+};
+
+/**
+ * @struct GroupHeader
+ * @brief Shared group segment
+ */
+struct alignas(CACHE_LINE_SIZE) GroupHeader {
+    // === Static metadata ===
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_channels;
+    uint32_t reserved;
+    GroupMemberInfo members[MAX_GROUP_CHANNELS];
+    
+    // === Seqlock: odd while publishing, group sequence = seq / 2 ===
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> seq;
+    std::atomic<int64_t> timestamp_ns;
+    std::atomic<uint64_t> frames[MAX_GROUP_CHANNELS];   // Member frame per group
+    
+    // === Reader wake-up ===
+    alignas(CACHE_LINE_SIZE) NotifyWord notify;
+};
+
+static_assert(sizeof(GroupHeader) % CACHE_LINE_SIZE == 0, "GroupHeader must be cache-line aligned");
+
+/**
+ * @class PublishGroup
+ * @brief Stages writes to member channels and publishes them atomically
+ */
+class PublishGroup {
+public:
+    explicit PublishGroup(const std::string& name);
+    ~PublishGroup();
+    
+    PublishGroup(const PublishGroup&) = delete;
+    PublishGroup& operator=(const PublishGroup&) = delete;
+    
+    /**
+     * @brief Add an initialized member channel (before init())
+     * @return Member index, or -1 on error
+     */
+    int addChannel(BARQ::Writer& writer);
+    int addChannel(CASIR::Writer& writer);
+    
+    /**
+     * @brief Create the group segment
+     */
+    bool init();
+    
+    /**
+     * @brief Back buffer of a member (fill, then stage())
+     */
+    void* getWriteBuffer(int channel);
+    
+    /**
+     * @brief Mark a member as filled with size bytes for the next publish()
+     */
+    bool stage(int channel, size_t size);
+    
+    /**
+     * @brief Copy data into a member's back buffer and stage it
+     */
+    bool write(int channel, const void* data, size_t size);
+    
+    /**
+     * @brief Commit all staged members as one group
+     *
+     * Members not staged keep their previous frame in the new group.
+     * @return New group sequence, 0 on failure
+     */
+    uint64_t publish();
+    
+    uint64_t getGroupSequence() const;
+    size_t getChannelCount() const { return members_.size(); }
+    bool isReady() const { return initialized_; }
+    
+    void destroy();
+
+private:
+    struct Member {
+        GroupTransport transport;
+        BARQ::Writer* barq;
+        CASIR::Writer* casir;
+        size_t max_size;
+        size_t staged_size;
+        bool staged;
+    };
+    
+    int addMember(GroupTransport transport, BARQ::Writer* barq, CASIR::Writer* casir,
+                  const std::string& name, size_t max_size);
+    uint64_t frameOf(const Member& member) const;
+    size_t maxSizeOf(const Member& member) const;
+    
+    std::string name_;
+    bool initialized_;
+    int fd_;
+    void* ptr_;
+    size_t shm_size_;
+    GroupHeader* header_;
+    std::vector<Member> members_;
+    std::vector<std::string> member_names_;
+};
+
+/**
+ * @struct GroupMember
+ * @brief One member of a snapshot (zero-copy)
+ */
+struct GroupMember {
+    const void* data;
+    size_t size;
+    int64_t timestamp_ns;
+    uint64_t frame;
+};
+
+/**
+ * @struct GroupSnapshot
+ * @brief All members at one group sequence
+ */
+struct GroupSnapshot {
+    uint64_t sequence;
+    int64_t timestamp_ns;                   // publish() time
+    std::vector<GroupMember> members;       // addChannel() order
+};
+
+/**
+ * @class GroupReader
+ * @brief Lock-free consistent reads of a publish group
+ */
+class GroupReader {
+public:
+    explicit GroupReader(const std::string& name);
+    ~GroupReader();
+    
+    GroupReader(const GroupReader&) = delete;
+    GroupReader& operator=(const GroupReader&) = delete;
+    
+    /**
+     * @brief Open the group segment and all member channels
+     */
+    bool init();
+    
+    /**
+     * @brief Latest group newer than the last read
+     *
+     * Member pointers stay valid at least until the next publish() and
+     * until the writer starts staging the group after it; validate()
+     * confirms the members are still current.
+     * @return false if no new group (or writer kept publishing mid-read)
+     */
+    bool read(GroupSnapshot& out);
+    
+    bool readWithTimeout(GroupSnapshot& out, uint32_t timeout_ms);
+    
+    /**
+     * @brief Check that every member of a snapshot is still current
+     */
+    bool validate(const GroupSnapshot& snapshot) const;
+    
+    bool hasNewData() const;
+    bool waitForData(uint32_t timeout_ms);
+    void setWaitStrategy(const WaitStrategy& strategy) { wait_strategy_ = strategy; }
+    NotifyWord* getNotifyWord() const { return notify_.get(); }
+    
+    bool isReady() const { return initialized_; }
+    size_t getChannelCount() const { return members_.size(); }
+    const std::string& getChannelName(size_t index) const { return members_[index].name; }
+    uint64_t getLastSequence() const { return last_sequence_; }
+    uint64_t getRetries() const { return retries_; }
+
+private:
+    struct Member {
+        std::string name;
+        GroupTransport transport;
+        std::unique_ptr<BARQ::Reader> barq;
+        std::unique_ptr<CASIR::Reader> casir;
+    };
+    
+    const void* peek(const Member& member, uint64_t frame, size_t& size,
+                     int64_t& timestamp_ns) const;
+    void cleanup();
+    
+    std::string name_;
+    bool initialized_;
+    int fd_;
+    void* ptr_;
+    size_t shm_size_;
+    const GroupHeader* header_;
+    std::vector<Member> members_;
+    
+    uint64_t last_sequence_;
+    uint64_t retries_;
+    NotifyView notify_;
+    WaitStrategy wait_strategy_;
+};
+
+} // namespace SIM
+
+#endif // PUBLISH_GROUP_HPP
@@ -0,0 +1,288 @@
+/**
+ * @file registry.hpp
+ * @brief Topic Registry - host-wide discovery of channels
+ *
+ * One shared segment where writers advertise their channels:
+ * - Name, transport, layout version, capacity, metadata size and rate
+ * - Lock-free lookups (per-entry seqlock), writers serialize on a spinlock
+ *   holding their pid: a dead holder is taken over and its torn entry
+ *   withdrawn
+ * - Attach a reader by name alone, sizes come from the registry
+ * - Wildcard (fnmatch) watches report topics as they come and go
+ *
+ * Usage:
+ *   // Writer side
+ *   SIM::Registry registry;
+ *   registry.open();
+ *   int entry = registry.advertise(SIM::TopicInfo::make(
+ *       "/camera", SIM::TransportType::BARQ, 1920*1080*3, BARQ::VERSION, 0, 30.0));
+ *
+ *   // Reader side: no sizes hard-coded
+ *   auto reader = registry.attach<BARQ::Reader>("/camera");
+ *
+ *   // Tools
+ *   SIM::RegistryWatch watch(registry, "/lidar_*");
+ *   std::vector<SIM::TopicInfo> added; std::vector<std::string> removed;
+ *   for (;;) {
+ *       watch.wait(added, removed, 1000);
+ *       for (auto& t : added) ...
+ *   }
+ */
+
+#ifndef REGISTRY_HPP
+#define REGISTRY_HPP
+
+#include "wait_strategy.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SIM {
+
+constexpr uint32_t REGISTRY_MAGIC = 0x52454730;     // "REG0"
+constexpr uint32_t REGISTRY_VERSION = 0x00010000;
+constexpr uint32_t REGISTRY_DEFAULT_CAPACITY = 1024;
+constexpr size_t REGISTRY_NAME_LEN = 64;
+constexpr const char* REGISTRY_DEFAULT_NAME = "/sim_registry";
+
+/**
+ * @enum TransportType
+ * @brief Transport behind a registered topic
+ */
+enum class TransportType : uint32_t {
+    Unknown = 0,
+    SIM = 1,
+    SAHM = 2,
+    BARQ = 3,
+    CASIR = 4,
+    Mux = 5
+};
+
+const char* transportName(TransportType transport);
+
+/**
+ * @struct TopicInfo
+ * @brief What a writer advertises about its channel
+ */
+struct TopicInfo {
+    std::string name;           // Shared memory / control channel name
+    TransportType transport;
+    uint32_t layout_version;    // Transport header version (BARQ::VERSION...)
+    size_t max_size;            // Max bytes per frame (slot size for SAHM)
+    size_t meta_size;           // Per-frame user metadata bytes
+    double rate_hz;             // Nominal or measured publish rate (0 = unknown)
+    int32_t pid;                // Advertising process (filled by advertise())
+    int64_t updated_ns;         // Last advertise()/updateRate()
+    
+    static TopicInfo make(const std::string& name, TransportType transport, size_t max_size,
+                          uint32_t layout_version = 0, size_t meta_size = 0,
+                          double rate_hz = 0.0) {
+        TopicInfo info;
+        info.name = name;
+        info.transport = transport;
+        info.layout_version = layout_version;
+        info.max_size = max_size;
+        info.meta_size = meta_size;
+        info.rate_hz = rate_hz;
+        info.pid = 0;
+        info.updated_ns = 0;
+        return info;
+    }
+};
+
+/**
+ * @struct RegistryRecord
+ * @brief Plain entry payload, copied under the entry seqlock
+ */
+struct RegistryRecord {
+    char name[REGISTRY_NAME_LEN];
+    uint32_t hash;
+    uint32_t transport;
+    uint32_t layout_version;
+    int32_t pid;
+    uint64_t max_size;
+    uint64_t meta_size;
+    double rate_hz;
+    int64_t updated_ns;
+};
+
+/**
+ * @struct RegistryEntry
+ * @brief One hash table slot (2 cache lines)
+ */
+struct alignas(CACHE_LINE_SIZE) RegistryEntry {
+    std::atomic<uint32_t> seq;      // Odd while the record is being rewritten
+    std::atomic<uint32_t> state;    // 0 = free, 1 = live, 2 = withdrawn (keeps probe chains)
+    RegistryRecord record;
+};
+
+static_assert(sizeof(RegistryEntry) == 2 * CACHE_LINE_SIZE, "RegistryEntry must be 2 cache lines");
+
+/**
+ * @struct RegistryHeader
+ * @brief Segment header, followed by capacity entries
+ */
+struct alignas(CACHE_LINE_SIZE) RegistryHeader {
+    // === Cache Line 0: Layout (static) ===
+    std::atomic<uint32_t> magic;    // Set last by the creator
+    uint32_t version;
+    uint32_t capacity;              // Power of two
+    uint32_t reserved;
+    char pad0[CACHE_LINE_SIZE - 16];
+    
+    // === Cache Line 1: Writers ===
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> lock;   // Holder pid (0 = free)
+    std::atomic<uint32_t> live;
+    
+    // === Cache Line 2: Change notification (seq = generation) ===
+    alignas(CACHE_LINE_SIZE) NotifyWord notify;
+};
+
+/**
+ * @class Registry
+ * @brief Process-side handle on the host-wide registry segment
+ */
+class Registry {
+public:
+    explicit Registry(const std::string& name = REGISTRY_DEFAULT_NAME);
+    ~Registry();
+    
+    Registry(const Registry&) = delete;
+    Registry& operator=(const Registry&) = delete;
+    
+    /**
+     * @brief Attach to the registry, creating it if it does not exist
+     * @param capacity Entry count when creating (rounded up to a power of two)
+     */
+    bool open(uint32_t capacity = REGISTRY_DEFAULT_CAPACITY);
+    
+    /**
+     * @brief Advertise a topic (replaces an entry with the same name)
+     * @return Entry id, or -1 if full or the name does not fit
+     */
+    int advertise(const TopicInfo& info);
+    
+    /**
+     * @brief Refresh the advertised rate and update time
+     */
+    bool updateRate(int entry, double rate_hz);
+    
+    /**
+     * @brief Remove an advertised topic
+     */
+    bool withdraw(int entry);
+    bool withdraw(const std::string& topic);
+    
+    /**
+     * @brief Look a topic up by exact name (lock-free)
+     */
+    bool lookup(const std::string& topic, TopicInfo& out) const;
+    
+    /**
+     * @brief Topics whose name matches a shell wildcard pattern (lock-free)
+     * @return Number of topics appended to out
+     */
+    size_t list(std::vector<TopicInfo>& out, const std::string& pattern = "*") const;
+    
+    /**
+     * @brief Construct and init() a reader sized from the registry
+     *
+     * Works with BARQ::Reader, CASIR::Reader, SIM::Reader and
+     * SAHM::DirectReader (default ring size).
+     *
+     * @return nullptr if the topic is unknown or init() fails
+     */
+    template <typename Reader>
+    std::unique_ptr<Reader> attach(const std::string& topic) const {
+        TopicInfo info;
+        if (!lookup(topic, info)) return nullptr;
+        std::unique_ptr<Reader> reader(new Reader(info.name, info.max_size));
+        if (!reader->init()) return nullptr;
+        return reader;
+    }
+    
+    /**
+     * @brief Bumped on every advertise()/withdraw()
+     */
+    uint32_t getGeneration() const;
+    NotifyWord* getNotifyWord() const { return header_ ? &header_->notify : nullptr; }
+    
+    bool isReady() const { return header_ != nullptr; }
+    uint32_t getCapacity() const { return header_ ? header_->capacity : 0; }
+    size_t getTopicCount() const;
+    const std::string& getName() const { return name_; }
+    
+    /**
+     * @brief Unmap (the segment itself stays for other processes)
+     */
+    void close();
+    
+    /**
+     * @brief Remove the registry segment from the host
+     */
+    static bool unlink(const std::string& name = REGISTRY_DEFAULT_NAME);
+
+private:
+    bool readEntry(uint32_t index, RegistryRecord& out) const;
+    int find(const char* topic, uint32_t hash) const;
+    
+    // Writer spinlock in the shared segment (const: this handle is unchanged)
+    void lock() const;
+    void unlock() const;
+    bool takeOver(uint32_t holder) const;
+    void repair() const;
+    
+    std::string name_;
+    int fd_;
+    void* ptr_;
+    size_t shm_size_;
+    RegistryHeader* header_;
+    RegistryEntry* entries_;
+};
+
+/**
+ * @class RegistryWatch
+ * @brief Wildcard subscription to the registry
+ *
+ * Reports topics matching the pattern as they are advertised (or
+ * re-advertised with a new layout) and withdrawn. The first poll()
+ * reports every matching topic already present. Single thread.
+ */
+class RegistryWatch {
+public:
+    RegistryWatch(Registry& registry, const std::string& pattern);
+    
+    /**
+     * @brief Changes since the last poll()
+     * @return Number of added + removed topics
+     */
+    size_t poll(std::vector<TopicInfo>& added, std::vector<std::string>& removed);
+    
+    /**
+     * @brief Block until the registry changes, then poll()
+     */
+    size_t wait(std::vector<TopicInfo>& added, std::vector<std::string>& removed,
+                uint32_t timeout_ms);
+    
+    /**
+     * @brief Registry changed since the last poll() (may not match the pattern)
+     */
+    bool hasNewData() const { return registry_.getGeneration() != generation_; }
+    NotifyWord* getNotifyWord() const { return registry_.getNotifyWord(); }
+    void setWaitStrategy(const WaitStrategy& strategy) { wait_strategy_ = strategy; }
+
+private:
+    Registry& registry_;
+    std::string pattern_;
+    uint32_t generation_;
+    bool primed_;
+    std::vector<TopicInfo> known_;
+    WaitStrategy wait_strategy_;
+};
+
+} // namespace SIM
+
+#endif // REGISTRY_HPP
@@ -0,0 +1,202 @@
+/**
+ * @file replica.hpp
+ * @brief Per-NUMA-node replicas of a BARQ channel
+ *
+ * A reader on the other socket pulls every frame across the interconnect,
+ * and N remote readers pay that N times. A replicated channel keeps one
+ * copy per NUMA node: the channel itself on the writer's node and
+ * "<name>@node<N>" on every other node, each laid out in its node's
+ * memory. The frame crosses the interconnect once per node:
+ * - Relay (default): a ReplicaRelay thread running on the remote node
+ *   reads the channel and republishes into the replica, so the writer's
+ *   publish cost does not change. Relays can also run in another process
+ * - Inline: the writer copies each frame into every replica itself (no
+ *   extra threads, the writer pays for the copies)
+ *
+ * BARQ readers attach to the replica of the node they run on when it
+ * exists (see BARQ::Reader::init()), so existing readers need no change.
+ * Replicas keep the source frame's timestamp and metadata; their sequence
+ * numbers are their own. On single-node hosts no replicas are created.
+ *
+ * Usage:
+ *   SIM::ReplicatedWriter writer("/camera", 8 << 20);
+ *   writer.init();
+ *   writer.write(frame, size);
+ *
+ *   // On either socket
+ *   BARQ::Reader reader("/camera", 8 << 20);   // "/camera@node1" on node 1
+ */
+
+#ifndef REPLICA_HPP
+#define REPLICA_HPP
+
+#include "barq.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SIM {
+
+/**
+ * @brief Name of the replica of channel on node ("<channel>@node<N>")
+ */
+std::string replicaName(const std::string& channel, int node);
+
+/**
+ * @brief Replica for the calling thread's node if one exists, else channel
+ */
+std::string localReplicaName(const std::string& channel);
+
+/**
+ * @enum ReplicaMode
+ * @brief Who copies frames into the replicas
+ */
+enum class ReplicaMode : uint32_t {
+    Relay = 0,      // One relay thread per remote node
+    Inline          // The writer, on every publish
+};
+
+/**
+ * @struct ReplicaOptions
+ * @brief Replicated channel configuration
+ */
+struct ReplicaOptions {
+    ReplicaMode mode;
+    std::vector<int> nodes;     // Replica nodes (empty = every node with CPUs but the writer's)
+
+    static ReplicaOptions defaults() {
+        ReplicaOptions opts;
+        opts.mode = ReplicaMode::Relay;
+        return opts;
+    }
+};
+
+/**
+ * @struct ReplicaStats
+ * @brief Frames copied into one replica
+ */
+struct ReplicaStats {
+    int node;
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t skipped;           // Source frames overwritten before the relay got them
+};
+
+/**
+ * @class ReplicaRelay
+ * @brief Thread on a node republishing a channel into that node's replica
+ */
+class ReplicaRelay {
+public:
+    /**
+     * @param channel Source channel (the writer's)
+     * @param node Node to run on and to replicate to
+     * @param use_huge_pages Same as for BARQ::Writer
+     */
+    ReplicaRelay(const std::string& channel, int node, bool use_huge_pages = true);
+    ~ReplicaRelay();
+
+    ReplicaRelay(const ReplicaRelay&) = delete;
+    ReplicaRelay& operator=(const ReplicaRelay&) = delete;
+
+    /**
+     * @brief Start the relay thread
+     *
+     * Waits until the source channel can be read and the replica has been
+     * created from the node's CPUs.
+     *
+     * @return false if the node has no usable CPU or the channel does not exist
+     */
+    bool start(uint32_t timeout_ms = 1000);
+
+    /**
+     * @brief Stop the thread and remove the replica
+     */
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+    int getNode() const { return node_; }
+    ReplicaStats getStats() const;
+
+private:
+    std::string channel_;
+    int node_;
+    bool use_huge_pages_;
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+    std::atomic<bool> stop_;
+    std::atomic<int> state_;        // 0 = starting, 1 = ready, -1 = failed
+    std::atomic<uint64_t> frames_;
+    std::atomic<uint64_t> bytes_;
+    std::atomic<uint64_t> skipped_;
+
+    void run();
+};
+
+/**
+ * @class ReplicatedWriter
+ * @brief BARQ writer publishing to one channel and its node replicas
+ */
+class ReplicatedWriter {
+public:
+    ReplicatedWriter(const std::string& name, size_t max_size,
+                     const ReplicaOptions& options = ReplicaOptions::defaults(),
+                     bool use_huge_pages = true, size_t meta_size = 0);
+    ~ReplicatedWriter();
+
+    ReplicatedWriter(const ReplicatedWriter&) = delete;
+    ReplicatedWriter& operator=(const ReplicatedWriter&) = delete;
+
+    /**
+     * @brief Create the channel, then the replicas (each from its node's CPUs)
+     *
+     * The writer's node is the node of the calling thread: pin it first.
+     *
+     * @return false if the channel itself could not be created; a replica
+     *         that fails is left out (its readers use the channel)
+     */
+    bool init();
+
+    bool write(const void* data, size_t size);
+    void* getWriteBuffer();
+    void* getWriteMetadata();
+    bool commit(size_t size);
+
+    BARQ::Writer& primary() { return primary_; }
+    bool isReady() const { return primary_.isReady(); }
+
+    /**
+     * @brief Nodes with a live replica
+     */
+    std::vector<int> getReplicaNodes() const;
+    std::vector<ReplicaStats> getStats() const;
+
+    void destroy();
+
+private:
+    struct InlineReplica {
+        int node;
+        std::unique_ptr<BARQ::Writer> writer;
+        uint64_t frames;
+        uint64_t bytes;
+    };
+
+    BARQ::Writer primary_;
+    ReplicaOptions options_;
+    bool use_huge_pages_;
+    size_t meta_size_;
+    std::vector<std::unique_ptr<ReplicaRelay>> relays_;
+    std::vector<InlineReplica> inline_;
+
+    void copyToReplicas(const void* frame, const void* meta, size_t size, int64_t ts);
+};
+
+} // namespace SIM
+
+#endif // REPLICA_HPP
@@ -7,6 +7,7 @@
  * - Writer writes cyclically to slots
  * - Reader copies to history when it wants
  * - Zero synchronization overhead per write
+ * - Futex wake-up per ring for blocked readers
  */
 
 #ifndef SAHM_HPP
@@ -19,6 +20,9 @@
 #include <vector>
 #include <memory>
 
+#include "gather.hpp"
+#include "wait_strategy.hpp"
+
 namespace SAHM {
 
 // Constants
@@ -38,6 +42,7 @@ struct alignas(CACHE_LINE) ControlHeader {
     size_t max_slot_size;           // Max data per slot
     
     std::atomic<uint32_t> num_readers;
+    std::atomic<int32_t> writer_pid;    // 0 = no writer attached (see gc.hpp)
     std::atomic<int64_t> writer_heartbeat_ns;
     
     // Reader registration
@@ -70,6 +75,8 @@ struct alignas(CACHE_LINE) RingBufferHeader {
     std::atomic<uint32_t> write_idx;    // Next slot to write (cyclic)
     std::atomic<uint64_t> total_writes; // Total writes (monotonic)
     
+    SIM::NotifyWord notify;             // Bumped by writer after each slot
+    
     // Slots start after header at offset sizeof(RingBufferHeader)
 };
 
@@ -96,6 +103,12 @@ public:
      */
     int write(const void* data, size_t size);
     
+    /**
+     * @brief Write a multi-part message gathered into every reader's next slot
+     * @return Number of readers written to
+     */
+    int writev(const struct iovec* iov, int iovcnt);
+    
     /**
      * @brief Get direct pointers to current write slots
      * @return Vector of pointers to slot data areas
@@ -115,6 +128,10 @@ private:
     void discoverReaders();
     int64_t getCurrentTimestampNs();
     
+    // Slot, sequence and notify for every reader; fill(slot_data) copies the payload
+    template <typename Fill>
+    int publish(size_t size, Fill fill);
+    
     std::string channel_name_;
     size_t max_slot_size_;
     bool is_initialized_;
@@ -168,6 +185,35 @@ public:
      */
     const void* getLatest(size_t& size);
     
+    /**
+     * @brief Get latest slot, waiting up to timeout_ms for a new write
+     * @return Pointer to data, or nullptr on timeout
+     */
+    const void* getLatestWithTimeout(size_t& size, uint32_t timeout_ms);
+    
+    /**
+     * @brief Wait until a write newer than the last getLatest() arrives
+     * @return true if new data is available
+     */
+    bool waitForData(uint32_t timeout_ms);
+    
+    /**
+     * @brief Check for a write newer than the last getLatest()
+     */
+    bool hasNewData() const;
+    
+    /**
+     * @brief Select how the reader waits for new data
+     */
+    void setWaitStrategy(const SIM::WaitStrategy& strategy) { wait_strategy_ = strategy; }
+    
+    /**
+     * @brief Notify word of this reader's ring (for WaitSet/executors)
+     */
+    SIM::NotifyWord* getNotifyWord() const {
+        return ring_header_ ? &ring_header_->notify : nullptr;
+    }
+    
     /**
      * @brief Get pointer to specific slot by index
      * @param slot_idx Index 0 to ring_size-1
@@ -231,6 +277,9 @@ private:
     RingBufferHeader* ring_header_;
     uint8_t* slots_base_;
     size_t slot_total_size_;
+    
+    uint64_t last_seen_total_;
+    SIM::WaitStrategy wait_strategy_;
 };
 
 } // namespace SAHM
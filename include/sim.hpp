@@ -12,6 +12,8 @@
  * - Latenza sub-millisecondo
  * - Checksum opzionale
  * - POSIX shared memory
+ * - Attesa bloccante su futex (vedi wait_strategy.hpp)
+ * - Metadati utente opzionali per frame, accanto all'header
  * 
  * Uso tipico:
  *   // Writer
@@ -32,11 +34,14 @@
 #include <chrono>
 #include <memory>
 
+#include "gather.hpp"
+#include "wait_strategy.hpp"
+
 namespace SIM {
 
 // Versione libreria
 constexpr uint32_t VERSION_MAJOR = 1;
-constexpr uint32_t VERSION_MINOR = 0;
+constexpr uint32_t VERSION_MINOR = 2;
 
 // Configurazione default
 constexpr size_t DEFAULT_MAX_SIZE = 1920 * 1080 * 3;  // 1080p RGB
@@ -79,7 +84,18 @@ struct Header {
     // Flag checksum abilitato
     std::atomic<bool> checksum_enabled;
     
-    // Padding per allineamento cache line (64 byte)
+    // Byte di metadati utente per frame (0 = nessuno). Due blocchi,
+    // uno per buffer, seguono l'header e precedono i buffer dati
+    uint32_t meta_size;
+    
+    // PID del writer attivo (0 = nessuno), usato dal garbage collector (gc.hpp)
+    std::atomic<int32_t> writer_pid;
+    
+    // Parola futex per risvegliare i reader bloccati (cache line propria)
+    NotifyWord notify;
+    
+    // Riservato: l'allineamento lo da gia NotifyWord (alignas 64). Tiene
+    // l'header a 256 byte, cioe gli offset di metadati e buffer invariati
     char padding[16];
 };
 
@@ -97,8 +113,10 @@ public:
      * @param shm_name Nome shared memory (es. "/camera_front")
      * @param max_size Dimensione massima payload in byte
      * @param enable_checksum Abilita verifica checksum (default: false)
+     * @param meta_size Byte di metadati utente per frame (default: 0)
      */
-    Writer(const std::string& shm_name, size_t max_size, bool enable_checksum = false);
+    Writer(const std::string& shm_name, size_t max_size, bool enable_checksum = false,
+           size_t meta_size = 0);
     
     /**
      * @brief Distruttore - rilascia risorse ma NON cancella shared memory
@@ -127,6 +145,31 @@ public:
      */
     bool write(const void* data, size_t size);
     
+    /**
+     * @brief Scrive un messaggio in piu parti (header + payload...)
+     * 
+     * I segmenti vengono copiati direttamente nel back buffer,
+     * senza buffer intermedio.
+     * 
+     * @return true se successo, false se la somma > capacity
+     */
+    bool writev(const struct iovec* iov, int iovcnt);
+    
+    /**
+     * @brief Blocco metadati utente del back buffer
+     * 
+     * Da riempire prima di write()/writev(): viene pubblicato
+     * atomicamente insieme al frame, senza toccare il payload.
+     * 
+     * @return Puntatore a meta_size byte, nullptr se meta_size == 0
+     */
+    void* getWriteMetadata();
+    
+    /**
+     * @brief Dimensione del blocco metadati utente
+     */
+    size_t getMetadataSize() const { return meta_size_; }
+    
     /**
      * @brief Verifica se la shared memory e pronta
      */
@@ -160,6 +203,7 @@ public:
 private:
     std::string shm_name_;
     size_t max_size_;
+    size_t meta_size_;
     bool enable_checksum_;
     bool is_initialized_;
     int shm_fd_;
@@ -167,8 +211,11 @@ private:
     size_t shm_size_;
     Header* header_;
     uint8_t* buffer_[2];
+    uint8_t* meta_[2];
     uint64_t frame_count_;
     
+    // Metadati, checksum, flip e notify del back buffer gia riempito
+    void publishBack(uint32_t back, size_t size);
     uint32_t calculateChecksum(const void* data, size_t size) const;
     int64_t getCurrentTimestampNs() const;
 };
@@ -213,8 +260,18 @@ public:
      */
     bool read(void* data, size_t& size);
     
+    /**
+     * @brief Legge frame e metadati utente (getMetadataSize() byte)
+     * @param metadata Buffer destinazione metadati
+     */
+    bool read(void* data, size_t& size, void* metadata);
+    
     /**
      * @brief Legge dati con timeout
+     * 
+     * Attende secondo la WaitStrategy configurata
+     * (default: spin adattivo -> yield -> futex).
+     * 
      * @param data Buffer destinazione
      * @param size Output: dimensione dati letti
      * @param timeout_ms Timeout in millisecondi
@@ -222,6 +279,28 @@ public:
      */
     bool readWithTimeout(void* data, size_t& size, uint32_t timeout_ms);
     
+    /**
+     * @brief Attende un nuovo frame senza consumarlo
+     * @param timeout_ms Timeout in millisecondi
+     * @return true se e disponibile un nuovo frame
+     */
+    bool waitForData(uint32_t timeout_ms);
+    
+    /**
+     * @brief Verifica se e disponibile un frame piu recente dell'ultimo letto
+     */
+    bool hasNewData() const;
+    
+    /**
+     * @brief Imposta la strategia di attesa (spin, yield, futex, adattiva)
+     */
+    void setWaitStrategy(const WaitStrategy& strategy) { wait_strategy_ = strategy; }
+    
+    /**
+     * @brief Parola futex scrivibile per WaitSet (nullptr se read-only)
+     */
+    NotifyWord* getNotifyWord() const { return notify_.get(); }
+    
     /**
      * @brief Verifica se la shared memory e pronta
      */
@@ -253,6 +332,11 @@ public:
      * @return true se checksum OK o disabilitato, false se corrotto
      */
     bool verifyLastChecksum() const { return last_checksum_valid_; }
+    
+    /**
+     * @brief Dimensione del blocco metadati utente (0 = nessuno)
+     */
+    size_t getMetadataSize() const { return header_ ? header_->meta_size : 0; }
 
 private:
     std::string shm_name_;
@@ -263,10 +347,14 @@ private:
     size_t shm_size_;
     Header* header_;
     const uint8_t* buffer_[2];
+    const uint8_t* meta_[2];
     uint64_t last_frame_;
+    uint32_t last_idx_;
     int64_t last_timestamp_ns_;
     uint64_t dropped_frames_;
     bool last_checksum_valid_;
+    NotifyView notify_;
+    WaitStrategy wait_strategy_;
     
     uint32_t calculateChecksum(const void* data, size_t size) const;
     int64_t getCurrentTimestampNs() const;
@@ -0,0 +1,196 @@
+/**
+ * @file synchronizer.hpp
+ * @brief Multi-channel timestamp synchronizer (camera + lidar + radar)
+ *
+ * Matches frames across channels with different rates, directly in shared
+ * memory (no private queues, no copies):
+ * - SAHM channels are searched through their ring history (binary search
+ *   by timestamp, O(log ring_size) per channel and arrival)
+ * - Any other reader (BARQ, CASIR, DerivedReader) contributes its latest value
+ * - Channel 0 is the reference: each of its frames yields at most one tuple
+ *
+ * Policies:
+ * - Exact:       timestamps must be equal (hardware-triggered sensors,
+ *                usually with a TimestampFn reading the payload stamp)
+ * - Approximate: nearest frame within tolerance_ns; waits up to max_wait_ns
+ *                for a closer frame that may still arrive
+ *
+ * Tuple pointers stay valid until the writer laps the ring; verify() tells
+ * whether that happened while processing.
+ *
+ * Usage:
+ *   SIM::Synchronizer sync(SIM::SyncConfig::approximate(5000000));  // 5ms
+ *   sync.addChannel(camera_ring);       // reference
+ *   sync.addChannel(lidar_ring);
+ *   sync.addChannel(radar_barq);
+ *   SIM::SyncTuple t;
+ *   while (sync.waitNext(t, 100)) fuse(t.frames[0], t.frames[1], t.frames[2]);
+ */
+
+#ifndef SYNCHRONIZER_HPP
+#define SYNCHRONIZER_HPP
+
+#include "coro.hpp"
+#include "wait_set.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace SIM {
+
+/**
+ * @enum SyncPolicy
+ */
+enum class SyncPolicy : uint32_t {
+    Exact = 0,
+    Approximate = 1
+};
+
+/**
+ * @struct SyncConfig
+ */
+struct SyncConfig {
+    SyncPolicy policy;
+    int64_t tolerance_ns;   // Max |t - t_ref| per channel (0 for Exact)
+    int64_t max_wait_ns;    // How long after t_ref to wait for late channels
+    
+    static SyncConfig exact(int64_t max_wait_ns = 100000000) {
+        SyncConfig cfg;
+        cfg.policy = SyncPolicy::Exact;
+        cfg.tolerance_ns = 0;
+        cfg.max_wait_ns = max_wait_ns;
+        return cfg;
+    }
+    
+    static SyncConfig approximate(int64_t tolerance_ns, int64_t max_wait_ns = 100000000) {
+        SyncConfig cfg;
+        cfg.policy = SyncPolicy::Approximate;
+        cfg.tolerance_ns = tolerance_ns;
+        cfg.max_wait_ns = max_wait_ns;
+        return cfg;
+    }
+};
+
+/**
+ * @struct SyncFrame
+ * @brief Zero-copy frame of one channel inside a tuple
+ */
+struct SyncFrame {
+    const void* data;
+    size_t size;
+    int64_t timestamp_ns;
+    uint64_t sequence;      // SAHM write sequence, or local counter for latest-value channels
+};
+
+/**
+ * @struct SyncTuple
+ * @brief One frame per channel, in addChannel() order
+ */
+struct SyncTuple {
+    std::vector<SyncFrame> frames;
+    int64_t timestamp_ns;   // Reference (channel 0) timestamp
+    int64_t spread_ns;      // Max - min timestamp in the tuple
+};
+
+/**
+ * @struct SyncStats
+ */
+struct SyncStats {
+    uint64_t emitted;       // Tuples produced
+    uint64_t dropped;       // Reference frames without a match
+    uint64_t skipped;       // Reference frames overwritten before being matched
+    uint64_t searches;      // Timestamp reads during binary searches
+};
+
+/**
+ * @brief Extract the capture timestamp from a payload (default: transport timestamp)
+ */
+using TimestampFn = std::function<int64_t(const void* data, size_t size)>;
+
+/**
+ * @class Synchronizer
+ * @brief Emits timestamp-aligned tuples across channels (single thread)
+ */
+class Synchronizer {
+public:
+    explicit Synchronizer(const SyncConfig& config);
+    ~Synchronizer();
+    
+    Synchronizer(const Synchronizer&) = delete;
+    Synchronizer& operator=(const Synchronizer&) = delete;
+    
+    /**
+     * @brief Add a SAHM reader, matched through its ring history
+     *
+     * The ring is read in place; getLatest() on this reader is still allowed.
+     * @return Channel index, or -1 on error
+     */
+    int addChannel(SAHM::DirectReader& reader, TimestampFn stamp = nullptr);
+    
+    /**
+     * @brief Add a latest-value reader (BARQ, CASIR, DerivedReader...)
+     *
+     * The synchronizer consumes from the reader; do not read it elsewhere.
+     */
+    template <typename Reader>
+    int addChannel(Reader& reader, TimestampFn stamp = nullptr) {
+        return addLatest(reader.getNotifyWord(),
+                         [&reader] { return reader.hasNewData(); },
+                         [&reader] { return fetchFrame(reader); },
+                         std::move(stamp));
+    }
+    
+    int addLatest(NotifyWord* word, std::function<bool()> has_data,
+                  std::function<Frame()> fetch, TimestampFn stamp = nullptr);
+    
+    /**
+     * @brief Produce the next tuple if one is ready (non-blocking)
+     */
+    bool next(SyncTuple& out);
+    
+    /**
+     * @brief Wait for the next tuple
+     */
+    bool waitNext(SyncTuple& out, uint32_t timeout_ms);
+    
+    /**
+     * @brief Check that no frame of the tuple was overwritten meanwhile
+     */
+    bool verify(const SyncTuple& tuple) const;
+    
+    size_t getChannelCount() const { return channels_.size(); }
+    SyncStats getStats() const { return stats_; }
+
+private:
+    struct Channel {
+        SAHM::DirectReader* ring;       // History channel, nullptr = latest value
+        uint32_t ring_size;
+        
+        std::function<bool()> has_data;
+        std::function<Frame()> fetch;
+        Frame current;
+        uint64_t current_seq;
+        
+        TimestampFn stamp;
+        int wait_id;
+    };
+    
+    bool range(Channel& ch, uint64_t& lo, uint64_t& hi);
+    bool frameAt(const Channel& ch, uint64_t seq, SyncFrame& frame) const;
+    bool timestampAt(Channel& ch, uint64_t seq, int64_t& timestamp_ns);
+    bool nearest(Channel& ch, int64_t target_ns, uint64_t lo, uint64_t hi,
+                 SyncFrame& best, int64_t& newest_ns);
+    
+    SyncConfig config_;
+    std::vector<Channel> channels_;
+    uint64_t next_ref_;     // Next reference sequence to match (0 = not started)
+    
+    WaitSet wait_set_;
+    std::vector<int> ready_;
+    SyncStats stats_;
+};
+
+} // namespace SIM
+
+#endif // SYNCHRONIZER_HPP
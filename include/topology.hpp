@@ -0,0 +1,172 @@
+/**
+ * @file topology.hpp
+ * @brief Host topology - one parsed snapshot of sysfs/procfs per process
+ *
+ * Cache sizes, NUMA nodes and huge page pools used to be re-read from
+ * sysfs and /proc/meminfo by every CASIR writer and reader, and by every
+ * fitsInL3()/shouldUseHugePages() call. The snapshot is built once, on
+ * first use, and covers:
+ * - Per-CPU caches (L1d/L1i/L2/L3), L3 sharing groups, SMT siblings
+ * - Packages, NUMA nodes and their distances
+ * - Huge page pools of every size, shmem THP mode
+ *
+ * The first process to build it publishes a copy in the shm segment
+ * "/sim_topology"; later processes map that instead of parsing (the copy
+ * is tied to the boot id). refresh() re-reads everything after CPU
+ * hotplug or a huge page pool change and replaces the shared copy.
+ * SIM_TOPOLOGY_CACHE=off skips the shared copy.
+ *
+ * Usage:
+ *   auto topo = SIM::Topology::get();
+ *   for (int cpu : topo->l3Group(3)) ...
+ *   int node = topo->nodeOfCpu(CacheUtils::getCurrentCpu());
+ */
+
+#ifndef TOPOLOGY_HPP
+#define TOPOLOGY_HPP
+
+#include "cache_utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace SIM {
+
+constexpr int TOPOLOGY_MAX_CPUS = 1024;
+constexpr int TOPOLOGY_MAX_NODES = 64;
+constexpr int TOPOLOGY_MAX_POOLS = 4;
+
+/**
+ * @struct CpuTopology
+ * @brief One logical CPU
+ */
+struct CpuTopology {
+    bool online;
+    int16_t node;           // NUMA node (0 without NUMA)
+    int32_t package;        // Physical package (socket)
+    int32_t core;           // Lowest CPU of its SMT sibling group
+    int32_t l3_group;       // Lowest CPU sharing its L3 (-1 = no L3)
+    uint32_t l1d_size;
+    uint32_t l1i_size;
+    uint32_t l2_size;
+    uint32_t l3_size;
+};
+
+/**
+ * @struct HugePagePool
+ * @brief Counters of one huge page size (/sys/kernel/mm/hugepages)
+ */
+struct HugePagePool {
+    size_t page_size;
+    size_t total;
+    size_t free;
+    size_t reserved;        // Free pages promised to existing mappings
+    size_t surplus;
+};
+
+/**
+ * @struct TopologySnapshot
+ * @brief Plain data, as shared between processes
+ */
+struct TopologySnapshot {
+    uint32_t magic;
+    uint32_t version;
+    char boot_id[40];
+    int64_t built_ns;                   // CLOCK_REALTIME
+
+    int32_t num_cpus;                   // Highest possible CPU + 1
+    int32_t num_nodes;
+    int32_t num_pools;
+    uint32_t line_size;
+    size_t default_huge_page_size;
+    bool thp_shmem;
+
+    CpuTopology cpus[TOPOLOGY_MAX_CPUS];
+    uint8_t distance[TOPOLOGY_MAX_NODES][TOPOLOGY_MAX_NODES];   // SLIT, 10 = local
+    HugePagePool pools[TOPOLOGY_MAX_POOLS];
+};
+
+/**
+ * @class Topology
+ * @brief Query API over a snapshot (immutable; refresh() publishes a new one)
+ */
+class Topology {
+public:
+    /**
+     * @brief Process-wide snapshot, built on first use
+     */
+    static std::shared_ptr<const Topology> get();
+
+    /**
+     * @brief Re-read sysfs/procfs and replace the process and shared snapshots
+     */
+    static std::shared_ptr<const Topology> refresh();
+
+    /**
+     * @brief Read from the shared copy instead of parsing
+     */
+    bool fromCache() const { return from_cache_; }
+    const TopologySnapshot& snapshot() const { return data_; }
+
+    int numCpus() const { return data_.num_cpus; }
+    int numNodes() const { return data_.num_nodes; }
+    std::vector<int> onlineCpus() const;
+
+    /**
+     * @brief CPU entry, or nullptr if out of range
+     */
+    const CpuTopology* cpu(int cpu_id) const;
+
+    int nodeOfCpu(int cpu_id) const;
+    std::vector<int> cpusOfNode(int node) const;
+
+    /**
+     * @brief Hardware threads of the core of cpu_id (cpu_id included)
+     */
+    std::vector<int> smtSiblings(int cpu_id) const;
+
+    /**
+     * @brief CPUs sharing the L3 of cpu_id (cpu_id included)
+     */
+    std::vector<int> l3Group(int cpu_id) const;
+
+    /**
+     * @brief SLIT distance between two nodes (10 = local, 0 if unknown)
+     */
+    int distance(int node_a, int node_b) const;
+
+    /**
+     * @brief Cache sizes seen from cpu_id
+     */
+    CacheInfo cacheInfo(int cpu_id = 0) const;
+
+    /**
+     * @brief Pool of the given page size (default size if 0), or nullptr
+     */
+    const HugePagePool* hugePagePool(size_t page_size = 0) const;
+
+    /**
+     * @brief Default pool in CacheUtils terms
+     */
+    HugePagesInfo hugePages() const;
+
+    NUMAInfo numa() const;
+
+private:
+    Topology() = default;
+
+    TopologySnapshot data_;
+    bool from_cache_ = false;
+};
+
+/**
+ * @brief Counters of one huge page pool, read now rather than from the snapshot
+ * @param page_size Pool page size (0 = default size)
+ */
+HugePagePool readHugePagePool(size_t page_size);
+
+} // namespace SIM
+
+#endif // TOPOLOGY_HPP
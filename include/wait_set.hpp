@@ -0,0 +1,159 @@
+/**
+ * @file wait_set.hpp
+ * @brief WaitSet - Block until any of N channels has new data
+ *
+ * Works with every transport (BARQ, CASIR, SIM, SAHM). Channels are tracked
+ * through the NotifyWord the writer bumps on each publish, so writers pay
+ * nothing extra:
+ * - Spin phase: vectorized scan of channel sequence words (SSE2/AVX2)
+ * - Park phase: futex_waitv() on all notify words at once (Linux 5.16+),
+ *   sleep backoff on older kernels
+ * - getFd(): eventfd usable in existing epoll loops (relay thread,
+ *   started lazily on first call)
+ *
+ * Usage:
+ *   SIM::WaitSet ws;
+ *   int cam = ws.add(camera_reader);
+ *   int lidar = ws.add(lidar_reader);
+ *   std::vector<int> ready;
+ *   while (ws.wait(ready, 100)) { for (int id : ready) ... }
+ */
+
+#ifndef WAIT_SET_HPP
+#define WAIT_SET_HPP
+
+#include "wait_strategy.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SIM {
+
+/**
+ * @class WaitSet
+ * @brief Multi-channel readiness wait with epoll integration
+ *
+ * add()/remove()/wait()/poll() must be called from a single owner thread.
+ */
+class WaitSet {
+public:
+    // futex_waitv() accepts 128 words, one is reserved for internal control
+    static constexpr size_t MAX_CHANNELS = 127;
+    
+    WaitSet();
+    ~WaitSet();
+    
+    WaitSet(const WaitSet&) = delete;
+    WaitSet& operator=(const WaitSet&) = delete;
+    
+    /**
+     * @brief Add any transport reader (must outlive the WaitSet entry)
+     *
+     * Readers without a writable notify word (segment opened read-only)
+     * fall back to polling hasNewData() with sleep backoff, always from
+     * the thread calling wait()/poll().
+     *
+     * @return Channel id, or -1 if full
+     */
+    template <typename Reader>
+    int add(Reader& reader) {
+        return add(reader.getNotifyWord(), [&reader] { return reader.hasNewData(); });
+    }
+    
+    /**
+     * @brief Add a raw notify word and/or readiness predicate
+     *
+     * The predicate (used only without a word) is called from wait() and
+     * poll(), never from the relay thread.
+     * @return Channel id, or -1 if full or both arguments are empty
+     */
+    int add(NotifyWord* word, std::function<bool()> has_data = nullptr);
+    
+    /**
+     * @brief Stop tracking a channel (id may be reused by add())
+     *
+     * Returns once the relay thread (if any) no longer references it, so
+     * the reader may be destroyed right after.
+     */
+    bool remove(int id);
+    
+    /**
+     * @brief Number of tracked channels
+     */
+    size_t size() const { return active_count_; }
+    
+    /**
+     * @brief Block until at least one channel published since last wait()/poll()
+     * @param ready Output: ids of channels with new data
+     * @param timeout_ms Timeout in milliseconds
+     * @return Number of ready channels (0 on timeout)
+     */
+    size_t wait(std::vector<int>& ready, uint32_t timeout_ms);
+    
+    /**
+     * @brief Non-blocking readiness check (also drains the eventfd)
+     * @return Number of ready channels
+     */
+    size_t poll(std::vector<int>& ready);
+    
+    /**
+     * @brief Eventfd that becomes readable when any channel publishes
+     *
+     * Register it with EPOLLIN in an existing loop, then call poll() to get
+     * the ready ids. Starts a relay thread on first call. The relay only
+     * watches notify words; while polled channels (readiness predicate,
+     * no notify word) are tracked, the fd also fires every millisecond so
+     * that poll() re-checks them on the calling thread.
+     *
+     * @return File descriptor, or -1 on failure
+     */
+    int getFd();
+    
+    /**
+     * @brief Spin/yield budget before parking (default: adaptive)
+     */
+    void setWaitStrategy(const WaitStrategy& strategy) { strategy_ = strategy; }
+
+private:
+    struct Channel {
+        NotifyWord* word;
+        std::function<bool()> has_data;
+        bool active;
+    };
+    
+    static void scanWords(const std::vector<NotifyWord*>& words,
+                          const std::vector<uint32_t>& baseline,
+                          std::vector<uint32_t>& current,
+                          std::vector<int>& ready);
+    size_t scan(std::vector<int>& ready);
+    bool park(const std::vector<NotifyWord*>& words,
+              const std::vector<uint32_t>& expected,
+              uint32_t control, int64_t timeout_ns);
+    void drainFd();
+    void relayLoop();
+    
+    mutable std::mutex mutex_;          // Guards channels_/words_ against the relay
+    std::vector<Channel> channels_;
+    std::vector<NotifyWord*> words_;    // Dense, id-indexed (nullptr = none)
+    std::vector<uint32_t> last_seq_;    // Acknowledged seq per channel
+    std::vector<uint32_t> cur_seq_;     // Scratch for vectorized scan
+    size_t active_count_;
+    size_t predicate_count_;
+    
+    WaitStrategy strategy_;
+    std::atomic<bool> waitv_supported_;
+    
+    int event_fd_;
+    std::thread relay_;
+    std::atomic<bool> stop_;
+    std::atomic<uint32_t> control_;     // Bumped on add/remove/stop
+    std::atomic<uint32_t> relay_seen_;  // Last control value the relay rebuilt from
+};
+
+} // namespace SIM
+
+#endif // WAIT_SET_HPP
@@ -0,0 +1,258 @@
+/**
+ * @file wait_strategy.hpp
+ * @brief Pluggable Wait Strategies for all SIM-family readers
+ *
+ * Readers can wait for new data in four ways:
+ * - BusySpin:  spin with CPU pause (lowest latency, burns a core)
+ * - SpinYield: short spin, then sched_yield()
+ * - Block:     park on a futex word bumped by the writer (~0% CPU)
+ * - Adaptive:  spin -> yield -> park (default)
+ *
+ * The writer bumps a NotifyWord in the shared header on every publish and
+ * only issues FUTEX_WAKE when at least one reader is parked, so writers pay
+ * a single atomic increment when nobody is waiting.
+ */
+
+#ifndef WAIT_STRATEGY_HPP
+#define WAIT_STRATEGY_HPP
+
+#include "cache_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>  // _mm_pause
+#endif
+
+namespace SIM {
+
+/**
+ * @struct NotifyWord
+ * @brief Futex word shared between writer and readers
+ *
+ * Embedded in every transport header on its own cache line.
+ */
+struct alignas(CACHE_LINE_SIZE) NotifyWord {
+    std::atomic<uint32_t> seq;       // Bumped by writer on every publish
+    std::atomic<uint32_t> waiters;   // Readers currently parked on seq
+    char padding[CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>) * 2];
+};
+
+static_assert(sizeof(NotifyWord) == CACHE_LINE_SIZE, "NotifyWord must be 1 cache line");
+
+/**
+ * @enum WaitMode
+ * @brief How a reader waits for the next frame
+ */
+enum class WaitMode : uint32_t {
+    BusySpin = 0,
+    SpinYield = 1,
+    Block = 2,
+    Adaptive = 3
+};
+
+/**
+ * @class Futex
+ * @brief Thin wrappers around the futex syscall (process-shared)
+ */
+class Futex {
+public:
+    /**
+     * @brief Park while *addr == expected
+     * @param timeout_ns Relative timeout (< 0 = infinite)
+     * @return true if woken or value changed, false on timeout
+     */
+    static bool wait(std::atomic<uint32_t>* addr, uint32_t expected, int64_t timeout_ns);
+    
+    /**
+     * @brief Wake up to count waiters parked on addr
+     * @return Number of waiters woken
+     */
+    static int wake(std::atomic<uint32_t>* addr, int count);
+    
+    /**
+     * @brief Writer side: announce a publish, wake parked readers if any
+     */
+    static inline void publish(NotifyWord* word) {
+        if (!word) return;
+        word->seq.fetch_add(1, std::memory_order_seq_cst);
+        if (word->waiters.load(std::memory_order_seq_cst) != 0) {
+            wake(&word->seq, WAKE_ALL);
+        }
+    }
+    
+    /**
+     * @brief CPU hint for spin loops
+     */
+    static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#else
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+    
+    static constexpr int WAKE_ALL = 0x7FFFFFFF;
+};
+
+/**
+ * @class NotifyView
+ * @brief Writable mapping of the page holding a shared NotifyWord
+ *
+ * Readers map the payload read-only. Parking needs to increment the
+ * waiter count, so the header page is mapped a second time read-write.
+ * If the segment could only be opened read-only, get() returns nullptr
+ * and blocking waits degrade to sleep backoff.
+ */
+class NotifyView {
+public:
+    NotifyView() : base_(nullptr), size_(0), word_(nullptr) {}
+    ~NotifyView() { detach(); }
+    
+    NotifyView(const NotifyView&) = delete;
+    NotifyView& operator=(const NotifyView&) = delete;
+    
+    NotifyView(NotifyView&& other) noexcept;
+    NotifyView& operator=(NotifyView&& other) noexcept;
+    
+    /**
+     * @brief Map the NotifyWord at byte offset within the segment behind fd
+     * @return true on success (fd must be opened O_RDWR)
+     */
+    bool attach(int fd, size_t offset);
+    
+    void detach();
+    
+    NotifyWord* get() const { return word_; }
+
+private:
+    void* base_;
+    size_t size_;
+    NotifyWord* word_;
+};
+
+/**
+ * @struct WaitStrategy
+ * @brief Reader wait configuration
+ */
+struct WaitStrategy {
+    WaitMode mode;
+    uint32_t spin_iterations;   // Pause-spins before escalating
+    uint32_t yield_iterations;  // Yields before parking
+    
+    /**
+     * @brief Spin forever (lowest latency, 100% CPU)
+     */
+    static WaitStrategy busySpin() {
+        WaitStrategy ws;
+        ws.mode = WaitMode::BusySpin;
+        ws.spin_iterations = 0;
+        ws.yield_iterations = 0;
+        return ws;
+    }
+    
+    /**
+     * @brief Spin briefly, then yield
+     */
+    static WaitStrategy spinYield() {
+        WaitStrategy ws;
+        ws.mode = WaitMode::SpinYield;
+        ws.spin_iterations = 1000;
+        ws.yield_iterations = 0;
+        return ws;
+    }
+    
+    /**
+     * @brief Park on the futex immediately (~0% CPU while idle)
+     */
+    static WaitStrategy blocking() {
+        WaitStrategy ws;
+        ws.mode = WaitMode::Block;
+        ws.spin_iterations = 0;
+        ws.yield_iterations = 0;
+        return ws;
+    }
+    
+    /**
+     * @brief Spin ~2-5us, yield a few times, then park (default)
+     */
+    static WaitStrategy adaptive() {
+        WaitStrategy ws;
+        ws.mode = WaitMode::Adaptive;
+        ws.spin_iterations = 2000;
+        ws.yield_iterations = 16;
+        return ws;
+    }
+    
+    /**
+     * @brief Wait until ready() returns true or timeout expires
+     * @param ready Predicate checking the transport for new data
+     * @param word Shared notify word (nullptr = no futex, sleep backoff)
+     * @param timeout_ms Timeout in milliseconds
+     * @return true if ready() became true
+     */
+    template <typename Ready>
+    bool waitUntil(Ready ready, NotifyWord* word, uint32_t timeout_ms) const {
+        if (ready()) return true;
+        
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeout_ms);
+        
+        // Phase 1: spin with pause
+        uint32_t spins = (mode == WaitMode::BusySpin) ? UINT32_MAX : spin_iterations;
+        for (uint32_t i = 0; i < spins; ++i) {
+            if (ready()) return true;
+            Futex::cpuRelax();
+            if ((i & 127) == 127 && std::chrono::steady_clock::now() >= deadline) {
+                return ready();
+            }
+        }
+        
+        // Phase 2: spin-then-yield
+        uint32_t yields = (mode == WaitMode::SpinYield) ? UINT32_MAX : yield_iterations;
+        for (uint32_t i = 0; i < yields; ++i) {
+            if (ready()) return true;
+            if (std::chrono::steady_clock::now() >= deadline) return ready();
+            std::this_thread::yield();
+        }
+        
+        // Phase 3: park
+        int64_t backoff_us = 50;
+        while (true) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) return ready();
+            int64_t remaining_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                deadline - now).count();
+            
+            if (word) {
+                uint32_t observed = word->seq.load(std::memory_order_acquire);
+                if (ready()) return true;
+                
+                // Register before re-checking so the writer cannot miss us
+                word->waiters.fetch_add(1, std::memory_order_seq_cst);
+                if (word->seq.load(std::memory_order_seq_cst) == observed && !ready()) {
+                    Futex::wait(&word->seq, observed, remaining_ns);
+                }
+                word->waiters.fetch_sub(1, std::memory_order_relaxed);
+            } else {
+                // No writable notify word: bounded sleep backoff
+                if (ready()) return true;
+                int64_t sleep_ns = std::min<int64_t>(backoff_us * 1000, remaining_ns);
+                std::this_thread::sleep_for(std::chrono::nanoseconds(sleep_ns));
+                backoff_us = std::min<int64_t>(backoff_us * 2, 1000);
+            }
+            
+            if (ready()) return true;
+        }
+    }
+};
+
+} // namespace SIM
+
+#endif // WAIT_STRATEGY_HPP
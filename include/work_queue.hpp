@@ -0,0 +1,231 @@
+/**
+ * @file work_queue.hpp
+ * @brief Lock-free queues used by the executor and pipeline
+ *
+ * - WorkStealingDeque: Chase-Lev deque (owner push/pop LIFO, thieves steal FIFO)
+ * - BoundedQueue:      Vyukov bounded MPMC queue
+ *
+ * Both have a fixed power-of-two capacity chosen at construction,
+ * so push() never allocates and can fail when full.
+ */
+
+#ifndef WORK_QUEUE_HPP
+#define WORK_QUEUE_HPP
+
+#include "cache_utils.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace SIM {
+
+/**
+ * @brief Round up to the next power of two (minimum 2)
+ */
+inline size_t nextPowerOfTwo(size_t value) {
+    size_t result = 2;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+/**
+ * @class WorkStealingDeque
+ * @brief Chase-Lev work-stealing deque of T*
+ *
+ * push()/pop() only from the owner thread, steal() from any thread.
+ */
+template <typename T>
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(size_t capacity)
+        : capacity_(nextPowerOfTwo(capacity))
+        , mask_(capacity_ - 1)
+        , buffer_(new std::atomic<T*>[capacity_])
+    {
+        top_.store(0, std::memory_order_relaxed);
+        bottom_.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < capacity_; ++i) {
+            buffer_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+    
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+    
+    /**
+     * @brief Owner: push to bottom
+     * @return false if full
+     */
+    bool push(T* item) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        if (b - t >= static_cast<int64_t>(capacity_)) return false;
+        
+        buffer_[b & mask_].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    /**
+     * @brief Owner: pop from bottom (LIFO)
+     * @return nullptr if empty or lost the race for the last item
+     */
+    T* pop() {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        
+        T* item = buffer_[b & mask_].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last item: race against thieves
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+    
+    /**
+     * @brief Thief: steal from top (FIFO)
+     * @return nullptr if empty or lost a race
+     */
+    T* steal() {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        
+        if (t >= b) return nullptr;
+        
+        T* item = buffer_[t & mask_].load(std::memory_order_relaxed);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+    
+    bool empty() const {
+        return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_acquire);
+    }
+    
+    size_t capacity() const { return capacity_; }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> top_;
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> bottom_;
+    alignas(CACHE_LINE_SIZE) size_t capacity_;
+    size_t mask_;
+    std::unique_ptr<std::atomic<T*>[]> buffer_;
+};
+
+/**
+ * @class BoundedQueue
+ * @brief Vyukov bounded multi-producer multi-consumer queue
+ *
+ * T must be default constructible and copy/move assignable.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity)
+        : capacity_(nextPowerOfTwo(capacity))
+        , mask_(capacity_ - 1)
+        , cells_(new Cell[capacity_])
+    {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueue_pos_.store(0, std::memory_order_relaxed);
+        dequeue_pos_.store(0, std::memory_order_relaxed);
+    }
+    
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+    
+    /**
+     * @return false if full
+     */
+    bool push(T value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    
+    /**
+     * @return false if empty
+     */
+    bool pop(T& value) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->value);
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+    
+    /**
+     * @brief Approximate number of queued items
+     */
+    size_t size() const {
+        size_t e = enqueue_pos_.load(std::memory_order_acquire);
+        size_t d = dequeue_pos_.load(std::memory_order_acquire);
+        return e >= d ? e - d : 0;
+    }
+    
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+    
+    size_t capacity_;
+    size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueue_pos_;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeue_pos_;
+};
+
+} // namespace SIM
+
+#endif // WORK_QUEUE_HPP
@@ -0,0 +1,250 @@
+/**
+ * @file async_writer.cpp
+ * @brief Async Writer Implementation
+ */
+
+#include "async_writer.hpp"
+#include "cache_utils.hpp"
+#include <chrono>
+
+namespace SIM {
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+AsyncWriter::AsyncWriter(const AsyncWriterConfig& config)
+    : config_(config)
+    , running_(false)
+    , stop_(false)
+    , submitters_(0)
+    , next_token_(1)
+    , in_flight_(0)
+    , stat_submitted_(0)
+    , stat_completed_(0)
+    , stat_failed_(0)
+    , stat_rejected_(0)
+    , stat_bytes_(0)
+    , stat_max_queued_ns_(0)
+{
+    if (config_.num_threads == 0) config_.num_threads = 1;
+    if (config_.queue_depth == 0) config_.queue_depth = 1;
+    completion_word_.seq.store(0, std::memory_order_relaxed);
+    completion_word_.waiters.store(0, std::memory_order_relaxed);
+}
+
+AsyncWriter::~AsyncWriter() {
+    stop();
+}
+
+int AsyncWriter::addChannel(PublishFn publish) {
+    if (running_.load(std::memory_order_acquire) || !publish) return -1;
+    
+    std::unique_ptr<Channel> channel(new Channel(config_.queue_depth));
+    channel->publish = std::move(publish);
+    channel->thread = channels_.size() % config_.num_threads;
+    channels_.push_back(std::move(channel));
+    return static_cast<int>(channels_.size() - 1);
+}
+
+bool AsyncWriter::start() {
+    if (running_.load(std::memory_order_acquire)) return true;
+    if (channels_.empty()) return false;
+    
+    // Sized for every buffer a channel may hold, so completions never overflow
+    size_t capacity = channels_.size() * config_.queue_depth;
+    if (!completions_ || completions_->capacity() < capacity) {
+        completions_.reset(new BoundedQueue<AsyncCompletion>(capacity));
+    }
+    stop_.store(false, std::memory_order_release);
+    
+    threads_.clear();
+    for (size_t i = 0; i < config_.num_threads; ++i) {
+        std::unique_ptr<CopyThread> t(new CopyThread());
+        t->work.seq.store(0, std::memory_order_relaxed);
+        t->work.waiters.store(0, std::memory_order_relaxed);
+        t->cpu = i < config_.cpus.size() ? config_.cpus[i] : -1;
+        threads_.push_back(std::move(t));
+    }
+    for (size_t c = 0; c < channels_.size(); ++c) {
+        threads_[channels_[c]->thread]->channels.push_back(static_cast<int>(c));
+    }
+    
+    running_.store(true, std::memory_order_release);
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        threads_[i]->thread = std::thread(&AsyncWriter::copyLoop, this, i);
+    }
+    return true;
+}
+
+void AsyncWriter::stop() {
+    if (!running_.load(std::memory_order_acquire)) return;
+    
+    stop_.store(true, std::memory_order_seq_cst);
+    for (auto& t : threads_) {
+        Futex::publish(&t->work);
+    }
+    for (auto& t : threads_) {
+        if (t->thread.joinable()) t->thread.join();
+    }
+    running_.store(false, std::memory_order_release);
+    
+    // A submit() that passed its check before stop_ finishes its push first
+    while (submitters_.load(std::memory_order_seq_cst) > 0) {
+        std::this_thread::yield();
+    }
+    
+    // Hand back whatever was still queued
+    int64_t now = nowNs();
+    for (size_t c = 0; c < channels_.size(); ++c) {
+        Request request;
+        while (channels_[c]->queue.pop(request)) {
+            complete(static_cast<int>(c), request, false, now);
+        }
+    }
+}
+
+uint64_t AsyncWriter::submit(int channel, const void* data, size_t size) {
+    if (channel < 0 || static_cast<size_t>(channel) >= channels_.size()) return 0;
+    
+    // Announce before checking stop_: stop() drains only once no submit() is
+    // between the check and the push (both sides seq_cst)
+    submitters_.fetch_add(1, std::memory_order_seq_cst);
+    if (stop_.load(std::memory_order_seq_cst) || !running_.load(std::memory_order_acquire)) {
+        submitters_.fetch_sub(1, std::memory_order_release);
+        return 0;
+    }
+    uint64_t token = enqueue(*channels_[channel], data, size);
+    submitters_.fetch_sub(1, std::memory_order_release);
+    return token;
+}
+
+uint64_t AsyncWriter::enqueue(Channel& ch, const void* data, size_t size) {
+    // Reserve a place: queued + unpolled buffers never exceed queue_depth
+    if (ch.outstanding.fetch_add(1, std::memory_order_acq_rel) >= config_.queue_depth) {
+        ch.outstanding.fetch_sub(1, std::memory_order_acq_rel);
+        stat_rejected_.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    
+    Request request;
+    request.token = next_token_.fetch_add(1, std::memory_order_relaxed);
+    request.data = data;
+    request.size = size;
+    request.submit_ns = nowNs();
+    
+    in_flight_.fetch_add(1, std::memory_order_acq_rel);
+    if (!ch.queue.push(request)) {
+        in_flight_.fetch_sub(1, std::memory_order_acq_rel);
+        ch.outstanding.fetch_sub(1, std::memory_order_acq_rel);
+        stat_rejected_.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    
+    stat_submitted_.fetch_add(1, std::memory_order_relaxed);
+    Futex::publish(&threads_[ch.thread]->work);
+    return request.token;
+}
+
+void AsyncWriter::complete(int channel, const Request& request, bool success, int64_t now) {
+    AsyncCompletion done;
+    done.token = request.token;
+    done.channel = channel;
+    done.buffer = request.data;
+    done.size = request.size;
+    done.success = success;
+    done.queued_ns = now - request.submit_ns;
+    
+    // Cannot fail: capacity covers every outstanding buffer
+    completions_->push(done);
+    
+    stat_completed_.fetch_add(1, std::memory_order_relaxed);
+    if (success) {
+        stat_bytes_.fetch_add(request.size, std::memory_order_relaxed);
+    } else {
+        stat_failed_.fetch_add(1, std::memory_order_relaxed);
+    }
+    int64_t prev = stat_max_queued_ns_.load(std::memory_order_relaxed);
+    while (done.queued_ns > prev &&
+           !stat_max_queued_ns_.compare_exchange_weak(prev, done.queued_ns,
+                                                      std::memory_order_relaxed)) {
+    }
+    
+    in_flight_.fetch_sub(1, std::memory_order_acq_rel);
+    Futex::publish(&completion_word_);
+}
+
+bool AsyncWriter::hasWork(const CopyThread& self) const {
+    for (int c : self.channels) {
+        if (channels_[c]->queue.size() > 0) return true;
+    }
+    return false;
+}
+
+void AsyncWriter::copyLoop(size_t index) {
+    CopyThread& self = *threads_[index];
+    if (self.cpu >= 0) {
+        CacheUtils::setCpuAffinity(self.cpu);
+    }
+    
+    while (!stop_.load(std::memory_order_acquire)) {
+        bool worked = false;
+        
+        // One request per channel per pass: a busy channel cannot starve others
+        for (int c : self.channels) {
+            Channel& ch = *channels_[c];
+            Request request;
+            if (!ch.queue.pop(request)) continue;
+            
+            bool ok = ch.publish(request.data, request.size);
+            complete(c, request, ok, nowNs());
+            worked = true;
+        }
+        
+        if (!worked) {
+            config_.wait_strategy.waitUntil([this, &self] {
+                return stop_.load(std::memory_order_acquire) || hasWork(self);
+            }, &self.work, 100);
+        }
+    }
+}
+
+bool AsyncWriter::poll(AsyncCompletion& out) {
+    if (!completions_ || !completions_->pop(out)) return false;
+    if (out.channel >= 0 && static_cast<size_t>(out.channel) < channels_.size()) {
+        channels_[out.channel]->outstanding.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    return true;
+}
+
+bool AsyncWriter::waitCompletion(AsyncCompletion& out, uint32_t timeout_ms) {
+    if (poll(out)) return true;
+    if (!completions_) return false;
+    config_.wait_strategy.waitUntil([this] { return hasNewData(); },
+                                    &completion_word_, timeout_ms);
+    return poll(out);
+}
+
+bool AsyncWriter::flush(uint32_t timeout_ms) {
+    return config_.wait_strategy.waitUntil([this] {
+        return in_flight_.load(std::memory_order_acquire) == 0;
+    }, &completion_word_, timeout_ms);
+}
+
+AsyncWriterStats AsyncWriter::getStats() const {
+    AsyncWriterStats stats;
+    stats.submitted = stat_submitted_.load(std::memory_order_relaxed);
+    stats.completed = stat_completed_.load(std::memory_order_relaxed);
+    stats.failed = stat_failed_.load(std::memory_order_relaxed);
+    stats.rejected = stat_rejected_.load(std::memory_order_relaxed);
+    stats.bytes = stat_bytes_.load(std::memory_order_relaxed);
+    stats.max_queued_ns = stat_max_queued_ns_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace SIM
@@ -4,13 +4,16 @@
  */
 
 #include "barq.hpp"
+#include "replica.hpp"
 
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cstring>
 #include <chrono>
+#include <thread>
 
 // Non-temporal store intrinsics
 #if defined(__x86_64__) || defined(_M_X64)
@@ -30,6 +33,9 @@ static inline size_t alignUp(size_t value, size_t alignment) {
     return (value + alignment - 1) & ~(alignment - 1);
 }
 
+// Yields while a resize() rewrites the layout before a reader gives up
+static constexpr int LAYOUT_RETRIES = 1000;
+
 // Non-temporal memcpy for large data (bypasses cache)
 static void ntMemcpy(void* dst, const void* src, size_t size) {
 #if HAS_NT_STORE
@@ -64,20 +70,37 @@ static void ntMemcpy(void* dst, const void* src, size_t size) {
 // Writer Implementation
 // ============================================================================
 
-Writer::Writer(const std::string& name, size_t max_size, bool use_huge_pages)
+Writer::Writer(const std::string& name, size_t max_size, bool use_huge_pages,
+               size_t meta_size)
     : name_(name)
     , max_size_(max_size)
+    , meta_size_(meta_size)
     , use_huge_pages_(use_huge_pages)
     , initialized_(false)
     , huge_pages_active_(false)
+    , pages_()
+    , provisioned_(false)
+    , keep_segment_(false)
+    , anonymous_(SIM::anonymousSegmentsDefault())
+    , use_broker_(true)
+    , serving_(false)
     , fd_(-1)
     , ptr_(nullptr)
     , shm_size_(0)
     , header_(nullptr)
     , frame_count_(0)
+    , idle_policy_(SIM::IdlePolicy::disabled())
+    , idle_stats_()
+    , back_released_(false)
+    , priority_(SIM::ChannelPriority::Normal)
+    , retired_offset_(0)
+    , retired_len_(0)
+    , retire_at_(0)
 {
     buffer_[0] = nullptr;
     buffer_[1] = nullptr;
+    meta_[0] = nullptr;
+    meta_[1] = nullptr;
 }
 
 Writer::~Writer() {
@@ -89,67 +112,68 @@ bool Writer::init() {
     
     // Calculate sizes
     size_t buffer_size = alignUp(max_size_, CACHE_LINE);
-    shm_size_ = sizeof(Header) + buffer_size * 2;
+    size_t meta_stride = alignUp(meta_size_, CACHE_LINE);
+    size_t buffer_offset = sizeof(Header) + meta_stride * 2;
+    shm_size_ = buffer_offset + buffer_size * 2;
     
     // Align to huge page if using
     if (use_huge_pages_ && shm_size_ >= HUGE_PAGE) {
         shm_size_ = alignUp(shm_size_, HUGE_PAGE);
     }
     
-    // Remove existing
-    shm_unlink(name_.c_str());
-    
-    // Create SHM
-    fd_ = shm_open(name_.c_str(), O_CREAT | O_RDWR | O_EXCL, 0666);
-    if (fd_ < 0) return false;
-    
-    // Set size
-    if (ftruncate(fd_, shm_size_) < 0) {
-        close(fd_);
-        shm_unlink(name_.c_str());
+    // Where huge pages can come from for this size (see huge_pages.hpp)
+    SIM::HugePagePlan plan = SIM::planHugePages(shm_size_, use_huge_pages_);
+    
+    // Broker, anonymous memfd, pre-provisioned or new segment (see memfd.hpp)
+    SIM::WriterSegment segment = SIM::acquireWriterSegment(
+        name_, shm_size_, "barq", plan.hugetlb, anonymous_, use_broker_ ? &broker_ : nullptr,
+        [this](int fd) {
+            return SIM::sameLayout<Header>(fd, shm_size_, MAGIC, VERSION, max_size_, meta_size_);
+        });
+    if (segment.fd < 0) return false;
+    fd_ = segment.fd;
+    serving_ = segment.serving;
+    provisioned_ = segment.provisioned;
+    keep_segment_ = segment.keep;
+    
+    // Map with optimizations. Huge pages come with the segment (hugetlb) or
+    // from MADV_HUGEPAGE before the pages are faulted in (THP)
+    ptr_ = SIM::mapSegment(fd_, shm_size_, PROT_READ | PROT_WRITE, true, plan.thp);
+    if (ptr_ == MAP_FAILED) {
+        ptr_ = nullptr;
+        releaseSegment();
         return false;
     }
     
-    // Map with optimizations
-    int flags = MAP_SHARED | MAP_POPULATE;
-    
-    // Try huge pages first
-    if (use_huge_pages_ && shm_size_ >= HUGE_PAGE) {
-        ptr_ = mmap(nullptr, shm_size_, PROT_READ | PROT_WRITE,
-                    flags | MAP_HUGETLB, fd_, 0);
-        if (ptr_ != MAP_FAILED) {
-            huge_pages_active_ = true;
-        }
-    }
-    
-    // Fallback to regular pages
-    if (ptr_ == nullptr || ptr_ == MAP_FAILED) {
-        ptr_ = mmap(nullptr, shm_size_, PROT_READ | PROT_WRITE, flags, fd_, 0);
-        if (ptr_ == MAP_FAILED) {
-            close(fd_);
-            shm_unlink(name_.c_str());
-            ptr_ = nullptr;
-            return false;
-        }
-        huge_pages_active_ = false;
-    }
-    
     // Lock in RAM (prevent page faults during write)
     mlock(ptr_, shm_size_);
     
+    // Record what the kernel actually gave us
+    pages_ = SIM::inspectMapping(ptr_, shm_size_);
+    huge_pages_active_ = pages_.backing != SIM::PageBacking::Regular;
+    
     // Advise kernel
     madvise(ptr_, shm_size_, MADV_SEQUENTIAL);
     madvise(ptr_, shm_size_, MADV_WILLNEED);
     
-    // Initialize header
+    // Initialize header (readers may already wait on a provisioned segment)
     header_ = static_cast<Header*>(ptr_);
+    uint32_t waiters = provisioned_ ? header_->notify.waiters.load(std::memory_order_relaxed) : 0;
+    
+    // Kept segments continue the layout generation: attached readers remap
+    uint32_t layout_gen = 0;
+    if (keep_segment_ && header_->magic == MAGIC) {
+        layout_gen = (header_->layout_gen.load(std::memory_order_relaxed) | 1) + 1;
+    }
     std::memset(header_, 0, sizeof(Header));
     
     header_->magic = MAGIC;
     header_->version = VERSION;
     header_->capacity = max_size_;
-    header_->buffer_offset = sizeof(Header);
-    header_->flags = huge_pages_active_ ? 1 : 0;
+    header_->buffer_offset = buffer_offset;
+    header_->flags = pages_.flags();
+    header_->meta_size = static_cast<uint32_t>(meta_size_);
+    header_->layout_gen.store(layout_gen, std::memory_order_relaxed);
     
     header_->front_idx.store(0, std::memory_order_relaxed);
     header_->seq0.store(0, std::memory_order_relaxed);
@@ -161,9 +185,16 @@ bool Writer::init() {
     header_->heartbeat_ns.store(nowNs(), std::memory_order_relaxed);
     header_->total_writes.store(0, std::memory_order_relaxed);
     header_->total_bytes.store(0, std::memory_order_relaxed);
+    header_->writer_pid.store(getpid(), std::memory_order_relaxed);
+    header_->notify.seq.store(0, std::memory_order_relaxed);
+    header_->notify.waiters.store(waiters, std::memory_order_relaxed);
+    
+    // Set metadata and buffer pointers
+    uint8_t* meta = static_cast<uint8_t*>(ptr_) + sizeof(Header);
+    meta_[0] = meta_size_ ? meta : nullptr;
+    meta_[1] = meta_size_ ? meta + meta_stride : nullptr;
     
-    // Set buffer pointers
-    uint8_t* base = static_cast<uint8_t*>(ptr_) + sizeof(Header);
+    uint8_t* base = static_cast<uint8_t*>(ptr_) + buffer_offset;
     buffer_[0] = base;
     buffer_[1] = base + buffer_size;
     
@@ -176,90 +207,246 @@ bool Writer::init() {
 
 bool Writer::write(const void* data, size_t size) {
     if (!initialized_ || size > max_size_) return false;
+    if (back_released_) prepare();
     
     // Get back buffer
     uint32_t front = header_->front_idx.load(std::memory_order_acquire);
     uint32_t back = 1 - front;
     
-    // Copy data - use non-temporal for large data
-    if (size >= 4096) {
+    // Copy data - use non-temporal for large data, in paced chunks if asked
+    if (pacer_.applies(size) && priority_ != SIM::ChannelPriority::Critical) {
+        pacer_.copy(buffer_[back], data, size, true);
+    } else if (size >= 4096) {
         ntMemcpy(buffer_[back], data, size);
     } else {
         std::memcpy(buffer_[back], data, size);
     }
     
-    // Update metadata
-    int64_t now = nowNs();
-    ++frame_count_;
-    
-    if (back == 0) {
-        header_->len0.store(size, std::memory_order_relaxed);
-        header_->ts0.store(now, std::memory_order_relaxed);
-        header_->seq0.store(frame_count_, std::memory_order_relaxed);
-    } else {
-        header_->len1.store(size, std::memory_order_relaxed);
-        header_->ts1.store(now, std::memory_order_relaxed);
-        header_->seq1.store(frame_count_, std::memory_order_relaxed);
-    }
-    
-    header_->heartbeat_ns.store(now, std::memory_order_relaxed);
-    
-    // Atomic swap with release semantics
-    header_->front_idx.store(back, std::memory_order_release);
-    
+    publishBack(back, size, 0);
     return true;
 }
 
+bool Writer::writev(const struct iovec* iov, int iovcnt) {
+    size_t size = SIM::iovecSize(iov, iovcnt);
+    if (!initialized_ || size > max_size_) return false;
+    
+    // Same threshold as write(): stream large messages past the cache
+    SIM::gatherCopy(getWriteBuffer(), iov, iovcnt, size >= 4096);
+    return commit(size);
+}
+
 void* Writer::getWriteBuffer() {
     if (!initialized_) return nullptr;
+    if (back_released_) prepare();
     uint32_t front = header_->front_idx.load(std::memory_order_acquire);
     return buffer_[1 - front];
 }
 
-bool Writer::commit(size_t size) {
+void* Writer::getWriteMetadata() {
+    if (!initialized_) return nullptr;
+    uint32_t front = header_->front_idx.load(std::memory_order_acquire);
+    return meta_[1 - front];
+}
+
+bool Writer::commit(size_t size, int64_t timestamp_ns) {
     if (!initialized_ || size > max_size_) return false;
     
     uint32_t front = header_->front_idx.load(std::memory_order_acquire);
     uint32_t back = 1 - front;
     
+    header_->total_writes.fetch_add(1, std::memory_order_relaxed);
+    header_->total_bytes.fetch_add(size, std::memory_order_relaxed);
+    publishBack(back, size, timestamp_ns);
+    return true;
+}
+
+void Writer::publishBack(uint32_t back, size_t size, int64_t timestamp_ns) {
     int64_t now = nowNs();
+    int64_t ts = timestamp_ns ? timestamp_ns : now;
     ++frame_count_;
     
     if (back == 0) {
         header_->len0.store(size, std::memory_order_relaxed);
-        header_->ts0.store(now, std::memory_order_relaxed);
+        header_->ts0.store(ts, std::memory_order_relaxed);
         header_->seq0.store(frame_count_, std::memory_order_relaxed);
     } else {
         header_->len1.store(size, std::memory_order_relaxed);
-        header_->ts1.store(now, std::memory_order_relaxed);
+        header_->ts1.store(ts, std::memory_order_relaxed);
         header_->seq1.store(frame_count_, std::memory_order_relaxed);
     }
     
     header_->heartbeat_ns.store(now, std::memory_order_relaxed);
-    header_->total_writes.fetch_add(1, std::memory_order_relaxed);
-    header_->total_bytes.fetch_add(size, std::memory_order_relaxed);
     
+    // Atomic swap with release semantics
     header_->front_idx.store(back, std::memory_order_release);
     
+    // Wake blocked readers (no syscall if nobody is parked)
+    SIM::Futex::publish(&header_->notify);
+    if (priority_ == SIM::ChannelPriority::Critical) SIM::signalCritical();
+    
+    if (retired_len_ && frame_count_ >= retire_at_) retireLayout();
+}
+
+void Writer::setPriority(SIM::ChannelPriority priority) {
+    priority_ = priority;
+    if (priority == SIM::ChannelPriority::Bulk && pacer_.getPolicy().chunk_bytes == 0) {
+        pacer_.setPolicy(SIM::PacingPolicy::latencyBudget(SIM::CRITICAL_HOLD_NS / 2));
+    }
+}
+
+size_t Writer::backOffset() const {
+    uint32_t back = 1 - header_->front_idx.load(std::memory_order_relaxed);
+    return static_cast<size_t>(buffer_[back] - static_cast<uint8_t*>(ptr_));
+}
+
+size_t Writer::pageSize() const {
+    return huge_pages_active_ ? HUGE_PAGE : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+bool Writer::releaseIfIdle() {
+    if (!initialized_ || back_released_ || idle_policy_.quiet_ms == 0) return false;
+    
+    int64_t quiet_ns = static_cast<int64_t>(idle_policy_.quiet_ms) * 1000000;
+    if (nowNs() - header_->heartbeat_ns.load(std::memory_order_relaxed) < quiet_ns) return false;
+    
+    // Front buffer stays: readers keep the latest frame
+    size_t released = SIM::releasePages(fd_, ptr_, backOffset(),
+                                        alignUp(max_size_, CACHE_LINE), pageSize());
+    if (released == 0) return false;
+    
+    back_released_ = true;
+    idle_stats_.released_bytes = released;
+    ++idle_stats_.releases;
     return true;
 }
 
+bool Writer::prepare() {
+    if (!initialized_) return false;
+    if (!back_released_) return true;
+    
+    int64_t start = nowNs();
+    size_t offset = backOffset();
+    SIM::populatePages(ptr_, offset, alignUp(max_size_, CACHE_LINE), pageSize(), true);
+    if (idle_policy_.warmup) {
+        idle_policy_.warmup(static_cast<uint8_t*>(ptr_) + offset, max_size_);
+    }
+    
+    back_released_ = false;
+    idle_stats_.released_bytes = 0;
+    ++idle_stats_.reinflations;
+    idle_stats_.last_reinflate_ns = nowNs() - start;
+    return true;
+}
+
+bool Writer::resize(size_t new_max_size) {
+    if (!initialized_ || new_max_size == 0) return false;
+    if (new_max_size == max_size_) return true;
+    
+    // Resized again within two publishes: the oldest buffers go now
+    if (retired_len_) retireLayout();
+    
+    size_t page = pageSize();
+    size_t old_buffer_size = alignUp(max_size_, CACHE_LINE);
+    size_t old_offset = header_->buffer_offset;
+    size_t buffer_size = alignUp(new_max_size, CACHE_LINE);
+    
+    // New pair in the free space before the current buffers if it fits,
+    // otherwise appended (page aligned, so the old pair can be released)
+    size_t first = sizeof(Header) + alignUp(meta_size_, CACHE_LINE) * 2;
+    size_t offset = (first + buffer_size * 2 <= old_offset)
+                  ? first : alignUp(old_offset + old_buffer_size * 2, page);
+    size_t new_size = std::max(shm_size_, offset + buffer_size * 2);
+    if (huge_pages_active_) new_size = alignUp(new_size, HUGE_PAGE);
+    
+    if (new_size > shm_size_) {
+        if (ftruncate(fd_, new_size) < 0) return false;
+        void* ptr = mremap(ptr_, shm_size_, new_size, MREMAP_MAYMOVE);
+        if (ptr == MAP_FAILED) return false;    // Larger segment, same layout
+        
+        ptr_ = ptr;
+        shm_size_ = new_size;
+        header_ = static_cast<Header*>(ptr_);
+        uint8_t* meta = static_cast<uint8_t*>(ptr_) + sizeof(Header);
+        meta_[0] = meta_size_ ? meta : nullptr;
+        meta_[1] = meta_size_ ? meta + alignUp(meta_size_, CACHE_LINE) : nullptr;
+        buffer_[0] = static_cast<uint8_t*>(ptr_) + old_offset;
+        buffer_[1] = buffer_[0] + old_buffer_size;
+    }
+    uint8_t* base = static_cast<uint8_t*>(ptr_) + offset;
+    SIM::populatePages(ptr_, offset, buffer_size * 2, page, true);
+    
+    // Latest frame moves along: readers remapping before the next publish see it
+    uint32_t front = header_->front_idx.load(std::memory_order_relaxed);
+    std::atomic<size_t>& len = (front == 0) ? header_->len0 : header_->len1;
+    size_t frame = len.load(std::memory_order_relaxed);
+    if (frame <= new_max_size) {
+        std::memcpy(base + front * buffer_size, buffer_[front], frame);
+    } else {
+        len.store(0, std::memory_order_relaxed);
+    }
+    
+    // Publish the layout (odd generation while the fields change)
+    uint32_t gen = header_->layout_gen.load(std::memory_order_relaxed);
+    header_->layout_gen.store(gen + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->capacity = new_max_size;
+    header_->buffer_offset = offset;
+    header_->layout_gen.store(gen + 2, std::memory_order_release);
+    
+    // Old pair: the front may still be read until two frames replace it
+    retired_offset_ = old_offset;
+    retired_len_ = old_buffer_size * 2;
+    retire_at_ = frame_count_ + 2;
+    
+    max_size_ = new_max_size;
+    buffer_[0] = base;
+    buffer_[1] = base + buffer_size;
+    back_released_ = false;
+    idle_stats_.released_bytes = 0;
+    return true;
+}
+
+void Writer::retireLayout() {
+    SIM::releasePages(fd_, ptr_, retired_offset_, retired_len_, pageSize());
+    retired_len_ = 0;
+}
+
+SIM::IdleStats Writer::getIdleStats() const {
+    SIM::IdleStats stats = idle_stats_;
+    stats.segment_bytes = shm_size_;
+    stats.resident_bytes = ptr_ ? SIM::residentBytes(ptr_, shm_size_) : 0;
+    return stats;
+}
+
 void Writer::destroy() {
     if (ptr_ && ptr_ != MAP_FAILED) {
+        if (keep_segment_ && header_) {
+            header_->writer_pid.store(0, std::memory_order_relaxed);   // Parked
+        }
         munmap(ptr_, shm_size_);
         ptr_ = nullptr;
     }
-    if (fd_ >= 0) {
-        close(fd_);
-        shm_unlink(name_.c_str());
-        fd_ = -1;
-    }
+    releaseSegment();
     header_ = nullptr;
     buffer_[0] = nullptr;
     buffer_[1] = nullptr;
+    back_released_ = false;
+    retired_len_ = 0;
     initialized_ = false;
 }
 
+void Writer::releaseSegment() {
+    SIM::WriterSegment segment = {fd_, serving_, provisioned_, keep_segment_};
+    SIM::releaseWriterSegment(name_, segment, broker_);
+    fd_ = segment.fd;
+    serving_ = segment.serving;
+}
+
+void Writer::detach() {
+    keep_segment_ = true;
+    destroy();
+}
+
 int64_t Writer::nowNs() {
     auto now = std::chrono::high_resolution_clock::now();
     return std::chrono::duration_cast<std::chrono::nanoseconds>(
@@ -272,23 +459,37 @@ int64_t Writer::nowNs() {
 
 Reader::Reader(const std::string& name, size_t max_size)
     : name_(name)
+    , attached_(name)
     , max_size_(max_size)
     , initialized_(false)
+    , local_replica_(true)
     , fd_(-1)
     , ptr_(nullptr)
     , shm_size_(0)
+    , retired_ptr_(nullptr)
+    , retired_size_(0)
     , header_(nullptr)
+    , capacity_(0)
+    , layout_gen_(0)
     , last_seq_(0)
+    , last_idx_(0)
     , dropped_(0)
+    , wait_strategy_(SIM::WaitStrategy::adaptive())
 {
     buffer_[0] = nullptr;
     buffer_[1] = nullptr;
+    meta_[0] = nullptr;
+    meta_[1] = nullptr;
 }
 
 Reader::~Reader() {
+    notify_.detach();
     if (ptr_ && ptr_ != MAP_FAILED) {
         munmap(ptr_, shm_size_);
     }
+    if (retired_ptr_) {
+        munmap(retired_ptr_, retired_size_);
+    }
     if (fd_ >= 0) {
         close(fd_);
     }
@@ -297,21 +498,37 @@ Reader::~Reader() {
 bool Reader::init() {
     if (initialized_) return true;
     
-    // Open existing SHM
-    fd_ = shm_open(name_.c_str(), O_RDONLY, 0666);
+    // This node's copy of a replicated channel
+    attached_ = local_replica_ ? SIM::localReplicaName(name_) : name_;
+    
+    // Segment from the broker daemon if it manages this channel, then from
+    // an anonymous writer
+    fd_ = broker_.acquire(attached_, 0, SIM::BrokerRole::Reader);
+    if (fd_ < 0) {
+        broker_.close();
+        fd_ = SIM::fetchSegment(attached_);
+    }
+    if (fd_ < 0) {
+        // Open existing SHM (read-write only needed to park on the futex)
+        fd_ = SIM::openNamedSegment(attached_, O_RDWR);
+        if (fd_ < 0) {
+            fd_ = SIM::openNamedSegment(attached_, O_RDONLY);
+        }
+    }
     if (fd_ < 0) return false;
     
-    // Get size
+    // Get size (sealed memfds are sized before they are handed out)
     struct stat st;
-    if (fstat(fd_, &st) < 0) {
+    if (fstat(fd_, &st) < 0 ||
+        (!SIM::isShrinkSealed(fd_) && static_cast<size_t>(st.st_size) < sizeof(Header))) {
         close(fd_);
         fd_ = -1;
         return false;
     }
     shm_size_ = st.st_size;
     
-    // Map (try huge pages if they were used)
-    ptr_ = mmap(nullptr, shm_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    // Map (2MB aligned, so huge pages of the segment map as huge pages)
+    ptr_ = SIM::mapSegment(fd_, shm_size_, PROT_READ, false, true);
     if (ptr_ == MAP_FAILED) {
         close(fd_);
         fd_ = -1;
@@ -329,11 +546,22 @@ bool Reader::init() {
         return false;
     }
     
-    // Set buffer pointers
-    size_t buffer_size = alignUp(max_size_, CACHE_LINE);
-    const uint8_t* base = static_cast<const uint8_t*>(ptr_) + sizeof(Header);
-    buffer_[0] = base;
-    buffer_[1] = base + buffer_size;
+    // Set metadata and buffer pointers (layout written by the writer)
+    if (!mapLayout()) {
+        munmap(ptr_, shm_size_);
+        close(fd_);
+        ptr_ = nullptr;
+        fd_ = -1;
+        return false;
+    }
+    if (retired_ptr_) {
+        munmap(retired_ptr_, retired_size_);    // Grew while attaching
+        retired_ptr_ = nullptr;
+    }
+    
+    // Writable view of the notify word (payload stays read-only)
+    notify_.attach(fd_, reinterpret_cast<const uint8_t*>(&header_->notify) -
+                        static_cast<const uint8_t*>(ptr_));
     
     // Advise kernel for read pattern
     madvise(ptr_, shm_size_, MADV_SEQUENTIAL);
@@ -349,6 +577,12 @@ const void* Reader::getLatest(size_t& size, int64_t& timestamp_ns) {
     // Load front index with acquire semantics
     uint32_t front = header_->front_idx.load(std::memory_order_acquire);
     
+    // Writer resized the channel: pick up the new layout first
+    while (header_->layout_gen.load(std::memory_order_relaxed) != layout_gen_) {
+        if (!mapLayout()) return nullptr;
+        front = header_->front_idx.load(std::memory_order_acquire);
+    }
+    
     // Get sequence and metadata
     uint64_t seq;
     size_t len;
@@ -368,6 +602,9 @@ const void* Reader::getLatest(size_t& size, int64_t& timestamp_ns) {
     if (seq == last_seq_) {
         return nullptr;  // No new data
     }
+    if (len > capacity_) {
+        return nullptr;  // Rewritten under a newer layout: remap on the next call
+    }
     
     // Track dropped frames
     if (last_seq_ > 0 && seq > last_seq_ + 1) {
@@ -375,6 +612,7 @@ const void* Reader::getLatest(size_t& size, int64_t& timestamp_ns) {
     }
     
     last_seq_ = seq;
+    last_idx_ = front;
     size = len;
     timestamp_ns = ts;
     
@@ -382,6 +620,111 @@ const void* Reader::getLatest(size_t& size, int64_t& timestamp_ns) {
     return buffer_[front];
 }
 
+const void* Reader::getMetadata() const {
+    if (!initialized_ || last_seq_ == 0) return nullptr;
+    return meta_[last_idx_];
+}
+
+bool Reader::hasNewData() const {
+    if (!initialized_) return false;
+    
+    uint32_t front = header_->front_idx.load(std::memory_order_acquire);
+    uint64_t seq = (front == 0) ?
+        header_->seq0.load(std::memory_order_relaxed) :
+        header_->seq1.load(std::memory_order_relaxed);
+    
+    return seq != last_seq_;
+}
+
+bool Reader::waitForData(uint32_t timeout_ms) {
+    if (!initialized_) return false;
+    
+    return wait_strategy_.waitUntil([this] { return hasNewData(); },
+                                    notify_.get(), timeout_ms);
+}
+
+const void* Reader::peek(uint64_t seq, size_t& size, int64_t& timestamp_ns) const {
+    if (!initialized_) return nullptr;
+    
+    uint32_t front = header_->front_idx.load(std::memory_order_acquire);
+    uint64_t front_seq = (front == 0) ?
+        header_->seq0.load(std::memory_order_relaxed) :
+        header_->seq1.load(std::memory_order_relaxed);
+    if (front_seq != seq) return nullptr;
+    
+    size = (front == 0) ? header_->len0.load(std::memory_order_relaxed) :
+                          header_->len1.load(std::memory_order_relaxed);
+    timestamp_ns = (front == 0) ? header_->ts0.load(std::memory_order_relaxed) :
+                                  header_->ts1.load(std::memory_order_relaxed);
+    if (size > capacity_) return nullptr;
+    
+    // Flipped while reading metadata: frame no longer current
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header_->front_idx.load(std::memory_order_relaxed) != front) return nullptr;
+    if (header_->layout_gen.load(std::memory_order_relaxed) != layout_gen_) return nullptr;
+    
+    return buffer_[front];
+}
+
+bool Reader::refreshLayout() {
+    if (!initialized_) return false;
+    if (header_->layout_gen.load(std::memory_order_relaxed) == layout_gen_) return true;
+    return mapLayout();
+}
+
+// Capacity and buffer offset as the writer last published them. A grown
+// segment gets a new mapping; the previous one is kept until the next
+// remap so frames already returned stay readable.
+bool Reader::mapLayout() {
+    for (int attempt = 0; attempt < LAYOUT_RETRIES; ++attempt) {
+        uint32_t gen = header_->layout_gen.load(std::memory_order_acquire);
+        size_t capacity = header_->capacity;
+        size_t offset = header_->buffer_offset;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((gen & 1) || header_->layout_gen.load(std::memory_order_relaxed) != gen) {
+            std::this_thread::yield();
+            continue;
+        }
+        
+        size_t buffer_size = alignUp(capacity, CACHE_LINE);
+        if (offset + buffer_size * 2 > shm_size_) {
+            struct stat st;
+            if (fstat(fd_, &st) < 0 || static_cast<size_t>(st.st_size) < offset + buffer_size * 2) {
+                return false;
+            }
+            void* ptr = SIM::mapSegment(fd_, st.st_size, PROT_READ, false, true);
+            if (ptr == MAP_FAILED) return false;
+            
+            if (retired_ptr_) munmap(retired_ptr_, retired_size_);
+            retired_ptr_ = ptr_;
+            retired_size_ = shm_size_;
+            ptr_ = ptr;
+            shm_size_ = st.st_size;
+            header_ = static_cast<Header*>(ptr_);
+            madvise(ptr_, shm_size_, MADV_SEQUENTIAL);
+        }
+        
+        size_t meta_stride = alignUp(header_->meta_size, CACHE_LINE);
+        const uint8_t* meta = static_cast<const uint8_t*>(ptr_) + sizeof(Header);
+        meta_[0] = header_->meta_size ? meta : nullptr;
+        meta_[1] = header_->meta_size ? meta + meta_stride : nullptr;
+        
+        const uint8_t* base = static_cast<const uint8_t*>(ptr_) + offset;
+        buffer_[0] = base;
+        buffer_[1] = base + buffer_size;
+        capacity_ = capacity;
+        layout_gen_ = gen;
+        return true;
+    }
+    return false;
+}
+
+const void* Reader::getLatestWithTimeout(size_t& size, int64_t& timestamp_ns,
+                                         uint32_t timeout_ms) {
+    if (!waitForData(timeout_ms)) return nullptr;
+    return getLatest(size, timestamp_ns);
+}
+
 bool Reader::isWriterAlive(uint32_t timeout_ms) const {
     if (!initialized_) return false;
     
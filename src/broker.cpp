@@ -0,0 +1,560 @@
+/**
+ * @file broker.cpp
+ * @brief Channel Broker Implementation
+ */
+
+#include "broker.hpp"
+#include "memfd.hpp"
+#include "huge_pages.hpp"
+#include "cache_utils.hpp"
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+namespace SIM {
+
+namespace {
+
+// === Wire protocol (SOCK_SEQPACKET, one struct per message) ===
+
+enum Op : uint32_t {
+    OP_ACQUIRE = 1,
+    OP_RELEASE = 2,
+    OP_STATUS = 3
+};
+
+constexpr uint32_t FLAG_CREATED = 0x1;
+
+struct WireRequest {
+    uint32_t op;
+    uint32_t role;
+    uint64_t size;
+    char name[BROKER_NAME_LEN];
+};
+
+struct WireReply {
+    int32_t status;         // 0 or -errno
+    uint32_t flags;
+    uint64_t size;          // Segment size, or channel count for OP_STATUS
+};
+
+struct WireHealth {
+    uint32_t channels;
+    uint32_t clients;
+    uint32_t pooled;
+    uint32_t reserved;
+    uint64_t pool_hits;
+    uint64_t pool_misses;
+    uint64_t reclaimed;
+};
+
+struct WireChannel {
+    char name[BROKER_NAME_LEN];
+    uint64_t size;
+    int32_t writer_pid;
+    uint32_t readers;
+    uint32_t generation;
+    uint32_t reserved;
+    int64_t age_ns;
+    int64_t idle_ns;
+};
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Fault every page in, so the first writer does not pay for it
+void prefault(int fd, size_t size, bool thp) {
+    void* ptr = mapSegment(fd, size, PROT_READ | PROT_WRITE, true, thp);
+    if (ptr != MAP_FAILED) munmap(ptr, size);
+}
+
+// Huge pages for sizes writers round to them (use_huge_pages)
+int createSegment(size_t size) {
+    HugePagePlan plan = planHugePages(size, true);
+    int fd = createMemfd("sim_channel", size, plan.hugetlb);
+    if (fd < 0) return -1;
+    prefault(fd, size, plan.thp);
+    return fd;
+}
+
+} // namespace
+
+std::string brokerSocketName() {
+    const char* env = std::getenv("SIM_BROKER");
+    if (!env) return BROKER_DEFAULT_SOCKET;
+    std::string name(env);
+    if (name == "off" || name == "0") return std::string();
+    return name;
+}
+
+// ============================================================================
+// BrokerClient
+// ============================================================================
+
+BrokerClient::BrokerClient()
+    : fd_(-1)
+{
+}
+
+BrokerClient::~BrokerClient() {
+    close();
+}
+
+BrokerClient::BrokerClient(BrokerClient&& other) noexcept
+    : fd_(other.fd_)
+{
+    other.fd_ = -1;
+}
+
+BrokerClient& BrokerClient::operator=(BrokerClient&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd_ = other.fd_;
+        other.fd_ = -1;
+    }
+    return *this;
+}
+
+bool BrokerClient::connect(const std::string& socket_name) {
+    if (fd_ >= 0) return true;
+    if (socket_name.empty()) return false;
+    
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    
+    sockaddr_un addr;
+    socklen_t len = abstractAddress(socket_name, addr);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), len) < 0) {
+        ::close(fd);
+        return false;
+    }
+    
+    // A stuck broker must not hang init()
+    timeval timeout;
+    timeout.tv_sec = 2;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    fd_ = fd;
+    return true;
+}
+
+void BrokerClient::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+int BrokerClient::acquire(const std::string& channel, size_t size, BrokerRole role,
+                          bool* created) {
+    if (channel.empty() || channel.size() >= BROKER_NAME_LEN) return -1;
+    if (!connect()) return -1;
+    
+    WireRequest request;
+    std::memset(&request, 0, sizeof(request));
+    request.op = OP_ACQUIRE;
+    request.role = static_cast<uint32_t>(role);
+    request.size = size;
+    std::memcpy(request.name, channel.data(), channel.size());
+    
+    WireReply reply;
+    int fd = -1;
+    if (send(fd_, &request, sizeof(request), MSG_NOSIGNAL) != sizeof(request) ||
+        !recvFd(fd_, &reply, sizeof(reply), fd)) {
+        // Broker went away: behave as if it was never there
+        if (fd >= 0) ::close(fd);
+        close();
+        return -1;
+    }
+    if (reply.status != 0) {
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    if (created) *created = (reply.flags & FLAG_CREATED) != 0;
+    return fd;
+}
+
+bool BrokerClient::release(const std::string& channel) {
+    if (fd_ < 0 || channel.empty() || channel.size() >= BROKER_NAME_LEN) return false;
+    
+    WireRequest request;
+    std::memset(&request, 0, sizeof(request));
+    request.op = OP_RELEASE;
+    std::memcpy(request.name, channel.data(), channel.size());
+    
+    WireReply reply;
+    if (send(fd_, &request, sizeof(request), MSG_NOSIGNAL) != sizeof(request) ||
+        recv(fd_, &reply, sizeof(reply), 0) != sizeof(reply)) {
+        close();
+        return false;
+    }
+    return reply.status == 0;
+}
+
+bool BrokerClient::status(BrokerHealth& health, std::vector<ChannelHealth>& channels) {
+    if (!connect()) return false;
+    
+    WireRequest request;
+    std::memset(&request, 0, sizeof(request));
+    request.op = OP_STATUS;
+    
+    WireReply reply;
+    WireHealth wire;
+    if (send(fd_, &request, sizeof(request), MSG_NOSIGNAL) != sizeof(request) ||
+        recv(fd_, &reply, sizeof(reply), 0) != sizeof(reply) ||
+        recv(fd_, &wire, sizeof(wire), 0) != sizeof(wire)) {
+        close();
+        return false;
+    }
+    health.channels = wire.channels;
+    health.clients = wire.clients;
+    health.pooled = wire.pooled;
+    health.pool_hits = wire.pool_hits;
+    health.pool_misses = wire.pool_misses;
+    health.reclaimed = wire.reclaimed;
+    
+    channels.clear();
+    for (uint64_t i = 0; i < reply.size; ++i) {
+        WireChannel c;
+        if (recv(fd_, &c, sizeof(c), 0) != sizeof(c)) {
+            close();
+            return false;
+        }
+        ChannelHealth h;
+        h.name.assign(c.name, strnlen(c.name, BROKER_NAME_LEN));
+        h.size = c.size;
+        h.writer_pid = c.writer_pid;
+        h.readers = c.readers;
+        h.generation = c.generation;
+        h.age_ns = c.age_ns;
+        h.idle_ns = c.idle_ns;
+        channels.push_back(h);
+    }
+    return true;
+}
+
+// ============================================================================
+// BrokerServer
+// ============================================================================
+
+BrokerServer::BrokerServer(const BrokerConfig& config)
+    : config_(config)
+    , running_(false)
+    , stop_(false)
+    , listen_fd_(-1)
+    , next_client_(0)
+    , pool_hits_(0)
+    , pool_misses_(0)
+    , reclaimed_(0)
+{
+    // Smallest class first: takeSegment() picks the first that fits
+    std::sort(config_.pools.begin(), config_.pools.end(),
+              [](const BrokerPool& a, const BrokerPool& b) { return a.size < b.size; });
+}
+
+BrokerServer::~BrokerServer() {
+    stop();
+}
+
+bool BrokerServer::start() {
+    if (running_.load(std::memory_order_acquire)) return true;
+    if (config_.socket_name.empty()) return false;
+    
+    listen_fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) return false;
+    
+    sockaddr_un addr;
+    socklen_t len = abstractAddress(config_.socket_name, addr);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), len) < 0 ||
+        listen(listen_fd_, 64) < 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    
+    // Pools are filled before serving: this is boot time
+    pools_.assign(config_.pools.size(), std::vector<int>());
+    for (size_t i = 0; i < config_.pools.size(); ++i) {
+        while (pools_[i].size() < config_.pools[i].count) {
+            int fd = createSegment(config_.pools[i].size);
+            if (fd < 0) break;
+            pools_[i].push_back(fd);
+        }
+    }
+    
+    stop_.store(false, std::memory_order_release);
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&BrokerServer::serve, this);
+    return true;
+}
+
+void BrokerServer::stop() {
+    if (!running_.load(std::memory_order_acquire)) return;
+    
+    stop_.store(true, std::memory_order_release);
+    if (thread_.joinable()) thread_.join();
+    
+    for (auto& c : clients_) ::close(c.second.fd);
+    for (auto& ch : channels_) ::close(ch.second.fd);
+    for (auto& pool : pools_) {
+        for (int fd : pool) ::close(fd);
+    }
+    clients_.clear();
+    channels_.clear();
+    pools_.clear();
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    running_.store(false, std::memory_order_release);
+}
+
+void BrokerServer::serve() {
+    std::vector<pollfd> fds;
+    std::vector<int> ids;
+    
+    while (!stop_.load(std::memory_order_acquire)) {
+        fds.clear();
+        ids.clear();
+        fds.push_back({listen_fd_, POLLIN, 0});
+        ids.push_back(-1);
+        for (auto& c : clients_) {
+            fds.push_back({c.second.fd, POLLIN, 0});
+            ids.push_back(c.first);
+        }
+        
+        int ready = ::poll(fds.data(), fds.size(), 100);
+        if (ready > 0) {
+            for (size_t i = 1; i < fds.size(); ++i) {
+                if (fds[i].revents && clients_.count(ids[i])) handle(ids[i]);
+            }
+            if (fds[0].revents & POLLIN) {
+                int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+                if (fd >= 0) {
+                    ucred cred;
+                    socklen_t len = sizeof(cred);
+                    Client client;
+                    client.fd = fd;
+                    client.pid = getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0
+                                 ? cred.pid : 0;
+                    clients_[next_client_++] = client;
+                }
+            }
+        }
+        
+        reclaim(nowNs());
+        refill();
+    }
+}
+
+int BrokerServer::takeSegment(size_t size) {
+    for (size_t i = 0; i < config_.pools.size(); ++i) {
+        if (config_.pools[i].size < size || pools_[i].empty()) continue;
+        // Huge page segments only shrink in whole huge pages
+        if (size % HUGE_PAGE_SIZE != 0 && isHugetlbFd(pools_[i].back())) continue;
+        int fd = pools_[i].back();
+        pools_[i].pop_back();
+        // Shrinking releases the tail; the rest stays faulted in
+        if (ftruncate(fd, size) < 0) {
+            ::close(fd);
+            continue;
+        }
+        sealSegment(fd);
+        ++pool_hits_;
+        return fd;
+    }
+    ++pool_misses_;
+    
+    // Sealed once sized: mappings of a channel can never be cut short
+    int fd = createSegment(size);
+    if (fd >= 0) sealSegment(fd);
+    return fd;
+}
+
+void BrokerServer::refill() {
+    // One segment per pass keeps request latency low
+    for (size_t i = 0; i < config_.pools.size(); ++i) {
+        if (pools_[i].size() < config_.pools[i].count) {
+            int fd = createSegment(config_.pools[i].size);
+            if (fd >= 0) pools_[i].push_back(fd);
+            return;
+        }
+    }
+}
+
+void BrokerServer::leave(Channel& channel, int client) {
+    if (channel.writer == client) channel.writer = -1;
+    channel.readers.erase(std::remove(channel.readers.begin(), channel.readers.end(), client),
+                          channel.readers.end());
+    if (channel.writer < 0 && channel.readers.empty() && channel.idle_since_ns == 0) {
+        channel.idle_since_ns = nowNs();
+    }
+}
+
+void BrokerServer::disconnect(int client) {
+    for (auto& ch : channels_) {
+        leave(ch.second, client);
+    }
+    auto it = clients_.find(client);
+    if (it != clients_.end()) {
+        ::close(it->second.fd);
+        clients_.erase(it);
+    }
+}
+
+void BrokerServer::reclaim(int64_t now) {
+    int64_t linger_ns = static_cast<int64_t>(config_.linger_ms) * 1000000;
+    for (auto it = channels_.begin(); it != channels_.end();) {
+        const Channel& ch = it->second;
+        if (ch.idle_since_ns != 0 && now - ch.idle_since_ns > linger_ns) {
+            // Mappings still held by processes stay valid
+            ::close(ch.fd);
+            it = channels_.erase(it);
+            ++reclaimed_;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void BrokerServer::handle(int client) {
+    int sock = clients_[client].fd;
+    WireRequest request;
+    ssize_t n = recv(sock, &request, sizeof(request), MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        disconnect(client);
+        return;
+    }
+    if (n < 0) return;
+    
+    WireReply reply;
+    reply.status = 0;
+    reply.flags = 0;
+    reply.size = 0;
+    if (n != sizeof(request)) {
+        reply.status = -EINVAL;
+        sendFd(sock, &reply, sizeof(reply), -1);
+        return;
+    }
+    request.name[BROKER_NAME_LEN - 1] = '\0';
+    std::string name(request.name);
+    int64_t now = nowNs();
+    
+    if (request.op == OP_ACQUIRE) {
+        auto it = channels_.find(name);
+        int fd = -1;
+        
+        if (name.empty()) {
+            reply.status = -EINVAL;
+        } else if (request.role == static_cast<uint32_t>(BrokerRole::Writer)) {
+            if (request.size == 0) {
+                reply.status = -EINVAL;
+            } else if (it != channels_.end() && it->second.writer >= 0 &&
+                       it->second.writer != client) {
+                reply.status = -EBUSY;      // One writer per channel
+            } else {
+                if (it == channels_.end() || it->second.size != request.size) {
+                    int seg = takeSegment(request.size);
+                    if (seg < 0) {
+                        reply.status = -ENOMEM;
+                    } else if (it == channels_.end()) {
+                        Channel ch;
+                        ch.fd = seg;
+                        ch.size = request.size;
+                        ch.writer = -1;
+                        ch.generation = 1;
+                        ch.created_ns = now;
+                        ch.idle_since_ns = 0;
+                        it = channels_.emplace(name, ch).first;
+                        reply.flags |= FLAG_CREATED;
+                    } else {
+                        // New layout: readers of the old one keep their mapping
+                        ::close(it->second.fd);
+                        it->second.fd = seg;
+                        it->second.size = request.size;
+                        it->second.generation++;
+                        it->second.created_ns = now;
+                        reply.flags |= FLAG_CREATED;
+                    }
+                }
+                if (reply.status == 0) {
+                    it->second.writer = client;
+                    it->second.idle_since_ns = 0;
+                    fd = it->second.fd;
+                }
+            }
+        } else if (request.role == static_cast<uint32_t>(BrokerRole::Reader)) {
+            if (it == channels_.end()) {
+                reply.status = -ENOENT;
+            } else {
+                auto& readers = it->second.readers;
+                if (std::find(readers.begin(), readers.end(), client) == readers.end()) {
+                    readers.push_back(client);
+                }
+                it->second.idle_since_ns = 0;
+                fd = it->second.fd;
+            }
+        } else {
+            reply.status = -EINVAL;
+        }
+        
+        if (fd >= 0) reply.size = it->second.size;
+        sendFd(sock, &reply, sizeof(reply), fd);
+    
+    } else if (request.op == OP_RELEASE) {
+        auto it = channels_.find(name);
+        if (it == channels_.end()) {
+            reply.status = -ENOENT;
+        } else {
+            leave(it->second, client);
+        }
+        sendFd(sock, &reply, sizeof(reply), -1);
+    
+    } else if (request.op == OP_STATUS) {
+        reply.size = channels_.size();
+        WireHealth health;
+        std::memset(&health, 0, sizeof(health));
+        health.channels = static_cast<uint32_t>(channels_.size());
+        health.clients = static_cast<uint32_t>(clients_.size());
+        for (auto& pool : pools_) health.pooled += static_cast<uint32_t>(pool.size());
+        health.pool_hits = pool_hits_;
+        health.pool_misses = pool_misses_;
+        health.reclaimed = reclaimed_;
+        
+        if (!sendFd(sock, &reply, sizeof(reply), -1) ||
+            !sendFd(sock, &health, sizeof(health), -1)) {
+            return;
+        }
+        for (auto& entry : channels_) {
+            const Channel& ch = entry.second;
+            WireChannel c;
+            std::memset(&c, 0, sizeof(c));
+            std::memcpy(c.name, entry.first.data(),
+                        std::min(entry.first.size(), BROKER_NAME_LEN - 1));
+            c.size = ch.size;
+            c.writer_pid = ch.writer >= 0 ? clients_[ch.writer].pid : 0;
+            c.readers = static_cast<uint32_t>(ch.readers.size());
+            c.generation = ch.generation;
+            c.age_ns = now - ch.created_ns;
+            c.idle_ns = ch.idle_since_ns ? now - ch.idle_since_ns : 0;
+            if (!sendFd(sock, &c, sizeof(c), -1)) return;
+        }
+    
+    } else {
+        reply.status = -EINVAL;
+        sendFd(sock, &reply, sizeof(reply), -1);
+    }
+}
+
+} // namespace SIM
@@ -9,32 +9,55 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <errno.h>
+#include <algorithm>
 #include <cstring>
 #include <chrono>
 #include <thread>
 
 namespace CASIR {
 
+namespace {
+
+// Yields while a resize() rewrites the layout before a reader gives up
+constexpr int LAYOUT_RETRIES = 1000;
+
+} // namespace
+
 // ============================================================================
 // Writer Implementation
 // ============================================================================
 
 Writer::Writer(const std::string& shm_name, size_t max_size,
-                         const Config& config)
+                         const Config& config, size_t meta_size)
     : shm_name_(shm_name)
     , max_size_(max_size)
+    , meta_size_(meta_size)
     , config_(config)
     , is_initialized_(false)
+    , provisioned_(false)
+    , keep_segment_(false)
+    , anonymous_(SIM::anonymousSegmentsDefault())
+    , use_broker_(true)
+    , serving_(false)
     , shm_fd_(-1)
     , shm_ptr_(nullptr)
     , shm_size_(0)
     , using_huge_pages_(false)
+    , pages_()
     , header_(nullptr)
     , frame_count_(0)
+    , idle_policy_(SIM::IdlePolicy::disabled())
+    , idle_stats_()
+    , back_released_(false)
+    , priority_(SIM::ChannelPriority::Normal)
+    , retired_offset_(0)
+    , retired_len_(0)
+    , retire_at_(0)
 {
     buffer_[0] = nullptr;
     buffer_[1] = nullptr;
+    meta_[0] = nullptr;
+    meta_[1] = nullptr;
     cache_info_ = CacheUtils::detectCacheInfo();
     
     // Auto-configure prefetch distance if not set
@@ -50,20 +73,40 @@ Writer::~Writer() {
 Writer::Writer(Writer&& other) noexcept
     : shm_name_(std::move(other.shm_name_))
     , max_size_(other.max_size_)
+    , meta_size_(other.meta_size_)
     , config_(other.config_)
     , is_initialized_(other.is_initialized_)
+    , provisioned_(other.provisioned_)
+    , keep_segment_(other.keep_segment_)
+    , anonymous_(other.anonymous_)
+    , use_broker_(other.use_broker_)
+    , serving_(other.serving_)
+    , broker_(std::move(other.broker_))
     , shm_fd_(other.shm_fd_)
     , shm_ptr_(other.shm_ptr_)
     , shm_size_(other.shm_size_)
     , using_huge_pages_(other.using_huge_pages_)
+    , pages_(other.pages_)
     , header_(other.header_)
     , frame_count_(other.frame_count_)
     , cache_info_(other.cache_info_)
+    , idle_policy_(std::move(other.idle_policy_))
+    , idle_stats_(other.idle_stats_)
+    , back_released_(other.back_released_)
+    , priority_(other.priority_)
+    , pacer_(other.pacer_)
+    , retired_offset_(other.retired_offset_)
+    , retired_len_(other.retired_len_)
+    , retire_at_(other.retire_at_)
 {
     buffer_[0] = other.buffer_[0];
     buffer_[1] = other.buffer_[1];
+    meta_[0] = other.meta_[0];
+    meta_[1] = other.meta_[1];
     
     other.is_initialized_ = false;
+    other.back_released_ = false;
+    other.serving_ = false;
     other.shm_fd_ = -1;
     other.shm_ptr_ = nullptr;
     other.header_ = nullptr;
@@ -75,19 +118,39 @@ Writer& Writer::operator=(Writer&& other) noexcept {
         
         shm_name_ = std::move(other.shm_name_);
         max_size_ = other.max_size_;
+        meta_size_ = other.meta_size_;
         config_ = other.config_;
         is_initialized_ = other.is_initialized_;
+        provisioned_ = other.provisioned_;
+        keep_segment_ = other.keep_segment_;
+        anonymous_ = other.anonymous_;
+        use_broker_ = other.use_broker_;
+        serving_ = other.serving_;
+        broker_ = std::move(other.broker_);
         shm_fd_ = other.shm_fd_;
         shm_ptr_ = other.shm_ptr_;
         shm_size_ = other.shm_size_;
         using_huge_pages_ = other.using_huge_pages_;
+        pages_ = other.pages_;
         header_ = other.header_;
         buffer_[0] = other.buffer_[0];
         buffer_[1] = other.buffer_[1];
+        meta_[0] = other.meta_[0];
+        meta_[1] = other.meta_[1];
         frame_count_ = other.frame_count_;
         cache_info_ = other.cache_info_;
+        idle_policy_ = std::move(other.idle_policy_);
+        idle_stats_ = other.idle_stats_;
+        back_released_ = other.back_released_;
+        priority_ = other.priority_;
+        pacer_ = other.pacer_;
+        retired_offset_ = other.retired_offset_;
+        retired_len_ = other.retired_len_;
+        retire_at_ = other.retire_at_;
         
         other.is_initialized_ = false;
+        other.back_released_ = false;
+        other.serving_ = false;
         other.shm_fd_ = -1;
         other.shm_ptr_ = nullptr;
         other.header_ = nullptr;
@@ -107,45 +170,57 @@ bool Writer::init() {
     
     // Calculate total size needed
     size_t aligned_buffer = CacheUtils::alignToCacheLine(max_size_);
-    shm_size_ = sizeof(Header) + aligned_buffer * 2;
+    size_t meta_stride = CacheUtils::alignToCacheLine(meta_size_);
+    shm_size_ = sizeof(Header) + meta_stride * 2 + aligned_buffer * 2;
     
     // Try to use huge pages if beneficial
     if (config_.use_huge_pages && CacheUtils::shouldUseHugePages(shm_size_)) {
         shm_size_ = CacheUtils::alignToHugePage(shm_size_);
     }
     
-    // Try to unlink existing
-    shm_unlink(shm_name_.c_str());
-    
-    // Create shared memory
-    shm_fd_ = shm_open(shm_name_.c_str(), O_CREAT | O_RDWR | O_EXCL, 0666);
-    if (shm_fd_ == -1) {
-        return false;
-    }
-    
-    // Set size
-    if (ftruncate(shm_fd_, shm_size_) == -1) {
-        close(shm_fd_);
-        shm_unlink(shm_name_.c_str());
+    // Where huge pages can come from for this size (see huge_pages.hpp)
+    SIM::HugePagePlan plan = SIM::planHugePages(shm_size_, config_.use_huge_pages);
+    
+    // Broker, anonymous memfd, pre-provisioned or new segment (see memfd.hpp)
+    SIM::WriterSegment segment = SIM::acquireWriterSegment(
+        shm_name_, shm_size_, "casir", plan.hugetlb, anonymous_, use_broker_ ? &broker_ : nullptr,
+        [this](int fd) {
+            return SIM::sameLayout<Header>(fd, shm_size_, CASIR_MAGIC, CASIR_VERSION,
+                                           max_size_, meta_size_);
+        });
+    if (segment.fd < 0) {
         return false;
     }
+    shm_fd_ = segment.fd;
+    serving_ = segment.serving;
+    provisioned_ = segment.provisioned;
+    keep_segment_ = segment.keep;
     
     // Map memory
-    if (!allocateMemory()) {
-        close(shm_fd_);
-        shm_unlink(shm_name_.c_str());
+    if (!allocateMemory(plan.thp)) {
+        releaseSegment();
         return false;
     }
     
-    // Initialize header
+    // Initialize header (readers may already wait on a provisioned segment)
     header_ = static_cast<Header*>(shm_ptr_);
+    uint32_t waiters = provisioned_ ? header_->notify.waiters.load(std::memory_order_relaxed) : 0;
+    
+    // Kept segments continue the layout generation: attached readers remap
+    uint32_t layout_gen = 0;
+    if (keep_segment_ && header_->magic == CASIR_MAGIC) {
+        layout_gen = (header_->layout_gen.load(std::memory_order_relaxed) | 1) + 1;
+    }
     std::memset(header_, 0, sizeof(Header));
     
     header_->magic = CASIR_MAGIC;
     header_->version = CASIR_VERSION;
     header_->capacity = max_size_;
-    header_->huge_page_size = using_huge_pages_ ? HUGE_PAGE_SIZE : 0;
-    header_->flags = using_huge_pages_ ? 1 : 0;
+    header_->huge_page_size = using_huge_pages_ ? pages_.page_size : 0;
+    header_->flags = pages_.flags();
+    header_->meta_size = static_cast<uint32_t>(meta_size_);
+    header_->buffer_offset = sizeof(Header) + meta_stride * 2;
+    header_->layout_gen.store(layout_gen, std::memory_order_relaxed);
     
     header_->front_idx.store(0, std::memory_order_relaxed);
     header_->frame0.store(0, std::memory_order_relaxed);
@@ -156,10 +231,17 @@ bool Writer::init() {
     header_->checksum_enabled.store(false, std::memory_order_relaxed);
     header_->total_writes.store(0, std::memory_order_relaxed);
     header_->total_bytes.store(0, std::memory_order_relaxed);
+    header_->writer_pid.store(getpid(), std::memory_order_relaxed);
+    header_->notify.seq.store(0, std::memory_order_relaxed);
+    header_->notify.waiters.store(waiters, std::memory_order_relaxed);
+    
+    // Set metadata and buffer pointers
+    uint8_t* meta = static_cast<uint8_t*>(shm_ptr_) + sizeof(Header);
+    meta_[0] = meta_size_ ? meta : nullptr;
+    meta_[1] = meta_size_ ? meta + meta_stride : nullptr;
     
-    // Set buffer pointers
     size_t aligned_buffer_size = CacheUtils::alignToCacheLine(max_size_);
-    uint8_t* base = static_cast<uint8_t*>(shm_ptr_) + sizeof(Header);
+    uint8_t* base = meta + meta_stride * 2;
     buffer_[0] = base;
     buffer_[1] = base + aligned_buffer_size;
     
@@ -173,28 +255,10 @@ bool Writer::init() {
     return true;
 }
 
-bool Writer::allocateMemory() {
-    int flags = MAP_SHARED | MAP_POPULATE;  // Pre-populate page tables
-    
-    // Try huge pages first
-    if (config_.use_huge_pages) {
-        auto hp_info = CacheUtils::detectHugePages();
-        if (hp_info.usable) {
-            void* ptr = mmap(nullptr, shm_size_, PROT_READ | PROT_WRITE,
-                           flags | MAP_HUGETLB, shm_fd_, 0);
-            if (ptr != MAP_FAILED) {
-                shm_ptr_ = ptr;
-                using_huge_pages_ = true;
-                // Lock pages in RAM to prevent page faults
-                mlock(shm_ptr_, shm_size_);
-                return true;
-            }
-            // Fallback to regular pages
-        }
-    }
-    
-    // Regular mapping with MAP_POPULATE
-    shm_ptr_ = mmap(nullptr, shm_size_, PROT_READ | PROT_WRITE, flags, shm_fd_, 0);
+bool Writer::allocateMemory(bool thp) {
+    // Pre-populated. Huge pages come with the segment (hugetlb) or from
+    // MADV_HUGEPAGE before the pages are faulted in (THP)
+    shm_ptr_ = SIM::mapSegment(shm_fd_, shm_size_, PROT_READ | PROT_WRITE, true, thp);
     if (shm_ptr_ == MAP_FAILED) {
         shm_ptr_ = nullptr;
         return false;
@@ -203,17 +267,21 @@ bool Writer::allocateMemory() {
     // Lock pages in RAM to prevent page faults during write
     mlock(shm_ptr_, shm_size_);
     
-    // Advise kernel for sequential access and that we'll need this memory
-    madvise(shm_ptr_, shm_size_, MADV_SEQUENTIAL);
-    madvise(shm_ptr_, shm_size_, MADV_WILLNEED);
+    // Record what the kernel actually gave us
+    pages_ = SIM::inspectMapping(shm_ptr_, shm_size_);
+    using_huge_pages_ = pages_.backing != SIM::PageBacking::Regular;
     
-    using_huge_pages_ = false;
+    // Advise kernel for sequential access and that we'll need this memory
+    if (!using_huge_pages_) {
+        madvise(shm_ptr_, shm_size_, MADV_SEQUENTIAL);
+        madvise(shm_ptr_, shm_size_, MADV_WILLNEED);
+    }
     return true;
 }
 
 void Writer::prefetchBuffer(int idx) {
     if (buffer_[idx] && config_.enable_prefetch) {
-        CacheUtils::prefetchRange(buffer_[idx], 
+        CacheUtils::prefetchRange(buffer_[idx],
             std::min(max_size_, config_.prefetch_distance));
     }
 }
@@ -222,39 +290,43 @@ bool Writer::write(const void* data, size_t size) {
     if (!is_initialized_ || size > max_size_) {
         return false;
     }
+    if (back_released_) {
+        prepare();
+    }
     
     // Get back buffer index
     uint32_t front = header_->front_idx.load(std::memory_order_acquire);
     uint32_t back = 1 - front;
     
-    // Copy data to back buffer
-    std::memcpy(buffer_[back], data, size);
-    
-    // Update metadata
-    int64_t now = getCurrentTimestampNs();
-    ++frame_count_;
-    
-    if (back == 0) {
-        header_->frame0.store(frame_count_, std::memory_order_relaxed);
-        header_->timestamp0_ns.store(now, std::memory_order_relaxed);
+    // Copy data to back buffer (paced chunks for large frames if asked)
+    if (pacer_.applies(size) && priority_ != SIM::ChannelPriority::Critical) {
+        pacer_.copy(buffer_[back], data, size, false);
     } else {
-        header_->frame1.store(frame_count_, std::memory_order_relaxed);
-        header_->timestamp1_ns.store(now, std::memory_order_relaxed);
+        std::memcpy(buffer_[back], data, size);
     }
     
-    header_->published_length.store(size, std::memory_order_relaxed);
-    header_->writer_heartbeat_ns.store(now, std::memory_order_relaxed);
-    
-    // Atomic swap - release ensures all writes are visible
-    header_->front_idx.store(back, std::memory_order_release);
-    
+    publishBack(back, size);
     return true;
 }
 
+bool Writer::writev(const struct iovec* iov, int iovcnt) {
+    size_t size = SIM::iovecSize(iov, iovcnt);
+    if (!is_initialized_ || size > max_size_) {
+        return false;
+    }
+    
+    // Cached stores: CASIR readers pick the frame up from cache
+    SIM::gatherCopy(getWriteBuffer(), iov, iovcnt, false);
+    return commitWrite(size);
+}
+
 bool Writer::writeZeroCopy(std::function<void(void*)> fill_func, size_t size) {
     if (!is_initialized_ || size > max_size_) {
         return false;
     }
+    if (back_released_) {
+        prepare();
+    }
     
     uint32_t front = header_->front_idx.load(std::memory_order_acquire);
     uint32_t back = 1 - front;
@@ -262,25 +334,9 @@ bool Writer::writeZeroCopy(std::function<void(void*)> fill_func, size_t size) {
     // Caller fills buffer directly
     fill_func(buffer_[back]);
     
-    // Update and swap
-    int64_t now = getCurrentTimestampNs();
-    ++frame_count_;
-    
-    if (back == 0) {
-        header_->frame0.store(frame_count_, std::memory_order_relaxed);
-        header_->timestamp0_ns.store(now, std::memory_order_relaxed);
-    } else {
-        header_->frame1.store(frame_count_, std::memory_order_relaxed);
-        header_->timestamp1_ns.store(now, std::memory_order_relaxed);
-    }
-    
-    header_->published_length.store(size, std::memory_order_relaxed);
-    header_->writer_heartbeat_ns.store(now, std::memory_order_relaxed);
-    header_->front_idx.store(back, std::memory_order_release);
-    
     header_->total_writes.fetch_add(1, std::memory_order_relaxed);
     header_->total_bytes.fetch_add(size, std::memory_order_relaxed);
-    
+    publishBack(back, size);
     return true;
 }
 
@@ -288,10 +344,21 @@ void* Writer::getWriteBuffer() {
     if (!is_initialized_) {
         return nullptr;
     }
+    if (back_released_) {
+        prepare();
+    }
     uint32_t front = header_->front_idx.load(std::memory_order_acquire);
     return buffer_[1 - front];
 }
 
+void* Writer::getWriteMetadata() {
+    if (!is_initialized_) {
+        return nullptr;
+    }
+    uint32_t front = header_->front_idx.load(std::memory_order_acquire);
+    return meta_[1 - front];
+}
+
 bool Writer::commitWrite(size_t size) {
     if (!is_initialized_ || size > max_size_) {
         return false;
@@ -300,6 +367,13 @@ bool Writer::commitWrite(size_t size) {
     uint32_t front = header_->front_idx.load(std::memory_order_acquire);
     uint32_t back = 1 - front;
     
+    header_->total_writes.fetch_add(1, std::memory_order_relaxed);
+    header_->total_bytes.fetch_add(size, std::memory_order_relaxed);
+    publishBack(back, size);
+    return true;
+}
+
+void Writer::publishBack(uint32_t back, size_t size) {
     int64_t now = getCurrentTimestampNs();
     ++frame_count_;
     
@@ -313,17 +387,180 @@ bool Writer::commitWrite(size_t size) {
     
     header_->published_length.store(size, std::memory_order_relaxed);
     header_->writer_heartbeat_ns.store(now, std::memory_order_relaxed);
+    
+    // Atomic swap - release ensures all writes are visible
     header_->front_idx.store(back, std::memory_order_release);
     
-    header_->total_writes.fetch_add(1, std::memory_order_relaxed);
-    header_->total_bytes.fetch_add(size, std::memory_order_relaxed);
+    // Wake blocked readers (no syscall if nobody is parked)
+    SIM::Futex::publish(&header_->notify);
+    if (priority_ == SIM::ChannelPriority::Critical) {
+        SIM::signalCritical();
+    }
+    
+    if (retired_len_ && frame_count_ >= retire_at_) {
+        retireLayout();
+    }
+}
+
+size_t Writer::backOffset() const {
+    uint32_t back = 1 - header_->front_idx.load(std::memory_order_relaxed);
+    return static_cast<size_t>(buffer_[back] - static_cast<uint8_t*>(shm_ptr_));
+}
+
+size_t Writer::pageSize() const {
+    return using_huge_pages_ ? HUGE_PAGE_SIZE : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+bool Writer::releaseIfIdle() {
+    if (!is_initialized_ || back_released_ || idle_policy_.quiet_ms == 0) {
+        return false;
+    }
+    
+    int64_t quiet_ns = static_cast<int64_t>(idle_policy_.quiet_ms) * 1000000;
+    int64_t last = header_->writer_heartbeat_ns.load(std::memory_order_relaxed);
+    if (getCurrentTimestampNs() - last < quiet_ns) {
+        return false;
+    }
+    
+    // Front buffer stays: readers keep the latest frame
+    size_t released = SIM::releasePages(shm_fd_, shm_ptr_, backOffset(),
+                                        CacheUtils::alignToCacheLine(max_size_), pageSize());
+    if (released == 0) {
+        return false;
+    }
+    
+    back_released_ = true;
+    idle_stats_.released_bytes = released;
+    ++idle_stats_.releases;
+    return true;
+}
+
+bool Writer::prepare() {
+    if (!is_initialized_) {
+        return false;
+    }
+    if (!back_released_) {
+        return true;
+    }
+    
+    int64_t start = getCurrentTimestampNs();
+    size_t offset = backOffset();
+    SIM::populatePages(shm_ptr_, offset, CacheUtils::alignToCacheLine(max_size_), pageSize(), true);
+    if (idle_policy_.warmup) {
+        idle_policy_.warmup(static_cast<uint8_t*>(shm_ptr_) + offset, max_size_);
+    }
+    
+    back_released_ = false;
+    idle_stats_.released_bytes = 0;
+    ++idle_stats_.reinflations;
+    idle_stats_.last_reinflate_ns = getCurrentTimestampNs() - start;
+    return true;
+}
+
+bool Writer::resize(size_t new_max_size) {
+    if (!is_initialized_ || new_max_size == 0) {
+        return false;
+    }
+    if (new_max_size == max_size_) {
+        return true;
+    }
+    
+    // Resized again within two publishes: the oldest buffers go now
+    if (retired_len_) {
+        retireLayout();
+    }
+    
+    size_t page = pageSize();
+    size_t old_buffer_size = CacheUtils::alignToCacheLine(max_size_);
+    size_t old_offset = header_->buffer_offset;
+    size_t buffer_size = CacheUtils::alignToCacheLine(new_max_size);
+    
+    // New pair in the free space before the current buffers if it fits,
+    // otherwise appended (page aligned, so the old pair can be released)
+    size_t first = sizeof(Header) + CacheUtils::alignToCacheLine(meta_size_) * 2;
+    size_t offset = (first + buffer_size * 2 <= old_offset)
+                  ? first
+                  : (old_offset + old_buffer_size * 2 + page - 1) & ~(page - 1);
+    size_t new_size = std::max(shm_size_, offset + buffer_size * 2);
+    if (using_huge_pages_) {
+        new_size = CacheUtils::alignToHugePage(new_size);
+    }
+    
+    if (new_size > shm_size_) {
+        if (ftruncate(shm_fd_, new_size) == -1) {
+            return false;
+        }
+        void* ptr = mremap(shm_ptr_, shm_size_, new_size, MREMAP_MAYMOVE);
+        if (ptr == MAP_FAILED) {
+            return false;   // Larger segment, same layout
+        }
+        
+        shm_ptr_ = ptr;
+        shm_size_ = new_size;
+        header_ = static_cast<Header*>(shm_ptr_);
+        uint8_t* meta = static_cast<uint8_t*>(shm_ptr_) + sizeof(Header);
+        meta_[0] = meta_size_ ? meta : nullptr;
+        meta_[1] = meta_size_ ? meta + CacheUtils::alignToCacheLine(meta_size_) : nullptr;
+        buffer_[0] = static_cast<uint8_t*>(shm_ptr_) + old_offset;
+        buffer_[1] = buffer_[0] + old_buffer_size;
+    }
+    uint8_t* base = static_cast<uint8_t*>(shm_ptr_) + offset;
+    SIM::populatePages(shm_ptr_, offset, buffer_size * 2, page, true);
+    
+    // Latest frame moves along: readers remapping before the next publish see it
+    uint32_t front = header_->front_idx.load(std::memory_order_relaxed);
+    size_t length = header_->published_length.load(std::memory_order_relaxed);
+    if (length <= new_max_size) {
+        std::memcpy(base + front * buffer_size, buffer_[front], length);
+    } else {
+        header_->published_length.store(0, std::memory_order_relaxed);
+    }
+    
+    // Publish the layout (odd generation while the fields change)
+    uint32_t gen = header_->layout_gen.load(std::memory_order_relaxed);
+    header_->layout_gen.store(gen + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->capacity = new_max_size;
+    header_->buffer_offset = offset;
+    header_->layout_gen.store(gen + 2, std::memory_order_release);
     
+    // Old pair: the front may still be read until two frames replace it
+    retired_offset_ = old_offset;
+    retired_len_ = old_buffer_size * 2;
+    retire_at_ = frame_count_ + 2;
+    
+    max_size_ = new_max_size;
+    buffer_[0] = base;
+    buffer_[1] = base + buffer_size;
+    back_released_ = false;
+    idle_stats_.released_bytes = 0;
     return true;
 }
 
+void Writer::retireLayout() {
+    SIM::releasePages(shm_fd_, shm_ptr_, retired_offset_, retired_len_, pageSize());
+    retired_len_ = 0;
+}
+
+void Writer::setPriority(SIM::ChannelPriority priority) {
+    priority_ = priority;
+    if (priority == SIM::ChannelPriority::Bulk && pacer_.getPolicy().chunk_bytes == 0) {
+        pacer_.setPolicy(SIM::PacingPolicy::latencyBudget(SIM::CRITICAL_HOLD_NS / 2));
+    }
+}
+
+SIM::IdleStats Writer::getIdleStats() const {
+    SIM::IdleStats stats = idle_stats_;
+    stats.segment_bytes = shm_size_;
+    stats.resident_bytes = shm_ptr_ ? SIM::residentBytes(shm_ptr_, shm_size_) : 0;
+    return stats;
+}
+
 Stats Writer::getStats() const {
     Stats stats;
     stats.huge_pages_active = using_huge_pages_;
+    stats.page_flags = pages_.flags();
+    stats.huge_page_bytes = pages_.huge_bytes;
     stats.prefetch_active = config_.enable_prefetch;
     stats.numa_node = 0;
     stats.pinned_cpu = config_.cpu_affinity;
@@ -336,24 +573,37 @@ Stats Writer::getStats() const {
 
 void Writer::destroy() {
     if (shm_ptr_ && shm_ptr_ != MAP_FAILED) {
+        if (keep_segment_ && header_) {
+            header_->writer_pid.store(0, std::memory_order_relaxed);   // Parked
+        }
         munmap(shm_ptr_, shm_size_);
         shm_ptr_ = nullptr;
     }
     
-    if (shm_fd_ >= 0) {
-        close(shm_fd_);
-        if (!shm_name_.empty()) {
-            shm_unlink(shm_name_.c_str());
-        }
-        shm_fd_ = -1;
-    }
+    releaseSegment();
     
     header_ = nullptr;
     buffer_[0] = nullptr;
     buffer_[1] = nullptr;
+    meta_[0] = nullptr;
+    meta_[1] = nullptr;
+    back_released_ = false;
+    retired_len_ = 0;
     is_initialized_ = false;
 }
 
+void Writer::releaseSegment() {
+    SIM::WriterSegment segment = {shm_fd_, serving_, provisioned_, keep_segment_};
+    SIM::releaseWriterSegment(shm_name_, segment, broker_);
+    shm_fd_ = segment.fd;
+    serving_ = segment.serving;
+}
+
+void Writer::detach() {
+    keep_segment_ = true;
+    destroy();
+}
+
 int64_t Writer::getCurrentTimestampNs() const {
     auto now = std::chrono::high_resolution_clock::now();
     return std::chrono::duration_cast<std::chrono::nanoseconds>(
@@ -374,15 +624,23 @@ Reader::Reader(const std::string& shm_name, size_t max_size,
     , shm_ptr_(nullptr)
     , shm_size_(0)
     , using_huge_pages_(false)
+    , retired_ptr_(nullptr)
+    , retired_size_(0)
     , header_(nullptr)
+    , capacity_(0)
+    , layout_gen_(0)
     , last_frame_(0)
+    , last_idx_(0)
     , last_timestamp_ns_(0)
     , dropped_frames_(0)
     , last_checksum_valid_(true)
     , zero_copy_active_(false)
+    , wait_strategy_(WaitStrategy::adaptive())
 {
     buffer_[0] = nullptr;
     buffer_[1] = nullptr;
+    meta_[0] = nullptr;
+    meta_[1] = nullptr;
     cache_info_ = CacheUtils::detectCacheInfo();
     
     if (config_.prefetch_distance == 0) {
@@ -391,9 +649,13 @@ Reader::Reader(const std::string& shm_name, size_t max_size,
 }
 
 Reader::~Reader() {
+    notify_.detach();
     if (shm_ptr_ && shm_ptr_ != MAP_FAILED) {
         munmap(shm_ptr_, shm_size_);
     }
+    if (retired_ptr_) {
+        munmap(retired_ptr_, retired_size_);
+    }
     if (shm_fd_ >= 0) {
         close(shm_fd_);
     }
@@ -407,27 +669,39 @@ Reader::Reader(Reader&& other) noexcept
     , shm_fd_(other.shm_fd_)
     , shm_ptr_(other.shm_ptr_)
     , shm_size_(other.shm_size_)
+    , broker_(std::move(other.broker_))
     , using_huge_pages_(other.using_huge_pages_)
+    , retired_ptr_(other.retired_ptr_)
+    , retired_size_(other.retired_size_)
     , header_(other.header_)
+    , capacity_(other.capacity_)
+    , layout_gen_(other.layout_gen_)
     , last_frame_(other.last_frame_)
+    , last_idx_(other.last_idx_)
     , last_timestamp_ns_(other.last_timestamp_ns_)
     , dropped_frames_(other.dropped_frames_)
     , last_checksum_valid_(other.last_checksum_valid_)
     , zero_copy_active_(other.zero_copy_active_)
     , cache_info_(other.cache_info_)
+    , notify_(std::move(other.notify_))
+    , wait_strategy_(other.wait_strategy_)
 {
     buffer_[0] = other.buffer_[0];
     buffer_[1] = other.buffer_[1];
+    meta_[0] = other.meta_[0];
+    meta_[1] = other.meta_[1];
     
     other.is_initialized_ = false;
     other.shm_fd_ = -1;
     other.shm_ptr_ = nullptr;
+    other.retired_ptr_ = nullptr;
     other.header_ = nullptr;
 }
 
 Reader& Reader::operator=(Reader&& other) noexcept {
     if (this != &other) {
         if (shm_ptr_) munmap(shm_ptr_, shm_size_);
+        if (retired_ptr_) munmap(retired_ptr_, retired_size_);
         if (shm_fd_ >= 0) close(shm_fd_);
         
         shm_name_ = std::move(other.shm_name_);
@@ -437,20 +711,31 @@ Reader& Reader::operator=(Reader&& other) noexcept {
         shm_fd_ = other.shm_fd_;
         shm_ptr_ = other.shm_ptr_;
         shm_size_ = other.shm_size_;
+        broker_ = std::move(other.broker_);
         using_huge_pages_ = other.using_huge_pages_;
+        retired_ptr_ = other.retired_ptr_;
+        retired_size_ = other.retired_size_;
         header_ = other.header_;
         buffer_[0] = other.buffer_[0];
         buffer_[1] = other.buffer_[1];
+        meta_[0] = other.meta_[0];
+        meta_[1] = other.meta_[1];
+        capacity_ = other.capacity_;
+        layout_gen_ = other.layout_gen_;
         last_frame_ = other.last_frame_;
+        last_idx_ = other.last_idx_;
         last_timestamp_ns_ = other.last_timestamp_ns_;
         dropped_frames_ = other.dropped_frames_;
         last_checksum_valid_ = other.last_checksum_valid_;
         zero_copy_active_ = other.zero_copy_active_;
         cache_info_ = other.cache_info_;
+        notify_ = std::move(other.notify_);
+        wait_strategy_ = other.wait_strategy_;
         
         other.is_initialized_ = false;
         other.shm_fd_ = -1;
         other.shm_ptr_ = nullptr;
+        other.retired_ptr_ = nullptr;
         other.header_ = nullptr;
     }
     return *this;
@@ -466,42 +751,41 @@ bool Reader::init() {
         CacheUtils::setCpuAffinity(config_.cpu_affinity);
     }
     
-    // Open existing shared memory
-    shm_fd_ = shm_open(shm_name_.c_str(), O_RDONLY, 0666);
+    // Segment from the broker daemon if it manages this channel, then from
+    // an anonymous writer
+    shm_fd_ = broker_.acquire(shm_name_, 0, SIM::BrokerRole::Reader);
+    if (shm_fd_ == -1) {
+        broker_.close();
+        shm_fd_ = SIM::fetchSegment(shm_name_);
+    }
+    if (shm_fd_ == -1) {
+        // Open existing shared memory (read-write only needed to park on the futex)
+        shm_fd_ = SIM::openNamedSegment(shm_name_, O_RDWR);
+        if (shm_fd_ == -1) {
+            shm_fd_ = SIM::openNamedSegment(shm_name_, O_RDONLY);
+        }
+    }
     if (shm_fd_ == -1) {
         return false;
     }
     
-    // Get size
+    // Get size (sealed memfds are sized before they are handed out)
     struct stat st;
-    if (fstat(shm_fd_, &st) == -1) {
+    if (fstat(shm_fd_, &st) == -1 ||
+        (!SIM::isShrinkSealed(shm_fd_) && static_cast<size_t>(st.st_size) < sizeof(Header))) {
         close(shm_fd_);
         shm_fd_ = -1;
         return false;
     }
     shm_size_ = st.st_size;
     
-    // Map memory (try huge pages if available)
-    int flags = MAP_SHARED;
-    
-    if (config_.use_huge_pages) {
-        void* ptr = mmap(nullptr, shm_size_, PROT_READ, 
-                        flags | MAP_HUGETLB, shm_fd_, 0);
-        if (ptr != MAP_FAILED) {
-            shm_ptr_ = ptr;
-            using_huge_pages_ = true;
-        }
-    }
-    
-    if (!shm_ptr_) {
-        shm_ptr_ = mmap(nullptr, shm_size_, PROT_READ, flags, shm_fd_, 0);
-        if (shm_ptr_ == MAP_FAILED) {
-            close(shm_fd_);
-            shm_fd_ = -1;
-            shm_ptr_ = nullptr;
-            return false;
-        }
-        using_huge_pages_ = false;
+    // Map memory (2MB aligned, so huge pages of the segment map as huge pages)
+    shm_ptr_ = SIM::mapSegment(shm_fd_, shm_size_, PROT_READ, false, config_.use_huge_pages);
+    if (shm_ptr_ == MAP_FAILED) {
+        close(shm_fd_);
+        shm_fd_ = -1;
+        shm_ptr_ = nullptr;
+        return false;
     }
     
     // Validate header
@@ -513,12 +797,24 @@ bool Reader::init() {
         shm_fd_ = -1;
         return false;
     }
+    using_huge_pages_ = (header_->flags & (SIM::SEGMENT_FLAG_HUGETLB | SIM::SEGMENT_FLAG_THP)) != 0;
     
-    // Set buffer pointers
-    size_t aligned_buffer_size = CacheUtils::alignToCacheLine(max_size_);
-    const uint8_t* base = static_cast<const uint8_t*>(shm_ptr_) + sizeof(Header);
-    buffer_[0] = base;
-    buffer_[1] = base + aligned_buffer_size;
+    // Set metadata and buffer pointers (layout written by the writer)
+    if (!mapLayout()) {
+        munmap(shm_ptr_, shm_size_);
+        close(shm_fd_);
+        shm_ptr_ = nullptr;
+        shm_fd_ = -1;
+        return false;
+    }
+    if (retired_ptr_) {
+        munmap(retired_ptr_, retired_size_);    // Grew while attaching
+        retired_ptr_ = nullptr;
+    }
+    
+    // Writable view of the notify word (payload stays read-only)
+    notify_.attach(shm_fd_, reinterpret_cast<const uint8_t*>(&header_->notify) -
+                            static_cast<const uint8_t*>(shm_ptr_));
     
     is_initialized_ = true;
     return true;
@@ -526,7 +822,7 @@ bool Reader::init() {
 
 void Reader::prefetchBuffer(int idx) {
     if (buffer_[idx] && config_.enable_prefetch) {
-        CacheUtils::prefetchRange(buffer_[idx], 
+        CacheUtils::prefetchRange(buffer_[idx],
             std::min(max_size_, config_.prefetch_distance));
     }
 }
@@ -538,9 +834,12 @@ bool Reader::read(void* data, size_t& size) {
     
     // Load front index with acquire semantics
     uint32_t front = header_->front_idx.load(std::memory_order_acquire);
+    if (!checkLayout(front)) {
+        return false;
+    }
     
     // Get current frame number
-    uint64_t current_frame = (front == 0) ? 
+    uint64_t current_frame = (front == 0) ?
         header_->frame0.load(std::memory_order_relaxed) :
         header_->frame1.load(std::memory_order_relaxed);
     
@@ -556,7 +855,7 @@ bool Reader::read(void* data, size_t& size) {
     
     // Get size
     size_t data_size = header_->published_length.load(std::memory_order_relaxed);
-    if (data_size > max_size_) {
+    if (data_size > max_size_ || data_size > capacity_) {
         return false;
     }
     size = data_size;
@@ -566,6 +865,7 @@ bool Reader::read(void* data, size_t& size) {
     
     // Update state
     last_frame_ = current_frame;
+    last_idx_ = front;
     last_timestamp_ns_ = (front == 0) ?
         header_->timestamp0_ns.load(std::memory_order_relaxed) :
         header_->timestamp1_ns.load(std::memory_order_relaxed);
@@ -573,12 +873,25 @@ bool Reader::read(void* data, size_t& size) {
     return true;
 }
 
+bool Reader::read(void* data, size_t& size, void* metadata) {
+    if (!read(data, size)) {
+        return false;
+    }
+    if (metadata && meta_[last_idx_]) {
+        std::memcpy(metadata, meta_[last_idx_], header_->meta_size);
+    }
+    return true;
+}
+
 const void* Reader::readZeroCopy(size_t& size) {
     if (!is_initialized_ || zero_copy_active_) {
         return nullptr;
     }
     
     uint32_t front = header_->front_idx.load(std::memory_order_acquire);
+    if (!checkLayout(front)) {
+        return nullptr;
+    }
     
     uint64_t current_frame = (front == 0) ?
         header_->frame0.load(std::memory_order_relaxed) :
@@ -589,8 +902,12 @@ const void* Reader::readZeroCopy(size_t& size) {
     }
     
     size = header_->published_length.load(std::memory_order_relaxed);
+    if (size > capacity_) {
+        return nullptr;     // Rewritten under a newer layout: remap on the next call
+    }
     
     last_frame_ = current_frame;
+    last_idx_ = front;
     last_timestamp_ns_ = (front == 0) ?
         header_->timestamp0_ns.load(std::memory_order_relaxed) :
         header_->timestamp1_ns.load(std::memory_order_relaxed);
@@ -599,27 +916,148 @@ const void* Reader::readZeroCopy(size_t& size) {
     return buffer_[front];
 }
 
+const void* Reader::getMetadata() const {
+    if (!is_initialized_ || last_frame_ == 0) {
+        return nullptr;
+    }
+    return meta_[last_idx_];
+}
+
 void Reader::releaseZeroCopy() {
     zero_copy_active_ = false;
 }
 
-bool Reader::readWithTimeout(void* data, size_t& size, uint32_t timeout_ms) {
-    auto start = std::chrono::steady_clock::now();
+const void* Reader::peek(uint64_t frame, size_t& size, int64_t& timestamp_ns) const {
+    if (!is_initialized_) {
+        return nullptr;
+    }
+    
+    uint32_t front = header_->front_idx.load(std::memory_order_acquire);
+    uint64_t current_frame = (front == 0) ?
+        header_->frame0.load(std::memory_order_relaxed) :
+        header_->frame1.load(std::memory_order_relaxed);
+    if (current_frame != frame) {
+        return nullptr;
+    }
+    
+    size = header_->published_length.load(std::memory_order_relaxed);
+    if (size > capacity_) {
+        return nullptr;
+    }
+    timestamp_ns = (front == 0) ?
+        header_->timestamp0_ns.load(std::memory_order_relaxed) :
+        header_->timestamp1_ns.load(std::memory_order_relaxed);
+    
+    // published_length belongs to the front: re-check it did not move
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header_->front_idx.load(std::memory_order_relaxed) != front ||
+        header_->layout_gen.load(std::memory_order_relaxed) != layout_gen_) {
+        return nullptr;
+    }
     
-    while (true) {
-        if (read(data, size)) {
-            return true;
+    return buffer_[front];
+}
+
+bool Reader::refreshLayout() {
+    if (!is_initialized_) {
+        return false;
+    }
+    if (header_->layout_gen.load(std::memory_order_relaxed) == layout_gen_) {
+        return true;
+    }
+    return mapLayout();
+}
+
+// Writer resized the channel since front was loaded: remap, reload front
+bool Reader::checkLayout(uint32_t& front) {
+    while (header_->layout_gen.load(std::memory_order_relaxed) != layout_gen_) {
+        if (!mapLayout()) {
+            return false;
+        }
+        front = header_->front_idx.load(std::memory_order_acquire);
+    }
+    return true;
+}
+
+// Capacity and buffer offset as the writer last published them. A grown
+// segment gets a new mapping; the previous one is kept until the next
+// remap so frames already returned stay readable.
+bool Reader::mapLayout() {
+    for (int attempt = 0; attempt < LAYOUT_RETRIES; ++attempt) {
+        uint32_t gen = header_->layout_gen.load(std::memory_order_acquire);
+        size_t capacity = header_->capacity;
+        size_t offset = header_->buffer_offset;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((gen & 1) || header_->layout_gen.load(std::memory_order_relaxed) != gen) {
+            std::this_thread::yield();
+            continue;
         }
         
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::steady_clock::now() - start).count();
-        
-        if (elapsed >= timeout_ms) {
-            return false;
+        size_t buffer_size = CacheUtils::alignToCacheLine(capacity);
+        if (offset + buffer_size * 2 > shm_size_) {
+            struct stat st;
+            if (fstat(shm_fd_, &st) == -1 ||
+                static_cast<size_t>(st.st_size) < offset + buffer_size * 2) {
+                return false;
+            }
+            void* ptr = SIM::mapSegment(shm_fd_, st.st_size, PROT_READ, false,
+                                        config_.use_huge_pages);
+            if (ptr == MAP_FAILED) {
+                return false;
+            }
+            
+            if (retired_ptr_) {
+                munmap(retired_ptr_, retired_size_);
+            }
+            retired_ptr_ = shm_ptr_;
+            retired_size_ = shm_size_;
+            shm_ptr_ = ptr;
+            shm_size_ = st.st_size;
+            header_ = static_cast<Header*>(shm_ptr_);
         }
         
-        std::this_thread::yield();
+        size_t meta_stride = CacheUtils::alignToCacheLine(header_->meta_size);
+        const uint8_t* meta = static_cast<const uint8_t*>(shm_ptr_) + sizeof(Header);
+        meta_[0] = header_->meta_size ? meta : nullptr;
+        meta_[1] = header_->meta_size ? meta + meta_stride : nullptr;
+        
+        const uint8_t* base = static_cast<const uint8_t*>(shm_ptr_) + offset;
+        buffer_[0] = base;
+        buffer_[1] = base + buffer_size;
+        capacity_ = capacity;
+        layout_gen_ = gen;
+        return true;
+    }
+    return false;
+}
+
+bool Reader::readWithTimeout(void* data, size_t& size, uint32_t timeout_ms) {
+    if (!waitForData(timeout_ms)) {
+        return false;
+    }
+    return read(data, size);
+}
+
+bool Reader::hasNewData() const {
+    if (!is_initialized_) {
+        return false;
+    }
+    
+    uint32_t front = header_->front_idx.load(std::memory_order_acquire);
+    uint64_t current_frame = (front == 0) ?
+        header_->frame0.load(std::memory_order_relaxed) :
+        header_->frame1.load(std::memory_order_relaxed);
+    
+    return current_frame != last_frame_;
+}
+
+bool Reader::waitForData(uint32_t timeout_ms) {
+    if (!is_initialized_) {
+        return false;
     }
+    
+    return wait_strategy_.waitUntil([this] { return hasNewData(); },
+                                    notify_.get(), timeout_ms);
 }
 
 bool Reader::isWriterAlive(uint32_t timeout_ms) const {
@@ -637,6 +1075,8 @@ bool Reader::isWriterAlive(uint32_t timeout_ms) const {
 Stats Reader::getStats() const {
     Stats stats;
     stats.huge_pages_active = using_huge_pages_;
+    stats.page_flags = header_ ? header_->flags : 0;
+    stats.huge_page_bytes = 0;  // Writer's view: see Writer::getStats()
     stats.prefetch_active = config_.enable_prefetch;
     stats.numa_node = 0;
     stats.pinned_cpu = config_.cpu_affinity;
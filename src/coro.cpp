@@ -0,0 +1,338 @@
+/**
+ * @file coro.cpp
+ * @brief Coroutine Frame Pool and Scheduler Implementation
+ */
+
+#include "coro.hpp"
+#include <new>
+
+namespace SIM {
+
+// ============================================================================
+// FramePool
+// ============================================================================
+
+FramePool& FramePool::instance() {
+    static FramePool pool;
+    return pool;
+}
+
+FramePool::FramePool()
+    : allocations_(0)
+    , heap_allocations_(0)
+{
+    for (size_t i = 0; i < NUM_CLASSES; ++i) {
+        classes_[i].lock.clear();
+        classes_[i].free_list = nullptr;
+    }
+}
+
+FramePool::~FramePool() {
+    for (void* chunk : chunks_) {
+        ::operator delete(chunk);
+    }
+}
+
+int FramePool::classIndex(size_t size) {
+    size_t block = MIN_BLOCK;
+    for (size_t i = 0; i < NUM_CLASSES; ++i, block <<= 1) {
+        if (size <= block) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void* FramePool::allocate(size_t size) {
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    
+    int idx = classIndex(size);
+    if (idx < 0) {
+        heap_allocations_.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+    
+    SizeClass& sc = classes_[idx];
+    while (sc.lock.test_and_set(std::memory_order_acquire)) {
+        Futex::cpuRelax();
+    }
+    
+    if (!sc.free_list) {
+        // Carve a new chunk into blocks (operator new alignment is kept)
+        size_t block = MIN_BLOCK << idx;
+        uint8_t* chunk = static_cast<uint8_t*>(::operator new(block * BLOCKS_PER_CHUNK));
+        {
+            std::lock_guard<std::mutex> lock(chunks_mutex_);
+            chunks_.push_back(chunk);
+        }
+        for (size_t i = 0; i < BLOCKS_PER_CHUNK; ++i) {
+            FreeBlock* fb = reinterpret_cast<FreeBlock*>(chunk + i * block);
+            fb->next = sc.free_list;
+            sc.free_list = fb;
+        }
+        heap_allocations_.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    FreeBlock* fb = sc.free_list;
+    sc.free_list = fb->next;
+    sc.lock.clear(std::memory_order_release);
+    return fb;
+}
+
+void FramePool::deallocate(void* ptr, size_t size) noexcept {
+    if (!ptr) return;
+    
+    int idx = classIndex(size);
+    if (idx < 0) {
+        ::operator delete(ptr);
+        return;
+    }
+    
+    SizeClass& sc = classes_[idx];
+    FreeBlock* fb = static_cast<FreeBlock*>(ptr);
+    while (sc.lock.test_and_set(std::memory_order_acquire)) {
+        Futex::cpuRelax();
+    }
+    fb->next = sc.free_list;
+    sc.free_list = fb;
+    sc.lock.clear(std::memory_order_release);
+}
+
+#ifdef SIM_HAS_COROUTINES
+
+// ============================================================================
+// Task
+// ============================================================================
+
+void Task::promise_type::FinalAwaiter::await_suspend(
+    std::coroutine_handle<promise_type> handle) noexcept {
+    Scheduler* scheduler = handle.promise().scheduler;
+    handle.destroy();
+    if (scheduler) scheduler->taskDone();
+}
+
+// ============================================================================
+// Scheduler
+// ============================================================================
+
+namespace {
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+Scheduler::Scheduler(size_t num_threads)
+    : num_threads_(num_threads)
+    , stop_(false)
+    , live_(0)
+    , control_id_(-1)
+    , run_queue_(4096)
+{
+    control_.seq.store(0, std::memory_order_relaxed);
+    control_.waiters.store(0, std::memory_order_relaxed);
+    work_.seq.store(0, std::memory_order_relaxed);
+    work_.waiters.store(0, std::memory_order_relaxed);
+}
+
+Scheduler::~Scheduler() {
+    stop();
+    
+    // Destroy coroutines that never completed
+    std::vector<std::coroutine_handle<>> leftover;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        leftover.swap(spawned_);
+        for (Waiter* w : incoming_) leftover.push_back(w->handle);
+        incoming_.clear();
+    }
+    for (Waiter* w : by_channel_) {
+        if (w) leftover.push_back(w->handle);
+    }
+    for (Waiter* w : polled_) leftover.push_back(w->handle);
+    void* addr;
+    while (run_queue_.pop(addr)) {
+        leftover.push_back(std::coroutine_handle<>::from_address(addr));
+    }
+    
+    for (auto handle : leftover) {
+        handle.destroy();
+    }
+}
+
+void Scheduler::spawn(Task&& task) {
+    Task::Handle handle = task.release();
+    if (!handle) return;
+    handle.promise().scheduler = this;
+    live_.fetch_add(1, std::memory_order_acq_rel);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        spawned_.push_back(handle);
+    }
+    Futex::publish(&control_);
+}
+
+void Scheduler::suspend(Waiter* waiter) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        incoming_.push_back(waiter);
+    }
+    Futex::publish(&control_);
+}
+
+void Scheduler::taskDone() {
+    if (live_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        Futex::publish(&control_);
+    }
+}
+
+void Scheduler::stop() {
+    stop_.store(true, std::memory_order_release);
+    Futex::publish(&control_);
+    Futex::publish(&work_);
+}
+
+void Scheduler::dispatch(std::coroutine_handle<> handle) {
+    if (num_threads_ == 0) {
+        handle.resume();
+        return;
+    }
+    while (!run_queue_.push(handle.address())) {
+        std::this_thread::yield();
+    }
+    Futex::publish(&work_);
+}
+
+void Scheduler::watch(Waiter* waiter) {
+    if (waiter->ready(waiter->ctx)) {
+        dispatch(waiter->handle);
+        return;
+    }
+    
+    int id = waiter->word ? wait_set_.add(waiter->word) : -1;
+    if (id < 0) {
+        waiter->channel = -1;
+        polled_.push_back(waiter);
+        return;
+    }
+    
+    waiter->channel = id;
+    if (static_cast<size_t>(id) >= by_channel_.size()) {
+        by_channel_.resize(id + 1, nullptr);
+    }
+    by_channel_[id] = waiter;
+    
+    // A publish between the check above and add() set the baseline past it
+    if (waiter->ready(waiter->ctx)) {
+        unwatch(waiter);
+        dispatch(waiter->handle);
+    }
+}
+
+void Scheduler::unwatch(Waiter* waiter) {
+    if (waiter->channel >= 0) {
+        wait_set_.remove(waiter->channel);
+        by_channel_[waiter->channel] = nullptr;
+        waiter->channel = -1;
+    }
+}
+
+void Scheduler::workerLoop() {
+    WaitStrategy strategy = WaitStrategy::adaptive();
+    void* addr;
+    while (!stop_.load(std::memory_order_acquire)) {
+        if (run_queue_.pop(addr)) {
+            std::coroutine_handle<>::from_address(addr).resume();
+            continue;
+        }
+        strategy.waitUntil([this] {
+            return run_queue_.size() > 0 || stop_.load(std::memory_order_acquire);
+        }, &work_, 100);
+    }
+}
+
+void Scheduler::run() {
+    stop_.store(false, std::memory_order_release);
+    if (control_id_ < 0) {
+        control_id_ = wait_set_.add(&control_);
+    }
+    for (size_t i = 0; i < num_threads_; ++i) {
+        workers_.emplace_back(&Scheduler::workerLoop, this);
+    }
+    
+    std::vector<std::coroutine_handle<>> spawned;
+    std::vector<Waiter*> incoming;
+    std::vector<int> ready;
+    
+    while (!stop_.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            spawned.swap(spawned_);
+            incoming.swap(incoming_);
+        }
+        for (auto handle : spawned) dispatch(handle);
+        for (Waiter* w : incoming) watch(w);
+        spawned.clear();
+        incoming.clear();
+        
+        if (live_.load(std::memory_order_acquire) == 0) break;
+        
+        // Sleep until the nearest deadline, briefly if some waiters are polled
+        int64_t now = steadyNowNs();
+        int64_t nearest = INT64_MAX;
+        for (Waiter* w : by_channel_) {
+            if (w && w->deadline_ns < nearest) nearest = w->deadline_ns;
+        }
+        for (Waiter* w : polled_) {
+            if (w->deadline_ns < nearest) nearest = w->deadline_ns;
+        }
+        uint32_t timeout_ms = polled_.empty() ? 100 : 1;
+        if (nearest != INT64_MAX) {
+            int64_t until_ms = nearest > now ? (nearest - now + 999999) / 1000000 : 0;
+            if (until_ms < timeout_ms) timeout_ms = static_cast<uint32_t>(until_ms);
+        }
+        
+        size_t n = wait_set_.wait(ready, timeout_ms);
+        for (size_t i = 0; i < n; ++i) {
+            int id = ready[i];
+            if (id == control_id_ || static_cast<size_t>(id) >= by_channel_.size()) continue;
+            Waiter* w = by_channel_[id];
+            if (w && w->ready(w->ctx)) {
+                unwatch(w);
+                dispatch(w->handle);
+            }
+        }
+        
+        // Polled readers and expired deadlines
+        now = steadyNowNs();
+        for (size_t i = 0; i < polled_.size();) {
+            Waiter* w = polled_[i];
+            if (w->ready(w->ctx) || w->deadline_ns <= now) {
+                polled_[i] = polled_.back();
+                polled_.pop_back();
+                dispatch(w->handle);
+            } else {
+                ++i;
+            }
+        }
+        for (size_t id = 0; id < by_channel_.size(); ++id) {
+            Waiter* w = by_channel_[id];
+            if (w && w->deadline_ns <= now) {
+                unwatch(w);
+                dispatch(w->handle);
+            }
+        }
+    }
+    
+    Futex::publish(&work_);
+    stop_.store(true, std::memory_order_release);
+    for (auto& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+    workers_.clear();
+    stop_.store(false, std::memory_order_release);
+}
+
+#endif // SIM_HAS_COROUTINES
+
+} // namespace SIM
@@ -0,0 +1,171 @@
+/**
+ * @file derived.cpp
+ * @brief Lazy Derived Channel Implementation
+ */
+
+#include "derived.hpp"
+
+namespace SIM {
+
+// ============================================================================
+// DerivedChannel
+// ============================================================================
+
+DerivedChannel::DerivedChannel(const std::string& name, size_t max_size, DeriveFn fn,
+                               size_t depth)
+    : name_(name)
+    , max_size_(max_size)
+    , fn_(std::move(fn))
+    , depth_(depth < 2 ? 2 : depth)
+    , version_(0)
+    , stat_requests_(0)
+    , stat_computations_(0)
+    , stat_shared_(0)
+{
+    size_t stride = (max_size_ + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+    storage_.reset(new uint8_t[stride * depth_ + CACHE_LINE_SIZE]);
+    uint8_t* base = reinterpret_cast<uint8_t*>(
+        (reinterpret_cast<uintptr_t>(storage_.get()) + CACHE_LINE_SIZE - 1) &
+        ~static_cast<uintptr_t>(CACHE_LINE_SIZE - 1));
+    
+    results_.resize(depth_);
+    for (size_t i = 0; i < depth_; ++i) {
+        results_[i].data = base + i * stride;
+        results_[i].size = 0;
+        results_[i].timestamp_ns = 0;
+    }
+}
+
+DerivedChannel::~DerivedChannel() = default;
+
+bool DerivedChannel::addSource(NotifyWord* word, std::function<bool()> has_data,
+                               std::function<Frame()> fetch) {
+    if (!has_data || !fetch) return false;
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (version_.load(std::memory_order_relaxed) != 0) return false;
+    
+    Source source;
+    source.word = word;
+    source.has_data = std::move(has_data);
+    source.fetch = std::move(fetch);
+    source.sequence = 0;
+    sources_.push_back(std::move(source));
+    return true;
+}
+
+bool DerivedChannel::sourcesChanged() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Source& source : sources_) {
+        if (source.has_data()) return true;
+    }
+    return false;
+}
+
+uint64_t DerivedChannel::refresh(Result& out, bool& computed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    computed = false;
+    
+    bool changed = false;
+    for (Source& source : sources_) {
+        if (!source.has_data()) continue;
+        // Drop the old frame first (CASIR allows one zero-copy read at a time)
+        source.current.reset();
+        source.current = source.fetch();
+        if (source.current) {
+            ++source.sequence;
+            changed = true;
+        }
+    }
+    
+    uint64_t version = version_.load(std::memory_order_relaxed);
+    
+    if (changed && !sources_.empty()) {
+        // Derive once every source has produced at least one frame
+        bool complete = true;
+        inputs_.clear();
+        int64_t newest = 0;
+        for (const Source& source : sources_) {
+            if (!source.current) {
+                complete = false;
+                break;
+            }
+            DerivedInput input;
+            input.data = source.current.data();
+            input.size = source.current.size();
+            input.timestamp_ns = source.current.timestampNs();
+            input.sequence = source.sequence;
+            inputs_.push_back(input);
+            if (input.timestamp_ns > newest) newest = input.timestamp_ns;
+        }
+        
+        if (complete) {
+            Result& slot = results_[version % depth_];
+            size_t size = fn_(inputs_, slot.data, max_size_);
+            stat_computations_.fetch_add(1, std::memory_order_relaxed);
+            computed = true;
+            if (size > 0 && size <= max_size_) {
+                slot.size = size;
+                slot.timestamp_ns = newest;
+                version_.store(++version, std::memory_order_release);
+            }
+        }
+    }
+    
+    if (version > 0) {
+        out = results_[(version - 1) % depth_];
+    }
+    return version;
+}
+
+DerivedStats DerivedChannel::getStats() const {
+    DerivedStats stats;
+    stats.requests = stat_requests_.load(std::memory_order_relaxed);
+    stats.computations = stat_computations_.load(std::memory_order_relaxed);
+    stats.shared = stat_shared_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ============================================================================
+// DerivedReader
+// ============================================================================
+
+const void* DerivedReader::getLatest(size_t& size, int64_t& timestamp_ns) {
+    channel_.stat_requests_.fetch_add(1, std::memory_order_relaxed);
+    
+    DerivedChannel::Result result;
+    bool computed;
+    uint64_t version = channel_.refresh(result, computed);
+    if (version == 0 || version == last_version_) {
+        return nullptr;
+    }
+    
+    if (!computed) {
+        channel_.stat_shared_.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    last_version_ = version;
+    last_timestamp_ns_ = result.timestamp_ns;
+    size = result.size;
+    timestamp_ns = result.timestamp_ns;
+    return result.data;
+}
+
+bool DerivedReader::hasNewData() const {
+    if (channel_.version_.load(std::memory_order_acquire) != last_version_) {
+        return true;
+    }
+    return channel_.sourcesChanged();
+}
+
+bool DerivedReader::waitForData(uint32_t timeout_ms) {
+    return wait_strategy_.waitUntil([this] { return hasNewData(); },
+                                    getNotifyWord(), timeout_ms);
+}
+
+NotifyWord* DerivedReader::getNotifyWord() const {
+    std::lock_guard<std::mutex> lock(channel_.mutex_);
+    return channel_.sources_.empty() ? nullptr : channel_.sources_[0].word;
+}
+
+} // namespace SIM
@@ -0,0 +1,501 @@
+/**
+ * @file executor.cpp
+ * @brief Subscription Executor Implementation
+ */
+
+#include "executor.hpp"
+
+namespace SIM {
+
+namespace {
+
+// Subscription whose callback runs on this thread (self-unsubscribe)
+thread_local const void* tls_running_sub = nullptr;
+
+} // namespace
+
+// ============================================================================
+// Construction
+// ============================================================================
+
+Executor::Worker::Worker(size_t capacity)
+    : cpu(-1)
+    , inbox(capacity)
+{
+    for (size_t p = 0; p < PRIORITY_LEVELS; ++p) {
+        deques[p].reset(new WorkStealingDeque<Subscription>(capacity));
+    }
+}
+
+Executor::Executor(const ExecutorConfig& config)
+    : config_(config)
+    , running_(false)
+    , stop_(false)
+    , next_worker_(0)
+    , work_seq_(0)
+    , idle_workers_(0)
+    , pending_(0)
+    , stat_dispatched_(0)
+    , stat_executed_(0)
+    , stat_coalesced_(0)
+    , stat_stolen_(0)
+    , stat_wakeups_(0)
+{
+    if (config_.num_workers == 0) {
+        config_.num_workers = 1;
+    }
+}
+
+Executor::~Executor() {
+    stop();
+}
+
+// ============================================================================
+// Subscriptions
+// ============================================================================
+
+uint32_t Executor::submit(Shard* shard, const Command& cmd) {
+    uint32_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->commands.push_back(cmd);
+        ticket = ++shard->submitted;
+    }
+    // Wake the dispatcher through its control word
+    Futex::publish(&shard->control);
+    return ticket;
+}
+
+Executor::Subscription* Executor::lookup(int id) {
+    if (id < 0) return nullptr;
+    size_t slot = static_cast<size_t>(id) & (MAX_SUBSCRIPTIONS - 1);
+    uint32_t generation = static_cast<uint32_t>(id) >> SLOT_BITS;
+    if (slot >= subs_.size() || subs_[slot]->generation != generation) return nullptr;
+    return subs_[slot].get();
+}
+
+void Executor::reclaim() {
+    // A slot is free once its shard dropped the channel and no worker holds it
+    for (size_t i = 0; i < retired_.size();) {
+        Subscription* sub = subs_[retired_[i]].get();
+        Shard* shard = shards_[sub->shard].get();
+        if (static_cast<int32_t>(shard->applied.load(std::memory_order_acquire) - sub->remove_ticket) >= 0 &&
+            sub->state.load(std::memory_order_acquire) == IDLE) {
+            free_.push_back(retired_[i]);
+            retired_[i] = retired_.back();
+            retired_.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+int Executor::subscribe(NotifyWord* word, std::function<bool()> has_data,
+                        std::function<void()> callback,
+                        const SubscriptionOptions& options) {
+    if ((!word && !has_data) || !callback) return -1;
+    
+    std::lock_guard<std::mutex> lock(subs_mutex_);
+    if (free_.empty()) reclaim();
+    if (free_.empty() && subs_.size() >= MAX_SUBSCRIPTIONS) return -1;
+    
+    // First dispatcher shard with room, or a new one
+    Shard* shard = nullptr;
+    size_t shard_idx = 0;
+    for (; shard_idx < shards_.size(); ++shard_idx) {
+        if (shards_[shard_idx]->count < CHANNELS_PER_DISPATCHER) {
+            shard = shards_[shard_idx].get();
+            break;
+        }
+    }
+    
+    bool new_shard = false;
+    if (!shard) {
+        shards_.emplace_back(new Shard());
+        shard = shards_.back().get();
+        shard->control.seq.store(0, std::memory_order_relaxed);
+        shard->control.waiters.store(0, std::memory_order_relaxed);
+        shard->control_id = -1;
+        shard->applied.store(0, std::memory_order_relaxed);
+        shard->submitted = 0;
+        shard->count = 0;
+        new_shard = true;
+    }
+    
+    // Reused slots keep their object: stale pointers still see a valid state
+    size_t slot;
+    if (!free_.empty()) {
+        slot = free_.back();
+        free_.pop_back();
+    } else {
+        slot = subs_.size();
+        subs_.emplace_back(new Subscription());
+        subs_[slot]->generation = 0;
+    }
+    Subscription* sub = subs_[slot].get();
+    sub->word = word;
+    sub->has_data = std::move(has_data);
+    sub->callback = std::move(callback);
+    sub->options = options;
+    sub->state.store(IDLE, std::memory_order_relaxed);
+    sub->cancelled.store(false, std::memory_order_release);
+    sub->shard = static_cast<int>(shard_idx);
+    sub->channel_id = -1;
+    sub->generation = (sub->generation + 1) & GENERATION_MASK;
+    sub->remove_ticket = 0;
+    
+    ++shard->count;
+    submit(shard, Command{sub, true});
+    
+    if (new_shard && running_.load(std::memory_order_acquire)) {
+        startShard(shard);
+    }
+    
+    return static_cast<int>((sub->generation << SLOT_BITS) | slot);
+}
+
+bool Executor::unsubscribe(int id) {
+    Subscription* sub;
+    Shard* shard;
+    uint32_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(subs_mutex_);
+        sub = lookup(id);
+        if (!sub || sub->cancelled.exchange(true)) return false;
+        shard = shards_[sub->shard].get();
+        --shard->count;
+        ticket = submit(shard, Command{sub, false});
+        sub->remove_ticket = ticket;
+        retired_.push_back(static_cast<size_t>(id) & (MAX_SUBSCRIPTIONS - 1));
+    }
+    
+    if (!running_.load(std::memory_order_acquire)) {
+        // No dispatcher: the command is applied on the next start()
+        return true;
+    }
+    
+    // Own callback: it is RUNNING until we return, run() drops it afterwards
+    if (tls_running_sub == sub) return true;
+    
+    // Wait until the dispatcher dropped the channel and no worker holds it
+    while (static_cast<int32_t>(shard->applied.load(std::memory_order_acquire) - ticket) < 0 ||
+           sub->state.load(std::memory_order_acquire) != IDLE) {
+        if (!running_.load(std::memory_order_acquire)) break;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+bool Executor::trigger(int id) {
+    Subscription* sub;
+    {
+        // Queued under the lock: a QUEUED slot is never reclaimed
+        std::lock_guard<std::mutex> lock(subs_mutex_);
+        sub = lookup(id);
+        if (!sub || !running_.load(std::memory_order_acquire) ||
+            sub->cancelled.load(std::memory_order_acquire)) {
+            return false;
+        }
+        if (!notify(sub)) return true;
+    }
+    
+    Worker& worker = *workers_[route(sub)];
+    while (!worker.inbox.push(sub)) {
+        std::this_thread::yield();
+    }
+    stat_dispatched_.fetch_add(1, std::memory_order_relaxed);
+    pending_.fetch_add(1, std::memory_order_seq_cst);
+    work_seq_.fetch_add(1, std::memory_order_seq_cst);
+    if (idle_workers_.load(std::memory_order_seq_cst) > 0) {
+        Futex::wake(&work_seq_, 1);
+        stat_wakeups_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+bool Executor::start() {
+    std::lock_guard<std::mutex> lock(subs_mutex_);
+    if (running_.load(std::memory_order_acquire)) return true;
+    
+    stop_.store(false, std::memory_order_release);
+    pending_.store(0, std::memory_order_relaxed);
+    
+    workers_.clear();
+    for (size_t i = 0; i < config_.num_workers; ++i) {
+        workers_.emplace_back(new Worker(MAX_SUBSCRIPTIONS));
+        workers_[i]->cpu = i < config_.worker_cpus.size() ? config_.worker_cpus[i] : -1;
+    }
+    
+    running_.store(true, std::memory_order_release);
+    
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread(&Executor::workerLoop, this, i);
+    }
+    for (auto& shard : shards_) {
+        startShard(shard.get());
+    }
+    return true;
+}
+
+void Executor::startShard(Shard* shard) {
+    shard->thread = std::thread(&Executor::dispatchLoop, this, shard);
+}
+
+void Executor::stop() {
+    if (!running_.load(std::memory_order_acquire)) return;
+    
+    stop_.store(true, std::memory_order_release);
+    
+    std::lock_guard<std::mutex> lock(subs_mutex_);
+    for (auto& shard : shards_) {
+        Futex::publish(&shard->control);
+    }
+    for (auto& shard : shards_) {
+        if (shard->thread.joinable()) shard->thread.join();
+    }
+    
+    work_seq_.fetch_add(1, std::memory_order_seq_cst);
+    Futex::wake(&work_seq_, Futex::WAKE_ALL);
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+    workers_.clear();
+    
+    // Queued callbacks were dropped with the workers
+    for (auto& sub : subs_) {
+        sub->state.store(IDLE, std::memory_order_release);
+    }
+    
+    running_.store(false, std::memory_order_release);
+}
+
+ExecutorStats Executor::getStats() const {
+    ExecutorStats stats;
+    stats.dispatched = stat_dispatched_.load(std::memory_order_relaxed);
+    stats.executed = stat_executed_.load(std::memory_order_relaxed);
+    stats.coalesced = stat_coalesced_.load(std::memory_order_relaxed);
+    stats.stolen = stat_stolen_.load(std::memory_order_relaxed);
+    stats.wakeups = stat_wakeups_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ============================================================================
+// Dispatcher
+// ============================================================================
+
+void Executor::applyCommands(Shard* shard) {
+    std::vector<Command> commands;
+    uint32_t submitted;
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        commands.swap(shard->commands);
+        submitted = shard->submitted;
+    }
+    
+    for (const Command& cmd : commands) {
+        Subscription* sub = cmd.sub;
+        if (cmd.add) {
+            int id = shard->wait_set.add(sub->word, sub->has_data);
+            sub->channel_id = id;
+            if (id < 0) continue;
+            if (static_cast<size_t>(id) >= shard->by_channel.size()) {
+                shard->by_channel.resize(id + 1, nullptr);
+            }
+            shard->by_channel[id] = sub;
+        } else if (sub->channel_id >= 0) {
+            shard->wait_set.remove(sub->channel_id);
+            shard->by_channel[sub->channel_id] = nullptr;
+            sub->channel_id = -1;
+        }
+    }
+    
+    shard->applied.store(submitted, std::memory_order_release);
+}
+
+bool Executor::notify(Subscription* sub) {
+    uint32_t state = sub->state.load(std::memory_order_acquire);
+    while (true) {
+        if (state == IDLE) {
+            if (sub->state.compare_exchange_weak(state, QUEUED, std::memory_order_acq_rel)) {
+                return true;
+            }
+        } else if (state == RUNNING) {
+            // Callback in flight: make it run once more instead of queueing
+            if (sub->state.compare_exchange_weak(state, RUNNING_DIRTY, std::memory_order_acq_rel)) {
+                stat_coalesced_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } else {
+            stat_coalesced_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+}
+
+size_t Executor::route(Subscription* sub) {
+    int hint = sub->options.cpu_hint;
+    if (hint >= 0) {
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            if (workers_[i]->cpu == hint) return i;
+        }
+        return static_cast<size_t>(hint) % workers_.size();
+    }
+    return next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+}
+
+void Executor::dispatchLoop(Shard* shard) {
+    if (config_.dispatcher_cpu >= 0) {
+        CacheUtils::setCpuAffinity(config_.dispatcher_cpu);
+    }
+    
+    shard->wait_set.setWaitStrategy(config_.wait_strategy);
+    if (shard->control_id < 0) {
+        shard->control_id = shard->wait_set.add(&shard->control);
+    }
+    applyCommands(shard);
+    
+    std::vector<int> ready;
+    while (!stop_.load(std::memory_order_acquire)) {
+        size_t n = shard->wait_set.wait(ready, 100);
+        if (stop_.load(std::memory_order_acquire)) break;
+        
+        int64_t batch = 0;
+        for (size_t i = 0; i < n; ++i) {
+            int id = ready[i];
+            if (id == shard->control_id) {
+                applyCommands(shard);
+                continue;
+            }
+            
+            Subscription* sub = shard->by_channel[id];
+            if (!sub || sub->cancelled.load(std::memory_order_acquire)) continue;
+            if (!notify(sub)) continue;
+            
+            Worker& worker = *workers_[route(sub)];
+            while (!worker.inbox.push(sub)) {
+                std::this_thread::yield();  // Bounded by MAX_SUBSCRIPTIONS: transient
+            }
+            ++batch;
+        }
+        
+        if (batch == 0) continue;
+        
+        // One wake-up per batch, only if workers are parked
+        stat_dispatched_.fetch_add(batch, std::memory_order_relaxed);
+        pending_.fetch_add(batch, std::memory_order_seq_cst);
+        work_seq_.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t idle = idle_workers_.load(std::memory_order_seq_cst);
+        if (idle > 0) {
+            Futex::wake(&work_seq_, static_cast<int>(std::min<int64_t>(batch, idle)));
+            stat_wakeups_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// ============================================================================
+// Workers
+// ============================================================================
+
+Executor::Subscription* Executor::nextTask(size_t index) {
+    Worker& self = *workers_[index];
+    Subscription* sub = nullptr;
+    
+    // Move dispatched work into the local priority deques
+    while (self.inbox.pop(sub)) {
+        size_t level = static_cast<size_t>(sub->options.priority);
+        if (level >= PRIORITY_LEVELS) level = PRIORITY_LEVELS - 1;
+        self.deques[level]->push(sub);
+    }
+    
+    size_t n = workers_.size();
+    for (size_t p = PRIORITY_LEVELS; p-- > 0;) {
+        sub = self.deques[p]->pop();
+        if (sub) return sub;
+        
+        // Steal same-priority work, starting at the next worker
+        for (size_t k = 1; k < n; ++k) {
+            Worker& victim = *workers_[(index + k) % n];
+            sub = victim.deques[p]->steal();
+            if (sub) {
+                stat_stolen_.fetch_add(1, std::memory_order_relaxed);
+                return sub;
+            }
+        }
+    }
+    
+    // Work still waiting in a busy worker's inbox
+    for (size_t k = 1; k < n; ++k) {
+        Worker& victim = *workers_[(index + k) % n];
+        if (victim.inbox.pop(sub)) {
+            stat_stolen_.fetch_add(1, std::memory_order_relaxed);
+            return sub;
+        }
+    }
+    
+    return nullptr;
+}
+
+void Executor::run(size_t index, Subscription* sub) {
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    
+    while (true) {
+        sub->state.store(RUNNING, std::memory_order_release);
+        
+        if (!sub->cancelled.load(std::memory_order_acquire)) {
+            tls_running_sub = sub;
+            sub->callback();
+            tls_running_sub = nullptr;
+            stat_executed_.fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        uint32_t expected = RUNNING;
+        if (sub->state.compare_exchange_strong(expected, IDLE, std::memory_order_acq_rel)) {
+            return;
+        }
+        
+        // Published again while running (RUNNING_DIRTY)
+        if (sub->cancelled.load(std::memory_order_acquire)) {
+            sub->state.store(IDLE, std::memory_order_release);
+            return;
+        }
+        
+        // Requeue locally so higher-priority work can go first
+        sub->state.store(QUEUED, std::memory_order_release);
+        size_t level = static_cast<size_t>(sub->options.priority);
+        if (level >= PRIORITY_LEVELS) level = PRIORITY_LEVELS - 1;
+        if (workers_[index]->deques[level]->push(sub)) {
+            pending_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+void Executor::workerLoop(size_t index) {
+    Worker& self = *workers_[index];
+    if (self.cpu >= 0) {
+        CacheUtils::setCpuAffinity(self.cpu);
+    }
+    
+    while (!stop_.load(std::memory_order_acquire)) {
+        Subscription* sub = nextTask(index);
+        if (sub) {
+            run(index, sub);
+            continue;
+        }
+        
+        // Park until the dispatcher publishes a batch
+        uint32_t seen = work_seq_.load(std::memory_order_acquire);
+        idle_workers_.fetch_add(1, std::memory_order_seq_cst);
+        if (pending_.load(std::memory_order_seq_cst) <= 0 &&
+            !stop_.load(std::memory_order_acquire)) {
+            Futex::wait(&work_seq_, seen, -1);
+        }
+        idle_workers_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+} // namespace SIM
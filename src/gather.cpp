@@ -0,0 +1,142 @@
+/**
+ * @file gather.cpp
+ * @brief Scatter-gather copy implementation
+ */
+
+#include "gather.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>  // SSE2
+#define HAS_NT_STORE 1
+#else
+#define HAS_NT_STORE 0
+#endif
+
+namespace SIM {
+
+namespace {
+
+#if HAS_NT_STORE
+/**
+ * @brief Streaming writer that treats all segments as one byte stream
+ *
+ * Bytes that do not fill a 16-byte chunk are kept in a carry register
+ * and completed by the next segment, so every store after the alignment
+ * prefix is a full aligned _mm_stream_si128.
+ */
+class NtStream {
+public:
+    explicit NtStream(uint8_t* dst)
+        : out_(dst)
+        , prefix_((16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15)
+        , carry_len_(0)
+    {
+    }
+    
+    void append(const uint8_t* src, size_t size) {
+        if (size == 0) return;
+        
+        // Cached bytes until the destination is 16-byte aligned
+        if (prefix_ > 0) {
+            size_t n = size < prefix_ ? size : prefix_;
+            std::memcpy(out_, src, n);
+            out_ += n;
+            src += n;
+            size -= n;
+            prefix_ -= n;
+        }
+        
+        // Complete a chunk started by the previous segment
+        if (carry_len_ > 0 && size > 0) {
+            size_t n = size < 16 - carry_len_ ? size : 16 - carry_len_;
+            std::memcpy(carry_ + carry_len_, src, n);
+            carry_len_ += n;
+            src += n;
+            size -= n;
+            if (carry_len_ < 16) return;
+            _mm_stream_si128(reinterpret_cast<__m128i*>(out_),
+                             _mm_load_si128(reinterpret_cast<const __m128i*>(carry_)));
+            out_ += 16;
+            carry_len_ = 0;
+        }
+        
+        size_t chunks = size / 16;
+        auto* d = reinterpret_cast<__m128i*>(out_);
+        const auto* s = reinterpret_cast<const __m128i*>(src);
+        for (size_t i = 0; i < chunks; ++i) {
+            _mm_stream_si128(d + i, _mm_loadu_si128(s + i));
+        }
+        out_ += chunks * 16;
+        src += chunks * 16;
+        
+        carry_len_ = size % 16;
+        std::memcpy(carry_, src, carry_len_);
+    }
+    
+    void finish() {
+        std::memcpy(out_, carry_, carry_len_);
+        out_ += carry_len_;
+        carry_len_ = 0;
+        _mm_sfence();
+    }
+
+private:
+    uint8_t* out_;
+    size_t prefix_;
+    alignas(16) uint8_t carry_[16];
+    size_t carry_len_;
+};
+#endif
+
+} // namespace
+
+size_t iovecSize(const struct iovec* iov, int iovcnt) {
+    if (iovcnt < 0 || (iovcnt > 0 && !iov)) return SIZE_MAX;
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        if (iov[i].iov_len > SIZE_MAX - total) return SIZE_MAX;
+        total += iov[i].iov_len;
+    }
+    return total;
+}
+
+void gatherCopy(void* dst, const struct iovec* iov, int iovcnt, bool non_temporal) {
+    auto* out = static_cast<uint8_t*>(dst);
+    
+    // Coalesce small leading segments (typically the message header)
+    alignas(64) uint8_t head[GATHER_COALESCE_BYTES];
+    size_t head_len = 0;
+    int i = 0;
+    while (i < iovcnt && iov[i].iov_len <= GATHER_COALESCE_BYTES - head_len) {
+        if (iov[i].iov_len == 0) { ++i; continue; }
+        std::memcpy(head + head_len, iov[i].iov_base, iov[i].iov_len);
+        head_len += iov[i].iov_len;
+        ++i;
+    }
+
+#if HAS_NT_STORE
+    if (non_temporal) {
+        NtStream stream(out);
+        stream.append(head, head_len);
+        for (; i < iovcnt; ++i) {
+            stream.append(static_cast<const uint8_t*>(iov[i].iov_base), iov[i].iov_len);
+        }
+        stream.finish();
+        return;
+    }
+#else
+    (void)non_temporal;
+#endif
+
+    std::memcpy(out, head, head_len);
+    out += head_len;
+    for (; i < iovcnt; ++i) {
+        if (iov[i].iov_len == 0) continue;
+        std::memcpy(out, iov[i].iov_base, iov[i].iov_len);
+        out += iov[i].iov_len;
+    }
+}
+
+} // namespace SIM
@@ -0,0 +1,301 @@
+/**
+ * @file gc.cpp
+ * @brief Segment GC Implementation
+ */
+
+#include "gc.hpp"
+#include "barq.hpp"
+#include "casir.hpp"
+#include "mux.hpp"
+#include "phase.hpp"
+#include "sahm.hpp"
+#include "sim.hpp"
+
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace SIM {
+
+namespace {
+
+// Writers stamp heartbeats with this clock
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+// "/<channel>_reader_<pid>": the ring belongs to reader <pid>
+int32_t ringOwner(const std::string& entry) {
+    size_t pos = entry.rfind("_reader_");
+    if (pos == std::string::npos || pos == 0) return 0;
+    const char* digits = entry.c_str() + pos + 8;
+    char* end = nullptr;
+    long pid = std::strtol(digits, &end, 10);
+    return (end != digits && *end == '\0' && pid > 0) ? static_cast<int32_t>(pid) : 0;
+}
+
+// Header fields of a library segment; false if the magic is not ours
+bool inspect(int fd, const std::string& entry, SegmentInfo& info) {
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size < 64) return false;
+    
+    size_t size = std::min<size_t>(static_cast<size_t>(st.st_size), 4096);
+    void* ptr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) return false;
+    
+    uint32_t magic;
+    std::memcpy(&magic, ptr, sizeof(magic));
+    
+    int32_t pid = 0;
+    int64_t heartbeat = 0;
+    SegmentKind kind = SegmentKind::Unknown;
+    
+    if (magic == BARQ::MAGIC && size >= sizeof(BARQ::Header)) {
+        const BARQ::Header* h = static_cast<const BARQ::Header*>(ptr);
+        kind = SegmentKind::BARQ;
+        pid = h->writer_pid.load(std::memory_order_relaxed);
+        heartbeat = h->heartbeat_ns.load(std::memory_order_relaxed);
+    } else if (magic == CASIR::CASIR_MAGIC && size >= sizeof(CASIR::Header)) {
+        const CASIR::Header* h = static_cast<const CASIR::Header*>(ptr);
+        kind = SegmentKind::CASIR;
+        pid = h->writer_pid.load(std::memory_order_relaxed);
+        heartbeat = h->writer_heartbeat_ns.load(std::memory_order_relaxed);
+    } else if (magic == HEADER_MAGIC && size >= sizeof(Header)) {
+        const Header* h = static_cast<const Header*>(ptr);
+        kind = SegmentKind::SIM;
+        pid = h->writer_pid.load(std::memory_order_relaxed);
+        heartbeat = h->writer_heartbeat_ns.load(std::memory_order_relaxed);
+    } else if (magic == MUX_MAGIC && size >= sizeof(MuxHeader)) {
+        const MuxHeader* h = static_cast<const MuxHeader*>(ptr);
+        kind = SegmentKind::Mux;
+        pid = h->owner_pid.load(std::memory_order_relaxed);
+        heartbeat = h->heartbeat_ns.load(std::memory_order_relaxed);
+    } else if (magic == PHASE_MAGIC && size >= sizeof(PhaseHeader)) {
+        // No single owner: a live consumer if any, else a dead one
+        const PhaseHeader* h = static_cast<const PhaseHeader*>(ptr);
+        kind = SegmentKind::Phase;
+        for (const PhaseSlot& slot : h->slots) {
+            int32_t slot_pid = slot.pid.load(std::memory_order_relaxed);
+            if (slot_pid == 0) continue;
+            heartbeat = std::max(heartbeat, slot.updated_ns.load(std::memory_order_relaxed));
+            if (pid == 0 || processAlive(slot_pid)) pid = slot_pid;
+            if (processAlive(pid)) break;
+        }
+    } else if (magic == SAHM::DIRECT_MAGIC) {
+        pid = ringOwner(entry);
+        if (pid > 0 && size >= sizeof(SAHM::RingBufferHeader)) {
+            kind = SegmentKind::SahmRing;
+        } else if (size >= sizeof(SAHM::ControlHeader)) {
+            const SAHM::ControlHeader* h = static_cast<const SAHM::ControlHeader*>(ptr);
+            kind = SegmentKind::SahmControl;
+            pid = h->writer_pid.load(std::memory_order_relaxed);
+            heartbeat = h->writer_heartbeat_ns.load(std::memory_order_relaxed);
+        }
+    }
+    munmap(ptr, size);
+    if (kind == SegmentKind::Unknown) return false;
+    
+    info.name = "/" + entry;
+    info.kind = kind;
+    info.state = SegmentState::Live;
+    info.bytes = static_cast<size_t>(st.st_size);
+    info.owner_pid = pid;
+    info.locked = false;
+    info.idle_ns = heartbeat > 0 ? std::max<int64_t>(0, nowNs() - heartbeat) : -1;
+    info.reclaimed = false;
+    return true;
+}
+
+// Owner lock test, only done for segments that look reclaimable: a writer
+// attaching while it runs would recreate its segment
+bool ownerLocked(int fd) {
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+        flock(fd, LOCK_UN);
+        return false;
+    }
+    return errno == EWOULDBLOCK;
+}
+
+// fd < 0: the caller already holds the lock exclusively
+SegmentState decide(SegmentInfo& info, const GcConfig& config, int fd) {
+    int64_t grace_ns = static_cast<int64_t>(config.grace_ms) * 1000000;
+    bool fresh = info.idle_ns >= 0 && info.idle_ns < grace_ns;
+    if (info.owner_pid > 0 && (fresh || processAlive(info.owner_pid))) return SegmentState::Live;
+    
+    info.state = info.owner_pid > 0 ? SegmentState::Dead : SegmentState::Parked;
+    if (fd >= 0 && isReclaimable(info, config) && ownerLocked(fd)) {
+        info.locked = true;
+        return SegmentState::Live;
+    }
+    return info.state;
+}
+
+// Move the name away, then unlink only if it still named the locked segment
+bool unlinkLocked(int dir, const std::string& entry, int fd) {
+    std::string tomb = "." + entry + ".gc" + std::to_string(getpid());
+    if (renameat(dir, entry.c_str(), dir, tomb.c_str()) < 0) return false;
+    
+    struct stat held, moved;
+    if (fstat(fd, &held) == 0 && fstatat(dir, tomb.c_str(), &moved, AT_SYMLINK_NOFOLLOW) == 0 &&
+        held.st_dev == moved.st_dev && held.st_ino == moved.st_ino) {
+        return unlinkat(dir, tomb.c_str(), 0) == 0;
+    }
+    
+    // A writer recreated the name before the rename: give it back
+    if (renameat2(dir, tomb.c_str(), dir, entry.c_str(), RENAME_NOREPLACE) < 0) {
+        unlinkat(dir, tomb.c_str(), 0);
+    }
+    return false;
+}
+
+// Free the dead reader's slot in its channel's control header
+void releaseReaderSlot(int dir, const std::string& entry) {
+    std::string control = entry.substr(0, entry.rfind("_reader_"));
+    int fd = openat(dir, control.c_str(), O_RDWR | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0) return;
+    
+    struct stat st;
+    void* ptr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(SAHM::ControlHeader)) {
+        ptr = mmap(nullptr, sizeof(SAHM::ControlHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (ptr == MAP_FAILED) return;
+    
+    SAHM::ControlHeader* header = static_cast<SAHM::ControlHeader*>(ptr);
+    if (header->magic == SAHM::DIRECT_MAGIC) {
+        std::string ring = "/" + entry;
+        for (size_t i = 0; i < SAHM::MAX_READERS; ++i) {
+            if (header->reader_active[i].load(std::memory_order_acquire) &&
+                std::strncmp(header->reader_shm_names[i], ring.c_str(), SAHM::SHM_NAME_LEN) == 0) {
+                header->reader_shm_names[i][0] = '\0';
+                header->reader_active[i].store(false, std::memory_order_release);
+                header->num_readers.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    munmap(ptr, sizeof(SAHM::ControlHeader));
+}
+
+bool reclaim(int dir, const SegmentInfo& info, const GcConfig& config) {
+    std::string entry = info.name.substr(1);
+    int fd = openat(dir, entry.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0) return false;
+    
+    // Under the exclusive lock no writer can attach: re-check, then remove
+    bool removed = false;
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+        SegmentInfo now;
+        if (inspect(fd, entry, now) && now.kind == info.kind) {
+            now.state = decide(now, config, -1);
+            if (isReclaimable(now, config)) {
+                removed = unlinkLocked(dir, entry, fd);
+            }
+        }
+    }
+    close(fd);
+    
+    if (removed && info.kind == SegmentKind::SahmRing) {
+        releaseReaderSlot(dir, entry);
+    }
+    return removed;
+}
+
+template<typename Fn>
+bool forEachSegment(const GcConfig& config, Fn fn) {
+    int dir = open(config.shm_dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir < 0) return false;
+    DIR* listing = fdopendir(dup(dir));
+    if (!listing) {
+        close(dir);
+        return false;
+    }
+    
+    while (dirent* d = readdir(listing)) {
+        // Hidden names (our tombstones) and POSIX semaphores are skipped
+        if (d->d_name[0] == '.' || std::strncmp(d->d_name, "sem.", 4) == 0) continue;
+        
+        int fd = openat(dir, d->d_name, O_RDONLY | O_CLOEXEC | O_NOFOLLOW | O_NONBLOCK);
+        if (fd < 0) continue;
+        SegmentInfo info;
+        if (inspect(fd, d->d_name, info)) {
+            info.state = decide(info, config, fd);
+            close(fd);
+            fn(dir, info);
+        } else {
+            close(fd);
+        }
+    }
+    
+    closedir(listing);
+    close(dir);
+    return true;
+}
+
+} // namespace
+
+bool processAlive(int32_t pid) {
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+const char* segmentKindName(SegmentKind kind) {
+    switch (kind) {
+        case SegmentKind::SIM:         return "SIM";
+        case SegmentKind::BARQ:        return "BARQ";
+        case SegmentKind::CASIR:       return "CASIR";
+        case SegmentKind::SahmControl: return "SAHM";
+        case SegmentKind::SahmRing:    return "SAHM-ring";
+        case SegmentKind::Mux:         return "Mux";
+        case SegmentKind::Phase:       return "Phase";
+        default:                       return "Unknown";
+    }
+}
+
+const char* segmentStateName(SegmentState state) {
+    switch (state) {
+        case SegmentState::Live:   return "live";
+        case SegmentState::Parked: return "parked";
+        case SegmentState::Dead:   return "dead";
+        default:                   return "?";
+    }
+}
+
+size_t scanSegments(std::vector<SegmentInfo>& out, const GcConfig& config) {
+    size_t found = 0;
+    forEachSegment(config, [&](int, const SegmentInfo& info) {
+        out.push_back(info);
+        ++found;
+    });
+    return found;
+}
+
+bool isReclaimable(const SegmentInfo& info, const GcConfig& config) {
+    if (info.state == SegmentState::Dead) return true;
+    if (info.state != SegmentState::Parked || !config.collect_parked) return false;
+    return info.idle_ns < 0 || info.idle_ns >= static_cast<int64_t>(config.grace_ms) * 1000000;
+}
+
+size_t collectGarbage(const GcConfig& config, std::vector<SegmentInfo>* report) {
+    size_t removed = 0;
+    forEachSegment(config, [&](int dir, SegmentInfo info) {
+        if (isReclaimable(info, config) && reclaim(dir, info, config)) {
+            info.reclaimed = true;
+            ++removed;
+        }
+        if (report) report->push_back(info);
+    });
+    return removed;
+}
+
+} // namespace SIM
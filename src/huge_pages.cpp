@@ -0,0 +1,257 @@
+/**
+ * @file huge_pages.cpp
+ * @brief Huge Page Strategy Implementation
+ */
+
+#include "huge_pages.hpp"
+#include "cache_utils.hpp"
+#include "memfd.hpp"
+#include "topology.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+namespace SIM {
+
+namespace {
+
+enum class Mode { Auto, Hugetlb, THP, Off };
+
+Mode hugePageMode() {
+    const char* env = std::getenv("SIM_HUGEPAGES");
+    if (!env) return Mode::Auto;
+    if (std::strcmp(env, "hugetlb") == 0) return Mode::Hugetlb;
+    if (std::strcmp(env, "thp") == 0) return Mode::THP;
+    if (std::strcmp(env, "off") == 0) return Mode::Off;
+    return Mode::Auto;
+}
+
+bool thpAllowed() {
+    Mode mode = hugePageMode();
+    return mode == Mode::Auto || mode == Mode::THP;
+}
+
+std::string hugetlbfsPath(const std::string& name) {
+    std::string mount = hugetlbfsMount();
+    if (mount.empty() || name.empty()) return std::string();
+    return mount + (name[0] == '/' ? "" : "/") + name;
+}
+
+// "pagesize=2M" option of a hugetlbfs mount (0 = the default size)
+size_t mountPageSize(const std::string& options) {
+    size_t pos = options.find("pagesize=");
+    if (pos == std::string::npos) return 0;
+
+    size_t value = 0;
+    char unit = 0;
+    std::sscanf(options.c_str() + pos + 9, "%zu%c", &value, &unit);
+    switch (unit) {
+        case 'K': case 'k': return value << 10;
+        case 'M': case 'm': return value << 20;
+        case 'G': case 'g': return value << 30;
+        default:            return value;
+    }
+}
+
+// Kernels < 5.14: write-touch every page
+void populate(void* addr, size_t size) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t span = (size + page - 1) & ~(page - 1);
+    if (madvise(addr, span, MADV_POPULATE_WRITE) != 0) {
+        volatile uint8_t* p = static_cast<uint8_t*>(addr);
+        for (size_t off = 0; off < size; off += page) {
+            p[off] = p[off];
+        }
+    }
+}
+
+} // namespace
+
+HugePagePlan planHugePages(size_t size, bool wanted) {
+    HugePagePlan plan{false, false};
+    Mode mode = hugePageMode();
+    if (!wanted || mode == Mode::Off || size < HUGE_PAGE_SIZE) return plan;
+
+    // Only 2MB pages: segment sizes are rounded to them, not to 1GB. Pool
+    // counters change all the time: read them now, not from the snapshot
+    bool default_2mb = Topology::get()->snapshot().default_huge_page_size == HUGE_PAGE_SIZE;
+    if (mode != Mode::THP && default_2mb && size % HUGE_PAGE_SIZE == 0) {
+        HugePagePool pool = readHugePagePool(HUGE_PAGE_SIZE);
+        size_t unreserved = pool.free > pool.reserved ? pool.free - pool.reserved : 0;
+        plan.hugetlb = size / HUGE_PAGE_SIZE <= unreserved;
+    }
+    plan.thp = mode != Mode::Hugetlb;
+    return plan;
+}
+
+std::string hugetlbfsMount() {
+    const char* env = std::getenv("SIM_HUGETLBFS");
+    if (env && *env) return env;
+
+    size_t default_size = Topology::get()->snapshot().default_huge_page_size;
+    std::ifstream mounts("/proc/mounts");
+    std::string line;
+    while (std::getline(mounts, line)) {
+        std::istringstream fields(line);
+        std::string device, dir, type, options;
+        if (!(fields >> device >> dir >> type >> options) || type != "hugetlbfs") continue;
+
+        size_t page = mountPageSize(options);
+        if ((page ? page : default_size) != HUGE_PAGE_SIZE) continue;
+        if (access(dir.c_str(), W_OK | X_OK) == 0) return dir;
+    }
+    return std::string();
+}
+
+int openNamedSegment(const std::string& name, int flags) {
+    int fd = shm_open(name.c_str(), flags, 0666);
+    if (fd >= 0 || errno != ENOENT) return fd;
+
+    std::string path = hugetlbfsPath(name);
+    if (path.empty()) return -1;
+    return open(path.c_str(), flags | O_CLOEXEC, 0666);
+}
+
+int createNamedSegment(const std::string& name, size_t size, bool hugetlb) {
+    unlinkNamedSegment(name);
+
+    // hugetlbfs reserves pages at mmap(): probe that the pool can back it
+    std::string path = hugetlb ? hugetlbfsPath(name) : std::string();
+    if (!path.empty()) {
+        int fd = open(path.c_str(), O_CREAT | O_RDWR | O_EXCL | O_CLOEXEC, 0666);
+        if (fd >= 0) {
+            void* probe = MAP_FAILED;
+            if (ftruncate(fd, size) == 0) {
+                probe = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            if (probe != MAP_FAILED) {
+                munmap(probe, size);
+                return fd;
+            }
+            close(fd);
+            unlink(path.c_str());
+        }
+    }
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_EXCL, 0666);
+    if (fd < 0) return -1;
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        return -1;
+    }
+    return fd;
+}
+
+int unlinkNamedSegment(const std::string& name) {
+    bool removed = shm_unlink(name.c_str()) == 0;
+    std::string path = hugetlbfsPath(name);
+    if (!path.empty() && unlink(path.c_str()) == 0) removed = true;
+    return removed ? 0 : -1;
+}
+
+bool segmentLinked(int fd) {
+    struct stat st;
+    return fstat(fd, &st) == 0 && st.st_nlink > 0;
+}
+
+void* mapSegment(int fd, size_t size, int prot, bool populate_pages, bool huge) {
+    if (!huge || size < HUGE_PAGE_SIZE || !thpAllowed() || isHugetlbFd(fd)) {
+        int flags = MAP_SHARED | (populate_pages ? MAP_POPULATE : 0);
+        return mmap(nullptr, size, prot, flags, fd, 0);
+    }
+
+    // Shmem huge pages are only mapped at 2MB boundaries
+    size_t span = size + HUGE_PAGE_SIZE;
+    void* area = mmap(nullptr, span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (area == MAP_FAILED) return MAP_FAILED;
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(area);
+    uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    void* ptr = mmap(reinterpret_cast<void*>(aligned), size, prot, MAP_SHARED | MAP_FIXED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        munmap(area, span);
+        return MAP_FAILED;
+    }
+    if (aligned > start) munmap(area, aligned - start);
+    size_t tail = start + span - (aligned + size);
+    if (tail) munmap(reinterpret_cast<void*>(aligned + size), tail);
+
+    // Before the first fault: with shmem_enabled=advise the fault picks the page size
+    madvise(ptr, size, MADV_HUGEPAGE);
+    if (populate_pages) populate(ptr, size);
+    return ptr;
+}
+
+PageReport inspectMapping(const void* addr, size_t size) {
+    PageReport report;
+    report.backing = PageBacking::Regular;
+    report.page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    report.huge_bytes = 0;
+    if (!addr || size == 0) return report;
+
+    uintptr_t lo = reinterpret_cast<uintptr_t>(addr);
+    uintptr_t hi = lo + size;
+    size_t kernel_page_kb = 0, hugetlb_kb = 0, pmd_kb = 0;
+    bool inside = false;
+
+    // VMA lines start with a lowercase hex address, field lines with a capital
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    while (std::getline(smaps, line)) {
+        if (line.empty()) continue;
+        unsigned char c = static_cast<unsigned char>(line[0]);
+        if (std::isxdigit(c) && !std::isupper(c)) {
+            unsigned long start = 0, end = 0;
+            inside = std::sscanf(line.c_str(), "%lx-%lx", &start, &end) == 2 &&
+                     start < hi && end > lo;
+            continue;
+        }
+        if (!inside) continue;
+
+        size_t kb = 0;
+        if (std::sscanf(line.c_str(), "KernelPageSize: %zu kB", &kb) == 1) {
+            if (kb > kernel_page_kb) kernel_page_kb = kb;
+        } else if (std::sscanf(line.c_str(), "Shared_Hugetlb: %zu kB", &kb) == 1 ||
+                   std::sscanf(line.c_str(), "Private_Hugetlb: %zu kB", &kb) == 1) {
+            hugetlb_kb += kb;
+        } else if (std::sscanf(line.c_str(), "ShmemPmdMapped: %zu kB", &kb) == 1 ||
+                   std::sscanf(line.c_str(), "FilePmdMapped: %zu kB", &kb) == 1) {
+            pmd_kb += kb;
+        }
+    }
+
+    if (kernel_page_kb * 1024 > report.page_size) {
+        report.backing = PageBacking::Hugetlb;
+        report.page_size = kernel_page_kb * 1024;
+        report.huge_bytes = hugetlb_kb * 1024;
+    } else if (pmd_kb > 0) {
+        report.backing = PageBacking::THP;
+        report.page_size = HUGE_PAGE_SIZE;
+        report.huge_bytes = pmd_kb * 1024;
+    }
+    return report;
+}
+
+const char* backingName(PageBacking backing) {
+    switch (backing) {
+        case PageBacking::Hugetlb: return "hugetlb";
+        case PageBacking::THP:     return "thp";
+        default:                   return "regular";
+    }
+}
+
+} // namespace SIM
@@ -0,0 +1,81 @@
+/**
+ * @file idle.cpp
+ * @brief Idle Policy Implementation
+ */
+
+#include "idle.hpp"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+namespace SIM {
+
+namespace {
+
+// Whole pages inside [offset, offset + len)
+bool innerPages(size_t offset, size_t len, size_t page, size_t& first, size_t& bytes) {
+    first = (offset + page - 1) & ~(page - 1);
+    size_t end = (offset + len) & ~(page - 1);
+    if (end <= first) return false;
+    bytes = end - first;
+    return true;
+}
+
+} // namespace
+
+size_t releasePages(int fd, void* base, size_t offset, size_t len, size_t page) {
+    size_t first, bytes;
+    if (!innerPages(offset, len, page, first, bytes)) return 0;
+    
+    uint8_t* addr = static_cast<uint8_t*>(base) + first;
+    munlock(addr, bytes);
+    
+    // Punching through the fd frees the pages for every mapping
+    if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  static_cast<off_t>(first), static_cast<off_t>(bytes)) == 0) {
+        return bytes;
+    }
+    return madvise(addr, bytes, MADV_REMOVE) == 0 ? bytes : 0;
+}
+
+void populatePages(void* base, size_t offset, size_t len, size_t page, bool lock) {
+    size_t first, bytes;
+    if (!innerPages(offset, len, page, first, bytes)) return;
+    
+    uint8_t* addr = static_cast<uint8_t*>(base) + first;
+    
+    // Kernels < 5.14: write-touch every page (holes read back as zero)
+    if (madvise(addr, bytes, MADV_POPULATE_WRITE) != 0) {
+        volatile uint8_t* p = addr;
+        for (size_t off = 0; off < bytes; off += page) {
+            p[off] = p[off];
+        }
+    }
+    if (lock) {
+        mlock(addr, bytes);
+    }
+}
+
+size_t residentBytes(const void* addr, size_t len) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(addr) & ~(page - 1);
+    size_t span = reinterpret_cast<uintptr_t>(addr) + len - start;
+    size_t pages = (span + page - 1) / page;
+    
+    std::vector<unsigned char> vec(pages);
+    if (mincore(reinterpret_cast<void*>(start), span, vec.data()) != 0) return 0;
+    
+    size_t resident = 0;
+    for (unsigned char v : vec) {
+        if (v & 1) ++resident;
+    }
+    return resident * page;
+}
+
+} // namespace SIM
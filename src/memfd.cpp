@@ -0,0 +1,353 @@
+/**
+ * @file memfd.cpp
+ * @brief Anonymous Segments Implementation
+ */
+
+#include "memfd.hpp"
+#include "broker.hpp"
+#include "cache_utils.hpp"
+#include "huge_pages.hpp"
+
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef HUGETLBFS_MAGIC
+#define HUGETLBFS_MAGIC 0x958458f6
+#endif
+
+namespace SIM {
+
+namespace {
+
+constexpr const char* SEGMENT_SOCKET_PREFIX = "sim_seg";
+
+// Hands out the fds of this process's anonymous channels. Leaked on
+// purpose: writers may be destroyed during static destruction.
+class SegmentServer {
+public:
+    static SegmentServer& instance() {
+        static SegmentServer* server = new SegmentServer();
+        return *server;
+    }
+    
+    bool publish(const std::string& channel, int fd) {
+        int listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (listen_fd < 0) return false;
+        
+        // The bind is the ownership test: one writer per channel and namespace
+        sockaddr_un addr;
+        socklen_t len = abstractAddress(SEGMENT_SOCKET_PREFIX + channel, addr);
+        if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), len) < 0 ||
+            listen(listen_fd, 64) < 0) {
+            close(listen_fd);
+            return false;
+        }
+        
+        int served = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (served < 0) {
+            close(listen_fd);
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[channel] = Entry{listen_fd, served};
+        if (!running_) {
+            running_ = true;
+            std::thread(&SegmentServer::serve, this).detach();
+        }
+        return true;
+    }
+    
+    void withdraw(const std::string& channel) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(channel);
+        if (it == entries_.end()) return;
+        close(it->second.listen_fd);
+        close(it->second.fd);
+        entries_.erase(it);
+    }
+
+private:
+    struct Entry {
+        int listen_fd;
+        int fd;
+    };
+    
+    SegmentServer() : running_(false) {}
+    
+    void serve() {
+        std::vector<pollfd> fds;
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (entries_.empty()) {
+                    running_ = false;       // Restarted by the next publish()
+                    return;
+                }
+                fds.clear();
+                for (auto& e : entries_) fds.push_back({e.second.listen_fd, POLLIN, 0});
+            }
+            
+            // Short timeout: withdrawn sockets drop out of the set quickly
+            if (::poll(fds.data(), fds.size(), 100) <= 0) continue;
+            
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const pollfd& p : fds) {
+                if (!(p.revents & POLLIN)) continue;
+                for (auto& e : entries_) {
+                    if (e.second.listen_fd != p.fd) continue;
+                    int conn;
+                    while ((conn = accept4(p.fd, nullptr, nullptr, SOCK_CLOEXEC)) >= 0) {
+                        uint64_t size = 0;
+                        struct stat st;
+                        if (fstat(e.second.fd, &st) == 0) size = static_cast<uint64_t>(st.st_size);
+                        sendFd(conn, &size, sizeof(size), e.second.fd);
+                        close(conn);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    
+    std::mutex mutex_;
+    std::map<std::string, Entry> entries_;
+    bool running_;
+};
+
+} // namespace
+
+int createMemfd(const char* tag, size_t size, bool try_huge) {
+    if (size == 0) return -1;
+    
+    // Huge pages only if the pool can back the whole segment right now
+    if (try_huge && size % HUGE_PAGE_SIZE == 0) {
+        int fd = memfd_create(tag, MFD_CLOEXEC | MFD_ALLOW_SEALING | MFD_HUGETLB);
+        if (fd >= 0) {
+            void* probe = MAP_FAILED;
+            if (ftruncate(fd, size) == 0) {
+                probe = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            if (probe != MAP_FAILED) {
+                munmap(probe, size);
+                return fd;
+            }
+            close(fd);
+        }
+    }
+    
+    int fd = memfd_create(tag, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) return -1;
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool sealSegment(int fd) {
+    return fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK) == 0;
+}
+
+bool isShrinkSealed(int fd) {
+    int seals = fcntl(fd, F_GET_SEALS);
+    return seals >= 0 && (seals & F_SEAL_SHRINK);
+}
+
+bool isHugetlbFd(int fd) {
+    struct statfs fs;
+    return fstatfs(fd, &fs) == 0 && static_cast<uint32_t>(fs.f_type) == HUGETLBFS_MAGIC;
+}
+
+bool sendFd(int sock, const void* data, size_t size, int fd) {
+    iovec iov;
+    iov.iov_base = const_cast<void*>(data);
+    iov.iov_len = size;
+    
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    if (fd >= 0) {
+        std::memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+    return sendmsg(sock, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(size);
+}
+
+bool recvFd(int sock, void* data, size_t size, int& fd) {
+    iovec iov;
+    iov.iov_base = data;
+    iov.iov_len = size;
+    
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    
+    fd = -1;
+    if (recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) != static_cast<ssize_t>(size)) return false;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+    return true;
+}
+
+bool anonymousSegmentsDefault() {
+    const char* env = std::getenv("SIM_SEGMENTS");
+    return env && std::strcmp(env, "memfd") == 0;
+}
+
+bool publishSegment(const std::string& channel, int fd) {
+    if (channel.empty() || fd < 0) return false;
+    return SegmentServer::instance().publish(channel, fd);
+}
+
+void withdrawSegment(const std::string& channel) {
+    SegmentServer::instance().withdraw(channel);
+}
+
+int fetchSegment(const std::string& channel) {
+    if (channel.empty()) return -1;
+    
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0) return -1;
+    
+    sockaddr_un addr;
+    socklen_t len = abstractAddress(SEGMENT_SOCKET_PREFIX + channel, addr);
+    if (connect(sock, reinterpret_cast<sockaddr*>(&addr), len) < 0) {
+        close(sock);
+        return -1;      // No anonymous writer: not an error
+    }
+    
+    // A stuck writer must not hang init()
+    timeval timeout;
+    timeout.tv_sec = 2;
+    timeout.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    uint64_t size = 0;
+    int fd = -1;
+    if (!recvFd(sock, &size, sizeof(size), fd) && fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    close(sock);
+    return fd;
+}
+
+socklen_t abstractAddress(const std::string& name, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    size_t len = std::min(name.size(), sizeof(addr.sun_path) - 1);
+    std::memcpy(addr.sun_path + 1, name.data(), len);     // sun_path[0] = 0: abstract
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + len);
+}
+
+// ============================================================================
+// Writer segments
+// ============================================================================
+
+WriterSegment acquireWriterSegment(const std::string& name, size_t size, const char* memfd_tag,
+                                   bool hugetlb, bool anonymous, BrokerClient* broker,
+                                   const std::function<bool(int)>& same_layout) {
+    WriterSegment segment = {-1, false, false, false};
+    bool brokered = false;
+    
+    // Broker daemon owns the segment when it runs (refusal is final)
+    if (broker) {
+        segment.fd = broker->acquire(name, size, BrokerRole::Writer);
+        if (segment.fd < 0 && broker->isConnected()) {
+            broker->close();
+            return segment;
+        }
+        brokered = segment.fd >= 0;
+    }
+    
+    if (!brokered && anonymous) {
+        segment.fd = createMemfd(memfd_tag, size, hugetlb);
+        if (segment.fd < 0) return segment;
+        sealSegment(segment.fd);
+        if (!publishSegment(name, segment.fd)) {
+            close(segment.fd);
+            segment.fd = -1;
+            return segment;
+        }
+        segment.serving = true;
+        segment.keep = true;
+        return segment;
+    }
+    
+    // Attach to a pre-provisioned segment, otherwise recreate it
+    if (!brokered) {
+        segment.fd = openNamedSegment(name, O_RDWR);
+        if (segment.fd >= 0 && (flock(segment.fd, LOCK_SH | LOCK_NB) < 0 || !segmentLinked(segment.fd))) {
+            close(segment.fd);
+            segment.fd = -1;
+        }
+    }
+    if (segment.fd >= 0) {
+        if (same_layout(segment.fd)) {
+            segment.provisioned = true;
+        } else if (!brokered) {
+            close(segment.fd);
+            segment.fd = -1;
+        }
+    }
+    segment.keep = brokered || segment.provisioned;
+    if (segment.fd >= 0) return segment;
+    
+    // Recreate, again if the GC unlinked the new segment before the lock
+    for (int attempt = 0; attempt <= 100; ++attempt) {
+        segment.fd = createNamedSegment(name, size, hugetlb);
+        if (segment.fd < 0) return segment;
+        flock(segment.fd, LOCK_SH);
+        if (segmentLinked(segment.fd)) return segment;
+        close(segment.fd);
+        segment.fd = -1;
+    }
+    return segment;
+}
+
+void releaseWriterSegment(const std::string& name, WriterSegment& segment, BrokerClient& broker) {
+    if (segment.fd >= 0) {
+        close(segment.fd);
+        if (!segment.keep) unlinkNamedSegment(name);
+        segment.fd = -1;
+    }
+    if (segment.serving) {
+        withdrawSegment(name);
+        segment.serving = false;
+    }
+    broker.close();
+}
+
+} // namespace SIM
@@ -0,0 +1,491 @@
+/**
+ * @file mux.cpp
+ * @brief Multiplexed Segment Implementation
+ */
+
+#include "mux.hpp"
+#include "name_hash.hpp"
+#include "work_queue.hpp"
+
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace SIM {
+
+namespace {
+
+inline size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+// ============================================================================
+// MuxSegment
+// ============================================================================
+
+MuxSegment::MuxSegment(const std::string& name)
+    : name_(name)
+    , owner_(false)
+    , writable_(false)
+    , fd_(-1)
+    , ptr_(nullptr)
+    , shm_size_(0)
+    , header_(nullptr)
+    , change_(nullptr)
+    , index_(nullptr)
+    , topics_(nullptr)
+    , data_(nullptr)
+{
+}
+
+MuxSegment::~MuxSegment() {
+    destroy();
+}
+
+bool MuxSegment::map(size_t size, bool writable) {
+    int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    int flags = MAP_SHARED | (writable ? MAP_POPULATE : 0);
+    ptr_ = mmap(nullptr, size, prot, flags, fd_, 0);
+    if (ptr_ == MAP_FAILED) {
+        ptr_ = nullptr;
+        return false;
+    }
+    shm_size_ = size;
+    writable_ = writable;
+    return true;
+}
+
+bool MuxSegment::create(uint32_t max_topics, size_t data_bytes) {
+    if (header_ || max_topics == 0) return false;
+    
+    // Layout: header | change words | name index | topic table | data
+    uint32_t index_size = static_cast<uint32_t>(nextPowerOfTwo(max_topics * 2));
+    size_t change_offset = alignUp(sizeof(MuxHeader), CACHE_LINE_SIZE);
+    size_t index_offset = change_offset + alignUp(max_topics * sizeof(uint32_t), CACHE_LINE_SIZE);
+    size_t topic_offset = index_offset + alignUp(index_size * sizeof(uint32_t), CACHE_LINE_SIZE);
+    size_t data_offset = topic_offset + max_topics * sizeof(MuxTopic);
+    size_t data_size = alignUp(data_bytes, CACHE_LINE_SIZE);
+    
+    shm_unlink(name_.c_str());
+    fd_ = shm_open(name_.c_str(), O_CREAT | O_RDWR | O_EXCL, 0666);
+    if (fd_ < 0) return false;
+    flock(fd_, LOCK_SH);            // Held by the owner (see gc.hpp)
+    
+    if (ftruncate(fd_, data_offset + data_size) < 0 || !map(data_offset + data_size, true)) {
+        close(fd_);
+        fd_ = -1;
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    owner_ = true;
+    
+    // Data pages are left as ftruncate zeroed them
+    std::memset(ptr_, 0, data_offset);
+    header_ = static_cast<MuxHeader*>(ptr_);
+    header_->version = MUX_VERSION;
+    header_->max_topics = max_topics;
+    header_->index_size = index_size;
+    header_->change_offset = change_offset;
+    header_->index_offset = index_offset;
+    header_->topic_offset = topic_offset;
+    header_->data_offset = data_offset;
+    header_->data_size = data_size;
+    header_->lock.store(0, std::memory_order_relaxed);
+    header_->num_topics.store(0, std::memory_order_relaxed);
+    header_->data_used.store(0, std::memory_order_relaxed);
+    header_->heartbeat_ns.store(nowNs(), std::memory_order_relaxed);
+    header_->owner_pid.store(getpid(), std::memory_order_relaxed);
+    header_->notify.seq.store(0, std::memory_order_relaxed);
+    header_->notify.waiters.store(0, std::memory_order_relaxed);
+    
+    uint8_t* base = static_cast<uint8_t*>(ptr_);
+    change_ = reinterpret_cast<std::atomic<uint32_t>*>(base + change_offset);
+    index_ = reinterpret_cast<std::atomic<uint32_t>*>(base + index_offset);
+    topics_ = reinterpret_cast<MuxTopic*>(base + topic_offset);
+    data_ = base + data_offset;
+    
+    // Magic last: readers validate it
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = MUX_MAGIC;
+    return true;
+}
+
+bool MuxSegment::open(bool writable) {
+    if (header_) return true;
+    
+    // Read-write fd also lets read-only mappings park on the futex
+    fd_ = shm_open(name_.c_str(), O_RDWR, 0666);
+    if (fd_ < 0 && !writable) {
+        fd_ = shm_open(name_.c_str(), O_RDONLY, 0666);
+    }
+    if (fd_ < 0) return false;
+    
+    struct stat st;
+    if (fstat(fd_, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(MuxHeader) ||
+        !map(st.st_size, writable)) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    
+    const MuxHeader* header = static_cast<const MuxHeader*>(ptr_);
+    if (header->magic != MUX_MAGIC ||
+        header->data_offset + header->data_size > shm_size_) {
+        munmap(ptr_, shm_size_);
+        ptr_ = nullptr;
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    
+    header_ = static_cast<MuxHeader*>(ptr_);
+    uint8_t* base = static_cast<uint8_t*>(ptr_);
+    change_ = reinterpret_cast<std::atomic<uint32_t>*>(base + header_->change_offset);
+    index_ = reinterpret_cast<std::atomic<uint32_t>*>(base + header_->index_offset);
+    topics_ = reinterpret_cast<MuxTopic*>(base + header_->topic_offset);
+    data_ = base + header_->data_offset;
+    
+    if (!writable) {
+        notify_.attach(fd_, offsetof(MuxHeader, notify));
+    }
+    return true;
+}
+
+NotifyWord* MuxSegment::getNotifyWord() const {
+    if (!header_) return nullptr;
+    return writable_ ? &header_->notify : notify_.get();
+}
+
+void MuxSegment::lock() {
+    uint32_t expected = 0;
+    while (!header_->lock.compare_exchange_weak(expected, 1, std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+        expected = 0;
+        Futex::cpuRelax();
+    }
+}
+
+void MuxSegment::unlock() {
+    header_->lock.store(0, std::memory_order_release);
+}
+
+MuxTopic* MuxSegment::topic(int id) const {
+    if (!header_ || id < 0 ||
+        static_cast<uint32_t>(id) >= header_->num_topics.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &topics_[id];
+}
+
+int MuxSegment::lookup(const char* name, uint32_t hash) const {
+    uint32_t mask = header_->index_size - 1;
+    for (uint32_t probe = 0; probe <= mask; ++probe) {
+        uint32_t entry = index_[(hash + probe) & mask].load(std::memory_order_acquire);
+        if (entry == 0) return -1;
+        const MuxTopic& t = topics_[entry - 1];
+        if (t.hash == hash && std::strncmp(t.name, name, MUX_TOPIC_NAME_LEN) == 0) {
+            return static_cast<int>(entry - 1);
+        }
+    }
+    return -1;
+}
+
+int MuxSegment::findTopic(const std::string& topic) const {
+    if (!header_ || topic.empty() || topic.size() >= MUX_TOPIC_NAME_LEN) return -1;
+    return lookup(topic.c_str(), hashName(topic.c_str()));
+}
+
+int MuxSegment::addTopic(const std::string& topic, size_t max_size) {
+    if (!header_ || !writable_ || topic.empty() || topic.size() >= MUX_TOPIC_NAME_LEN ||
+        max_size == 0 || max_size > UINT32_MAX) {
+        return -1;
+    }
+    uint32_t hash = hashName(topic.c_str());
+    
+    lock();
+    int id = lookup(topic.c_str(), hash);
+    if (id >= 0) {
+        unlock();
+        return topics_[id].max_size >= max_size ? id : -1;
+    }
+    
+    uint32_t n = header_->num_topics.load(std::memory_order_relaxed);
+    size_t bytes = alignUp(max_size, CACHE_LINE_SIZE) * 2;
+    uint64_t used = header_->data_used.load(std::memory_order_relaxed);
+    if (n >= header_->max_topics || used + bytes > header_->data_size) {
+        unlock();
+        return -1;
+    }
+    
+    MuxTopic& t = topics_[n];
+    std::strncpy(t.name, topic.c_str(), MUX_TOPIC_NAME_LEN - 1);
+    t.max_size = static_cast<uint32_t>(max_size);
+    t.hash = hash;
+    t.buffer_offset = used;
+    t.front_idx.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < 2; ++i) {
+        t.len[i].store(0, std::memory_order_relaxed);
+        t.seq[i].store(0, std::memory_order_relaxed);
+        t.ts[i].store(0, std::memory_order_relaxed);
+    }
+    header_->data_used.store(used + bytes, std::memory_order_relaxed);
+    
+    // Publish the topic, then make it findable by name
+    header_->num_topics.store(n + 1, std::memory_order_release);
+    uint32_t mask = header_->index_size - 1;
+    for (uint32_t probe = 0; probe <= mask; ++probe) {
+        std::atomic<uint32_t>& slot = index_[(hash + probe) & mask];
+        if (slot.load(std::memory_order_relaxed) == 0) {
+            slot.store(n + 1, std::memory_order_release);
+            break;
+        }
+    }
+    unlock();
+    return static_cast<int>(n);
+}
+
+void* MuxSegment::getWriteBuffer(int id) {
+    MuxTopic* t = writable_ ? topic(id) : nullptr;
+    if (!t) return nullptr;
+    uint32_t back = 1 - t->front_idx.load(std::memory_order_relaxed);
+    return data_ + t->buffer_offset + back * alignUp(t->max_size, CACHE_LINE_SIZE);
+}
+
+bool MuxSegment::commit(int id, size_t size) {
+    MuxTopic* t = writable_ ? topic(id) : nullptr;
+    if (!t || size > t->max_size) return false;
+    
+    uint32_t front = t->front_idx.load(std::memory_order_relaxed);
+    uint32_t back = 1 - front;
+    int64_t now = nowNs();
+    
+    t->len[back].store(static_cast<uint32_t>(size), std::memory_order_relaxed);
+    t->ts[back].store(now, std::memory_order_relaxed);
+    t->seq[back].store(t->seq[front].load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+    t->front_idx.store(back, std::memory_order_release);
+    
+    // Dense change word for scanners, then one segment-wide wake-up
+    change_[id].fetch_add(1, std::memory_order_release);
+    header_->heartbeat_ns.store(now, std::memory_order_relaxed);
+    Futex::publish(&header_->notify);
+    return true;
+}
+
+bool MuxSegment::write(int id, const void* data, size_t size) {
+    void* buffer = getWriteBuffer(id);
+    if (!buffer || size > topics_[id].max_size) return false;
+    std::memcpy(buffer, data, size);
+    return commit(id, size);
+}
+
+const void* MuxSegment::peek(int id, size_t& size, int64_t& timestamp_ns, uint64_t& seq) const {
+    const MuxTopic* t = topic(id);
+    if (!t) return nullptr;
+    
+    uint32_t front = t->front_idx.load(std::memory_order_acquire);
+    seq = t->seq[front].load(std::memory_order_relaxed);
+    if (seq == 0) return nullptr;
+    size = t->len[front].load(std::memory_order_relaxed);
+    timestamp_ns = t->ts[front].load(std::memory_order_relaxed);
+    return data_ + t->buffer_offset + front * alignUp(t->max_size, CACHE_LINE_SIZE);
+}
+
+uint32_t MuxSegment::getTopicCount() const {
+    return header_ ? header_->num_topics.load(std::memory_order_acquire) : 0;
+}
+
+const char* MuxSegment::getTopicName(int id) const {
+    const MuxTopic* t = topic(id);
+    return t ? t->name : nullptr;
+}
+
+size_t MuxSegment::getTopicSize(int id) const {
+    const MuxTopic* t = topic(id);
+    return t ? t->max_size : 0;
+}
+
+void MuxSegment::destroy() {
+    notify_.detach();
+    if (ptr_) {
+        munmap(ptr_, shm_size_);
+        ptr_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    if (owner_) {
+        shm_unlink(name_.c_str());
+        owner_ = false;
+    }
+    header_ = nullptr;
+    change_ = nullptr;
+    index_ = nullptr;
+    topics_ = nullptr;
+    data_ = nullptr;
+    writable_ = false;
+}
+
+// ============================================================================
+// MuxReader
+// ============================================================================
+
+MuxReader::MuxReader(MuxSegment& segment)
+    : segment_(segment)
+    , wait_strategy_(WaitStrategy::adaptive())
+{
+    sync();
+}
+
+void MuxReader::sync() {
+    // Segment may have been opened after construction
+    size_t max_topics = segment_.getMaxTopics();
+    if (seen_.size() < max_topics) {
+        subscribed_.resize((max_topics + 63) / 64, 0);
+        seen_.resize(max_topics, 0);
+        current_.resize(max_topics, 0);
+    }
+}
+
+int MuxReader::subscribe(int id) {
+    sync();
+    if (id < 0 || static_cast<uint32_t>(id) >= segment_.getTopicCount()) return -1;
+    subscribed_[id / 64] |= 1ULL << (id % 64);
+    return id;
+}
+
+int MuxReader::subscribe(const std::string& topic) {
+    return subscribe(segment_.findTopic(topic));
+}
+
+bool MuxReader::unsubscribe(int id) {
+    if (id < 0 || static_cast<size_t>(id) >= seen_.size()) return false;
+    subscribed_[id / 64] &= ~(1ULL << (id % 64));
+    return true;
+}
+
+size_t MuxReader::poll(std::vector<int>& changed) {
+    changed.clear();
+    const std::atomic<uint32_t>* words = segment_.getChangeWords();
+    if (!words) return 0;
+    sync();
+    
+    // Change words are contiguous in the segment: compare them in place
+    const uint32_t* cur = reinterpret_cast<const uint32_t*>(words);
+    const uint32_t* seen = seen_.data();
+    uint32_t* out = current_.data();
+    size_t n = segment_.getTopicCount();
+    size_t i = 0;
+    
+    auto report = [&](size_t base, unsigned mask) {
+        mask &= static_cast<unsigned>(subscribed_[base / 64] >> (base % 64));
+        while (mask) {
+            size_t id = base + __builtin_ctz(mask);
+            changed.push_back(static_cast<int>(id));
+            seen_[id] = out[id];
+            mask &= mask - 1;
+        }
+    };
+
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8) {
+        if (static_cast<uint8_t>(subscribed_[i / 64] >> (i % 64)) == 0) continue;
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(seen + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), a);
+        unsigned mask = ~static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)))) & 0xFF;
+        report(i, mask);
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        if (((subscribed_[i / 64] >> (i % 64)) & 0xF) == 0) continue;
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(seen + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), a);
+        unsigned mask = ~static_cast<unsigned>(
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)))) & 0xF;
+        report(i, mask);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        out[i] = words[i].load(std::memory_order_relaxed);
+        report(i, out[i] != seen[i] ? 1u : 0u);
+    }
+    
+    // Pairs with the writer's release increment
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return changed.size();
+}
+
+size_t MuxReader::wait(std::vector<int>& changed, uint32_t timeout_ms) {
+    if (poll(changed) > 0) return changed.size();
+    wait_strategy_.waitUntil([this] { return hasNewData(); },
+                             segment_.getNotifyWord(), timeout_ms);
+    return poll(changed);
+}
+
+bool MuxReader::hasNewData() const {
+    const std::atomic<uint32_t>* words = segment_.getChangeWords();
+    if (!words) return false;
+    
+    size_t n = segment_.getTopicCount();
+    for (size_t w = 0; w < subscribed_.size() && w * 64 < n; ++w) {
+        uint64_t bits = subscribed_[w];
+        while (bits) {
+            size_t id = w * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            if (id < n && words[id].load(std::memory_order_acquire) != seen_[id]) return true;
+        }
+    }
+    return false;
+}
+
+const void* MuxReader::getLatest(int id, size_t& size, int64_t& timestamp_ns) {
+    uint64_t seq;
+    return segment_.peek(id, size, timestamp_ns, seq);
+}
+
+bool MuxReader::read(int id, void* data, size_t& size) {
+    // The writer fills the back buffer, so a copy is torn only if the front moved
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        size_t len;
+        int64_t ts;
+        uint64_t seq;
+        const void* src = segment_.peek(id, len, ts, seq);
+        if (!src) return false;
+        std::memcpy(data, src, len);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        
+        // Front unchanged: the writer was filling the other buffer
+        size_t len2;
+        uint64_t seq2;
+        if (segment_.peek(id, len2, ts, seq2) == src && seq2 == seq) {
+            size = len;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace SIM
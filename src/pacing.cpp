@@ -0,0 +1,268 @@
+/**
+ * @file pacing.cpp
+ * @brief Bandwidth Pacing Implementation
+ */
+
+#include "pacing.hpp"
+#include "gather.hpp"
+#include "gc.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace SIM {
+
+namespace {
+
+constexpr uint32_t PACING_MAGIC = 0x50414345;   // "PACE"
+constexpr uint32_t PACING_VERSION = 2;
+constexpr int PACING_MAX_PROCESSES = 64;
+constexpr size_t MIN_CHUNK = 4096;
+constexpr size_t MAX_CHUNK = 16 * 1024 * 1024;
+
+/**
+ * Host-wide critical work signals (one per host, "/sim_pacing")
+ *
+ * Open CriticalWork scopes are counted per process, in one word with the
+ * pid (pid << 32 | scopes), so the count of a process that crashed inside
+ * a scope can be dropped without racing a process claiming the slot.
+ */
+struct PacingBoard {
+    uint32_t magic;
+    uint32_t version;
+    char pad0[56];
+
+    alignas(64) std::atomic<int64_t> busy_until_ns;     // CLOCK_MONOTONIC
+    std::atomic<uint64_t> signals;
+
+    alignas(64) std::atomic<uint64_t> scopes[PACING_MAX_PROCESSES];
+};
+
+uint64_t scopeWord(int32_t pid, uint32_t scopes) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(pid)) << 32 | scopes;
+}
+
+int32_t scopePid(uint64_t word) {
+    return static_cast<int32_t>(word >> 32);
+}
+
+int64_t monoNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+PacingBoard* openBoard() {
+    static PacingBoard local;       // SIM_PACING_BOARD=off, or no /dev/shm access
+
+    const char* env = std::getenv("SIM_PACING_BOARD");
+    if (env && std::strcmp(env, "off") == 0) return &local;
+
+    int fd = shm_open("/sim_pacing", O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd >= 0) {
+        fchmod(fd, 0666);       // Shared by every user despite the umask
+    } else {
+        fd = shm_open("/sim_pacing", O_RDWR, 0666);
+    }
+    if (fd < 0) return &local;
+    struct stat st;
+    if (fstat(fd, &st) < 0 ||
+        (static_cast<size_t>(st.st_size) < sizeof(PacingBoard) && ftruncate(fd, sizeof(PacingBoard)) < 0)) {
+        close(fd);
+        return &local;
+    }
+    void* ptr = mmap(nullptr, sizeof(PacingBoard), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) return &local;
+
+    // All-zero is a valid empty board: stamping the magic can race harmlessly
+    PacingBoard* board = static_cast<PacingBoard*>(ptr);
+    if (board->magic != PACING_MAGIC) {
+        board->version = PACING_VERSION;
+        board->magic = PACING_MAGIC;
+    }
+    if (board->version != PACING_VERSION) {
+        munmap(ptr, sizeof(PacingBoard));
+        return &local;          // Other layout (older library still running)
+    }
+    return board;
+}
+
+PacingBoard* board() {
+    static PacingBoard* instance = openBoard();
+    return instance;
+}
+
+// This process's scope counter, claimed on first use (nullptr = board full)
+std::atomic<uint64_t>* claimScopes() {
+    PacingBoard* b = board();
+    int32_t self = static_cast<int32_t>(getpid());
+    for (std::atomic<uint64_t>& slot : b->scopes) {
+        uint64_t word = slot.load(std::memory_order_acquire);
+        int32_t pid = scopePid(word);
+        if (pid == self) return &slot;
+        if (pid != 0 && processAlive(pid)) continue;
+        if (slot.compare_exchange_strong(word, scopeWord(self, 0), std::memory_order_acq_rel)) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+std::atomic<uint64_t>* ownScopes() {
+    static std::atomic<uint64_t>* instance = claimScopes();
+    return instance;
+}
+
+void sleepNs(int64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000LL;
+    ts.tv_nsec = ns % 1000000000LL;
+    nanosleep(&ts, nullptr);
+}
+
+} // namespace
+
+const char* priorityName(ChannelPriority priority) {
+    switch (priority) {
+        case ChannelPriority::Bulk:     return "bulk";
+        case ChannelPriority::Critical: return "critical";
+        default:                        return "normal";
+    }
+}
+
+// ============================================================================
+// Critical signals
+// ============================================================================
+
+void signalCritical(int64_t hold_ns) {
+    PacingBoard* b = board();
+    int64_t until = monoNs() + hold_ns;
+    int64_t current = b->busy_until_ns.load(std::memory_order_relaxed);
+    while (current < until &&
+           !b->busy_until_ns.compare_exchange_weak(current, until, std::memory_order_relaxed)) {
+    }
+    b->signals.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool criticalPending() {
+    PacingBoard* b = board();
+    if (monoNs() < b->busy_until_ns.load(std::memory_order_relaxed)) return true;
+
+    for (std::atomic<uint64_t>& slot : b->scopes) {
+        uint64_t word = slot.load(std::memory_order_relaxed);
+        if (static_cast<uint32_t>(word) == 0) continue;
+        if (processAlive(scopePid(word))) return true;
+        // Crashed inside a scope: drop its count (fails if the slot was reclaimed)
+        slot.compare_exchange_strong(word, 0, std::memory_order_relaxed);
+    }
+    return false;
+}
+
+CriticalWork::CriticalWork() {
+    std::atomic<uint64_t>* scopes = ownScopes();
+    if (scopes) {
+        scopes->fetch_add(1, std::memory_order_relaxed);
+    } else {
+        signalCritical();       // Board full: hold bulk copies briefly instead
+    }
+}
+
+CriticalWork::~CriticalWork() {
+    std::atomic<uint64_t>* scopes = ownScopes();
+    if (scopes) scopes->fetch_sub(1, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// BandwidthPacer
+// ============================================================================
+
+BandwidthPacer::BandwidthPacer()
+    : BandwidthPacer(PacingPolicy::disabled()) {}
+
+BandwidthPacer::BandwidthPacer(const PacingPolicy& policy) {
+    setPolicy(policy);
+}
+
+void BandwidthPacer::setPolicy(const PacingPolicy& policy) {
+    policy_ = policy;
+    stats_ = PacingStats{0, 0, 0, 0, 0};
+    chunk_ = std::max(policy.chunk_bytes, MIN_CHUNK);
+    tokens_ = static_cast<double>(policy.burst_bytes);
+    refill_ns_ = 0;
+}
+
+void BandwidthPacer::copy(void* dst, const void* src, size_t size, bool non_temporal) {
+    uint8_t* d = static_cast<uint8_t*>(dst);
+    const uint8_t* s = static_cast<const uint8_t*>(src);
+    ++stats_.paced_writes;
+
+    for (size_t off = 0; off < size;) {
+        size_t n = std::min(chunk_, size - off);
+        takeTokens(n);
+        if (policy_.yield_to_critical) deferToCritical();
+
+        struct iovec iov;
+        iov.iov_base = const_cast<uint8_t*>(s + off);
+        iov.iov_len = n;
+        int64_t start = monoNs();
+        gatherCopy(d + off, &iov, 1, non_temporal);
+        int64_t elapsed = monoNs() - start;
+        ++stats_.chunks;
+        off += n;
+
+        // Next chunk sized to take the budget at the bandwidth just seen
+        if (policy_.latency_budget_ns > 0 && elapsed > 0) {
+            double target = static_cast<double>(n) * policy_.latency_budget_ns / elapsed;
+            size_t next = (chunk_ + static_cast<size_t>(target)) / 2;
+            chunk_ = std::min(std::max(next & ~(MIN_CHUNK - 1), MIN_CHUNK), MAX_CHUNK);
+        }
+    }
+}
+
+void BandwidthPacer::takeTokens(size_t bytes) {
+    if (policy_.rate_bytes_per_s <= 0.0) return;
+
+    int64_t now = monoNs();
+    if (refill_ns_ == 0) refill_ns_ = now;
+    tokens_ = std::min(static_cast<double>(policy_.burst_bytes),
+                       tokens_ + (now - refill_ns_) * policy_.rate_bytes_per_s / 1e9);
+    refill_ns_ = now;
+
+    // Chunks larger than the burst run into debt, paid back by waiting
+    tokens_ -= static_cast<double>(bytes);
+    if (tokens_ < 0.0) {
+        int64_t wait = static_cast<int64_t>(-tokens_ / policy_.rate_bytes_per_s * 1e9);
+        sleepNs(wait);
+        stats_.throttled_ns += wait;
+    }
+}
+
+void BandwidthPacer::deferToCritical() {
+    if (!criticalPending()) return;
+
+    int64_t start = monoNs();
+    int64_t waited = 0;
+    ++stats_.deferrals;
+    while (criticalPending() && waited < policy_.max_defer_ns) {
+        // Yield first (the critical reader may share this core), then sleep
+        if (waited < 20000) {
+            sched_yield();
+        } else {
+            sleepNs(10000);
+        }
+        waited = monoNs() - start;
+    }
+    stats_.deferred_ns += waited;
+}
+
+} // namespace SIM
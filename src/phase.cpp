@@ -0,0 +1,440 @@
+/**
+ * @file phase.cpp
+ * @brief Phase Alignment Implementation
+ */
+
+#include "phase.hpp"
+#include "gc.hpp"
+#include "huge_pages.hpp"
+
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+
+namespace SIM {
+
+namespace {
+
+constexpr uint32_t PHASE_VERSION = 2;
+constexpr double ANCHOR_ALPHA = 0.1;        // Anchor correction per event
+constexpr int PERIOD_RELEARN = 8;           // Inconsistent intervals in a row before relearning
+constexpr int PERIOD_WINDOW = 128;          // Intervals averaged into the learned period
+constexpr int MAX_SAMPLES = 64;             // Consume times per consumer in expectedAge()
+constexpr int64_t HARMONIC_TOLERANCE = 100; // Learned period within 1/100 of a harmonic: locked
+
+// Frame timestamp clock (same as the transports' writers)
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+int64_t modPos(int64_t value, int64_t period) {
+    int64_t r = value % period;
+    return r < 0 ? r + period : r;
+}
+
+int64_t gcd(int64_t a, int64_t b) {
+    while (b) {
+        int64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Participants hold a shared lock on the board while attached: the last
+// one to leave (or the GC) can take it exclusively and remove the board.
+// A board removed between shm_open() and the lock is opened again.
+PhaseHeader* openBoard(const std::string& channel, int& board_fd) {
+    std::string name = channel + "@phase";
+    int fd = -1;
+    for (int attempt = 0; ; ++attempt) {
+        fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0666);
+        if (fd < 0) return nullptr;
+        flock(fd, LOCK_SH);
+        if (segmentLinked(fd)) break;
+        close(fd);
+        if (attempt >= 100) return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 ||
+        (static_cast<size_t>(st.st_size) < sizeof(PhaseHeader) && ftruncate(fd, sizeof(PhaseHeader)) < 0)) {
+        close(fd);
+        return nullptr;
+    }
+    void* ptr = mmap(nullptr, sizeof(PhaseHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+
+    // All-zero is a valid empty board
+    PhaseHeader* header = static_cast<PhaseHeader*>(ptr);
+    if (header->magic != PHASE_MAGIC) {
+        header->version = PHASE_VERSION;
+        header->magic = PHASE_MAGIC;
+    }
+    if (header->version != PHASE_VERSION) {
+        munmap(ptr, sizeof(PhaseHeader));
+        close(fd);
+        return nullptr;         // Other layout (older library still attached)
+    }
+    board_fd = fd;
+    return header;
+}
+
+// Unmap, and remove the board if nobody else holds it. The name is still
+// ours while we hold the lock exclusively and the inode is linked.
+void closeBoard(const std::string& channel, PhaseHeader* header, int& board_fd) {
+    munmap(header, sizeof(PhaseHeader));
+    if (flock(board_fd, LOCK_EX | LOCK_NB) == 0 && segmentLinked(board_fd)) {
+        shm_unlink((channel + "@phase").c_str());
+    }
+    close(board_fd);
+    board_fd = -1;
+}
+
+// Learned period: mean of the intervals that are a whole number of periods
+// (missed events); a late wake-up or a burst is left out. Each wake-up's
+// jitter enters two neighbouring intervals with opposite signs, so the
+// mean over n of them is off by jitter / n: a plain mean up to
+// PERIOD_WINDOW intervals, then a running average over that many. Many
+// inconsistent intervals in a row mean the estimate is wrong: start over.
+void trackPeriod(int64_t dt, int64_t& period, int& misses, int& samples) {
+    if (dt <= 0) return;
+    if (period == 0 || misses >= PERIOD_RELEARN) {
+        period = dt;
+        misses = 0;
+        samples = 1;
+        return;
+    }
+    int64_t events = (dt + period / 2) / period;
+    int64_t residual = dt - events * period;
+    if (events < 1 || events > 4 || std::abs(residual) > period / 4) {
+        ++misses;
+        return;
+    }
+    misses = 0;
+    samples = std::min(samples + 1, PERIOD_WINDOW);
+    period += (dt / events - period) / samples;
+}
+
+// Keep anchor + k * period locked onto the event times t. The anchor moves
+// up to the latest event, so an error in the period estimate only shifts
+// the phase by that error, not by the error times the epoch in periods.
+// Corrections are bounded: one late wake-up barely moves the schedule.
+void trackSchedule(int64_t t, int64_t period, int64_t& anchor) {
+    if (anchor == 0 || period <= 0) {
+        anchor = t;
+        return;
+    }
+    int64_t since = t - anchor + period / 2;
+    int64_t k = since >= 0 ? since / period : -((period - 1 - since) / period);
+    int64_t expected = anchor + k * period;
+    int64_t error = std::max(-period / 8, std::min(period / 8, t - expected));
+    anchor = expected + static_cast<int64_t>(ANCHOR_ALPHA * static_cast<double>(error));
+}
+
+// A learned period within HARMONIC_TOLERANCE of a multiple or divisor of
+// the writer's is the writer's frames taken every n (or n times each):
+// lock it there, or its estimation error would be projected over all the
+// samples() consume times
+void lockHarmonics(std::vector<ConsumerInfo>& list, int64_t period) {
+    for (ConsumerInfo& c : list) {
+        int64_t n = (c.period_ns + period / 2) / period;
+        int64_t m = (period + c.period_ns / 2) / c.period_ns;
+        if (n >= 1 && std::abs(c.period_ns - n * period) <= c.period_ns / HARMONIC_TOLERANCE) {
+            c.period_ns = n * period;
+        } else if (m >= 1 && std::abs(period - m * c.period_ns) <= period / HARMONIC_TOLERANCE) {
+            c.period_ns = period / m;
+        }
+    }
+}
+
+// First consume time of c at or after from
+int64_t upcoming(const ConsumerInfo& c, int64_t from) {
+    return from + modPos(c.anchor_ns - from, c.period_ns);
+}
+
+// Consume times of c over one hyperperiod with the writer (bounded)
+int64_t samples(const ConsumerInfo& c, int64_t period) {
+    return std::min<int64_t>(period / gcd(period, c.period_ns), MAX_SAMPLES);
+}
+
+// Weighted mean of the age of the frame each consume time gets, from now
+// on: a frame published less than lead before the consume is not there
+// yet, the consume gets the previous one
+double meanAge(const std::vector<ConsumerInfo>& list, int64_t anchor, int64_t period, int64_t lead,
+               int64_t now) {
+    double total = 0.0;
+    double weights = 0.0;
+    for (const ConsumerInfo& c : list) {
+        int64_t first = upcoming(c, now);
+        int64_t n = samples(c, period);
+        double sum = 0.0;
+        for (int64_t k = 0; k < n; ++k) {
+            sum += lead + modPos(first + k * c.period_ns - anchor - lead, period);
+        }
+        total += c.weight * sum / n;
+        weights += c.weight;
+    }
+    return weights > 0.0 ? total / weights : 0.0;
+}
+
+} // namespace
+
+// ============================================================================
+// ConsumerPhase
+// ============================================================================
+
+ConsumerPhase::ConsumerPhase(const std::string& channel, int64_t period_ns, int64_t window_ns)
+    : channel_(channel)
+    , window_ns_(window_ns > 0 ? window_ns : 1000000000)
+    , fixed_period_(period_ns > 0)
+    , header_(nullptr)
+    , board_fd_(-1)
+    , slot_(nullptr)
+    , period_ns_(period_ns > 0 ? period_ns : 0)
+    , anchor_ns_(0)
+    , last_consume_ns_(0)
+    , last_frame_ns_(0)
+    , frame_period_ns_(0)
+    , frame_anchor_ns_(0)
+    , period_misses_(0)
+    , frame_misses_(0)
+    , period_samples_(0)
+    , frame_samples_(0)
+    , stats_{0, 0, 0.0, 0.0, 0, 0}
+    , window_start_ns_(0)
+    , window_sum_ns_(0.0)
+    , window_count_(0)
+    , window_max_ns_(0) {}
+
+ConsumerPhase::~ConsumerPhase() {
+    detach();
+}
+
+bool ConsumerPhase::attach(uint32_t weight) {
+    if (slot_) return true;
+    if (!header_) header_ = openBoard(channel_, board_fd_);
+    if (!header_) return false;
+
+    int32_t self = static_cast<int32_t>(getpid());
+    for (PhaseSlot& slot : header_->slots) {
+        int32_t pid = slot.pid.load(std::memory_order_acquire);
+        if (pid != 0 && processAlive(pid)) continue;
+        if (!slot.pid.compare_exchange_strong(pid, self, std::memory_order_acq_rel)) continue;
+
+        slot.weight.store(weight ? weight : 1, std::memory_order_relaxed);
+        slot.period_ns.store(period_ns_, std::memory_order_relaxed);
+        slot.anchor_ns.store(0, std::memory_order_relaxed);
+        slot.updated_ns.store(0, std::memory_order_relaxed);
+        slot.mean_age_ns.store(0, std::memory_order_relaxed);
+        slot.max_age_ns.store(0, std::memory_order_relaxed);
+        slot_ = &slot;
+        return true;
+    }
+    return false;
+}
+
+void ConsumerPhase::detach() {
+    if (slot_) {
+        slot_->pid.store(0, std::memory_order_release);
+        slot_ = nullptr;
+    }
+    if (header_) {
+        closeBoard(channel_, header_, board_fd_);
+        header_ = nullptr;
+    }
+}
+
+void ConsumerPhase::consumed(int64_t frame_timestamp_ns) {
+    int64_t now = nowNs();
+
+    // Consumption schedule
+    if (!fixed_period_ && last_consume_ns_) {
+        trackPeriod(now - last_consume_ns_, period_ns_, period_misses_, period_samples_);
+    }
+    trackSchedule(now, period_ns_, anchor_ns_);
+
+    // Writer's schedule, from the frames seen
+    if (frame_timestamp_ns > 0 && frame_timestamp_ns != last_frame_ns_) {
+        if (last_frame_ns_) {
+            trackPeriod(frame_timestamp_ns - last_frame_ns_, frame_period_ns_, frame_misses_, frame_samples_);
+        }
+        trackSchedule(frame_timestamp_ns, frame_period_ns_, frame_anchor_ns_);
+        last_frame_ns_ = frame_timestamp_ns;
+    }
+    last_consume_ns_ = now;
+
+    // Age achieved
+    int64_t age = frame_timestamp_ns > 0 ? std::max<int64_t>(0, now - frame_timestamp_ns) : 0;
+    ++stats_.frames;
+    stats_.last_ns = age;
+    stats_.mean_ns += (age - stats_.mean_ns) / static_cast<double>(stats_.frames);
+
+    if (!window_start_ns_) window_start_ns_ = now;
+    window_sum_ns_ += age;
+    ++window_count_;
+    window_max_ns_ = std::max(window_max_ns_, age);
+    bool window_done = now - window_start_ns_ >= window_ns_;
+    if (window_done) {
+        stats_.window_mean_ns = window_sum_ns_ / window_count_;
+        stats_.window_max_ns = window_max_ns_;
+        ++stats_.windows;
+        window_start_ns_ = now;
+        window_sum_ns_ = 0.0;
+        window_count_ = 0;
+        window_max_ns_ = 0;
+    }
+
+    if (slot_) {
+        slot_->period_ns.store(period_ns_, std::memory_order_relaxed);
+        slot_->anchor_ns.store(anchor_ns_, std::memory_order_relaxed);
+        slot_->updated_ns.store(now, std::memory_order_relaxed);
+        if (window_done) {
+            slot_->mean_age_ns.store(static_cast<int64_t>(stats_.window_mean_ns), std::memory_order_relaxed);
+            slot_->max_age_ns.store(stats_.window_max_ns, std::memory_order_relaxed);
+        }
+    }
+}
+
+int64_t ConsumerPhase::nextAlignedConsume(int64_t lead_ns) const {
+    int64_t period = 0;
+    int64_t anchor = 0;
+    if (header_ && header_->publish_period_ns.load(std::memory_order_relaxed) > 0) {
+        period = header_->publish_period_ns.load(std::memory_order_relaxed);
+        anchor = header_->publish_anchor_ns.load(std::memory_order_relaxed);
+    } else if (frame_period_ns_ > 0) {
+        period = frame_period_ns_;
+        anchor = frame_anchor_ns_;
+    }
+    if (period <= 0 || anchor == 0) return 0;
+
+    int64_t now = nowNs();
+    return now + modPos(anchor + lead_ns - now, period);
+}
+
+// ============================================================================
+// PhaseAligner
+// ============================================================================
+
+PhaseAligner::PhaseAligner(const std::string& channel, int64_t period_ns, int64_t lead_ns)
+    : channel_(channel)
+    , period_ns_(period_ns > 0 ? period_ns : 1)
+    , lead_ns_(lead_ns)
+    , anchor_ns_(0)
+    , planned_ns_(0)
+    , last_publish_ns_(0)
+    , header_(nullptr)
+    , board_fd_(-1) {}
+
+PhaseAligner::~PhaseAligner() {
+    if (header_) {
+        header_->publish_period_ns.store(0, std::memory_order_relaxed);
+        closeBoard(channel_, header_, board_fd_);
+    }
+}
+
+bool PhaseAligner::attach() {
+    if (!header_) header_ = openBoard(channel_, board_fd_);
+    if (!header_) return false;
+    header_->publish_anchor_ns.store(anchor_ns_, std::memory_order_relaxed);
+    header_->publish_period_ns.store(period_ns_, std::memory_order_relaxed);
+    return true;
+}
+
+std::vector<ConsumerInfo> PhaseAligner::consumers() const {
+    std::vector<ConsumerInfo> list;
+    if (!header_) return list;
+
+    int64_t now = nowNs();
+    for (const PhaseSlot& slot : header_->slots) {
+        int32_t pid = slot.pid.load(std::memory_order_acquire);
+        int64_t period = slot.period_ns.load(std::memory_order_relaxed);
+        int64_t updated = slot.updated_ns.load(std::memory_order_relaxed);
+        if (pid == 0 || period <= 0) continue;
+        if (now - updated > std::max<int64_t>(4 * period, 1000000000)) continue;   // Gone quiet
+
+        ConsumerInfo info;
+        info.pid = pid;
+        info.weight = slot.weight.load(std::memory_order_relaxed);
+        info.period_ns = period;
+        info.anchor_ns = slot.anchor_ns.load(std::memory_order_relaxed);
+        info.mean_age_ns = slot.mean_age_ns.load(std::memory_order_relaxed);
+        info.max_age_ns = slot.max_age_ns.load(std::memory_order_relaxed);
+        list.push_back(info);
+    }
+    return list;
+}
+
+double PhaseAligner::expectedAge(int64_t anchor_ns) const {
+    std::vector<ConsumerInfo> list = consumers();
+    lockHarmonics(list, period_ns_);
+    return meanAge(list, anchor_ns, period_ns_, lead_ns_, nowNs());
+}
+
+int64_t PhaseAligner::bestAnchor() {
+    int64_t now = nowNs();
+    if (anchor_ns_ == 0) anchor_ns_ = now;
+    std::vector<ConsumerInfo> list = consumers();
+    if (list.empty()) return anchor_ns_;
+    lockHarmonics(list, period_ns_);
+
+    // Candidates are upcoming consume times: all relative to now, never epoch phases
+    int64_t best = anchor_ns_;
+    double best_age = meanAge(list, anchor_ns_, period_ns_, lead_ns_, now);
+    for (const ConsumerInfo& c : list) {
+        int64_t first = upcoming(c, now);
+        for (int64_t k = 0; k < samples(c, period_ns_); ++k) {
+            int64_t candidate = first + k * c.period_ns - lead_ns_;
+            double age = meanAge(list, candidate, period_ns_, lead_ns_, now);
+            if (age < best_age) {
+                best_age = age;
+                best = candidate;
+            }
+        }
+    }
+
+    anchor_ns_ = best;
+    if (header_) header_->publish_anchor_ns.store(best, std::memory_order_relaxed);
+    return best;
+}
+
+int64_t PhaseAligner::nextPublishTime() {
+    int64_t now = nowNs();
+
+    // Consumers move slowly: re-plan about once a second
+    if (now - planned_ns_ >= std::max<int64_t>(period_ns_, 1000000000)) {
+        bestAnchor();
+        planned_ns_ = now;
+    }
+    if (anchor_ns_ == 0) anchor_ns_ = now;
+
+    int64_t next = now + modPos(anchor_ns_ - now, period_ns_);
+    if (last_publish_ns_ && next - last_publish_ns_ < period_ns_ / 2) {
+        next += period_ns_;             // Schedule moved back: no double publish
+    }
+    last_publish_ns_ = next;
+
+    // Re-anchored on every publish: readers see a recent anchor
+    anchor_ns_ = next;
+    if (header_) header_->publish_anchor_ns.store(next, std::memory_order_relaxed);
+    return next;
+}
+
+void PhaseAligner::sleepUntilNext() {
+    int64_t next = nextPublishTime();
+    std::this_thread::sleep_until(std::chrono::high_resolution_clock::time_point(
+        std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+            std::chrono::nanoseconds(next))));
+}
+
+} // namespace SIM
@@ -0,0 +1,393 @@
+/**
+ * @file pipeline.cpp
+ * @brief Dataflow Pipeline Implementation
+ */
+
+#include "pipeline.hpp"
+#include <chrono>
+#include <cstring>
+
+namespace SIM {
+
+namespace {
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void updateMax(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+// ============================================================================
+// StageContext
+// ============================================================================
+
+const void* StageContext::input(size_t index, size_t& size) const {
+    if (index >= inputs_.size()) {
+        size = 0;
+        return nullptr;
+    }
+    size = inputs_[index].size;
+    return inputs_[index].data;
+}
+
+void* StageContext::loan() {
+    return pipeline_->loan(static_cast<Pipeline::Node*>(node_), *this);
+}
+
+bool StageContext::commit(size_t size) {
+    return pipeline_->commit(static_cast<Pipeline::Node*>(node_), *this, size);
+}
+
+size_t StageContext::outputCapacity() const {
+    return static_cast<Pipeline::Node*>(node_)->output_size;
+}
+
+// ============================================================================
+// Graph construction
+// ============================================================================
+
+Pipeline::Pipeline(const ExecutorConfig& config)
+    : executor_(config)
+    , stopping_(false)
+{
+}
+
+Pipeline::~Pipeline() {
+    stop();
+}
+
+int Pipeline::addStage(const std::string& name, const std::vector<int>& inputs,
+                       size_t output_size, StageFn fn, const StageOptions& options) {
+    if (inputs.empty()) return -1;
+    return addNode(name, inputs, output_size, std::move(fn), options, nullptr, nullptr, nullptr);
+}
+
+int Pipeline::addNode(const std::string& name, const std::vector<int>& inputs,
+                      size_t output_size, StageFn fn, const StageOptions& options,
+                      NotifyWord* source_word, std::function<bool()> source_ready,
+                      std::function<Frame()> fetch) {
+    if (!fn || isRunning() || findStage(name) >= 0) return -1;
+    
+    // Inputs must already exist, so the graph is acyclic by construction
+    for (int input : inputs) {
+        if (input < 0 || static_cast<size_t>(input) >= nodes_.size()) return -1;
+        if (nodes_[input]->output_size == 0) return -1;
+    }
+    
+    std::unique_ptr<Node> node(new Node());
+    node->name = name;
+    node->inputs = inputs;
+    node->output_size = output_size;
+    node->fn = std::move(fn);
+    node->options = options;
+    if (node->options.queue_depth == 0) node->options.queue_depth = 1;
+    node->source_word = source_word;
+    node->source_ready = std::move(source_ready);
+    node->fetch = std::move(fetch);
+    
+    node->notify.seq.store(0, std::memory_order_relaxed);
+    node->notify.waiters.store(0, std::memory_order_relaxed);
+    
+    // Sampled inputs pin one of the producer's slots each (see runStage)
+    node->slots = node->options.queue_depth;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        Node* producer = nodes_[inputs[i]].get();
+        if (i > 0) ++producer->slots;
+        node->latest.push_back(nullptr);
+        producer->edges.push_back(Edge{node.get(), i});
+    }
+    
+    node->deferred.store(false, std::memory_order_relaxed);
+    node->subscription = -1;
+    node->runs.store(0, std::memory_order_relaxed);
+    node->dropped.store(0, std::memory_order_relaxed);
+    node->blocked.store(0, std::memory_order_relaxed);
+    node->total_ns.store(0, std::memory_order_relaxed);
+    node->max_ns.store(0, std::memory_order_relaxed);
+    node->total_wait_ns.store(0, std::memory_order_relaxed);
+    node->total_latency_ns.store(0, std::memory_order_relaxed);
+    node->max_latency_ns.store(0, std::memory_order_relaxed);
+    
+    nodes_.push_back(std::move(node));
+    return static_cast<int>(nodes_.size() - 1);
+}
+
+void Pipeline::allocate(Node* node) {
+    if (node->output_size > 0) {
+        size_t depth = node->slots;
+        size_t stride = alignUp(node->output_size, CACHE_LINE_SIZE);
+        node->slab.reset(new uint8_t[stride * depth + CACHE_LINE_SIZE]);
+        uint8_t* base = reinterpret_cast<uint8_t*>(
+            alignUp(reinterpret_cast<uintptr_t>(node->slab.get()), CACHE_LINE_SIZE));
+        
+        node->messages.reset(new Message[depth]);
+        node->free_slots.reset(new BoundedQueue<Message*>(depth));
+        for (size_t i = 0; i < depth; ++i) {
+            Message& msg = node->messages[i];
+            msg.data = base + i * stride;
+            msg.size = 0;
+            msg.origin_ns = 0;
+            msg.enqueue_ns = 0;
+            msg.refs.store(0, std::memory_order_relaxed);
+            msg.owner = node;
+            node->free_slots->push(&msg);
+        }
+    }
+    
+    // Consumer queues hold at most the producer's slot count: push never fails
+    node->queues.clear();
+    for (int input : node->inputs) {
+        node->queues.emplace_back(new BoundedQueue<Message*>(nodes_[input]->slots));
+    }
+}
+
+bool Pipeline::exportOutput(int stage, const std::string& shm_name) {
+    if (stage < 0 || static_cast<size_t>(stage) >= nodes_.size() || isRunning()) return false;
+    Node* node = nodes_[stage].get();
+    if (node->output_size == 0) return false;
+    
+    std::unique_ptr<BARQ::Writer> writer(new BARQ::Writer(shm_name, node->output_size));
+    if (!writer->init()) return false;
+    node->exporter = std::move(writer);
+    return true;
+}
+
+int Pipeline::findStage(const std::string& name) const {
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        if (nodes_[i]->name == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+StageStats Pipeline::getStats(int stage) const {
+    StageStats stats;
+    std::memset(&stats, 0, sizeof(stats));
+    if (stage < 0 || static_cast<size_t>(stage) >= nodes_.size()) return stats;
+    
+    const Node* node = nodes_[stage].get();
+    stats.runs = node->runs.load(std::memory_order_relaxed);
+    stats.dropped = node->dropped.load(std::memory_order_relaxed);
+    stats.blocked = node->blocked.load(std::memory_order_relaxed);
+    stats.total_ns = node->total_ns.load(std::memory_order_relaxed);
+    stats.max_ns = node->max_ns.load(std::memory_order_relaxed);
+    stats.total_wait_ns = node->total_wait_ns.load(std::memory_order_relaxed);
+    stats.total_latency_ns = node->total_latency_ns.load(std::memory_order_relaxed);
+    stats.max_latency_ns = node->max_latency_ns.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+bool Pipeline::start() {
+    if (isRunning()) return true;
+    stopping_.store(false, std::memory_order_release);
+    
+    if (subscriptions_.empty()) {
+        for (auto& owned : nodes_) {
+            allocate(owned.get());
+        }
+        for (auto& owned : nodes_) {
+            Node* node = owned.get();
+            int id;
+            if (node->fetch) {
+                id = executor_.subscribe(node->source_word, node->source_ready,
+                                         [this, node] { runStage(node); },
+                                         node->options.scheduling);
+            } else {
+                id = executor_.subscribe(&node->notify, [this, node] { return hasInput(node); },
+                                         [this, node] { runStage(node); },
+                                         node->options.scheduling);
+            }
+            if (id < 0) return false;
+            node->subscription = id;
+            subscriptions_.push_back(id);
+        }
+    }
+    
+    return executor_.start();
+}
+
+void Pipeline::stop() {
+    stopping_.store(true, std::memory_order_release);
+    executor_.stop();
+}
+
+// ============================================================================
+// Execution
+// ============================================================================
+
+bool Pipeline::hasInput(const Node* node) const {
+    for (const auto& queue : node->queues) {
+        if (queue->size() > 0) return true;
+    }
+    return false;
+}
+
+bool Pipeline::slotAvailable(Node* node) {
+    if (node->output_size == 0 || node->options.backpressure != Backpressure::Block ||
+        (node->exporter && node->edges.empty())) {
+        return true;
+    }
+    if (node->free_slots->size() > 0) return true;
+    
+    // Ask release() to re-trigger us, then re-check to close the race
+    node->deferred.store(true, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (node->free_slots->size() > 0) {
+        node->deferred.store(false, std::memory_order_relaxed);
+        return true;
+    }
+    node->blocked.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void Pipeline::runStage(Node* node) {
+    StageContext ctx(this, node);
+    
+    if (node->fetch) {
+        if (!slotAvailable(node)) return;
+        Frame frame = node->fetch();
+        if (!frame) return;
+        ctx.inputs_.push_back(StageContext::Input{frame.data(), frame.size()});
+        ctx.origin_ns_ = steadyNowNs();
+        execute(node, ctx, ctx.origin_ns_);
+        return;
+    }
+    
+    while (!stopping_.load(std::memory_order_acquire)) {
+        // Sampled inputs only keep their newest message
+        Message* msg;
+        for (size_t i = 1; i < node->queues.size(); ++i) {
+            while (node->queues[i]->pop(msg)) {
+                if (node->latest[i]) release(node->latest[i]);
+                node->latest[i] = msg;
+            }
+        }
+        
+        // Leave the input queued; release() of a slot re-notifies this stage
+        if (!slotAvailable(node)) break;
+        
+        Message* trigger;
+        if (!node->queues[0]->pop(trigger)) break;
+        
+        ctx.inputs_.clear();
+        ctx.inputs_.push_back(StageContext::Input{trigger->data, trigger->size});
+        for (size_t i = 1; i < node->latest.size(); ++i) {
+            Message* sampled = node->latest[i];
+            ctx.inputs_.push_back(sampled ? StageContext::Input{sampled->data, sampled->size}
+                                          : StageContext::Input{nullptr, 0});
+        }
+        ctx.origin_ns_ = trigger->origin_ns;
+        ctx.loaned_ = nullptr;
+        ctx.direct_ = nullptr;
+        ctx.committed_ = false;
+        
+        execute(node, ctx, trigger->enqueue_ns);
+        release(trigger);
+    }
+}
+
+void Pipeline::execute(Node* node, StageContext& ctx, int64_t enqueue_ns) {
+    int64_t start = steadyNowNs();
+    node->fn(ctx);
+    int64_t end = steadyNowNs();
+    
+    // Loaned but never committed: give the slot back
+    if (ctx.loaned_ && !ctx.committed_) {
+        Message* msg = static_cast<Message*>(ctx.loaned_);
+        msg->refs.store(1, std::memory_order_relaxed);
+        release(msg);
+    }
+    
+    uint64_t run_ns = static_cast<uint64_t>(end - start);
+    uint64_t latency_ns = static_cast<uint64_t>(end - ctx.origin_ns_);
+    node->runs.fetch_add(1, std::memory_order_relaxed);
+    node->total_ns.fetch_add(run_ns, std::memory_order_relaxed);
+    node->total_wait_ns.fetch_add(static_cast<uint64_t>(start - enqueue_ns), std::memory_order_relaxed);
+    node->total_latency_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+    updateMax(node->max_ns, run_ns);
+    updateMax(node->max_latency_ns, latency_ns);
+}
+
+void* Pipeline::loan(Node* node, StageContext& ctx) {
+    if (node->output_size == 0) return nullptr;
+    if (ctx.loaned_) return static_cast<Message*>(ctx.loaned_)->data;
+    if (ctx.direct_) return ctx.direct_;
+    
+    // Export-only stage: write straight into the BARQ back buffer
+    if (node->exporter && node->edges.empty()) {
+        ctx.direct_ = node->exporter->getWriteBuffer();
+        return ctx.direct_;
+    }
+    
+    // Block stages only run with a free slot (see runStage), so this
+    // fails for Drop stages only
+    Message* msg;
+    if (!node->free_slots->pop(msg)) {
+        node->dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    
+    ctx.loaned_ = msg;
+    return msg->data;
+}
+
+bool Pipeline::commit(Node* node, StageContext& ctx, size_t size) {
+    if (ctx.committed_ || size > node->output_size) return false;
+    
+    if (ctx.direct_) {
+        ctx.committed_ = true;
+        return node->exporter->commit(size);
+    }
+    if (!ctx.loaned_) return false;
+    
+    Message* msg = static_cast<Message*>(ctx.loaned_);
+    msg->size = size;
+    msg->origin_ns = ctx.origin_ns_;
+    msg->enqueue_ns = steadyNowNs();
+    ctx.committed_ = true;
+    
+    if (node->exporter) {
+        node->exporter->write(msg->data, size);
+    }
+    
+    if (node->edges.empty()) {
+        msg->refs.store(1, std::memory_order_relaxed);
+        release(msg);
+        return true;
+    }
+    
+    msg->refs.store(static_cast<uint32_t>(node->edges.size()), std::memory_order_release);
+    for (const Edge& edge : node->edges) {
+        edge.consumer->queues[edge.input]->push(msg);
+        Futex::publish(&edge.consumer->notify);
+    }
+    return true;
+}
+
+void Pipeline::release(Message* msg) {
+    if (msg->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    
+    Node* owner = msg->owner;
+    owner->free_slots->push(msg);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (owner->deferred.exchange(false, std::memory_order_acq_rel)) {
+        executor_.trigger(owner->subscription);
+    }
+}
+
+} // namespace SIM
@@ -0,0 +1,527 @@
+/**
+ * @file placement.cpp
+ * @brief Placement Planner Implementation
+ */
+
+#include "placement.hpp"
+#include "cache_utils.hpp"
+#include "topology.hpp"
+
+#include <sched.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace SIM {
+
+namespace {
+
+constexpr int TIERS = 3;        // Preferred cores, SMT siblings, IRQ/CPU 0
+
+// Typical one-way cache line transfer on current x86 servers
+double expectedNs(PathClass path, int distance) {
+    switch (path) {
+        case PathClass::SameCore: return 10.0;
+        case PathClass::SameL3:   return 40.0;
+        case PathClass::SameNode: return 90.0;     // Other L3 (chiplet, cluster) of the node
+        default:                  return distance > 10 ? 6.0 * distance : 130.0;
+    }
+}
+
+// Device interrupts taken per CPU since boot (numbered lines of /proc/interrupts)
+std::vector<uint64_t> irqLoad(int num_cpus) {
+    std::vector<uint64_t> load(num_cpus, 0);
+    std::ifstream file("/proc/interrupts");
+    std::string line;
+    if (!std::getline(file, line)) return load;
+
+    std::vector<int> columns;       // Column -> CPU id
+    std::istringstream header(line);
+    std::string name;
+    while (header >> name) {
+        int cpu = -1;
+        if (std::sscanf(name.c_str(), "CPU%d", &cpu) == 1) columns.push_back(cpu);
+    }
+
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string irq;
+        if (!(fields >> irq) || irq.empty() || irq[0] < '0' || irq[0] > '9') continue;
+        for (int cpu : columns) {
+            uint64_t count = 0;
+            if (!(fields >> count)) break;
+            if (cpu >= 0 && cpu < num_cpus) load[cpu] += count;
+        }
+    }
+    return load;
+}
+
+std::vector<int> eligibleCpus(const PlacementOptions& options, const Topology& topo) {
+    std::vector<int> allowed = options.allowed;
+    if (allowed.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < topo.numCpus() && cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) allowed.push_back(cpu);
+            }
+        }
+    }
+
+    std::vector<int> cpus;
+    for (int cpu : allowed) {
+        const CpuTopology* c = topo.cpu(cpu);
+        if (c && c->online) cpus.push_back(cpu);
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+int l3Key(const CpuTopology& c, int cpu) {
+    return c.l3_group >= 0 ? c.l3_group : cpu;
+}
+
+PathClass classify(const Topology& topo, int a, int b) {
+    const CpuTopology* ca = topo.cpu(a);
+    const CpuTopology* cb = topo.cpu(b);
+    if (!ca || !cb || a == b || ca->core == cb->core) return PathClass::SameCore;
+    if (ca->l3_group >= 0 && ca->l3_group == cb->l3_group) return PathClass::SameL3;
+    if (ca->node == cb->node) return PathClass::SameNode;
+    return PathClass::CrossNode;
+}
+
+// Free CPUs per L3 group and tier, groups in (node, L3) order
+class SlotPool {
+public:
+    SlotPool(const Topology& topo, const std::vector<int>& cpus, const PlacementOptions& options) {
+        std::vector<uint64_t> load = irqLoad(topo.numCpus());
+        uint64_t total = 0;
+        for (int cpu : cpus) total += load[cpu];
+        double mean = cpus.empty() ? 0.0 : static_cast<double>(total) / cpus.size();
+
+        // "IRQ CPU": well above the average; if that is every CPU, none is
+        std::set<int> irq;
+        if (options.avoid_irq_cpus && mean > 0.0) {
+            for (int cpu : cpus) {
+                if (load[cpu] > 2.0 * mean) irq.insert(cpu);
+            }
+            if (irq.size() == cpus.size()) irq.clear();
+        }
+
+        std::set<int> cores_seen;
+        for (int cpu : cpus) {
+            const CpuTopology& c = *topo.cpu(cpu);
+            bool primary = cores_seen.insert(c.core).second || !options.avoid_smt;
+            bool demoted = (options.avoid_cpu0 && cpu == 0 && cpus.size() > 1) || irq.count(cpu);
+            int tier = demoted ? 2 : (primary ? 0 : 1);
+
+            std::pair<int, int> key(c.node, l3Key(c, cpu));
+            auto it = std::find(keys_.begin(), keys_.end(), key);
+            size_t g = it - keys_.begin();
+            if (it == keys_.end()) {
+                keys_.push_back(key);
+                free_.emplace_back(TIERS);
+            }
+            free_[g][tier].push_back(cpu);
+        }
+
+        // (node, L3) order, keeping each group's CPUs in id order
+        std::vector<size_t> order(keys_.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys_[a] < keys_[b]; });
+        std::vector<std::pair<int, int>> keys;
+        std::vector<std::vector<std::vector<int>>> free;
+        for (size_t i : order) {
+            keys.push_back(keys_[i]);
+            free.push_back(free_[i]);
+        }
+        keys_.swap(keys);
+        free_.swap(free);
+        all_ = cpus;
+    }
+
+    size_t groups() const { return keys_.size(); }
+    int node(size_t g) const { return keys_[g].first; }
+    size_t freeCount(size_t g, int tier) const { return free_[g][tier].size(); }
+
+    // Group holding cpu (groups() if not eligible)
+    size_t groupOf(const Topology& topo, int cpu) const {
+        const CpuTopology* c = topo.cpu(cpu);
+        if (!c) return groups();
+        std::pair<int, int> key(c->node, l3Key(*c, cpu));
+        return std::find(keys_.begin(), keys_.end(), key) - keys_.begin();
+    }
+
+    bool remove(int cpu) {
+        for (auto& group : free_) {
+            for (auto& tier : group) {
+                auto it = std::find(tier.begin(), tier.end(), cpu);
+                if (it != tier.end()) {
+                    tier.erase(it);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // First free CPU of the best tier, groups tried in the given order
+    int take(const std::vector<size_t>& order) {
+        for (int t = 0; t < TIERS; ++t) {
+            for (size_t g : order) {
+                if (!free_[g][t].empty()) {
+                    int cpu = free_[g][t].front();
+                    free_[g][t].erase(free_[g][t].begin());
+                    return cpu;
+                }
+            }
+        }
+        // More threads than CPUs: share, round robin
+        if (all_.empty()) return -1;
+        return all_[wrap_++ % all_.size()];
+    }
+
+    // Group first, then its node, then the rest
+    std::vector<size_t> orderFrom(size_t first) const {
+        std::vector<size_t> order{first};
+        for (size_t g = 0; g < groups(); ++g) {
+            if (g != first && node(g) == node(first)) order.push_back(g);
+        }
+        for (size_t g = 0; g < groups(); ++g) {
+            if (node(g) != node(first)) order.push_back(g);
+        }
+        return order;
+    }
+
+private:
+    std::vector<std::pair<int, int>> keys_;                 // (node, L3 key)
+    std::vector<std::vector<std::vector<int>>> free_;       // [group][tier] -> CPUs
+    std::vector<int> all_;
+    size_t wrap_ = 0;
+};
+
+std::map<std::string, int> loadState(const std::string& path) {
+    std::map<std::string, int> state;
+    if (path.empty()) return state;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string thread;
+        int cpu;
+        if (fields >> thread >> cpu) state[thread] = cpu;
+    }
+    return state;
+}
+
+} // namespace
+
+const char* pathClassName(PathClass path) {
+    switch (path) {
+        case PathClass::SameCore: return "same-core";
+        case PathClass::SameL3:   return "same-l3";
+        case PathClass::SameNode: return "same-node";
+        default:                  return "cross-node";
+    }
+}
+
+// ============================================================================
+// PlacementPlan
+// ============================================================================
+
+int PlacementPlan::cpuOf(const std::string& thread) const {
+    for (const ThreadPlacement& t : threads) {
+        if (t.thread == thread) return t.cpu;
+    }
+    return -1;
+}
+
+std::vector<int> PlacementPlan::cpusOf(const std::vector<std::string>& names) const {
+    std::vector<int> cpus;
+    for (const std::string& name : names) cpus.push_back(cpuOf(name));
+    return cpus;
+}
+
+bool PlacementPlan::apply(const std::string& thread) const {
+    int cpu = cpuOf(thread);
+    return cpu >= 0 && CacheUtils::setCpuAffinity(cpu);
+}
+
+void PlacementPlan::measure(size_t round_trips) {
+    if (round_trips == 0) return;
+    std::map<std::pair<int, int>, double> measured;
+
+    for (ChannelPath& p : paths) {
+        int a = cpuOf(p.writer);
+        int b = cpuOf(p.reader);
+        if (a < 0 || b < 0 || a == b) continue;
+        auto key = std::make_pair(std::min(a, b), std::max(a, b));
+
+        auto it = measured.find(key);
+        if (it == measured.end()) {
+            // Ping-pong one cache line: odd values from a, even values from b
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> line(0);
+            std::atomic<bool> pinned(true);
+            std::thread pong([&]() {
+                if (!CacheUtils::setCpuAffinity(b)) pinned.store(false);
+                for (uint64_t i = 0; i < round_trips; ++i) {
+                    while (line.load(std::memory_order_acquire) != 2 * i + 1) {
+                        if (!pinned.load(std::memory_order_relaxed)) return;
+                    }
+                    line.store(2 * i + 2, std::memory_order_release);
+                }
+            });
+            double ns = -1.0;
+            std::thread ping([&]() {
+                if (!CacheUtils::setCpuAffinity(a)) pinned.store(false);
+                auto start = std::chrono::steady_clock::now();
+                for (uint64_t i = 0; i < round_trips; ++i) {
+                    line.store(2 * i + 1, std::memory_order_release);
+                    while (line.load(std::memory_order_acquire) != 2 * i + 2) {
+                        if (!pinned.load(std::memory_order_relaxed)) return;
+                    }
+                }
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                ns = std::chrono::duration<double, std::nano>(elapsed).count() / (2.0 * round_trips);
+            });
+            ping.join();
+            pong.join();
+            it = measured.emplace(key, pinned.load() ? ns : -1.0).first;
+        }
+        p.measured_ns = it->second;
+    }
+}
+
+bool PlacementPlan::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) return false;
+    file << "# thread cpu\n";
+    for (const ThreadPlacement& t : threads) {
+        file << t.thread << ' ' << t.cpu << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+std::string PlacementPlan::describe() const {
+    std::ostringstream out;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-24s %5s %5s %5s %s\n", "THREAD", "CPU", "NODE", "L3", "");
+    out << line;
+    for (const ThreadPlacement& t : threads) {
+        std::snprintf(line, sizeof(line), "%-24s %5d %5d %5d %s%s\n", t.thread.c_str(), t.cpu,
+                      t.node, t.l3_group, t.shared ? "shared " : "", t.kept ? "kept" : "");
+        out << line;
+    }
+    std::snprintf(line, sizeof(line), "\n%-40s %-11s %11s %11s\n", "PATH", "CLASS", "EXPECTED_NS", "MEASURED_NS");
+    out << line;
+    for (const ChannelPath& p : paths) {
+        std::string hop = p.channel + " " + p.writer + " -> " + p.reader;
+        std::snprintf(line, sizeof(line), "%-40s %-11s %11.1f %11.1f\n", hop.c_str(),
+                      pathClassName(p.path), p.expected_ns, p.measured_ns);
+        out << line;
+    }
+    return out.str();
+}
+
+// ============================================================================
+// PlacementPlanner
+// ============================================================================
+
+PlacementPlanner::PlacementPlanner(const PlacementOptions& options)
+    : options_(options) {}
+
+void PlacementPlanner::addThread(const std::string& name) {
+    if (std::find(threads_.begin(), threads_.end(), name) == threads_.end()) {
+        threads_.push_back(name);
+    }
+}
+
+void PlacementPlanner::addChannel(const std::string& channel, const std::string& writer,
+                                  const std::vector<std::string>& readers, double weight) {
+    addThread(writer);
+    for (const std::string& r : readers) addThread(r);
+    channels_.push_back(Channel{channel, writer, readers, weight > 0.0 ? weight : 1.0});
+}
+
+PlacementPlan PlacementPlanner::plan() const {
+    PlacementPlan result;
+    auto topo = Topology::get();
+    std::vector<int> cpus = eligibleCpus(options_, *topo);
+
+    // Names in sorted order: the plan does not depend on call order
+    std::vector<std::string> names(threads_);
+    std::sort(names.begin(), names.end());
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < names.size(); ++i) index[names[i]] = i;
+
+    std::vector<std::vector<double>> link(names.size(), std::vector<double>(names.size(), 0.0));
+    for (const Channel& ch : channels_) {
+        size_t w = index[ch.writer];
+        for (const std::string& r : ch.readers) {
+            size_t x = index[r];
+            if (x == w) continue;
+            link[w][x] += ch.weight;
+            link[x][w] += ch.weight;
+        }
+    }
+
+    // Connected components (threads linked by any channel)
+    std::vector<int> comp(names.size(), -1);
+    int num_comps = 0;
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (comp[i] >= 0) continue;
+        std::vector<size_t> stack{i};
+        comp[i] = num_comps;
+        while (!stack.empty()) {
+            size_t n = stack.back();
+            stack.pop_back();
+            for (size_t m = 0; m < names.size(); ++m) {
+                if (link[n][m] > 0.0 && comp[m] < 0) {
+                    comp[m] = num_comps;
+                    stack.push_back(m);
+                }
+            }
+        }
+        ++num_comps;
+    }
+
+    // Heaviest components first; within one, grow from the heaviest thread
+    // by the strongest link to what is already ordered
+    std::vector<double> comp_weight(num_comps, 0.0);
+    std::vector<double> degree(names.size(), 0.0);
+    for (size_t i = 0; i < names.size(); ++i) {
+        for (size_t j = 0; j < names.size(); ++j) degree[i] += link[i][j];
+        comp_weight[comp[i]] += degree[i];
+    }
+    std::vector<int> comp_order(num_comps);
+    for (int c = 0; c < num_comps; ++c) comp_order[c] = c;
+    std::stable_sort(comp_order.begin(), comp_order.end(),
+                     [&](int a, int b) { return comp_weight[a] > comp_weight[b]; });
+
+    std::vector<std::vector<size_t>> ordered(num_comps);
+    for (int c : comp_order) {
+        std::vector<size_t> members;
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (comp[i] == c) members.push_back(i);
+        }
+        std::vector<bool> done(names.size(), false);
+        while (ordered[c].size() < members.size()) {
+            size_t best = members.size();
+            double best_score = -1.0;
+            for (size_t k = 0; k < members.size(); ++k) {
+                size_t m = members[k];
+                if (done[m]) continue;
+                double score = 0.0;
+                if (ordered[c].empty()) {
+                    score = degree[m];
+                } else {
+                    for (size_t o : ordered[c]) score += link[m][o];
+                }
+                if (score > best_score) {
+                    best_score = score;
+                    best = k;
+                }
+            }
+            done[members[best]] = true;
+            ordered[c].push_back(members[best]);
+        }
+    }
+
+    // Earlier placements that are still valid
+    SlotPool pool(*topo, cpus, options_);
+    std::vector<int> assigned(names.size(), -1);
+    std::vector<bool> kept(names.size(), false);
+    // (CPUs shared in the saved plan stay shared)
+    for (const auto& entry : loadState(options_.state_file)) {
+        auto it = index.find(entry.first);
+        if (it != index.end() && std::binary_search(cpus.begin(), cpus.end(), entry.second)) {
+            pool.remove(entry.second);
+            assigned[it->second] = entry.second;
+            kept[it->second] = true;
+        }
+    }
+
+    for (int c : comp_order) {
+        size_t missing = 0;
+        int anchor_cpu = -1;
+        for (size_t m : ordered[c]) {
+            if (assigned[m] < 0) ++missing;
+            else if (anchor_cpu < 0) anchor_cpu = assigned[m];
+        }
+        if (missing == 0 || pool.groups() == 0) continue;
+
+        // A group that fits the whole component (next to kept members if
+        // possible), else start filling from the first group with room
+        size_t first = pool.groups();
+        size_t anchor = anchor_cpu >= 0 ? pool.groupOf(*topo, anchor_cpu) : pool.groups();
+        if (anchor < pool.groups() && pool.freeCount(anchor, 0) >= missing) first = anchor;
+        for (size_t g = 0; g < pool.groups() && first == pool.groups(); ++g) {
+            if (pool.freeCount(g, 0) >= missing) first = g;
+        }
+        for (size_t g = 0; g < pool.groups() && first == pool.groups(); ++g) {
+            if (pool.freeCount(g, 0) > 0) first = g;
+        }
+        if (first == pool.groups()) first = anchor < pool.groups() ? anchor : 0;
+
+        std::vector<size_t> order = pool.orderFrom(first);
+        for (size_t m : ordered[c]) {
+            if (assigned[m] < 0) assigned[m] = pool.take(order);
+        }
+    }
+
+    // Result in name order
+    std::map<int, int> cpu_use, core_use;
+    for (int cpu : assigned) {
+        if (cpu < 0) continue;
+        ++cpu_use[cpu];
+        ++core_use[topo->cpu(cpu)->core];
+    }
+    for (size_t i = 0; i < names.size(); ++i) {
+        ThreadPlacement t;
+        t.thread = names[i];
+        t.cpu = assigned[i];
+        const CpuTopology* c = topo->cpu(t.cpu);
+        t.node = c ? c->node : -1;
+        t.l3_group = c ? c->l3_group : -1;
+        t.shared = c && (cpu_use[t.cpu] > 1 || core_use[c->core] > 1);
+        t.kept = kept[i];
+        result.threads.push_back(t);
+    }
+
+    for (const Channel& ch : channels_) {
+        for (const std::string& r : ch.readers) {
+            ChannelPath p;
+            p.channel = ch.name;
+            p.writer = ch.writer;
+            p.reader = r;
+            p.weight = ch.weight;
+            int a = assigned[index[ch.writer]];
+            int b = assigned[index[r]];
+            p.path = classify(*topo, a, b);
+            const CpuTopology* ca = topo->cpu(a);
+            const CpuTopology* cb = topo->cpu(b);
+            p.expected_ns = expectedNs(p.path, (ca && cb) ? topo->distance(ca->node, cb->node) : 0);
+            p.measured_ns = -1.0;
+            result.paths.push_back(p);
+        }
+    }
+
+    if (!options_.state_file.empty()) result.save(options_.state_file);
+    return result;
+}
+
+int quietestCpu() {
+    PlacementPlanner planner;
+    planner.addThread("main");
+    return planner.plan().cpuOf("main");
+}
+
+} // namespace SIM
@@ -0,0 +1,325 @@
+/**
+ * @file provision.cpp
+ * @brief Channel Provisioning Implementation
+ */
+
+#include "provision.hpp"
+#include "barq.hpp"
+#include "broker.hpp"
+#include "casir.hpp"
+#include "sim.hpp"
+#include "huge_pages.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace SIM {
+
+namespace {
+
+constexpr int MPOL_DEFAULT_MODE = 0;
+constexpr int MPOL_PREFERRED_MODE = 1;
+constexpr int MAX_NUMA_NODES = 1024;
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+// "4096", "64K", "6M", "1G" (binary units)
+bool parseSize(const std::string& text, size_t& out) {
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    std::string unit = lower(end);
+    if (unit == "k" || unit == "kb") value <<= 10;
+    else if (unit == "m" || unit == "mb") value <<= 20;
+    else if (unit == "g" || unit == "gb") value <<= 30;
+    else if (!unit.empty()) return false;
+    out = static_cast<size_t>(value);
+    return true;
+}
+
+bool parseBool(const std::string& text, bool& out) {
+    std::string v = lower(text);
+    if (v == "on" || v == "1" || v == "true" || v == "yes") { out = true; return true; }
+    if (v == "off" || v == "0" || v == "false" || v == "no") { out = false; return true; }
+    return false;
+}
+
+// Task memory policy: shmem pages faulted by this thread prefer the node
+bool preferNode(int node) {
+    if (node < 0 || node >= MAX_NUMA_NODES) return false;
+    unsigned long mask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = {};
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    return syscall(SYS_set_mempolicy, MPOL_PREFERRED_MODE, mask, MAX_NUMA_NODES + 1) == 0;
+}
+
+void resetNodePolicy() {
+    syscall(SYS_set_mempolicy, MPOL_DEFAULT_MODE, nullptr, 0);
+}
+
+// Map the segment and fault every page in (without changing its contents)
+bool prefault(const std::string& name, bool huge, size_t& bytes) {
+    int fd = openNamedSegment(name, O_RDWR);
+    if (fd < 0) return false;
+    
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    bytes = static_cast<size_t>(st.st_size);
+    
+    // Same THP advice as the writer, so faults here get huge pages too
+    void* ptr = mapSegment(fd, bytes, PROT_READ | PROT_WRITE, true, huge);
+    close(fd);
+    if (ptr == MAP_FAILED) return false;
+    munmap(ptr, bytes);
+    return true;
+}
+
+size_t segmentSize(const std::string& name) {
+    int fd = openNamedSegment(name, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    size_t size = fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+    close(fd);
+    return size;
+}
+
+// Create the segment with the transport's own writer, then leave it in place.
+// Always a named segment: a broker memfd or an anonymous one would be gone
+// (reclaimed, withdrawn) once the writer detaches.
+bool createSegment(const ChannelSpec& spec, ProvisionReport& report) {
+    switch (spec.transport) {
+        case TransportType::BARQ: {
+            BARQ::Writer writer(spec.name, spec.max_size, spec.huge_pages, spec.meta_size);
+            writer.setUseBroker(false);
+            writer.setAnonymous(false);
+            if (!writer.init()) return false;
+            report.reused = writer.isProvisioned();
+            writer.detach();
+            return true;
+        }
+        case TransportType::CASIR: {
+            CASIR::Config config = CASIR::Config::autoDetect();
+            config.use_huge_pages = spec.huge_pages;
+            CASIR::Writer writer(spec.name, spec.max_size, config, spec.meta_size);
+            writer.setUseBroker(false);
+            writer.setAnonymous(false);
+            if (!writer.init()) return false;
+            report.reused = writer.isProvisioned();
+            writer.detach();
+            return true;
+        }
+        case TransportType::SIM: {
+            // SIM writers always attach and never unlink on destruction
+            size_t before = segmentSize(spec.name);
+            SIM::Writer writer(spec.name, spec.max_size, false, spec.meta_size);
+            if (!writer.init()) return false;
+            report.reused = before != 0 && before == segmentSize(spec.name);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+uint32_t layoutVersion(TransportType transport) {
+    switch (transport) {
+        case TransportType::BARQ:  return BARQ::VERSION;
+        case TransportType::CASIR: return CASIR::CASIR_VERSION;
+        case TransportType::SIM:   return (VERSION_MAJOR << 16) | VERSION_MINOR;
+        default:                   return 0;
+    }
+}
+
+void provisionOne(const ChannelSpec& spec, ProvisionReport& report, Registry* registry,
+                  bool broker_running) {
+    report.name = spec.name;
+    report.success = false;
+    report.reused = false;
+    report.numa_bound = false;
+    report.bytes = 0;
+    report.setup_ns = 0;
+    
+    // Writers would take their segment from the broker, not this one
+    if (broker_running && spec.transport != TransportType::SIM) {
+        report.error = "broker running, use its pools";
+        return;
+    }
+    
+    if (spec.numa_node >= 0) {
+        report.numa_bound = preferNode(spec.numa_node);
+    }
+    
+    // One figure: BARQ/CASIR writers already populate and mlock in init(),
+    // the prefault pass then only faults what they left (SIM segments)
+    int64_t start = nowNs();
+    if (!createSegment(spec, report)) {
+        report.error = "create failed";
+    } else if (!prefault(spec.name, spec.huge_pages, report.bytes)) {
+        report.error = "prefault failed";
+    } else {
+        report.success = true;
+    }
+    report.setup_ns = nowNs() - start;
+    
+    if (spec.numa_node >= 0) {
+        resetNodePolicy();
+    }
+    
+    if (report.success && registry) {
+        registry->advertise(TopicInfo::make(spec.name, spec.transport, spec.max_size,
+                                            layoutVersion(spec.transport), spec.meta_size));
+    }
+}
+
+} // namespace
+
+bool parseManifest(const std::string& text, std::vector<ChannelSpec>& out, std::string* error) {
+    std::istringstream lines(text);
+    std::string line;
+    std::vector<ChannelSpec> specs;
+    int number = 0;
+    
+    auto fail = [&](const std::string& what) {
+        if (error) *error = "line " + std::to_string(number) + ": " + what;
+        return false;
+    };
+    
+    while (std::getline(lines, line)) {
+        ++number;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        
+        std::istringstream fields(line);
+        std::string name, transport, size;
+        if (!(fields >> name)) continue;
+        if (!(fields >> transport >> size)) return fail("expected <name> <transport> <size>");
+        
+        ChannelSpec spec = ChannelSpec::make(name, TransportType::Unknown, 0);
+        if (name[0] != '/' || name.size() >= REGISTRY_NAME_LEN) return fail("bad channel name '" + name + "'");
+        
+        transport = lower(transport);
+        if (transport == "barq") spec.transport = TransportType::BARQ;
+        else if (transport == "casir") spec.transport = TransportType::CASIR;
+        else if (transport == "sim") spec.transport = TransportType::SIM;
+        else if (transport == "sahm" || transport == "mux") {
+            return fail(transport + " segments are created at runtime, not provisioned");
+        } else {
+            return fail("unknown transport '" + transport + "'");
+        }
+        
+        if (!parseSize(size, spec.max_size) || spec.max_size == 0) return fail("bad size '" + size + "'");
+        
+        std::string option;
+        while (fields >> option) {
+            size_t eq = option.find('=');
+            std::string key = lower(option.substr(0, eq));
+            std::string value = eq == std::string::npos ? "" : option.substr(eq + 1);
+            if (key == "huge") {
+                if (!parseBool(value, spec.huge_pages)) return fail("bad huge value '" + value + "'");
+            } else if (key == "numa") {
+                char* end = nullptr;
+                long node = std::strtol(value.c_str(), &end, 10);
+                if (value.empty() || *end != '\0' || node < 0 || node >= MAX_NUMA_NODES) {
+                    return fail("bad numa node '" + value + "'");
+                }
+                spec.numa_node = static_cast<int>(node);
+            } else if (key == "meta") {
+                if (!parseSize(value, spec.meta_size)) return fail("bad meta size '" + value + "'");
+            } else {
+                return fail("unknown option '" + option + "'");
+            }
+        }
+        
+        for (const ChannelSpec& other : specs) {
+            if (other.name == spec.name) return fail("duplicate channel '" + name + "'");
+        }
+        specs.push_back(spec);
+    }
+    
+    out.insert(out.end(), specs.begin(), specs.end());
+    return true;
+}
+
+bool loadManifest(const std::string& path, std::vector<ChannelSpec>& out, std::string* error) {
+    std::ifstream file(path);
+    if (!file) {
+        if (error) *error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    return parseManifest(text.str(), out, error);
+}
+
+size_t provisionChannels(const std::vector<ChannelSpec>& specs,
+                         std::vector<ProvisionReport>& reports,
+                         size_t threads, Registry* registry) {
+    reports.assign(specs.size(), ProvisionReport());
+    if (specs.empty()) return 0;
+    
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, specs.size());
+    
+    // BARQ/CASIR writers of the stack will use the broker if it runs now
+    BrokerClient probe;
+    bool broker_running = probe.connect();
+    probe.close();
+    
+    // Channels are handed out one at a time: large and small ones interleave
+    std::atomic<size_t> next(0);
+    auto work = [&] {
+        for (size_t i = next.fetch_add(1); i < specs.size(); i = next.fetch_add(1)) {
+            provisionOne(specs[i], reports[i], registry, broker_running);
+        }
+    };
+    
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto& t : pool) {
+        t.join();
+    }
+    
+    size_t ok = 0;
+    for (const ProvisionReport& r : reports) {
+        if (r.success) ++ok;
+    }
+    return ok;
+}
+
+size_t unprovisionChannels(const std::vector<ChannelSpec>& specs, Registry* registry) {
+    size_t removed = 0;
+    for (const ChannelSpec& spec : specs) {
+        if (unlinkNamedSegment(spec.name) == 0) ++removed;
+        if (registry) registry->withdraw(spec.name);
+    }
+    return removed;
+}
+
+} // namespace SIM
@@ -0,0 +1,393 @@
+/**
+ * @file publish_group.cpp
+ * @brief Publish Group Implementation
+ */
+
+#include "publish_group.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+
+namespace SIM {
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+constexpr int MAX_READ_RETRIES = 64;
+
+} // namespace
+
+// ============================================================================
+// PublishGroup
+// ============================================================================
+
+PublishGroup::PublishGroup(const std::string& name)
+    : name_(name)
+    , initialized_(false)
+    , fd_(-1)
+    , ptr_(nullptr)
+    , shm_size_(0)
+    , header_(nullptr)
+{
+}
+
+PublishGroup::~PublishGroup() {
+    destroy();
+}
+
+int PublishGroup::addMember(GroupTransport transport, BARQ::Writer* barq, CASIR::Writer* casir,
+                            const std::string& name, size_t max_size) {
+    if (initialized_ || members_.size() >= MAX_GROUP_CHANNELS) return -1;
+    if (name.empty() || name.size() >= GROUP_NAME_LEN) return -1;
+    
+    Member member;
+    member.transport = transport;
+    member.barq = barq;
+    member.casir = casir;
+    member.max_size = max_size;
+    member.staged_size = 0;
+    member.staged = false;
+    members_.push_back(member);
+    member_names_.push_back(name);
+    return static_cast<int>(members_.size() - 1);
+}
+
+int PublishGroup::addChannel(BARQ::Writer& writer) {
+    if (!writer.isReady()) return -1;
+    return addMember(GroupTransport::BARQ, &writer, nullptr, writer.getName(), writer.getMaxSize());
+}
+
+int PublishGroup::addChannel(CASIR::Writer& writer) {
+    if (!writer.isReady()) return -1;
+    return addMember(GroupTransport::CASIR, nullptr, &writer, writer.getName(), writer.getMaxSize());
+}
+
+bool PublishGroup::init() {
+    if (initialized_) return true;
+    if (members_.empty()) return false;
+    
+    shm_size_ = sizeof(GroupHeader);
+    
+    shm_unlink(name_.c_str());
+    fd_ = shm_open(name_.c_str(), O_CREAT | O_RDWR | O_EXCL, 0666);
+    if (fd_ < 0) return false;
+    
+    if (ftruncate(fd_, shm_size_) < 0) {
+        close(fd_);
+        fd_ = -1;
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    
+    ptr_ = mmap(nullptr, shm_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0);
+    if (ptr_ == MAP_FAILED) {
+        ptr_ = nullptr;
+        close(fd_);
+        fd_ = -1;
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    
+    std::memset(ptr_, 0, shm_size_);
+    header_ = static_cast<GroupHeader*>(ptr_);
+    header_->version = GROUP_VERSION;
+    header_->num_channels = static_cast<uint32_t>(members_.size());
+    for (size_t i = 0; i < members_.size(); ++i) {
+        GroupMemberInfo& info = header_->members[i];
+        std::strncpy(info.name, member_names_[i].c_str(), GROUP_NAME_LEN - 1);
+        info.transport = static_cast<uint32_t>(members_[i].transport);
+        info.max_size = members_[i].max_size;
+        header_->frames[i].store(frameOf(members_[i]), std::memory_order_relaxed);
+    }
+    header_->seq.store(0, std::memory_order_relaxed);
+    header_->timestamp_ns.store(0, std::memory_order_relaxed);
+    header_->notify.seq.store(0, std::memory_order_relaxed);
+    header_->notify.waiters.store(0, std::memory_order_relaxed);
+    
+    // Magic last: readers validate it
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = GROUP_MAGIC;
+    
+    initialized_ = true;
+    return true;
+}
+
+uint64_t PublishGroup::frameOf(const Member& member) const {
+    return member.transport == GroupTransport::BARQ ? member.barq->getFrameCount()
+                                                    : member.casir->getFrameCount();
+}
+
+// Follows resize() of the member writer
+size_t PublishGroup::maxSizeOf(const Member& member) const {
+    return member.transport == GroupTransport::BARQ ? member.barq->getMaxSize()
+                                                    : member.casir->getMaxSize();
+}
+
+void* PublishGroup::getWriteBuffer(int channel) {
+    if (!initialized_ || channel < 0 || static_cast<size_t>(channel) >= members_.size()) {
+        return nullptr;
+    }
+    const Member& member = members_[channel];
+    return member.transport == GroupTransport::BARQ ? member.barq->getWriteBuffer()
+                                                    : member.casir->getWriteBuffer();
+}
+
+bool PublishGroup::stage(int channel, size_t size) {
+    if (!initialized_ || channel < 0 || static_cast<size_t>(channel) >= members_.size()) {
+        return false;
+    }
+    Member& member = members_[channel];
+    if (size > maxSizeOf(member)) return false;
+    member.staged_size = size;
+    member.staged = true;
+    return true;
+}
+
+bool PublishGroup::write(int channel, const void* data, size_t size) {
+    void* buffer = getWriteBuffer(channel);
+    if (!buffer || size > maxSizeOf(members_[channel])) return false;
+    std::memcpy(buffer, data, size);
+    return stage(channel, size);
+}
+
+uint64_t PublishGroup::publish() {
+    if (!initialized_) return 0;
+    
+    // Seqlock write: odd while member fronts flip
+    uint64_t seq = header_->seq.load(std::memory_order_relaxed);
+    header_->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    bool ok = true;
+    for (size_t i = 0; i < members_.size(); ++i) {
+        Member& member = members_[i];
+        if (member.staged) {
+            bool committed = member.transport == GroupTransport::BARQ
+                ? member.barq->commit(member.staged_size)
+                : member.casir->commitWrite(member.staged_size);
+            ok = ok && committed;
+            member.staged = false;
+        }
+        header_->frames[i].store(frameOf(member), std::memory_order_relaxed);
+    }
+    header_->timestamp_ns.store(nowNs(), std::memory_order_relaxed);
+    
+    header_->seq.store(seq + 2, std::memory_order_release);
+    Futex::publish(&header_->notify);
+    
+    return ok ? (seq + 2) / 2 : 0;
+}
+
+uint64_t PublishGroup::getGroupSequence() const {
+    return header_ ? header_->seq.load(std::memory_order_acquire) / 2 : 0;
+}
+
+void PublishGroup::destroy() {
+    if (ptr_) {
+        munmap(ptr_, shm_size_);
+        ptr_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+        shm_unlink(name_.c_str());
+    }
+    header_ = nullptr;
+    initialized_ = false;
+}
+
+// ============================================================================
+// GroupReader
+// ============================================================================
+
+GroupReader::GroupReader(const std::string& name)
+    : name_(name)
+    , initialized_(false)
+    , fd_(-1)
+    , ptr_(nullptr)
+    , shm_size_(0)
+    , header_(nullptr)
+    , last_sequence_(0)
+    , retries_(0)
+    , wait_strategy_(WaitStrategy::adaptive())
+{
+}
+
+GroupReader::~GroupReader() {
+    cleanup();
+}
+
+void GroupReader::cleanup() {
+    notify_.detach();
+    members_.clear();
+    if (ptr_) {
+        munmap(ptr_, shm_size_);
+        ptr_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    header_ = nullptr;
+    initialized_ = false;
+}
+
+bool GroupReader::init() {
+    if (initialized_) return true;
+    
+    // Read-write only needed to park on the futex
+    fd_ = shm_open(name_.c_str(), O_RDWR, 0666);
+    if (fd_ < 0) {
+        fd_ = shm_open(name_.c_str(), O_RDONLY, 0666);
+    }
+    if (fd_ < 0) return false;
+    
+    struct stat st;
+    if (fstat(fd_, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(GroupHeader)) {
+        cleanup();
+        return false;
+    }
+    shm_size_ = st.st_size;
+    
+    ptr_ = mmap(nullptr, shm_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (ptr_ == MAP_FAILED) {
+        ptr_ = nullptr;
+        cleanup();
+        return false;
+    }
+    
+    header_ = static_cast<const GroupHeader*>(ptr_);
+    if (header_->magic != GROUP_MAGIC || header_->num_channels > MAX_GROUP_CHANNELS) {
+        cleanup();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    
+    for (uint32_t i = 0; i < header_->num_channels; ++i) {
+        const GroupMemberInfo& info = header_->members[i];
+        Member member;
+        member.name.assign(info.name, strnlen(info.name, GROUP_NAME_LEN));
+        member.transport = static_cast<GroupTransport>(info.transport);
+        
+        bool ok;
+        if (member.transport == GroupTransport::BARQ) {
+            member.barq.reset(new BARQ::Reader(member.name, info.max_size));
+            ok = member.barq->init();
+        } else {
+            member.casir.reset(new CASIR::Reader(member.name, info.max_size));
+            ok = member.casir->init();
+        }
+        if (!ok) {
+            cleanup();
+            return false;
+        }
+        members_.push_back(std::move(member));
+    }
+    
+    notify_.attach(fd_, reinterpret_cast<const uint8_t*>(&header_->notify) -
+                        static_cast<const uint8_t*>(ptr_));
+    
+    initialized_ = true;
+    return true;
+}
+
+const void* GroupReader::peek(const Member& member, uint64_t frame, size_t& size,
+                              int64_t& timestamp_ns) const {
+    return member.transport == GroupTransport::BARQ
+        ? member.barq->peek(frame, size, timestamp_ns)
+        : member.casir->peek(frame, size, timestamp_ns);
+}
+
+bool GroupReader::read(GroupSnapshot& out) {
+    if (!initialized_) return false;
+    
+    size_t n = members_.size();
+    out.members.resize(n);
+    uint64_t frames[MAX_GROUP_CHANNELS];
+    
+    for (int attempt = 0; attempt < MAX_READ_RETRIES; ++attempt) {
+        if (attempt > 0) {
+            ++retries_;
+            Futex::cpuRelax();
+        }
+        
+        // Members resized by their writer: peek() needs the new layout
+        for (Member& member : members_) {
+            bool mapped = member.transport == GroupTransport::BARQ ? member.barq->refreshLayout()
+                                                                   : member.casir->refreshLayout();
+            if (!mapped) return false;
+        }
+        
+        uint64_t s1 = header_->seq.load(std::memory_order_acquire);
+        if (s1 & 1) continue;                       // Publish in progress
+        if (s1 / 2 == last_sequence_) return false; // Nothing new (or none yet)
+        
+        for (size_t i = 0; i < n; ++i) {
+            frames[i] = header_->frames[i].load(std::memory_order_relaxed);
+        }
+        int64_t timestamp_ns = header_->timestamp_ns.load(std::memory_order_relaxed);
+        
+        // Each member's front must still hold the recorded frame
+        bool complete = true;
+        for (size_t i = 0; i < n && complete; ++i) {
+            GroupMember& m = out.members[i];
+            m.frame = frames[i];
+            m.data = frames[i] ? peek(members_[i], frames[i], m.size, m.timestamp_ns) : nullptr;
+            if (!m.data) {
+                m.size = 0;
+                m.timestamp_ns = 0;
+                complete = frames[i] == 0;          // Member never written: empty
+            }
+        }
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!complete || header_->seq.load(std::memory_order_relaxed) != s1) continue;
+        
+        out.sequence = s1 / 2;
+        out.timestamp_ns = timestamp_ns;
+        last_sequence_ = out.sequence;
+        return true;
+    }
+    return false;
+}
+
+bool GroupReader::readWithTimeout(GroupSnapshot& out, uint32_t timeout_ms) {
+    if (read(out)) return true;
+    if (!waitForData(timeout_ms)) return false;
+    return read(out);
+}
+
+bool GroupReader::validate(const GroupSnapshot& snapshot) const {
+    if (!initialized_ || snapshot.members.size() != members_.size()) return false;
+    
+    for (size_t i = 0; i < members_.size(); ++i) {
+        const GroupMember& m = snapshot.members[i];
+        if (!m.data) continue;
+        size_t size;
+        int64_t timestamp_ns;
+        if (peek(members_[i], m.frame, size, timestamp_ns) != m.data) return false;
+    }
+    return true;
+}
+
+bool GroupReader::hasNewData() const {
+    if (!initialized_) return false;
+    uint64_t seq = header_->seq.load(std::memory_order_acquire);
+    return (seq & 1) == 0 && seq / 2 != last_sequence_;
+}
+
+bool GroupReader::waitForData(uint32_t timeout_ms) {
+    if (!initialized_) return false;
+    return wait_strategy_.waitUntil([this] { return hasNewData(); },
+                                    notify_.get(), timeout_ms);
+}
+
+} // namespace SIM
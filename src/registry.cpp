@@ -0,0 +1,455 @@
+/**
+ * @file registry.cpp
+ * @brief Topic Registry Implementation
+ */
+
+#include "registry.hpp"
+#include "gc.hpp"
+#include "name_hash.hpp"
+#include "work_queue.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace SIM {
+
+namespace {
+
+constexpr uint32_t ENTRY_FREE = 0;
+constexpr uint32_t ENTRY_LIVE = 1;
+constexpr uint32_t ENTRY_WITHDRAWN = 2;
+constexpr uint32_t LOCK_CHECK_SPINS = 4096;     // Failed tries between liveness checks of the holder
+constexpr int READ_RETRIES = 1000;              // Odd seq reads before the entry is given up on
+constexpr int READ_SPINS = 64;                  // Then yield between reads
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+void toInfo(const RegistryRecord& record, TopicInfo& out) {
+    out.name.assign(record.name, strnlen(record.name, REGISTRY_NAME_LEN));
+    out.transport = static_cast<TransportType>(record.transport);
+    out.layout_version = record.layout_version;
+    out.max_size = record.max_size;
+    out.meta_size = record.meta_size;
+    out.rate_hz = record.rate_hz;
+    out.pid = record.pid;
+    out.updated_ns = record.updated_ns;
+}
+
+// Seqlock write side (caller holds the registry lock)
+void beginWrite(RegistryEntry& entry) {
+    entry.seq.store(entry.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void endWrite(RegistryEntry& entry) {
+    entry.seq.store(entry.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+} // namespace
+
+const char* transportName(TransportType transport) {
+    switch (transport) {
+        case TransportType::SIM:   return "SIM";
+        case TransportType::SAHM:  return "SAHM";
+        case TransportType::BARQ:  return "BARQ";
+        case TransportType::CASIR: return "CASIR";
+        case TransportType::Mux:   return "Mux";
+        default:                   return "Unknown";
+    }
+}
+
+// ============================================================================
+// Registry
+// ============================================================================
+
+Registry::Registry(const std::string& name)
+    : name_(name)
+    , fd_(-1)
+    , ptr_(nullptr)
+    , shm_size_(0)
+    , header_(nullptr)
+    , entries_(nullptr)
+{
+}
+
+Registry::~Registry() {
+    close();
+}
+
+bool Registry::open(uint32_t capacity) {
+    if (header_) return true;
+    if (capacity == 0) capacity = REGISTRY_DEFAULT_CAPACITY;
+    capacity = static_cast<uint32_t>(nextPowerOfTwo(capacity));
+    
+    bool creator = true;
+    fd_ = shm_open(name_.c_str(), O_CREAT | O_RDWR | O_EXCL, 0666);
+    if (fd_ < 0) {
+        creator = false;
+        fd_ = shm_open(name_.c_str(), O_RDWR, 0666);
+    }
+    if (fd_ < 0) return false;
+    
+    if (creator) {
+        size_t size = sizeof(RegistryHeader) + capacity * sizeof(RegistryEntry);
+        if (ftruncate(fd_, size) < 0) {
+            ::close(fd_);
+            fd_ = -1;
+            shm_unlink(name_.c_str());
+            return false;
+        }
+        shm_size_ = size;
+    } else {
+        // The creator may still be sizing the segment
+        struct stat st;
+        for (int i = 0; i < 1000; ++i) {
+            if (fstat(fd_, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(RegistryHeader)) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (fstat(fd_, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(RegistryHeader)) {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        shm_size_ = st.st_size;
+    }
+    
+    ptr_ = mmap(nullptr, shm_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0);
+    if (ptr_ == MAP_FAILED) {
+        ptr_ = nullptr;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    RegistryHeader* header = static_cast<RegistryHeader*>(ptr_);
+    
+    if (creator) {
+        // Entries are left as ftruncate zeroed them (free, seq 0)
+        header->version = REGISTRY_VERSION;
+        header->capacity = capacity;
+        header->lock.store(0, std::memory_order_relaxed);
+        header->live.store(0, std::memory_order_relaxed);
+        header->notify.seq.store(0, std::memory_order_relaxed);
+        header->notify.waiters.store(0, std::memory_order_relaxed);
+        header->magic.store(REGISTRY_MAGIC, std::memory_order_release);
+    } else {
+        for (int i = 0; i < 1000 && header->magic.load(std::memory_order_acquire) != REGISTRY_MAGIC; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (header->magic.load(std::memory_order_acquire) != REGISTRY_MAGIC ||
+            header->version != REGISTRY_VERSION ||
+            sizeof(RegistryHeader) + header->capacity * sizeof(RegistryEntry) > shm_size_) {
+            munmap(ptr_, shm_size_);
+            ptr_ = nullptr;
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+    }
+    
+    header_ = header;
+    entries_ = reinterpret_cast<RegistryEntry*>(static_cast<uint8_t*>(ptr_) + sizeof(RegistryHeader));
+    return true;
+}
+
+void Registry::close() {
+    if (ptr_) {
+        munmap(ptr_, shm_size_);
+        ptr_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    header_ = nullptr;
+    entries_ = nullptr;
+    shm_size_ = 0;
+}
+
+bool Registry::unlink(const std::string& name) {
+    return shm_unlink(name.c_str()) == 0;
+}
+
+void Registry::lock() const {
+    uint32_t self = static_cast<uint32_t>(getpid());
+    uint32_t expected = 0;
+    for (uint32_t spins = 1; !header_->lock.compare_exchange_weak(expected, self, std::memory_order_acquire,
+                                                                   std::memory_order_relaxed); ++spins) {
+        if (expected != 0 && spins % LOCK_CHECK_SPINS == 0 && takeOver(expected)) return;
+        expected = 0;
+        Futex::cpuRelax();
+    }
+}
+
+void Registry::unlock() const {
+    header_->lock.store(0, std::memory_order_release);
+}
+
+// The lock word holds the owner pid: a holder that died inside a critical
+// section is replaced, and what it left half-written is repaired
+bool Registry::takeOver(uint32_t holder) const {
+    if (processAlive(static_cast<int32_t>(holder))) return false;
+    uint32_t self = static_cast<uint32_t>(getpid());
+    if (!header_->lock.compare_exchange_strong(holder, self, std::memory_order_acquire,
+                                               std::memory_order_relaxed)) {
+        return false;
+    }
+    repair();
+    return true;
+}
+
+// Under the lock. An odd seq is a record torn by the dead holder, which
+// was advertising, updating or withdrawing it: withdrawn. The live count
+// may have missed its last update, so it is recounted.
+void Registry::repair() const {
+    uint32_t live = 0;
+    for (uint32_t i = 0; i < header_->capacity; ++i) {
+        RegistryEntry& entry = entries_[i];
+        uint32_t seq = entry.seq.load(std::memory_order_relaxed);
+        if (seq & 1) {
+            entry.state.store(ENTRY_WITHDRAWN, std::memory_order_relaxed);
+            entry.seq.store(seq + 1, std::memory_order_release);
+        }
+        if (entry.state.load(std::memory_order_relaxed) == ENTRY_LIVE) ++live;
+    }
+    header_->live.store(live, std::memory_order_relaxed);
+    Futex::publish(&header_->notify);
+}
+
+bool Registry::readEntry(uint32_t index, RegistryRecord& out) const {
+    const RegistryEntry& entry = entries_[index];
+    for (int attempt = 0; ; ++attempt) {
+        uint32_t s1 = entry.seq.load(std::memory_order_acquire);
+        if (s1 & 1) {
+            // Stuck odd: repair it if the writer died, else skip the entry
+            if (attempt >= READ_RETRIES) {
+                uint32_t holder = header_->lock.load(std::memory_order_relaxed);
+                if (holder == 0 || !takeOver(holder)) return false;
+                unlock();
+                attempt = 0;
+                continue;
+            }
+            if (attempt < READ_SPINS) {
+                Futex::cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        if (entry.state.load(std::memory_order_acquire) != ENTRY_LIVE) return false;
+        std::memcpy(&out, &entry.record, sizeof(RegistryRecord));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.seq.load(std::memory_order_relaxed) == s1) return true;
+    }
+}
+
+int Registry::find(const char* topic, uint32_t hash) const {
+    uint32_t mask = header_->capacity - 1;
+    RegistryRecord record;
+    for (uint32_t probe = 0; probe <= mask; ++probe) {
+        uint32_t index = (hash + probe) & mask;
+        uint32_t state = entries_[index].state.load(std::memory_order_acquire);
+        if (state == ENTRY_FREE) return -1;
+        if (state != ENTRY_LIVE || !readEntry(index, record)) continue;
+        if (record.hash == hash && std::strncmp(record.name, topic, REGISTRY_NAME_LEN) == 0) {
+            return static_cast<int>(index);
+        }
+    }
+    return -1;
+}
+
+int Registry::advertise(const TopicInfo& info) {
+    if (!header_ || info.name.empty() || info.name.size() >= REGISTRY_NAME_LEN) return -1;
+    uint32_t hash = hashName(info.name.c_str());
+    
+    lock();
+    int index = find(info.name.c_str(), hash);
+    if (index < 0) {
+        // First free or withdrawn slot on the probe chain
+        uint32_t mask = header_->capacity - 1;
+        for (uint32_t probe = 0; probe <= mask; ++probe) {
+            uint32_t slot = (hash + probe) & mask;
+            if (entries_[slot].state.load(std::memory_order_relaxed) != ENTRY_LIVE) {
+                index = static_cast<int>(slot);
+                break;
+            }
+        }
+        if (index < 0) {
+            unlock();
+            return -1;
+        }
+    }
+    
+    RegistryEntry& entry = entries_[index];
+    bool added = entry.state.load(std::memory_order_relaxed) != ENTRY_LIVE;
+    beginWrite(entry);
+    RegistryRecord& r = entry.record;
+    std::memset(&r, 0, sizeof(r));
+    std::memcpy(r.name, info.name.data(), info.name.size());
+    r.hash = hash;
+    r.transport = static_cast<uint32_t>(info.transport);
+    r.layout_version = info.layout_version;
+    r.pid = static_cast<int32_t>(getpid());
+    r.max_size = info.max_size;
+    r.meta_size = info.meta_size;
+    r.rate_hz = info.rate_hz;
+    r.updated_ns = nowNs();
+    entry.state.store(ENTRY_LIVE, std::memory_order_relaxed);
+    endWrite(entry);
+    if (added) header_->live.fetch_add(1, std::memory_order_relaxed);
+    unlock();
+    
+    Futex::publish(&header_->notify);
+    return index;
+}
+
+bool Registry::updateRate(int index, double rate_hz) {
+    if (!header_ || index < 0 || static_cast<uint32_t>(index) >= header_->capacity) return false;
+    RegistryEntry& entry = entries_[index];
+    
+    lock();
+    if (entry.state.load(std::memory_order_relaxed) != ENTRY_LIVE) {
+        unlock();
+        return false;
+    }
+    beginWrite(entry);
+    entry.record.rate_hz = rate_hz;
+    entry.record.updated_ns = nowNs();
+    endWrite(entry);
+    unlock();
+    
+    // Not a membership change: generation stays
+    return true;
+}
+
+bool Registry::withdraw(int index) {
+    if (!header_ || index < 0 || static_cast<uint32_t>(index) >= header_->capacity) return false;
+    RegistryEntry& entry = entries_[index];
+    
+    lock();
+    if (entry.state.load(std::memory_order_relaxed) != ENTRY_LIVE) {
+        unlock();
+        return false;
+    }
+    beginWrite(entry);
+    entry.state.store(ENTRY_WITHDRAWN, std::memory_order_relaxed);
+    endWrite(entry);
+    header_->live.fetch_sub(1, std::memory_order_relaxed);
+    unlock();
+    
+    Futex::publish(&header_->notify);
+    return true;
+}
+
+bool Registry::withdraw(const std::string& topic) {
+    if (!header_ || topic.empty() || topic.size() >= REGISTRY_NAME_LEN) return false;
+    return withdraw(find(topic.c_str(), hashName(topic.c_str())));
+}
+
+bool Registry::lookup(const std::string& topic, TopicInfo& out) const {
+    if (!header_ || topic.empty() || topic.size() >= REGISTRY_NAME_LEN) return false;
+    int index = find(topic.c_str(), hashName(topic.c_str()));
+    RegistryRecord record;
+    if (index < 0 || !readEntry(static_cast<uint32_t>(index), record)) return false;
+    toInfo(record, out);
+    return true;
+}
+
+size_t Registry::list(std::vector<TopicInfo>& out, const std::string& pattern) const {
+    if (!header_) return 0;
+    size_t count = 0;
+    RegistryRecord record;
+    
+    for (uint32_t i = 0; i < header_->capacity; ++i) {
+        if (!readEntry(i, record)) continue;
+        record.name[REGISTRY_NAME_LEN - 1] = '\0';
+        if (fnmatch(pattern.c_str(), record.name, 0) != 0) continue;
+        TopicInfo info;
+        toInfo(record, info);
+        out.push_back(std::move(info));
+        ++count;
+    }
+    return count;
+}
+
+uint32_t Registry::getGeneration() const {
+    return header_ ? header_->notify.seq.load(std::memory_order_acquire) : 0;
+}
+
+size_t Registry::getTopicCount() const {
+    return header_ ? header_->live.load(std::memory_order_relaxed) : 0;
+}
+
+// ============================================================================
+// RegistryWatch
+// ============================================================================
+
+RegistryWatch::RegistryWatch(Registry& registry, const std::string& pattern)
+    : registry_(registry)
+    , pattern_(pattern)
+    , generation_(0)
+    , primed_(false)
+    , wait_strategy_(WaitStrategy::adaptive())
+{
+}
+
+size_t RegistryWatch::poll(std::vector<TopicInfo>& added, std::vector<std::string>& removed) {
+    added.clear();
+    removed.clear();
+    if (!registry_.isReady()) return 0;
+    
+    uint32_t generation = registry_.getGeneration();
+    if (primed_ && generation == generation_) return 0;
+    
+    // Generation first: a change racing the scan is seen again next poll
+    std::vector<TopicInfo> current;
+    registry_.list(current, pattern_);
+    generation_ = generation;
+    primed_ = true;
+    
+    for (const TopicInfo& now : current) {
+        bool same = false;
+        for (const TopicInfo& old : known_) {
+            if (old.name == now.name) {
+                same = old.transport == now.transport && old.layout_version == now.layout_version &&
+                       old.max_size == now.max_size && old.meta_size == now.meta_size &&
+                       old.pid == now.pid;
+                break;
+            }
+        }
+        if (!same) added.push_back(now);
+    }
+    for (const TopicInfo& old : known_) {
+        bool found = false;
+        for (const TopicInfo& now : current) {
+            if (old.name == now.name) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) removed.push_back(old.name);
+    }
+    
+    known_.swap(current);
+    return added.size() + removed.size();
+}
+
+size_t RegistryWatch::wait(std::vector<TopicInfo>& added, std::vector<std::string>& removed,
+                           uint32_t timeout_ms) {
+    if (poll(added, removed) > 0) return added.size() + removed.size();
+    wait_strategy_.waitUntil([this] { return hasNewData(); },
+                             registry_.getNotifyWord(), timeout_ms);
+    return poll(added, removed);
+}
+
+} // namespace SIM
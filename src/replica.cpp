@@ -0,0 +1,305 @@
+/**
+ * @file replica.cpp
+ * @brief Per-NUMA-Node Replica Implementation
+ */
+
+#include "replica.hpp"
+#include "cache_utils.hpp"
+#include "gather.hpp"
+#include "topology.hpp"
+
+#include <sched.h>
+#include <signal.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace SIM {
+
+namespace {
+
+int64_t nowNs() {
+    auto now = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now.time_since_epoch()).count();
+}
+
+// Restrict the calling thread to the CPUs of node (previous mask saved if asked)
+bool pinToNode(int node, cpu_set_t* previous) {
+    if (previous && sched_getaffinity(0, sizeof(*previous), previous) != 0) return false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    bool any = false;
+    for (int cpu : Topology::get()->cpusOfNode(node)) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+            any = true;
+        }
+    }
+    return any && sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+// A replica left by a relay that is gone must not capture readers
+bool writerAttached(int fd) {
+    alignas(BARQ::CACHE_LINE) uint8_t raw[sizeof(BARQ::Header)];
+    if (pread(fd, raw, sizeof(raw), 0) != static_cast<ssize_t>(sizeof(raw))) return false;
+    const BARQ::Header* header = reinterpret_cast<const BARQ::Header*>(raw);
+    if (header->magic != BARQ::MAGIC) return false;
+    int32_t pid = header->writer_pid.load(std::memory_order_relaxed);
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+void copyFrame(void* dst, const void* src, size_t size) {
+    struct iovec iov;
+    iov.iov_base = const_cast<void*>(src);
+    iov.iov_len = size;
+    gatherCopy(dst, &iov, 1, size >= 4096);     // BARQ::Writer::write() threshold
+}
+
+} // namespace
+
+std::string replicaName(const std::string& channel, int node) {
+    return channel + "@node" + std::to_string(node);
+}
+
+std::string localReplicaName(const std::string& channel) {
+    if (channel.find("@node") != std::string::npos) return channel;
+
+    auto topo = Topology::get();
+    if (topo->numNodes() <= 1) return channel;
+    int node = topo->nodeOfCpu(CacheUtils::getCurrentCpu());
+    if (node < 0) return channel;
+
+    std::string name = replicaName(channel, node);
+    int fd = openNamedSegment(name, O_RDONLY);
+    if (fd < 0) return channel;
+    bool live = writerAttached(fd);
+    close(fd);
+    return live ? name : channel;
+}
+
+// ============================================================================
+// ReplicaRelay
+// ============================================================================
+
+ReplicaRelay::ReplicaRelay(const std::string& channel, int node, bool use_huge_pages)
+    : channel_(channel)
+    , node_(node)
+    , use_huge_pages_(use_huge_pages)
+    , running_(false)
+    , stop_(false)
+    , state_(0)
+    , frames_(0)
+    , bytes_(0)
+    , skipped_(0) {}
+
+ReplicaRelay::~ReplicaRelay() {
+    stop();
+}
+
+bool ReplicaRelay::start(uint32_t timeout_ms) {
+    if (running_.load(std::memory_order_acquire)) return true;
+    if (thread_.joinable()) thread_.join();
+
+    stop_.store(false, std::memory_order_relaxed);
+    state_.store(0, std::memory_order_relaxed);
+    running_.store(true, std::memory_order_release);
+    int64_t deadline = nowNs() + static_cast<int64_t>(timeout_ms) * 1000000;
+    thread_ = std::thread([this, deadline]() {
+        // Wait for the source channel, bounded by start()'s timeout
+        while (!stop_.load(std::memory_order_relaxed) && nowNs() < deadline) {
+            run();
+            if (state_.load(std::memory_order_acquire) != 0) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        state_.store(-1, std::memory_order_release);    // Ended or never started
+        running_.store(false, std::memory_order_release);
+    });
+
+    while (state_.load(std::memory_order_acquire) == 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    if (state_.load(std::memory_order_acquire) < 0) {
+        thread_.join();
+        return false;
+    }
+    return true;
+}
+
+void ReplicaRelay::stop() {
+    stop_.store(true, std::memory_order_release);
+    if (thread_.joinable()) thread_.join();
+}
+
+ReplicaStats ReplicaRelay::getStats() const {
+    ReplicaStats stats;
+    stats.node = node_;
+    stats.frames = frames_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.skipped = skipped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ReplicaRelay::run() {
+    // Everything below runs on the node: the replica is faulted in its memory
+    if (!pinToNode(node_, nullptr)) {
+        state_.store(-1, std::memory_order_release);
+        return;
+    }
+
+    BARQ::Reader source(channel_, 0);
+    source.setLocalReplica(false);
+    if (!source.init()) return;                 // Not there yet: caller retries
+
+    BARQ::Writer replica(replicaName(channel_, node_), source.getCapacity(),
+                         use_huge_pages_, source.getMetadataSize());
+    if (!replica.init()) {
+        state_.store(-1, std::memory_order_release);
+        return;
+    }
+    state_.store(1, std::memory_order_release);
+
+    while (!stop_.load(std::memory_order_acquire)) {
+        size_t size = 0;
+        int64_t ts = 0;
+        const void* frame = source.getLatestWithTimeout(size, ts, 100);
+        if (!frame) continue;
+
+        // Writer resized the channel
+        if (source.getCapacity() > replica.getMaxSize() && !replica.resize(source.getCapacity())) {
+            continue;
+        }
+
+        copyFrame(replica.getWriteBuffer(), frame, size);
+        const void* meta = source.getMetadata();
+        if (meta) std::memcpy(replica.getWriteMetadata(), meta, replica.getMetadataSize());
+        replica.commit(size, ts);
+
+        frames_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(size, std::memory_order_relaxed);
+        skipped_.store(source.getDropped(), std::memory_order_relaxed);
+    }
+    replica.destroy();
+}
+
+// ============================================================================
+// ReplicatedWriter
+// ============================================================================
+
+ReplicatedWriter::ReplicatedWriter(const std::string& name, size_t max_size,
+                                   const ReplicaOptions& options,
+                                   bool use_huge_pages, size_t meta_size)
+    : primary_(name, max_size, use_huge_pages, meta_size)
+    , options_(options)
+    , use_huge_pages_(use_huge_pages)
+    , meta_size_(meta_size) {}
+
+ReplicatedWriter::~ReplicatedWriter() {
+    destroy();
+}
+
+bool ReplicatedWriter::init() {
+    if (primary_.isReady()) return true;
+    if (!primary_.init()) return false;
+
+    auto topo = Topology::get();
+    int home = topo->nodeOfCpu(CacheUtils::getCurrentCpu());
+    std::vector<int> nodes = options_.nodes;
+    if (nodes.empty()) {
+        for (int node = 0; node < topo->numNodes(); ++node) {
+            if (!topo->cpusOfNode(node).empty()) nodes.push_back(node);
+        }
+    }
+
+    for (int node : nodes) {
+        if (node == home) continue;
+
+        if (options_.mode == ReplicaMode::Relay) {
+            std::unique_ptr<ReplicaRelay> relay(new ReplicaRelay(primary_.getName(), node, use_huge_pages_));
+            if (relay->start()) relays_.push_back(std::move(relay));
+            continue;
+        }
+
+        // Created from the node's CPUs so its pages are local there
+        cpu_set_t previous;
+        if (!pinToNode(node, &previous)) continue;
+        std::unique_ptr<BARQ::Writer> writer(new BARQ::Writer(
+            replicaName(primary_.getName(), node), primary_.getMaxSize(), use_huge_pages_, meta_size_));
+        bool ok = writer->init();
+        sched_setaffinity(0, sizeof(previous), &previous);
+        if (ok) inline_.push_back(InlineReplica{node, std::move(writer), 0, 0});
+    }
+    return true;
+}
+
+bool ReplicatedWriter::write(const void* data, size_t size) {
+    if (inline_.empty()) return primary_.write(data, size);
+
+    void* buffer = primary_.getWriteBuffer();
+    if (!buffer || size > primary_.getMaxSize()) return false;
+    copyFrame(buffer, data, size);
+    return commit(size);
+}
+
+void* ReplicatedWriter::getWriteBuffer() {
+    return primary_.getWriteBuffer();
+}
+
+void* ReplicatedWriter::getWriteMetadata() {
+    return primary_.getWriteMetadata();
+}
+
+bool ReplicatedWriter::commit(size_t size) {
+    if (inline_.empty()) return primary_.commit(size);
+
+    // Back buffer becomes the front: still readable after the commit
+    const void* frame = primary_.getWriteBuffer();
+    const void* meta = primary_.getWriteMetadata();
+    int64_t ts = nowNs();
+    if (!primary_.commit(size, ts)) return false;
+    copyToReplicas(frame, meta, size, ts);
+    return true;
+}
+
+void ReplicatedWriter::copyToReplicas(const void* frame, const void* meta, size_t size, int64_t ts) {
+    for (InlineReplica& r : inline_) {
+        BARQ::Writer& w = *r.writer;
+        if (w.getMaxSize() < primary_.getMaxSize() && !w.resize(primary_.getMaxSize())) continue;
+
+        copyFrame(w.getWriteBuffer(), frame, size);
+        if (meta) std::memcpy(w.getWriteMetadata(), meta, meta_size_);
+        w.commit(size, ts);
+        ++r.frames;
+        r.bytes += size;
+    }
+}
+
+std::vector<int> ReplicatedWriter::getReplicaNodes() const {
+    std::vector<int> nodes;
+    for (const auto& relay : relays_) {
+        if (relay->isRunning()) nodes.push_back(relay->getNode());
+    }
+    for (const InlineReplica& r : inline_) nodes.push_back(r.node);
+    return nodes;
+}
+
+std::vector<ReplicaStats> ReplicatedWriter::getStats() const {
+    std::vector<ReplicaStats> stats;
+    for (const auto& relay : relays_) stats.push_back(relay->getStats());
+    for (const InlineReplica& r : inline_) stats.push_back(ReplicaStats{r.node, r.frames, r.bytes, 0});
+    return stats;
+}
+
+void ReplicatedWriter::destroy() {
+    for (auto& relay : relays_) relay->stop();
+    relays_.clear();
+    for (InlineReplica& r : inline_) r.writer->destroy();
+    inline_.clear();
+    primary_.destroy();
+}
+
+} // namespace SIM
@@ -6,6 +6,7 @@
 #include "sahm.hpp"
 
 #include <fcntl.h>
+#include <sys/file.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -46,6 +47,7 @@ bool DirectWriter::init() {
     shm_unlink(channel_name_.c_str());
     control_fd_ = shm_open(channel_name_.c_str(), O_CREAT | O_RDWR, 0666);
     if (control_fd_ < 0) return false;
+    flock(control_fd_, LOCK_SH);    // Held while attached (see gc.hpp)
     
     if (ftruncate(control_fd_, control_size_) < 0) {
         close(control_fd_);
@@ -68,6 +70,7 @@ bool DirectWriter::init() {
     header_->version = 2;
     header_->max_slot_size = max_slot_size_;
     header_->num_readers.store(0);
+    header_->writer_pid.store(getpid());
     header_->writer_heartbeat_ns.store(getCurrentTimestampNs());
     
     for (size_t i = 0; i < MAX_READERS; ++i) {
@@ -132,7 +135,8 @@ void DirectWriter::discoverReaders() {
     }
 }
 
-int DirectWriter::write(const void* data, size_t size) {
+template <typename Fill>
+int DirectWriter::publish(size_t size, Fill fill) {
     if (!is_initialized_ || size > max_slot_size_) return 0;
     
     discoverReaders();
@@ -154,7 +158,7 @@ int DirectWriter::write(const void* data, size_t size) {
         uint8_t* slot_data = slot_ptr + sizeof(RingSlot);
         
         // Write data
-        std::memcpy(slot_data, data, size);
+        fill(slot_data);
         
         // Update slot metadata
         uint64_t seq = rh->total_writes.load(std::memory_order_relaxed) + 1;
@@ -166,6 +170,7 @@ int DirectWriter::write(const void* data, size_t size) {
         uint32_t next_idx = (idx + 1) % ring_size;
         rh->write_idx.store(next_idx, std::memory_order_relaxed);
         rh->total_writes.store(seq, std::memory_order_release);
+        SIM::Futex::publish(&rh->notify);
         
         ++written;
     }
@@ -174,6 +179,19 @@ int DirectWriter::write(const void* data, size_t size) {
     return written;
 }
 
+int DirectWriter::write(const void* data, size_t size) {
+    return publish(size, [data, size](uint8_t* slot_data) {
+        std::memcpy(slot_data, data, size);
+    });
+}
+
+int DirectWriter::writev(const struct iovec* iov, int iovcnt) {
+    // Gather segments straight into each reader's slot
+    return publish(SIM::iovecSize(iov, iovcnt), [iov, iovcnt](uint8_t* slot_data) {
+        SIM::gatherCopy(slot_data, iov, iovcnt, false);
+    });
+}
+
 std::vector<void*> DirectWriter::getWriteSlots() {
     std::vector<void*> slots;
     
@@ -222,6 +240,7 @@ int DirectWriter::commitSlots(size_t size) {
         uint32_t next_idx = (idx + 1) % ring_size;
         rh->write_idx.store(next_idx, std::memory_order_relaxed);
         rh->total_writes.store(seq, std::memory_order_release);
+        SIM::Futex::publish(&rh->notify);
         
         ++committed;
     }
@@ -276,6 +295,8 @@ DirectReader::DirectReader(const std::string& channel_name,
     , buffer_ptr_(nullptr)
     , ring_header_(nullptr)
     , slots_base_(nullptr)
+    , last_seen_total_(0)
+    , wait_strategy_(SIM::WaitStrategy::adaptive())
 {
     my_shm_name_ = channel_name + "_reader_" + std::to_string(getpid());
     slot_total_size_ = sizeof(RingSlot) + max_slot_size_;
@@ -336,6 +357,7 @@ bool DirectReader::init() {
         close(control_fd_);
         return false;
     }
+    flock(buffer_fd_, LOCK_SH);     // Held while attached (see gc.hpp)
     
     if (ftruncate(buffer_fd_, buffer_size_) < 0) {
         close(buffer_fd_);
@@ -365,6 +387,8 @@ bool DirectReader::init() {
     ring_header_->slot_total_size = slot_total_size_;
     ring_header_->write_idx.store(0);
     ring_header_->total_writes.store(0);
+    ring_header_->notify.seq.store(0);
+    ring_header_->notify.waiters.store(0);
     
     slots_base_ = static_cast<uint8_t*>(buffer_ptr_) + sizeof(RingBufferHeader);
     
@@ -419,10 +443,29 @@ const void* DirectReader::getLatest(size_t& size) {
     
     RingSlot* slot = getSlotPtr(latest_idx);
     size = slot->data_size.load(std::memory_order_relaxed);
+    last_seen_total_ = total;
     
     return slots_base_ + latest_idx * slot_total_size_ + sizeof(RingSlot);
 }
 
+const void* DirectReader::getLatestWithTimeout(size_t& size, uint32_t timeout_ms) {
+    if (!waitForData(timeout_ms)) return nullptr;
+    return getLatest(size);
+}
+
+bool DirectReader::hasNewData() const {
+    if (!ring_header_) return false;
+    return ring_header_->total_writes.load(std::memory_order_acquire) != last_seen_total_;
+}
+
+bool DirectReader::waitForData(uint32_t timeout_ms) {
+    if (!is_initialized_) return false;
+    
+    // Ring is our own RW mapping: park directly on its notify word
+    return wait_strategy_.waitUntil([this] { return hasNewData(); },
+                                    &ring_header_->notify, timeout_ms);
+}
+
 const void* DirectReader::getSlot(uint32_t slot_idx, size_t& size) {
     if (!is_initialized_ || slot_idx >= ring_size_) return nullptr;
     
@@ -4,7 +4,9 @@
  */
 
 #include "sim.hpp"
+#include "huge_pages.hpp"
 
+#include <sys/file.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -20,23 +22,25 @@ namespace SIM {
 // UTILITY FUNCTIONS
 // ============================================================================
 
-static size_t calculateShmSize(size_t max_payload) {
-    // Header + 2 buffer (double buffering) + padding per allineamento
-    return sizeof(Header) + (max_payload * 2) + 128;
-}
-
 static size_t alignToCacheLine(size_t size) {
     constexpr size_t CACHE_LINE = 64;
     return ((size + CACHE_LINE - 1) / CACHE_LINE) * CACHE_LINE;
 }
 
+static size_t calculateShmSize(size_t max_payload, size_t meta_size = 0) {
+    // Header + 2 blocchi metadati + 2 buffer (double buffering) + padding
+    return sizeof(Header) + alignToCacheLine(meta_size) * 2 + (max_payload * 2) + 128;
+}
+
 // ============================================================================
 // WRITER IMPLEMENTATION
 // ============================================================================
 
-Writer::Writer(const std::string& shm_name, size_t max_size, bool enable_checksum)
+Writer::Writer(const std::string& shm_name, size_t max_size, bool enable_checksum,
+               size_t meta_size)
     : shm_name_(shm_name)
     , max_size_(max_size)
+    , meta_size_(meta_size)
     , enable_checksum_(enable_checksum)
     , is_initialized_(false)
     , shm_fd_(-1)
@@ -47,10 +51,16 @@ Writer::Writer(const std::string& shm_name, size_t max_size, bool enable_checksu
 {
     buffer_[0] = nullptr;
     buffer_[1] = nullptr;
+    meta_[0] = nullptr;
+    meta_[1] = nullptr;
 }
 
 Writer::~Writer() {
     if (shm_ptr_ != nullptr && shm_ptr_ != MAP_FAILED) {
+        // Il segmento resta: nessun writer attaccato
+        if (header_) {
+            header_->writer_pid.store(0, std::memory_order_relaxed);
+        }
         munmap(shm_ptr_, shm_size_);
     }
     if (shm_fd_ >= 0) {
@@ -61,6 +71,7 @@ Writer::~Writer() {
 Writer::Writer(Writer&& other) noexcept
     : shm_name_(std::move(other.shm_name_))
     , max_size_(other.max_size_)
+    , meta_size_(other.meta_size_)
     , enable_checksum_(other.enable_checksum_)
     , is_initialized_(other.is_initialized_)
     , shm_fd_(other.shm_fd_)
@@ -71,6 +82,8 @@ Writer::Writer(Writer&& other) noexcept
 {
     buffer_[0] = other.buffer_[0];
     buffer_[1] = other.buffer_[1];
+    meta_[0] = other.meta_[0];
+    meta_[1] = other.meta_[1];
     
     other.shm_fd_ = -1;
     other.shm_ptr_ = nullptr;
@@ -91,6 +104,7 @@ Writer& Writer::operator=(Writer&& other) noexcept {
         // Move
         shm_name_ = std::move(other.shm_name_);
         max_size_ = other.max_size_;
+        meta_size_ = other.meta_size_;
         enable_checksum_ = other.enable_checksum_;
         is_initialized_ = other.is_initialized_;
         shm_fd_ = other.shm_fd_;
@@ -99,6 +113,8 @@ Writer& Writer::operator=(Writer&& other) noexcept {
         header_ = other.header_;
         buffer_[0] = other.buffer_[0];
         buffer_[1] = other.buffer_[1];
+        meta_[0] = other.meta_[0];
+        meta_[1] = other.meta_[1];
         frame_count_ = other.frame_count_;
         
         other.shm_fd_ = -1;
@@ -114,12 +130,28 @@ bool Writer::init() {
         return true;
     }
     
-    shm_size_ = calculateShmSize(max_size_);
+    shm_size_ = calculateShmSize(max_size_, meta_size_);
     
-    // Crea o apre shared memory
-    shm_fd_ = shm_open(shm_name_.c_str(), O_CREAT | O_RDWR, 0666);
-    if (shm_fd_ < 0) {
-        return false;
+    // Crea o apre shared memory. Il lock condiviso resta attivo finche il
+    // writer e attaccato: il GC (gc.hpp) rimuove solo segmenti che riesce a
+    // bloccare in esclusiva. Se il GC sta rimuovendo quello esistente, si
+    // riapre il nome finche non punta a un segmento nuovo.
+    for (int attempt = 0; ; ++attempt) {
+        shm_fd_ = shm_open(shm_name_.c_str(), O_CREAT | O_RDWR, 0666);
+        if (shm_fd_ < 0) {
+            return false;
+        }
+        // Il GC puo aver rimosso il nome tra shm_open e flock: un inode
+        // orfano non e raggiungibile dai reader, si riprova
+        if (flock(shm_fd_, LOCK_SH | LOCK_NB) == 0 && segmentLinked(shm_fd_)) {
+            break;
+        }
+        close(shm_fd_);
+        shm_fd_ = -1;
+        if (attempt >= 100) {
+            return false;
+        }
+        std::this_thread::yield();
     }
     
     // Imposta dimensione
@@ -143,13 +175,25 @@ bool Writer::init() {
     header_ = static_cast<Header*>(shm_ptr_);
     
     size_t header_size = alignToCacheLine(sizeof(Header));
-    uint8_t* payload_start = static_cast<uint8_t*>(shm_ptr_) + header_size;
+    size_t meta_stride = alignToCacheLine(meta_size_);
+    uint8_t* meta_start = static_cast<uint8_t*>(shm_ptr_) + header_size;
+    meta_[0] = meta_size_ ? meta_start : nullptr;
+    meta_[1] = meta_size_ ? meta_start + meta_stride : nullptr;
+    
+    uint8_t* payload_start = meta_start + meta_stride * 2;
     buffer_[0] = payload_start;
     buffer_[1] = payload_start + max_size_;
     
+    // Un segmento riaperto con lo stesso layout puo avere reader gia in
+    // attesa: si conservano i waiters, altrimenti sono residui da azzerare
+    uint32_t version = (VERSION_MAJOR << 16) | VERSION_MINOR;
+    bool same_layout = header_->magic == HEADER_MAGIC && header_->version == version &&
+                       header_->capacity == max_size_ && header_->meta_size == meta_size_;
+    uint32_t waiters = same_layout ? header_->notify.waiters.load(std::memory_order_relaxed) : 0;
+    
     // Inizializza header
     header_->magic = HEADER_MAGIC;
-    header_->version = (VERSION_MAJOR << 16) | VERSION_MINOR;
+    header_->version = version;
     header_->capacity = max_size_;
     header_->front_idx.store(0, std::memory_order_relaxed);
     header_->frame[0].store(0, std::memory_order_relaxed);
@@ -161,6 +205,10 @@ bool Writer::init() {
     header_->checksum[0].store(CHECKSUM_DISABLED, std::memory_order_relaxed);
     header_->checksum[1].store(CHECKSUM_DISABLED, std::memory_order_relaxed);
     header_->checksum_enabled.store(enable_checksum_, std::memory_order_relaxed);
+    header_->meta_size = static_cast<uint32_t>(meta_size_);
+    header_->writer_pid.store(getpid(), std::memory_order_relaxed);
+    header_->notify.seq.store(0, std::memory_order_relaxed);
+    header_->notify.waiters.store(waiters, std::memory_order_relaxed);
     
     // Memory barrier per assicurare visibilita
     std::atomic_thread_fence(std::memory_order_release);
@@ -181,6 +229,27 @@ bool Writer::write(const void* data, size_t size) {
     // Scrivi dati nel back buffer
     std::memcpy(buffer_[back], data, size);
     
+    publishBack(back, size);
+    return true;
+}
+
+bool Writer::writev(const struct iovec* iov, int iovcnt) {
+    size_t size = iovecSize(iov, iovcnt);
+    if (!is_initialized_ || size > max_size_) {
+        return false;
+    }
+    
+    uint32_t front = header_->front_idx.load(std::memory_order_relaxed);
+    uint32_t back = 1 - front;
+    
+    // Copia dei segmenti direttamente nel back buffer
+    gatherCopy(buffer_[back], iov, iovcnt, false);
+    
+    publishBack(back, size);
+    return true;
+}
+
+void Writer::publishBack(uint32_t back, size_t size) {
     // Aggiorna metadati
     ++frame_count_;
     int64_t now = getCurrentTimestampNs();
@@ -190,9 +259,9 @@ bool Writer::write(const void* data, size_t size) {
     header_->published_length.store(size, std::memory_order_relaxed);
     header_->writer_heartbeat_ns.store(now, std::memory_order_relaxed);
     
-    // Calcola checksum se abilitato
+    // Checksum sul messaggio gia copiato nel back buffer
     if (enable_checksum_) {
-        uint32_t cs = calculateChecksum(data, size);
+        uint32_t cs = calculateChecksum(buffer_[back], size);
         header_->checksum[back].store(cs, std::memory_order_relaxed);
     }
     
@@ -200,7 +269,16 @@ bool Writer::write(const void* data, size_t size) {
     // Questo garantisce che tutti gli store precedenti siano visibili
     header_->front_idx.store(back, std::memory_order_release);
     
-    return true;
+    // Risveglia i reader bloccati (nessuna syscall se nessuno attende)
+    Futex::publish(&header_->notify);
+}
+
+void* Writer::getWriteMetadata() {
+    if (!is_initialized_) {
+        return nullptr;
+    }
+    uint32_t front = header_->front_idx.load(std::memory_order_relaxed);
+    return meta_[1 - front];
 }
 
 void Writer::setChecksumEnabled(bool enabled) {
@@ -262,15 +340,20 @@ Reader::Reader(const std::string& shm_name, size_t max_size)
     , shm_size_(0)
     , header_(nullptr)
     , last_frame_(0)
+    , last_idx_(0)
     , last_timestamp_ns_(0)
     , dropped_frames_(0)
     , last_checksum_valid_(true)
+    , wait_strategy_(WaitStrategy::adaptive())
 {
     buffer_[0] = nullptr;
     buffer_[1] = nullptr;
+    meta_[0] = nullptr;
+    meta_[1] = nullptr;
 }
 
 Reader::~Reader() {
+    notify_.detach();
     if (shm_ptr_ != nullptr && shm_ptr_ != MAP_FAILED) {
         munmap(shm_ptr_, shm_size_);
     }
@@ -288,12 +371,17 @@ Reader::Reader(Reader&& other) noexcept
     , shm_size_(other.shm_size_)
     , header_(other.header_)
     , last_frame_(other.last_frame_)
+    , last_idx_(other.last_idx_)
     , last_timestamp_ns_(other.last_timestamp_ns_)
     , dropped_frames_(other.dropped_frames_)
     , last_checksum_valid_(other.last_checksum_valid_)
+    , notify_(std::move(other.notify_))
+    , wait_strategy_(other.wait_strategy_)
 {
     buffer_[0] = other.buffer_[0];
     buffer_[1] = other.buffer_[1];
+    meta_[0] = other.meta_[0];
+    meta_[1] = other.meta_[1];
     
     other.shm_fd_ = -1;
     other.shm_ptr_ = nullptr;
@@ -319,10 +407,15 @@ Reader& Reader::operator=(Reader&& other) noexcept {
         header_ = other.header_;
         buffer_[0] = other.buffer_[0];
         buffer_[1] = other.buffer_[1];
+        meta_[0] = other.meta_[0];
+        meta_[1] = other.meta_[1];
         last_frame_ = other.last_frame_;
+        last_idx_ = other.last_idx_;
         last_timestamp_ns_ = other.last_timestamp_ns_;
         dropped_frames_ = other.dropped_frames_;
         last_checksum_valid_ = other.last_checksum_valid_;
+        notify_ = std::move(other.notify_);
+        wait_strategy_ = other.wait_strategy_;
         
         other.shm_fd_ = -1;
         other.shm_ptr_ = nullptr;
@@ -339,8 +432,11 @@ bool Reader::init() {
     
     shm_size_ = calculateShmSize(max_size_);
     
-    // Apre shared memory esistente (read-only)
-    shm_fd_ = shm_open(shm_name_.c_str(), O_RDONLY, 0666);
+    // Apre shared memory esistente (read-write solo per l'attesa su futex)
+    shm_fd_ = shm_open(shm_name_.c_str(), O_RDWR, 0666);
+    if (shm_fd_ < 0) {
+        shm_fd_ = shm_open(shm_name_.c_str(), O_RDONLY, 0666);
+    }
     if (shm_fd_ < 0) {
         return false;
     }
@@ -367,11 +463,36 @@ bool Reader::init() {
         return false;
     }
     
+    // Con metadati utente il segmento e piu grande: rimappa
+    size_t meta_size = header_->meta_size;
+    if (meta_size > 0) {
+        munmap(shm_ptr_, shm_size_);
+        shm_size_ = calculateShmSize(max_size_, meta_size);
+        shm_ptr_ = mmap(nullptr, shm_size_, PROT_READ, MAP_SHARED, shm_fd_, 0);
+        if (shm_ptr_ == MAP_FAILED) {
+            close(shm_fd_);
+            shm_fd_ = -1;
+            shm_ptr_ = nullptr;
+            header_ = nullptr;
+            return false;
+        }
+        header_ = static_cast<Header*>(shm_ptr_);
+    }
+    
     size_t header_size = alignToCacheLine(sizeof(Header));
-    const uint8_t* payload_start = static_cast<const uint8_t*>(shm_ptr_) + header_size;
+    size_t meta_stride = alignToCacheLine(meta_size);
+    const uint8_t* meta_start = static_cast<const uint8_t*>(shm_ptr_) + header_size;
+    meta_[0] = meta_size ? meta_start : nullptr;
+    meta_[1] = meta_size ? meta_start + meta_stride : nullptr;
+    
+    const uint8_t* payload_start = meta_start + meta_stride * 2;
     buffer_[0] = payload_start;
     buffer_[1] = payload_start + max_size_;
     
+    // Vista scrivibile della parola futex (il payload resta read-only)
+    notify_.attach(shm_fd_, reinterpret_cast<const uint8_t*>(&header_->notify) -
+                            static_cast<const uint8_t*>(shm_ptr_));
+    
     is_initialized_ = true;
     return true;
 }
@@ -423,23 +544,45 @@ bool Reader::read(void* data, size_t& size) {
     
     // Aggiorna stato
     last_frame_ = current_frame;
+    last_idx_ = front;
     
     return true;
 }
 
+bool Reader::read(void* data, size_t& size, void* metadata) {
+    if (!read(data, size)) {
+        return false;
+    }
+    if (metadata != nullptr && meta_[last_idx_] != nullptr) {
+        std::memcpy(metadata, meta_[last_idx_], header_->meta_size);
+    }
+    return true;
+}
+
 bool Reader::readWithTimeout(void* data, size_t& size, uint32_t timeout_ms) {
-    auto start = std::chrono::steady_clock::now();
-    auto timeout = std::chrono::milliseconds(timeout_ms);
+    // Attesa senza sleep fisso: spin, yield, poi park su futex
+    if (!waitForData(timeout_ms)) {
+        return false;
+    }
+    return read(data, size);
+}
+
+bool Reader::hasNewData() const {
+    if (!is_initialized_ || header_ == nullptr) {
+        return false;
+    }
     
-    while (std::chrono::steady_clock::now() - start < timeout) {
-        if (read(data, size)) {
-            return true;
-        }
-        // Breve sleep per non saturare CPU
-        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    uint32_t front = header_->front_idx.load(std::memory_order_acquire);
+    return header_->frame[front].load(std::memory_order_relaxed) != last_frame_;
+}
+
+bool Reader::waitForData(uint32_t timeout_ms) {
+    if (!is_initialized_) {
+        return false;
     }
     
-    return false;
+    return wait_strategy_.waitUntil([this] { return hasNewData(); },
+                                    notify_.get(), timeout_ms);
 }
 
 bool Reader::isWriterAlive(uint32_t timeout_ms) const {
@@ -0,0 +1,268 @@
+/**
+ * @file synchronizer.cpp
+ * @brief Timestamp Synchronizer Implementation
+ */
+
+#include "synchronizer.hpp"
+#include <chrono>
+
+namespace SIM {
+
+namespace {
+
+// Same clock as the transport writers
+int64_t writerClockNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+Synchronizer::Synchronizer(const SyncConfig& config)
+    : config_(config)
+    , next_ref_(0)
+{
+    if (config_.policy == SyncPolicy::Exact) {
+        config_.tolerance_ns = 0;
+    }
+    stats_.emitted = 0;
+    stats_.dropped = 0;
+    stats_.skipped = 0;
+    stats_.searches = 0;
+}
+
+Synchronizer::~Synchronizer() = default;
+
+// ============================================================================
+// Channels
+// ============================================================================
+
+int Synchronizer::addChannel(SAHM::DirectReader& reader, TimestampFn stamp) {
+    if (!reader.isReady() || reader.getRingSize() < 2) return -1;
+    
+    Channel ch;
+    ch.ring = &reader;
+    ch.ring_size = reader.getRingSize();
+    ch.current_seq = 0;
+    ch.stamp = std::move(stamp);
+    ch.wait_id = wait_set_.add(reader.getNotifyWord());
+    channels_.push_back(std::move(ch));
+    return static_cast<int>(channels_.size() - 1);
+}
+
+int Synchronizer::addLatest(NotifyWord* word, std::function<bool()> has_data,
+                            std::function<Frame()> fetch, TimestampFn stamp) {
+    if (!has_data || !fetch) return -1;
+    
+    Channel ch;
+    ch.ring = nullptr;
+    ch.ring_size = 1;
+    ch.has_data = has_data;
+    ch.fetch = std::move(fetch);
+    ch.current_seq = 0;
+    ch.stamp = std::move(stamp);
+    ch.wait_id = wait_set_.add(word, std::move(has_data));
+    channels_.push_back(std::move(ch));
+    return static_cast<int>(channels_.size() - 1);
+}
+
+bool Synchronizer::range(Channel& ch, uint64_t& lo, uint64_t& hi) {
+    if (!ch.ring) {
+        if (ch.has_data()) {
+            ch.current.reset();
+            ch.current = ch.fetch();
+            if (ch.current) ++ch.current_seq;
+        }
+        if (!ch.current) return false;
+        lo = hi = ch.current_seq;
+        return true;
+    }
+    
+    hi = ch.ring->getTotalWrites();
+    if (hi == 0) return false;
+    
+    // The oldest slot is the next one the writer overwrites: leave it out
+    lo = hi > ch.ring_size - 1 ? hi - (ch.ring_size - 1) + 1 : 1;
+    return true;
+}
+
+bool Synchronizer::frameAt(const Channel& ch, uint64_t seq, SyncFrame& frame) const {
+    if (!ch.ring) {
+        if (seq != ch.current_seq || !ch.current) return false;
+        frame.data = ch.current.data();
+        frame.size = ch.current.size();
+        frame.timestamp_ns = ch.stamp ? ch.stamp(frame.data, frame.size)
+                                      : ch.current.timestampNs();
+        frame.sequence = seq;
+        return true;
+    }
+    
+    uint32_t idx = static_cast<uint32_t>((seq - 1) % ch.ring_size);
+    if (ch.ring->getSlotSequence(idx) != seq) return false;
+    
+    size_t size = 0;
+    const void* data = ch.ring->getSlot(idx, size);
+    int64_t timestamp_ns = ch.ring->getSlotTimestampNs(idx);
+    if (ch.stamp && data) timestamp_ns = ch.stamp(data, size);
+    
+    // Re-check: the writer may have lapped us while reading
+    if (!data || ch.ring->getSlotSequence(idx) != seq) return false;
+    
+    frame.data = data;
+    frame.size = size;
+    frame.timestamp_ns = timestamp_ns;
+    frame.sequence = seq;
+    return true;
+}
+
+bool Synchronizer::timestampAt(Channel& ch, uint64_t seq, int64_t& timestamp_ns) {
+    ++stats_.searches;
+    SyncFrame frame;
+    if (!frameAt(ch, seq, frame)) return false;
+    timestamp_ns = frame.timestamp_ns;
+    return true;
+}
+
+bool Synchronizer::nearest(Channel& ch, int64_t target_ns, uint64_t lo, uint64_t hi,
+                           SyncFrame& best, int64_t& newest_ns) {
+    if (!timestampAt(ch, hi, newest_ns)) return false;
+    
+    // First sequence with timestamp >= target (timestamps grow with sequence)
+    uint64_t first = lo, last = hi + 1;
+    while (first < last) {
+        uint64_t mid = first + (last - first) / 2;
+        int64_t ts;
+        if (!timestampAt(ch, mid, ts)) return false;
+        if (ts < target_ns) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    
+    // Closest of the neighbours around the insertion point
+    SyncFrame candidate;
+    bool found = false;
+    if (first <= hi && frameAt(ch, first, candidate)) {
+        best = candidate;
+        found = true;
+    }
+    if (first > lo && frameAt(ch, first - 1, candidate)) {
+        int64_t d_prev = target_ns - candidate.timestamp_ns;
+        if (!found || d_prev < best.timestamp_ns - target_ns) {
+            best = candidate;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// ============================================================================
+// Matching
+// ============================================================================
+
+bool Synchronizer::next(SyncTuple& out) {
+    if (channels_.empty()) return false;
+    
+    Channel& ref = channels_[0];
+    out.frames.resize(channels_.size());
+    
+    while (true) {
+        uint64_t lo, hi;
+        if (!range(ref, lo, hi)) return false;
+        
+        if (next_ref_ == 0) next_ref_ = hi;     // Start with live data
+        if (next_ref_ < lo) {
+            stats_.skipped += lo - next_ref_;
+            next_ref_ = lo;
+        }
+        if (next_ref_ > hi) return false;
+        
+        SyncFrame& pivot = out.frames[0];
+        if (!frameAt(ref, next_ref_, pivot)) {
+            ++stats_.skipped;
+            ++next_ref_;
+            continue;
+        }
+        
+        bool timed_out = writerClockNs() - pivot.timestamp_ns > config_.max_wait_ns;
+        bool drop = false;
+        int64_t min_ts = pivot.timestamp_ns, max_ts = pivot.timestamp_ns;
+        
+        for (size_t c = 1; c < channels_.size(); ++c) {
+            Channel& ch = channels_[c];
+            uint64_t clo, chi;
+            int64_t newest_ns;
+            SyncFrame& best = out.frames[c];
+            
+            if (!range(ch, clo, chi) || !nearest(ch, pivot.timestamp_ns, clo, chi, best, newest_ns)) {
+                // Nothing (readable) yet on this channel
+                if (timed_out) {
+                    drop = true;
+                    break;
+                }
+                return false;
+            }
+            
+            int64_t d = best.timestamp_ns - pivot.timestamp_ns;
+            if (d < 0) d = -d;
+            
+            // A frame at or after t_ref may still arrive and be closer
+            bool may_improve = newest_ns < pivot.timestamp_ns && d != 0;
+            if (may_improve && !timed_out) return false;
+            
+            if (d > config_.tolerance_ns) {
+                drop = true;
+                break;
+            }
+            if (best.timestamp_ns < min_ts) min_ts = best.timestamp_ns;
+            if (best.timestamp_ns > max_ts) max_ts = best.timestamp_ns;
+        }
+        
+        ++next_ref_;
+        if (drop) {
+            ++stats_.dropped;
+            continue;
+        }
+        
+        out.timestamp_ns = pivot.timestamp_ns;
+        out.spread_ns = max_ts - min_ts;
+        ++stats_.emitted;
+        return true;
+    }
+}
+
+bool Synchronizer::waitNext(SyncTuple& out, uint32_t timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    
+    while (true) {
+        if (next(out)) return true;
+        
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) return false;
+        int64_t remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - now).count() + 1;
+        
+        // Cap the park so max_wait_ns decisions are taken on time
+        uint32_t slice_ms = static_cast<uint32_t>(remaining_ms < 10 ? remaining_ms : 10);
+        wait_set_.wait(ready_, slice_ms);
+    }
+}
+
+bool Synchronizer::verify(const SyncTuple& tuple) const {
+    if (tuple.frames.size() != channels_.size()) return false;
+    
+    for (size_t c = 0; c < channels_.size(); ++c) {
+        const Channel& ch = channels_[c];
+        uint64_t seq = tuple.frames[c].sequence;
+        if (ch.ring) {
+            uint32_t idx = static_cast<uint32_t>((seq - 1) % ch.ring_size);
+            if (ch.ring->getSlotSequence(idx) != seq) return false;
+        } else if (ch.current_seq != seq) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace SIM
@@ -0,0 +1,419 @@
+/**
+ * @file topology.cpp
+ * @brief Host Topology Implementation
+ */
+
+#include "topology.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+namespace SIM {
+
+namespace {
+
+constexpr uint32_t TOPOLOGY_MAGIC = 0x544F504F;    // "TOPO"
+constexpr uint32_t TOPOLOGY_VERSION = 1;
+constexpr const char* TOPOLOGY_SEGMENT = "/sim_topology";
+
+// Default cache sizes if detection fails
+constexpr size_t DEFAULT_L1_SIZE = 32 * 1024;      // 32 KB
+constexpr size_t DEFAULT_L2_SIZE = 256 * 1024;     // 256 KB
+constexpr size_t DEFAULT_L3_SIZE = 8 * 1024 * 1024; // 8 MB
+
+const std::string CPU_BASE = "/sys/devices/system/cpu/";
+const std::string NODE_BASE = "/sys/devices/system/node/";
+const std::string HUGEPAGE_BASE = "/sys/kernel/mm/hugepages/";
+
+// Shared copy: ready is set last, once the snapshot is complete
+struct TopologySegment {
+    std::atomic<uint32_t> ready;
+    char pad[CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>)];
+    TopologySnapshot data;
+};
+
+std::mutex g_mutex;
+std::shared_ptr<const Topology> g_topology;
+
+std::string readLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+long readLong(const std::string& path, long fallback) {
+    std::ifstream file(path);
+    long value;
+    return (file >> value) ? value : fallback;
+}
+
+// "32K", "1024K", "8M"
+size_t parseSize(const std::string& str) {
+    size_t value = 0;
+    char suffix = 0;
+    if (std::sscanf(str.c_str(), "%zu%c", &value, &suffix) < 1) return 0;
+    switch (suffix) {
+        case 'K': case 'k': return value << 10;
+        case 'M': case 'm': return value << 20;
+        case 'G': case 'g': return value << 30;
+        default:            return value;
+    }
+}
+
+// "0-3,8-11" -> {0, 1, 2, 3, 8, 9, 10, 11}
+std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        int lo = 0, hi = 0;
+        int n = std::sscanf(range.c_str(), "%d-%d", &lo, &hi);
+        if (n < 1) continue;
+        if (n == 1) hi = lo;
+        for (int c = lo; c <= hi && c < TOPOLOGY_MAX_CPUS; ++c) {
+            if (c >= 0) cpus.push_back(c);
+        }
+    }
+    return cpus;
+}
+
+int lowest(const std::vector<int>& cpus, int fallback) {
+    return cpus.empty() ? fallback : *std::min_element(cpus.begin(), cpus.end());
+}
+
+HugePagePool readPool(const std::string& dir, size_t page_size) {
+    HugePagePool pool;
+    pool.page_size = page_size;
+    pool.total = static_cast<size_t>(readLong(dir + "/nr_hugepages", 0));
+    pool.free = static_cast<size_t>(readLong(dir + "/free_hugepages", 0));
+    pool.reserved = static_cast<size_t>(readLong(dir + "/resv_hugepages", 0));
+    pool.surplus = static_cast<size_t>(readLong(dir + "/surplus_hugepages", 0));
+    return pool;
+}
+
+void readCaches(int id, CpuTopology& cpu, uint32_t& line_size) {
+    std::string base = CPU_BASE + "cpu" + std::to_string(id) + "/cache/";
+    DIR* dir = opendir(base.c_str());
+    if (!dir) return;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (std::strncmp(entry->d_name, "index", 5) != 0) continue;
+        std::string index = base + entry->d_name + "/";
+
+        std::string type = readLine(index + "type");
+        long level = readLong(index + "level", 0);
+        uint32_t size = static_cast<uint32_t>(parseSize(readLine(index + "size")));
+        long line = readLong(index + "coherency_line_size", 0);
+        if (id == 0 && line > 0) line_size = static_cast<uint32_t>(line);
+
+        if (level == 1 && type == "Data") {
+            cpu.l1d_size = size;
+        } else if (level == 1 && type == "Instruction") {
+            cpu.l1i_size = size;
+        } else if (level == 2) {
+            cpu.l2_size = size;
+        } else if (level == 3) {
+            cpu.l3_size = size;
+            cpu.l3_group = lowest(parseCpuList(readLine(index + "shared_cpu_list")), id);
+        }
+    }
+    closedir(dir);
+}
+
+void build(TopologySnapshot& t) {
+    std::memset(&t, 0, sizeof(t));
+    t.magic = TOPOLOGY_MAGIC;
+    t.version = TOPOLOGY_VERSION;
+    std::string boot_id = readLine("/proc/sys/kernel/random/boot_id");
+    std::strncpy(t.boot_id, boot_id.c_str(), sizeof(t.boot_id) - 1);
+    t.built_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    t.line_size = CACHE_LINE_SIZE;
+
+    // CPUs
+    std::vector<int> possible = parseCpuList(readLine(CPU_BASE + "possible"));
+    t.num_cpus = possible.empty() ? static_cast<int32_t>(sysconf(_SC_NPROCESSORS_CONF))
+                                  : *std::max_element(possible.begin(), possible.end()) + 1;
+    t.num_cpus = std::max(1, std::min(t.num_cpus, TOPOLOGY_MAX_CPUS));
+
+    std::vector<int> online = parseCpuList(readLine(CPU_BASE + "online"));
+    for (int id = 0; id < t.num_cpus; ++id) {
+        CpuTopology& cpu = t.cpus[id];
+        cpu.online = online.empty() || std::find(online.begin(), online.end(), id) != online.end();
+        cpu.core = id;
+        cpu.l3_group = -1;
+        if (!cpu.online) continue;
+
+        std::string topo = CPU_BASE + "cpu" + std::to_string(id) + "/topology/";
+        cpu.package = static_cast<int32_t>(readLong(topo + "physical_package_id", 0));
+        cpu.core = lowest(parseCpuList(readLine(topo + "thread_siblings_list")), id);
+        readCaches(id, cpu, t.line_size);
+    }
+
+    // NUMA nodes (a single node 0 without NUMA support)
+    t.num_nodes = 1;
+    t.distance[0][0] = 10;
+    DIR* dir = opendir(NODE_BASE.c_str());
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            int node = -1;
+            if (std::sscanf(entry->d_name, "node%d", &node) != 1) continue;
+            if (node < 0 || node >= TOPOLOGY_MAX_NODES) continue;
+            t.num_nodes = std::max(t.num_nodes, node + 1);
+
+            std::string path = NODE_BASE + entry->d_name + "/";
+            for (int cpu : parseCpuList(readLine(path + "cpulist"))) {
+                if (cpu < t.num_cpus) t.cpus[cpu].node = static_cast<int16_t>(node);
+            }
+            std::istringstream distances(readLine(path + "distance"));
+            int d, other = 0;
+            while (distances >> d && other < TOPOLOGY_MAX_NODES) {
+                t.distance[node][other++] = static_cast<uint8_t>(d);
+            }
+        }
+        closedir(dir);
+    }
+
+    // Huge page pools, default size first
+    t.default_huge_page_size = HUGE_PAGE_SIZE;
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+    while (std::getline(meminfo, line)) {
+        size_t size_kb = 0;
+        if (std::sscanf(line.c_str(), "Hugepagesize: %zu kB", &size_kb) == 1) {
+            t.default_huge_page_size = size_kb * 1024;
+            break;
+        }
+    }
+    dir = opendir(HUGEPAGE_BASE.c_str());
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr && t.num_pools < TOPOLOGY_MAX_POOLS) {
+            size_t size_kb = 0;
+            if (std::sscanf(entry->d_name, "hugepages-%zukB", &size_kb) != 1) continue;
+            t.pools[t.num_pools++] = readPool(HUGEPAGE_BASE + entry->d_name, size_kb * 1024);
+        }
+        closedir(dir);
+    }
+
+    // Selected mode in brackets: "always within_size [advise] never deny force"
+    std::string modes = readLine("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+    t.thp_shmem = !modes.empty() && modes.find("[never]") == std::string::npos &&
+                  modes.find("[deny]") == std::string::npos;
+}
+
+bool cacheEnabled() {
+    const char* env = std::getenv("SIM_TOPOLOGY_CACHE");
+    return !env || std::strcmp(env, "off") != 0;
+}
+
+// Copy of the shared snapshot, if it was built during this boot. stale: a
+// complete snapshot of another boot or layout, to be replaced
+bool loadShared(TopologySnapshot& t, bool& stale) {
+    stale = false;
+    int fd = shm_open(TOPOLOGY_SEGMENT, O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    struct stat st;
+    void* ptr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == sizeof(TopologySegment)) {
+        ptr = mmap(nullptr, sizeof(TopologySegment), PROT_READ, MAP_SHARED, fd, 0);
+    } else {
+        stale = st.st_size != 0;    // 0: the creator has not sized it yet
+    }
+    close(fd);
+    if (ptr == MAP_FAILED) return false;
+
+    // Not ready yet: another process is publishing it
+    const TopologySegment* seg = static_cast<const TopologySegment*>(ptr);
+    bool ok = seg->ready.load(std::memory_order_acquire) == 1;
+    if (ok && (seg->data.magic != TOPOLOGY_MAGIC || seg->data.version != TOPOLOGY_VERSION)) {
+        ok = false;
+        stale = true;
+    }
+    if (ok) {
+        std::memcpy(&t, &seg->data, sizeof(t));
+        ok = readLine("/proc/sys/kernel/random/boot_id") == t.boot_id;
+        stale = !ok;
+    }
+    munmap(ptr, sizeof(TopologySegment));
+    return ok;
+}
+
+// replace: drop the current snapshot first (stale or refreshed). Otherwise
+// losing the O_EXCL race is fine: the winner publishes an equal snapshot
+void storeShared(const TopologySnapshot& t, bool replace) {
+    if (replace) shm_unlink(TOPOLOGY_SEGMENT);
+
+    int fd = shm_open(TOPOLOGY_SEGMENT, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) return;
+    fchmod(fd, 0644);       // Readable by every user despite the umask
+    if (ftruncate(fd, sizeof(TopologySegment)) < 0) {
+        close(fd);
+        shm_unlink(TOPOLOGY_SEGMENT);
+        return;
+    }
+    void* ptr = mmap(nullptr, sizeof(TopologySegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        shm_unlink(TOPOLOGY_SEGMENT);
+        return;
+    }
+
+    TopologySegment* seg = static_cast<TopologySegment*>(ptr);
+    std::memcpy(&seg->data, &t, sizeof(t));
+    seg->ready.store(1, std::memory_order_release);
+    munmap(ptr, sizeof(TopologySegment));
+}
+
+} // namespace
+
+std::shared_ptr<const Topology> Topology::get() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_topology) return g_topology;
+
+    std::shared_ptr<Topology> topo(new Topology());
+    bool shared = cacheEnabled();
+    bool stale = false;
+    if (shared && loadShared(topo->data_, stale)) {
+        topo->from_cache_ = true;
+    } else {
+        build(topo->data_);
+        if (shared) storeShared(topo->data_, stale);
+    }
+    g_topology = topo;
+    return g_topology;
+}
+
+std::shared_ptr<const Topology> Topology::refresh() {
+    std::shared_ptr<Topology> topo(new Topology());
+    build(topo->data_);
+    if (cacheEnabled()) storeShared(topo->data_, true);
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_topology = topo;
+    return g_topology;
+}
+
+std::vector<int> Topology::onlineCpus() const {
+    std::vector<int> cpus;
+    for (int id = 0; id < data_.num_cpus; ++id) {
+        if (data_.cpus[id].online) cpus.push_back(id);
+    }
+    return cpus;
+}
+
+const CpuTopology* Topology::cpu(int cpu_id) const {
+    if (cpu_id < 0 || cpu_id >= data_.num_cpus) return nullptr;
+    return &data_.cpus[cpu_id];
+}
+
+int Topology::nodeOfCpu(int cpu_id) const {
+    const CpuTopology* c = cpu(cpu_id);
+    return c ? c->node : 0;
+}
+
+std::vector<int> Topology::cpusOfNode(int node) const {
+    std::vector<int> cpus;
+    for (int id = 0; id < data_.num_cpus; ++id) {
+        if (data_.cpus[id].online && data_.cpus[id].node == node) cpus.push_back(id);
+    }
+    return cpus;
+}
+
+std::vector<int> Topology::smtSiblings(int cpu_id) const {
+    std::vector<int> cpus;
+    const CpuTopology* c = cpu(cpu_id);
+    if (!c) return cpus;
+    for (int id = 0; id < data_.num_cpus; ++id) {
+        if (data_.cpus[id].online && data_.cpus[id].core == c->core) cpus.push_back(id);
+    }
+    return cpus;
+}
+
+std::vector<int> Topology::l3Group(int cpu_id) const {
+    std::vector<int> cpus;
+    const CpuTopology* c = cpu(cpu_id);
+    if (!c) return cpus;
+    if (c->l3_group < 0) {
+        cpus.push_back(cpu_id);
+        return cpus;
+    }
+    for (int id = 0; id < data_.num_cpus; ++id) {
+        if (data_.cpus[id].online && data_.cpus[id].l3_group == c->l3_group) cpus.push_back(id);
+    }
+    return cpus;
+}
+
+int Topology::distance(int node_a, int node_b) const {
+    if (node_a < 0 || node_b < 0 || node_a >= data_.num_nodes || node_b >= data_.num_nodes) {
+        return 0;
+    }
+    return data_.distance[node_a][node_b];
+}
+
+CacheInfo Topology::cacheInfo(int cpu_id) const {
+    const CpuTopology* c = cpu(cpu_id);
+    CacheInfo info;
+    info.l1d_size = (c && c->l1d_size) ? c->l1d_size : DEFAULT_L1_SIZE;
+    info.l1i_size = (c && c->l1i_size) ? c->l1i_size : DEFAULT_L1_SIZE;
+    info.l2_size = (c && c->l2_size) ? c->l2_size : DEFAULT_L2_SIZE;
+    info.l3_size = (c && c->l3_size) ? c->l3_size : DEFAULT_L3_SIZE;
+    info.line_size = data_.line_size;
+    info.num_cores = static_cast<int>(onlineCpus().size());
+    return info;
+}
+
+const HugePagePool* Topology::hugePagePool(size_t page_size) const {
+    if (page_size == 0) page_size = data_.default_huge_page_size;
+    for (int i = 0; i < data_.num_pools; ++i) {
+        if (data_.pools[i].page_size == page_size) return &data_.pools[i];
+    }
+    return nullptr;
+}
+
+HugePagesInfo Topology::hugePages() const {
+    HugePagesInfo info;
+    const HugePagePool* pool = hugePagePool();
+    info.page_size = data_.default_huge_page_size;
+    info.total = pool ? pool->total : 0;
+    info.free = pool ? pool->free : 0;
+    info.reserved = pool ? pool->reserved : 0;
+    info.thp_shmem = data_.thp_shmem;
+    info.available = (info.total > 0);
+    info.usable = (info.unreserved() > 0);
+    return info;
+}
+
+NUMAInfo Topology::numa() const {
+    NUMAInfo info;
+    info.num_nodes = data_.num_nodes;
+    info.available = data_.num_nodes > 1;
+    info.current_node = nodeOfCpu(sched_getcpu());
+    return info;
+}
+
+HugePagePool readHugePagePool(size_t page_size) {
+    if (page_size == 0) page_size = Topology::get()->snapshot().default_huge_page_size;
+    return readPool(HUGEPAGE_BASE + "hugepages-" + std::to_string(page_size / 1024) + "kB",
+                    page_size);
+}
+
+} // namespace SIM
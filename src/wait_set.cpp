@@ -0,0 +1,414 @@
+/**
+ * @file wait_set.cpp
+ * @brief WaitSet Implementation - futex_waitv + eventfd relay
+ */
+
+#include "wait_set.hpp"
+
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// futex_waitv() (Linux 5.16+) - not exposed by older libc/kernel headers
+#ifndef SYS_futex_waitv
+#define SYS_futex_waitv 449
+#endif
+
+namespace SIM {
+
+// ============================================================================
+// futex_waitv helpers
+// ============================================================================
+
+struct FutexWaitv {
+    uint64_t val;
+    uint64_t uaddr;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+constexpr uint32_t FUTEX2_SIZE_U32 = 0x02;  // Shared (non-private) 32-bit word
+
+// ============================================================================
+// WaitSet Implementation
+// ============================================================================
+
+WaitSet::WaitSet()
+    : active_count_(0)
+    , predicate_count_(0)
+    , strategy_(WaitStrategy::adaptive())
+    , waitv_supported_(true)
+    , event_fd_(-1)
+    , stop_(false)
+    , control_(0)
+    , relay_seen_(0)
+{
+}
+
+WaitSet::~WaitSet() {
+    if (relay_.joinable()) {
+        stop_.store(true, std::memory_order_release);
+        control_.fetch_add(1, std::memory_order_seq_cst);
+        Futex::wake(&control_, Futex::WAKE_ALL);
+        relay_.join();
+    }
+    if (event_fd_ >= 0) {
+        close(event_fd_);
+    }
+}
+
+int WaitSet::add(NotifyWord* word, std::function<bool()> has_data) {
+    if (!word && !has_data) return -1;
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    // Reuse a removed slot if possible
+    size_t id = channels_.size();
+    for (size_t i = 0; i < channels_.size(); ++i) {
+        if (!channels_[i].active) {
+            id = i;
+            break;
+        }
+    }
+    if (id >= MAX_CHANNELS) return -1;
+    
+    if (id == channels_.size()) {
+        channels_.push_back(Channel());
+        words_.push_back(nullptr);
+        last_seq_.push_back(0);
+        cur_seq_.push_back(0);
+    }
+    
+    Channel& ch = channels_[id];
+    ch.word = word;
+    ch.has_data = word ? nullptr : std::move(has_data);
+    ch.active = true;
+    
+    words_[id] = word;
+    // Data published before add() is not reported, only new publishes
+    last_seq_[id] = word ? word->seq.load(std::memory_order_acquire) : 0;
+    
+    ++active_count_;
+    if (!word) ++predicate_count_;
+    
+    control_.fetch_add(1, std::memory_order_seq_cst);
+    Futex::wake(&control_, Futex::WAKE_ALL);
+    return static_cast<int>(id);
+}
+
+bool WaitSet::remove(int id) {
+    uint32_t control;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        if (id < 0 || static_cast<size_t>(id) >= channels_.size() || !channels_[id].active) {
+            return false;
+        }
+        
+        if (!channels_[id].word) --predicate_count_;
+        channels_[id].word = nullptr;
+        channels_[id].has_data = nullptr;
+        channels_[id].active = false;
+        words_[id] = nullptr;
+        --active_count_;
+        
+        control = control_.fetch_add(1, std::memory_order_seq_cst) + 1;
+    }
+    Futex::wake(&control_, Futex::WAKE_ALL);
+    
+    // Wait for the relay to drop its copy of the removed word
+    if (relay_.joinable()) {
+        while (static_cast<int32_t>(relay_seen_.load(std::memory_order_acquire) - control) < 0) {
+            std::this_thread::yield();
+        }
+    }
+    return true;
+}
+
+void WaitSet::scanWords(const std::vector<NotifyWord*>& words,
+                        const std::vector<uint32_t>& baseline,
+                        std::vector<uint32_t>& current,
+                        std::vector<int>& ready) {
+    size_t n = words.size();
+    
+    // Gather sequence words into a contiguous array
+    for (size_t i = 0; i < n; ++i) {
+        current[i] = words[i] ? words[i]->seq.load(std::memory_order_acquire) : baseline[i];
+    }
+    
+    const uint32_t* cur = current.data();
+    const uint32_t* base = baseline.data();
+    size_t i = 0;
+    
+    // Vectorized compare: one mask bit per changed channel
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + i));
+        unsigned mask = ~static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)))) & 0xFF;
+        while (mask) {
+            ready.push_back(static_cast<int>(i + __builtin_ctz(mask)));
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i));
+        unsigned mask = ~static_cast<unsigned>(
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)))) & 0xF;
+        while (mask) {
+            ready.push_back(static_cast<int>(i + __builtin_ctz(mask)));
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        if (cur[i] != base[i]) {
+            ready.push_back(static_cast<int>(i));
+        }
+    }
+}
+
+size_t WaitSet::scan(std::vector<int>& ready) {
+    ready.clear();
+    scanWords(words_, last_seq_, cur_seq_, ready);
+    
+    // Acknowledge what we report
+    for (int id : ready) {
+        last_seq_[id] = cur_seq_[id];
+    }
+    
+    // Channels without a notify word
+    if (predicate_count_ > 0) {
+        for (size_t i = 0; i < channels_.size(); ++i) {
+            const Channel& ch = channels_[i];
+            if (ch.active && !ch.word && ch.has_data && ch.has_data()) {
+                ready.push_back(static_cast<int>(i));
+            }
+        }
+    }
+    
+    return ready.size();
+}
+
+bool WaitSet::park(const std::vector<NotifyWord*>& words,
+                   const std::vector<uint32_t>& expected,
+                   uint32_t control, int64_t timeout_ns) {
+    if (!waitv_supported_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    
+    FutexWaitv waitv[MAX_CHANNELS + 1];
+    size_t nr = 0;
+    
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (!words[i]) continue;
+        waitv[nr].val = expected[i];
+        waitv[nr].uaddr = reinterpret_cast<uintptr_t>(&words[i]->seq);
+        waitv[nr].flags = FUTEX2_SIZE_U32;
+        waitv[nr].reserved = 0;
+        ++nr;
+    }
+    
+    // Internal control word: add/remove/stop interrupt the wait
+    waitv[nr].val = control;
+    waitv[nr].uaddr = reinterpret_cast<uintptr_t>(&control_);
+    waitv[nr].flags = FUTEX2_SIZE_U32;
+    waitv[nr].reserved = 0;
+    ++nr;
+    
+    // Register as waiter on every channel, then re-check before sleeping
+    for (NotifyWord* w : words) {
+        if (w) w->waiters.fetch_add(1, std::memory_order_seq_cst);
+    }
+    
+    bool changed = control_.load(std::memory_order_seq_cst) != control;
+    for (size_t i = 0; i < words.size() && !changed; ++i) {
+        if (words[i] && words[i]->seq.load(std::memory_order_seq_cst) != expected[i]) {
+            changed = true;
+        }
+    }
+    
+    if (!changed) {
+        // futex_waitv takes an absolute timeout
+        struct timespec ts;
+        struct timespec* pts = nullptr;
+        if (timeout_ns >= 0) {
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            int64_t abs_ns = static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec + timeout_ns;
+            ts.tv_sec = abs_ns / 1000000000;
+            ts.tv_nsec = abs_ns % 1000000000;
+            pts = &ts;
+        }
+        
+        long rc = syscall(SYS_futex_waitv, waitv, static_cast<unsigned>(nr), 0u,
+                          pts, CLOCK_MONOTONIC);
+        if (rc < 0 && errno == ENOSYS) {
+            waitv_supported_.store(false, std::memory_order_relaxed);
+        }
+    }
+    
+    for (NotifyWord* w : words) {
+        if (w) w->waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+    
+    return waitv_supported_.load(std::memory_order_relaxed);
+}
+
+size_t WaitSet::wait(std::vector<int>& ready, uint32_t timeout_ms) {
+    if (scan(ready) > 0) {
+        drainFd();
+        return ready.size();
+    }
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    
+    // Phase 1: spin on the vectorized scan
+    uint32_t spins = (strategy_.mode == WaitMode::BusySpin) ? UINT32_MAX : strategy_.spin_iterations;
+    for (uint32_t i = 0; i < spins; ++i) {
+        if (scan(ready) > 0) {
+            drainFd();
+            return ready.size();
+        }
+        Futex::cpuRelax();
+        if ((i & 127) == 127 && std::chrono::steady_clock::now() >= deadline) {
+            return 0;
+        }
+    }
+    
+    // Phase 2: yield
+    uint32_t yields = (strategy_.mode == WaitMode::SpinYield) ? UINT32_MAX : strategy_.yield_iterations;
+    for (uint32_t i = 0; i < yields; ++i) {
+        if (scan(ready) > 0) {
+            drainFd();
+            return ready.size();
+        }
+        if (std::chrono::steady_clock::now() >= deadline) return 0;
+        std::this_thread::yield();
+    }
+    
+    // Phase 3: park on all notify words
+    int64_t backoff_us = 50;
+    while (true) {
+        uint32_t control = control_.load(std::memory_order_acquire);
+        if (scan(ready) > 0) {
+            drainFd();
+            return ready.size();
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) return 0;
+        int64_t remaining_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadline - now).count();
+        
+        // Predicate-only channels cannot be parked on: cap the sleep
+        bool parked = false;
+        if (predicate_count_ == 0 || active_count_ > predicate_count_) {
+            int64_t park_ns = predicate_count_ > 0 ?
+                std::min<int64_t>(remaining_ns, backoff_us * 1000) : remaining_ns;
+            parked = park(words_, last_seq_, control, park_ns);
+        }
+        
+        if (!parked) {
+            int64_t sleep_ns = std::min<int64_t>(backoff_us * 1000, remaining_ns);
+            std::this_thread::sleep_for(std::chrono::nanoseconds(sleep_ns));
+        }
+        backoff_us = std::min<int64_t>(backoff_us * 2, 1000);
+    }
+}
+
+size_t WaitSet::poll(std::vector<int>& ready) {
+    drainFd();
+    return scan(ready);
+}
+
+void WaitSet::drainFd() {
+    if (event_fd_ >= 0) {
+        uint64_t value;
+        ssize_t rc = ::read(event_fd_, &value, sizeof(value));
+        (void)rc;  // EAGAIN when nothing pending
+    }
+}
+
+int WaitSet::getFd() {
+    if (event_fd_ >= 0) return event_fd_;
+    
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0) return -1;
+    
+    // Report data that is already pending
+    std::vector<uint32_t> current(words_.size());
+    std::vector<int> pending;
+    scanWords(words_, last_seq_, current, pending);
+    if (!pending.empty()) {
+        uint64_t one = 1;
+        ssize_t rc = ::write(event_fd_, &one, sizeof(one));
+        (void)rc;
+    }
+    
+    relay_ = std::thread(&WaitSet::relayLoop, this);
+    return event_fd_;
+}
+
+void WaitSet::relayLoop() {
+    std::vector<NotifyWord*> words;
+    std::vector<uint32_t> snapshot;
+    std::vector<uint32_t> current;
+    std::vector<int> changed;
+    uint32_t seen_control = UINT32_MAX;
+    bool polled = false;
+    
+    while (!stop_.load(std::memory_order_acquire)) {
+        uint32_t control = control_.load(std::memory_order_acquire);
+        
+        // Rebuild the channel copy after add()/remove()
+        if (control != seen_control) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            words = words_;
+            polled = predicate_count_ > 0;
+            snapshot.resize(words.size());
+            current.resize(words.size());
+            for (size_t i = 0; i < words.size(); ++i) {
+                snapshot[i] = words[i] ? words[i]->seq.load(std::memory_order_acquire) : 0;
+            }
+            seen_control = control;
+            relay_seen_.store(control, std::memory_order_release);
+        }
+        
+        changed.clear();
+        scanWords(words, snapshot, current, changed);
+        for (int id : changed) {
+            snapshot[id] = current[id];
+        }
+        
+        // Predicates touch their reader's state: never call them here, tick
+        // the fd instead so that poll() re-checks them on the owner thread
+        bool signal = !changed.empty();
+        if (!signal) {
+            int64_t timeout_ns = polled ? 1000000 : -1;
+            if (!park(words, snapshot, control, timeout_ns)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            signal = polled;
+        }
+        
+        if (signal) {
+            uint64_t one = 1;
+            ssize_t rc = ::write(event_fd_, &one, sizeof(one));
+            (void)rc;
+        }
+    }
+}
+
+} // namespace SIM
@@ -0,0 +1,106 @@
+/**
+ * @file wait_strategy.cpp
+ * @brief Futex and NotifyView Implementation
+ */
+
+#include "wait_strategy.hpp"
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+
+namespace SIM {
+
+// ============================================================================
+// Futex
+// ============================================================================
+
+// Shared (non-private) futex ops: writer and readers live in different processes
+static long futexCall(std::atomic<uint32_t>* addr, int op, uint32_t val,
+                      const struct timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), op, val,
+                   timeout, nullptr, 0);
+}
+
+bool Futex::wait(std::atomic<uint32_t>* addr, uint32_t expected, int64_t timeout_ns) {
+    struct timespec ts;
+    struct timespec* pts = nullptr;
+    
+    if (timeout_ns >= 0) {
+        ts.tv_sec = timeout_ns / 1000000000;
+        ts.tv_nsec = timeout_ns % 1000000000;
+        pts = &ts;
+    }
+    
+    long rc = futexCall(addr, FUTEX_WAIT, expected, pts);
+    if (rc == 0) return true;
+    
+    // EAGAIN: value already changed, EINTR: spurious - both mean "re-check"
+    return errno != ETIMEDOUT;
+}
+
+int Futex::wake(std::atomic<uint32_t>* addr, int count) {
+    long rc = futexCall(addr, FUTEX_WAKE, static_cast<uint32_t>(count), nullptr);
+    return rc < 0 ? 0 : static_cast<int>(rc);
+}
+
+// ============================================================================
+// NotifyView
+// ============================================================================
+
+NotifyView::NotifyView(NotifyView&& other) noexcept
+    : base_(other.base_)
+    , size_(other.size_)
+    , word_(other.word_)
+{
+    other.base_ = nullptr;
+    other.size_ = 0;
+    other.word_ = nullptr;
+}
+
+NotifyView& NotifyView::operator=(NotifyView&& other) noexcept {
+    if (this != &other) {
+        detach();
+        base_ = other.base_;
+        size_ = other.size_;
+        word_ = other.word_;
+        other.base_ = nullptr;
+        other.size_ = 0;
+        other.word_ = nullptr;
+    }
+    return *this;
+}
+
+bool NotifyView::attach(int fd, size_t offset) {
+    detach();
+    if (fd < 0) return false;
+    
+    // mmap offsets must be page aligned
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t map_offset = offset & ~(page - 1);
+    size_t map_size = (offset - map_offset) + sizeof(NotifyWord);
+    map_size = (map_size + page - 1) & ~(page - 1);
+    
+    void* ptr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     fd, static_cast<off_t>(map_offset));
+    if (ptr == MAP_FAILED) return false;
+    
+    base_ = ptr;
+    size_ = map_size;
+    word_ = reinterpret_cast<NotifyWord*>(static_cast<uint8_t*>(ptr) + (offset - map_offset));
+    return true;
+}
+
+void NotifyView::detach() {
+    if (base_) {
+        munmap(base_, size_);
+    }
+    base_ = nullptr;
+    size_ = 0;
+    word_ = nullptr;
+}
+
+} // namespace SIM
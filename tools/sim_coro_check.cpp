@@ -0,0 +1,101 @@
+/**
+ * @file sim_coro_check.cpp
+ * @brief SIM Library - Timeout check of coroutine reads
+ *
+ * co_awaits SIM::next() with a short timeout on a SAHM channel whose
+ * latest frame was already consumed: the timeout must yield an empty
+ * Frame, not the old frame again. Then publishes once more and checks
+ * that the next await gets the new frame. Exits non-zero on failure.
+ *
+ * Compile (C++20 for coroutines):
+ *   g++ -std=c++20 -O2 sim_coro_check.cpp -I../include -L../build \
+ *       -lsim_library -lrt -lpthread -o sim_coro_check
+ *   (or the sim_coro_check target of CMakeLists.txt.example)
+ *
+ * Run:
+ *   ./sim_coro_check
+ */
+
+#include "coro.hpp"
+
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifndef SIM_HAS_COROUTINES
+
+int main() {
+    std::cerr << "Built without coroutine support (compile with -std=c++20)" << std::endl;
+    return 2;
+}
+
+#else
+
+namespace {
+
+constexpr size_t SLOT_SIZE = 64;
+constexpr uint32_t TIMEOUT_MS = 20;
+
+struct CheckResult {
+    bool stale_empty = false;
+    bool fresh_frame = false;
+    uint32_t fresh_value = 0;
+};
+
+bool verdict(const char* what, bool ok, const char* detail) {
+    std::printf("%-6s %-22s %s\n", ok ? "PASS" : "FAIL", what, detail);
+    return ok;
+}
+
+SIM::Task check(SAHM::DirectWriter& writer, SAHM::DirectReader& reader, CheckResult& result) {
+    // Nothing new since the frame consumed in main(): must time out empty
+    SIM::Frame stale = co_await SIM::next(reader, TIMEOUT_MS);
+    result.stale_empty = !stale;
+
+    uint32_t value = 2;
+    writer.write(&value, sizeof(value));
+    SIM::Frame fresh = co_await SIM::next(reader, TIMEOUT_MS);
+    result.fresh_frame = static_cast<bool>(fresh);
+    if (fresh) std::memcpy(&result.fresh_value, fresh.data(), sizeof(result.fresh_value));
+}
+
+}  // namespace
+
+int main() {
+    std::string channel = "/sim_coro_check_" + std::to_string(getpid());
+    SAHM::DirectWriter writer(channel, SLOT_SIZE);
+    SAHM::DirectReader reader(channel, SLOT_SIZE);
+    if (!writer.init() || !reader.init()) {
+        std::cerr << "Failed to create " << channel << std::endl;
+        return 1;
+    }
+
+    // Publish one frame and consume it, so the ring holds an old frame
+    uint32_t value = 1;
+    size_t size = 0;
+    writer.write(&value, sizeof(value));
+    if (!reader.hasNewData() || !reader.getLatest(size)) {
+        std::cerr << "Reader did not receive the first frame" << std::endl;
+        writer.destroy();
+        return 1;
+    }
+
+    CheckResult result;
+    SIM::Scheduler sched;
+    sched.spawn(check(writer, reader, result));
+    sched.run();
+    writer.destroy();
+
+    char detail[128];
+    bool ok = true;
+    std::snprintf(detail, sizeof(detail), "next(reader, %u) with nothing new", TIMEOUT_MS);
+    ok &= verdict("timeout is empty", result.stale_empty, detail);
+    std::snprintf(detail, sizeof(detail), "got %s, value %u (want 2)",
+                  result.fresh_frame ? "a frame" : "nothing", result.fresh_value);
+    ok &= verdict("new frame delivered", result.fresh_frame && result.fresh_value == 2, detail);
+    return ok ? 0 : 1;
+}
+
+#endif // SIM_HAS_COROUTINES
@@ -0,0 +1,236 @@
+/**
+ * @file sim_pacing_bench.cpp
+ * @brief SIM Library - Tail latency of a small channel next to large writes
+ *
+ * Publishes 1KB frames on a CASIR control channel while a BARQ channel
+ * takes large writes (read back by a bulk reader), twice: unpaced, then
+ * with the control channel Critical and the bulk channel paced. Prints
+ * the control channel's latency percentiles and the bulk throughput of
+ * both runs.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 sim_pacing_bench.cpp -I../include -L../build \
+ *       -lsim_library -lrt -lpthread -o sim_pacing_bench
+ *   (or the sim_pacing_bench target of CMakeLists.txt.example)
+ *
+ * Run:
+ *   ./sim_pacing_bench                              # 50MB at 30Hz, 1KB at 1kHz
+ *   ./sim_pacing_bench --cpus 2,3,4,5 --budget-us 20
+ *   ./sim_pacing_bench --rate-mbps 2000 --seconds 5
+ */
+
+#include "barq.hpp"
+#include "casir.hpp"
+#include "pacing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BenchConfig {
+    size_t bulk_bytes = 50 * 1024 * 1024;
+    double bulk_hz = 30.0;
+    size_t small_bytes = 1024;
+    double small_hz = 1000.0;
+    double seconds = 3.0;
+    int64_t budget_ns = 50000;
+    double rate_bytes_per_s = 0.0;
+    std::vector<int> cpus;          // small writer, small reader, bulk writer, bulk reader
+};
+
+struct RunResult {
+    std::vector<int64_t> latency_ns;
+    uint64_t bulk_frames = 0;
+    double elapsed_s = 0.0;
+    SIM::PacingStats pacing{};
+};
+
+int64_t monoNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void sleepUntil(int64_t deadline_ns) {
+    struct timespec ts;
+    ts.tv_sec = deadline_ns / 1000000000LL;
+    ts.tv_nsec = deadline_ns % 1000000000LL;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+}
+
+void pin(const BenchConfig& cfg, size_t role) {
+    if (role < cfg.cpus.size()) SIM::CacheUtils::setCpuAffinity(cfg.cpus[role]);
+}
+
+bool runOnce(const BenchConfig& cfg, bool paced, RunResult& result) {
+    BARQ::Writer bulk("/sim_bench_bulk", cfg.bulk_bytes, true);
+    CASIR::Writer small("/sim_bench_ctl", cfg.small_bytes);
+    if (!bulk.init() || !small.init()) return false;
+
+    if (paced) {
+        small.setPriority(SIM::ChannelPriority::Critical);
+        bulk.setPriority(SIM::ChannelPriority::Bulk);
+        SIM::PacingPolicy policy = cfg.rate_bytes_per_s > 0.0
+            ? SIM::PacingPolicy::rate(cfg.rate_bytes_per_s)
+            : SIM::PacingPolicy::latencyBudget(cfg.budget_ns);
+        if (cfg.rate_bytes_per_s > 0.0 && cfg.budget_ns > 0) policy.latency_budget_ns = cfg.budget_ns;
+        bulk.setPacing(policy);
+    }
+
+    std::atomic<bool> running(true);
+    int64_t start = monoNs();
+    int64_t warm_ns = start + 100000000;        // First 100ms are warm-up
+    int64_t end_ns = start + static_cast<int64_t>(cfg.seconds * 1e9);
+
+    std::thread small_reader([&]() {
+        pin(cfg, 1);
+        CASIR::Reader reader("/sim_bench_ctl", cfg.small_bytes);
+        if (!reader.init()) return;
+        std::vector<uint8_t> frame(cfg.small_bytes);
+        while (running.load(std::memory_order_relaxed)) {
+            size_t size = frame.size();
+            if (!reader.readWithTimeout(frame.data(), size, 100) || size < sizeof(int64_t)) continue;
+            int64_t sent;
+            std::memcpy(&sent, frame.data(), sizeof(sent));
+            if (sent >= warm_ns) result.latency_ns.push_back(monoNs() - sent);
+        }
+    });
+
+    std::thread bulk_reader([&]() {
+        pin(cfg, 3);
+        BARQ::Reader reader("/sim_bench_bulk", cfg.bulk_bytes);
+        if (!reader.init()) return;
+        volatile uint64_t sink = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            size_t size;
+            int64_t ts;
+            const uint8_t* data = static_cast<const uint8_t*>(reader.getLatestWithTimeout(size, ts, 100));
+            if (!data) continue;
+            uint64_t sum = 0;
+            for (size_t i = 0; i < size; i += 64) sum += data[i];    // Pull every line
+            sink = sink + sum;
+        }
+    });
+
+    std::thread bulk_writer([&]() {
+        pin(cfg, 2);
+        std::vector<uint8_t> payload(cfg.bulk_bytes, 0x5a);
+        int64_t period = cfg.bulk_hz > 0.0 ? static_cast<int64_t>(1e9 / cfg.bulk_hz) : 0;
+        int64_t next = monoNs();
+        while (monoNs() < end_ns) {
+            bulk.write(payload.data(), payload.size());
+            ++result.bulk_frames;
+            if (period) {
+                next += period;
+                sleepUntil(next);
+            }
+        }
+    });
+
+    // Small writer on this thread
+    pin(cfg, 0);
+    std::vector<uint8_t> frame(cfg.small_bytes, 0);
+    int64_t period = static_cast<int64_t>(1e9 / cfg.small_hz);
+    int64_t next = start;
+    while (monoNs() < end_ns) {
+        int64_t now = monoNs();
+        std::memcpy(frame.data(), &now, sizeof(now));
+        small.write(frame.data(), frame.size());
+        next += period;
+        sleepUntil(next);
+    }
+
+    bulk_writer.join();
+    running.store(false);
+    small_reader.join();
+    bulk_reader.join();
+    result.elapsed_s = (monoNs() - warm_ns) / 1e9;
+    result.pacing = bulk.getPacingStats();
+    bulk.destroy();
+    small.destroy();
+    return true;
+}
+
+int64_t percentile(std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1));
+    return sorted[idx];
+}
+
+void report(const char* label, RunResult& r, size_t bulk_bytes) {
+    std::vector<int64_t>& lat = r.latency_ns;
+    std::sort(lat.begin(), lat.end());
+    double gbps = r.elapsed_s > 0 ? r.bulk_frames * static_cast<double>(bulk_bytes) / r.elapsed_s / 1e9 : 0.0;
+    std::printf("%-8s %8zu %9.1f %9.1f %9.1f %9.1f %10.2f %9lu %9.2f\n", label, lat.size(),
+                percentile(lat, 0.50) / 1e3, percentile(lat, 0.99) / 1e3,
+                percentile(lat, 0.999) / 1e3, (lat.empty() ? 0 : lat.back()) / 1e3, gbps,
+                static_cast<unsigned long>(r.pacing.deferrals), r.pacing.deferred_ns / 1e6);
+}
+
+std::vector<int> parseCpus(const char* list) {
+    std::vector<int> cpus;
+    std::stringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) cpus.push_back(std::atoi(item.c_str()));
+    return cpus;
+}
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0
+              << " [--bulk-mb N] [--bulk-hz HZ] [--small-hz HZ] [--seconds S]"
+                 " [--budget-us US] [--rate-mbps MBPS] [--cpus SW,SR,BW,BR]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--bulk-mb") == 0 && i + 1 < argc) {
+            cfg.bulk_bytes = static_cast<size_t>(std::atof(argv[++i]) * 1024 * 1024);
+        } else if (std::strcmp(argv[i], "--bulk-hz") == 0 && i + 1 < argc) {
+            cfg.bulk_hz = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--small-hz") == 0 && i + 1 < argc) {
+            cfg.small_hz = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            cfg.seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--budget-us") == 0 && i + 1 < argc) {
+            cfg.budget_ns = static_cast<int64_t>(std::atof(argv[++i]) * 1000);
+        } else if (std::strcmp(argv[i], "--rate-mbps") == 0 && i + 1 < argc) {
+            cfg.rate_bytes_per_s = std::atof(argv[++i]) * 1e6;
+        } else if (std::strcmp(argv[i], "--cpus") == 0 && i + 1 < argc) {
+            cfg.cpus = parseCpus(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (cfg.small_hz <= 0.0 || cfg.bulk_bytes == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    RunResult unpaced, paced;
+    if (!runOnce(cfg, false, unpaced) || !runOnce(cfg, true, paced)) {
+        std::cerr << "Failed to create the benchmark channels" << std::endl;
+        return 1;
+    }
+
+    std::printf("%zu MB bulk writes at %.0f Hz, %zu B control frames at %.0f Hz\n\n",
+                cfg.bulk_bytes >> 20, cfg.bulk_hz, cfg.small_bytes, cfg.small_hz);
+    std::printf("%-8s %8s %9s %9s %9s %9s %10s %9s %9s\n", "RUN", "FRAMES", "P50_US",
+                "P99_US", "P99.9_US", "MAX_US", "BULK_GB/S", "DEFERS", "DEFER_MS");
+    report("unpaced", unpaced, cfg.bulk_bytes);
+    report("paced", paced, cfg.bulk_bytes);
+    return 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file sim_phase_check.cpp
+ * @brief SIM Library - Convergence check of phase alignment
+ *
+ * A consumer consumes a fixed offset after each frame of a grid, without
+ * telling ConsumerPhase its period, while a PhaseAligner plans against
+ * it. Checks that the learned period matches the grid, that the
+ * announced schedule (anchor + k * period) holds the consume offset
+ * instead of drifting, and that the writer plans lead_ns ahead of that
+ * schedule. Exits non-zero if any of them does not converge.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 sim_phase_check.cpp -I../include -L../build \
+ *       -lsim_library -lrt -lpthread -o sim_phase_check
+ *   (or the sim_phase_check target of CMakeLists.txt.example)
+ *
+ * Run:
+ *   ./sim_phase_check                               # 100Hz, 3.5ms offset, 300 frames
+ *   ./sim_phase_check --period-ms 33.333 --offset-ms 12 --frames 200
+ */
+
+#include "phase.hpp"
+
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+struct CheckConfig {
+    int64_t period_ns = 10000000;
+    int64_t offset_ns = 3500000;
+    int64_t lead_ns = 1000000;
+    int frames = 300;
+    int warmup = 30;
+};
+
+// Frame timestamp clock, as written by the transports
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+void sleepUntil(int64_t deadline_ns) {
+    std::this_thread::sleep_until(std::chrono::high_resolution_clock::time_point(
+        std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+            std::chrono::nanoseconds(deadline_ns))));
+}
+
+int64_t modPos(int64_t value, int64_t period) {
+    int64_t r = value % period;
+    return r < 0 ? r + period : r;
+}
+
+// Signed distance on the circle of the period
+int64_t circularDiff(int64_t a, int64_t b, int64_t period) {
+    int64_t d = modPos(a - b, period);
+    return d > period / 2 ? d - period : d;
+}
+
+bool verdict(const char* what, bool ok, const char* detail) {
+    std::printf("%-6s %-22s %s\n", ok ? "PASS" : "FAIL", what, detail);
+    return ok;
+}
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0
+              << " [--period-ms N] [--offset-ms N] [--lead-ms N] [--frames N]" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    CheckConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--period-ms") == 0 && i + 1 < argc) {
+            cfg.period_ns = static_cast<int64_t>(std::atof(argv[++i]) * 1e6);
+        } else if (std::strcmp(argv[i], "--offset-ms") == 0 && i + 1 < argc) {
+            cfg.offset_ns = static_cast<int64_t>(std::atof(argv[++i]) * 1e6);
+        } else if (std::strcmp(argv[i], "--lead-ms") == 0 && i + 1 < argc) {
+            cfg.lead_ns = static_cast<int64_t>(std::atof(argv[++i]) * 1e6);
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            cfg.frames = std::atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (cfg.period_ns <= 0 || cfg.frames <= cfg.warmup) {
+        usage(argv[0]);
+        return 2;
+    }
+    cfg.offset_ns = modPos(cfg.offset_ns, cfg.period_ns);
+
+    std::string channel = "/sim_phase_check_" + std::to_string(getpid());
+    SIM::ConsumerPhase phase(channel);          // Period learned, not given
+    SIM::PhaseAligner aligner(channel, cfg.period_ns, cfg.lead_ns);
+    if (!phase.attach() || !aligner.attach()) {
+        std::cerr << "Failed to open " << channel << "@phase" << std::endl;
+        return 1;
+    }
+
+    // Offsets are measured against the frame grid, never as epoch phases
+    const int64_t grid = (nowNs() / cfg.period_ns + 1) * cfg.period_ns;
+    int64_t anchor_lo = 0, anchor_hi = 0;
+    int64_t publish_err = 0;
+
+    for (int k = 0; k < cfg.frames; ++k) {
+        int64_t frame_ts = grid + k * cfg.period_ns;
+        sleepUntil(frame_ts + cfg.offset_ns);
+        phase.consumed(frame_ts);
+        if (k < cfg.warmup) continue;
+
+        int64_t drift = circularDiff(phase.getAnchor() - grid, cfg.offset_ns, cfg.period_ns);
+        anchor_lo = k == cfg.warmup ? drift : std::min(anchor_lo, drift);
+        anchor_hi = k == cfg.warmup ? drift : std::max(anchor_hi, drift);
+
+        // The writer follows the announced schedule, wake-up latency included
+        int64_t publish = aligner.bestAnchor();
+        int64_t err = circularDiff(publish, phase.getAnchor() - cfg.lead_ns, cfg.period_ns);
+        if (std::llabs(err) > std::llabs(publish_err)) publish_err = err;
+    }
+
+    phase.detach();
+
+    char detail[128];
+    bool ok = true;
+    double period_err = static_cast<double>(phase.getPeriod() - cfg.period_ns) / cfg.period_ns;
+    std::snprintf(detail, sizeof(detail), "%.4f ms learned for %.4f ms",
+                  phase.getPeriod() / 1e6, cfg.period_ns / 1e6);
+    // A late last wake-up (up to period / 4) moves it by 1 / 128 of that
+    ok &= verdict("learned period", std::abs(period_err) < 1.0 / 500, detail);
+
+    // Wakeup jitter moves single consume times, not the smoothed schedule
+    std::snprintf(detail, sizeof(detail), "consume offset %+.3f .. %+.3f ms off %.3f ms",
+                  anchor_lo / 1e6, anchor_hi / 1e6, cfg.offset_ns / 1e6);
+    ok &= verdict("consume anchor", anchor_hi - anchor_lo < cfg.period_ns / 10, detail);
+
+    std::snprintf(detail, sizeof(detail), "worst %+.3f ms from lead %.3f ms before consume",
+                  publish_err / 1e6, cfg.lead_ns / 1e6);
+    ok &= verdict("publish anchor", std::llabs(publish_err) < cfg.period_ns / 20, detail);
+
+    return ok ? 0 : 1;
+}